@@ -4,6 +4,12 @@
 -*/
 
 #include <usb/UsbTypes.hpp>
+#include <usb/UsbDescriptorBuilder.hpp>
+#include <usb/UsbFunctionStrings.hpp>
+
+#include "UsbDescriptors.hpp"
+
+#include <cstddef>
 
 #if defined(__cplusplus)
 extern "C" {
@@ -27,10 +33,14 @@ extern const ::usb::UsbDeviceDescriptor_t usbDeviceDescriptor FIXED_DATA = {
     .m_bDeviceClass         = ::usb::UsbInterfaceClass_e::e_UsbInterface_VendorSpecific,/* m_bDeviceClass */
     .m_bDeviceSubClass      = 0x02,                                                     /* m_bDeviceSubClass */
     .m_bDeviceProtocol      = 0x01,                                                     /* m_bDeviceProtocol */
+#elif defined(USB_INTERFACE_MSC)
+    .m_bDeviceClass         = static_cast<::usb::UsbInterfaceClass_e>(0x00),            /* m_bDeviceClass -- Mass Storage is declared by the Interface */
+    .m_bDeviceSubClass      = 0x00,                                                     /* m_bDeviceSubClass */
+    .m_bDeviceProtocol      = 0x00,                                                     /* m_bDeviceProtocol */
 #else
 #error No USB Interface defined.
 #endif /* */
-    .m_bMaxPacketSize0      = 64,                                                       /* m_bMaxPacketSize0 -- Should be 64 for a USB Full Speed Device. */
+    .m_bMaxPacketSize0      = usbCtrlMaxPacketSize,                                     /* m_bMaxPacketSize0 -- Should be 64 for a USB Full Speed Device. */
     .m_idVendor             = { 0xad, 0xde },                                           /* m_idVendor */
     .m_idProduct            = { 0xef, 0xbe },                                           /* m_idProduct */
     .m_bcdDevice            = { 0xfe, 0xca },                                           /* m_bcdDevice */
@@ -49,7 +59,16 @@ static const auto usbStringDescriptorManufacturer   FIXED_DATA  = ::usb::UsbStri
 static const auto usbStringDescriptorSerialNumber   FIXED_DATA  = ::usb::UsbStringDescriptor(u"D2209DFF-B80D-4E44-A8E5-466ADCCE7E30");
 static const auto usbStringDescriptorProduct        FIXED_DATA  = ::usb::UsbStringDescriptor(u"PhiSch.org USB Virtual COM Port (VCP) Demo on STM32F4Discovery");
 static const auto usbStringDescriptorConfiguration  FIXED_DATA  = ::usb::UsbStringDescriptor(u"PhiSch.org USB Virtual COM Port (VCP) Configuration");
+#if defined(USB_INTERFACE_VCP)
 static const auto usbStringDescriptorInterface      FIXED_DATA  = ::usb::UsbStringDescriptor(u"PhiSch.org USB Comm. Device Class (CDC) Interface");
+#elif defined(USB_INTERFACE_VENDOR)
+static const auto usbStringDescriptorInterface      FIXED_DATA  = ::usb::UsbStringDescriptor(u"PhiSch.org USB Vendor Interface");
+#elif defined(USB_INTERFACE_MSC)
+static const auto usbStringDescriptorInterface      FIXED_DATA  = ::usb::UsbStringDescriptor(u"PhiSch.org USB Mass Storage Interface");
+#endif /* defined(USB_INTERFACE_VCP) */
+static const auto usbStringDescriptorLoopback       FIXED_DATA  = ::usb::UsbStringDescriptor(u"PhiSch.org USB Loopback Interface");
+static const auto usbStringDescriptorIsoLoopback    FIXED_DATA  = ::usb::UsbStringDescriptor(u"PhiSch.org USB Isochronous Loopback Interface");
+static const auto usbStringDescriptorDfu            FIXED_DATA  = ::usb::UsbStringDescriptor(u"PhiSch.org USB Device Firmware Upgrade (DFU) Interface");
 
 extern const ::usb::UsbStringDescriptors_t usbStringDescriptors FIXED_DATA = {
     .m_strings = {
@@ -62,201 +81,131 @@ extern const ::usb::UsbStringDescriptors_t usbStringDescriptors FIXED_DATA = {
     }
 };
 
-#if defined(USB_INTERFACE_VCP)
-extern const struct UsbConfigurationDescriptor_s {
-    struct ::usb::UsbConfigurationDescriptorT<void *, 0>    m_configDescrHdr;
-    struct ::usb::UsbInterfaceAssociationDescriptor_s       m_iad;
-    struct ::usb::UsbInterfaceDescriptorT<0>                m_cdcInterface;
-    struct ::usb::UsbCdc_FunctDescr_Header_s                m_cdcFunctDescr_Header;
-    struct ::usb::UsbCdc_FunctDescr_CallMgmt_s              m_cdcFunctDescr_CallMgmt;
-    struct ::usb::UsbCdc_FunctDescr_ACM_s                   m_cdcFunctDescr_ACM;
-    struct ::usb::UsbCdc_FunctDescr_UnionT<1>               m_cdcFunctDescr_Union;
-    struct ::usb::UsbEndpointDescriptor                     m_notificationEndpoint;
-    struct ::usb::UsbInterfaceDescriptorT<2>                m_dataInterface;
-} __attribute__((packed)) usbConfigurationDescriptor FIXED_DATA = {
-    .m_configDescrHdr = {
-        .m_bLength                  = sizeof( decltype(usbConfigurationDescriptor.m_configDescrHdr)),
-        .m_bDescriptorType          = ::usb::UsbDescriptorTypeId_e::e_Configuration,
-        .m_wTotalLength = {
-            .m_loByte               = (sizeof(decltype(usbConfigurationDescriptor)) >> 0),
-            .m_hiByte               = (sizeof(decltype(usbConfigurationDescriptor)) >> 8)
-        },
-        .m_bNumInterfaces           = 2,
-        .m_bConfigurationValue      = 1,
-        .m_iConfiguration           = 4, /* Index of m_configuration within usbStringDescriptors.m_stringDescriptorTable */
-        .m_bmAttributes             = 0x80      // USB 2.0 Spec demands this Bit to always be set
-                                    | 0x40,     // Set to 0x40 for Self-powered Device, 0x00 for Bus-powered
-        .m_bMaxPower                = 5,        // Power consumption in Units of 2mA
-        .m_interfaces               = {}
-    },
-    .m_iad = {
-        .m_bLength                  = sizeof(decltype(usbConfigurationDescriptor.m_iad)),
-        .m_bDescriptorType          = 0x0B /* ::usb::UsbDescriptorTypeId_e::e_InterfaceAssociation */,
-        .m_bFirstInterface          = 0 /* usbConfigurationDescriptor.m_cdcInterface.m_bInterfaceNumber */,
-        .m_bInterfaceCount          = 2,
-        .m_bFunctionClass           = ::usb::UsbInterfaceClass_e::e_UsbInterface_CommunicationDeviceClass,
-        .m_bFunctionSubClass        = ::usb::UsbCdc_SubclassCode_e::e_UsbCdcSubclass_AbstractControl,
-        .m_bFunctionProtocol        = ::usb::UsbCdc_ProtocolCode_e::e_UsbCdcProto_AT_V250,
-        .m_iFunction                = 5 /* Index of m_interface within usbStringDescriptors.m_stringDescriptorTable */
-    },
-    .m_cdcInterface = {
-        .m_bLength                  = sizeof(decltype(usbConfigurationDescriptor.m_cdcInterface)),
-        .m_bDescriptorType          = ::usb::UsbDescriptorTypeId_e::e_Interface,
-        .m_bInterfaceNumber         = 0,
-        .m_bAlternateSetting        = 0,
-        .m_bNumEndpoints            = 1,
-        .m_bInterfaceClass          = ::usb::UsbInterfaceClass_e::e_UsbInterface_CommunicationDeviceClass,
-        .m_bInterfaceSubClass       = ::usb::UsbCdc_SubclassCode_e::e_UsbCdcSubclass_AbstractControl,
-        .m_bInterfaceProtocol       = ::usb::UsbCdc_ProtocolCode_e::e_UsbCdcProto_AT_V250,
-        .m_iInterface               = 5, /* Index of m_interface within usbStringDescriptors.m_stringDescriptorTable */
-        .m_endpoints                = {}
-    },
-    .m_cdcFunctDescr_Header = {
-        .m_cdcFncDescr = {
-            .m_bFunctionLength      = sizeof(decltype(usbConfigurationDescriptor.m_cdcFunctDescr_Header)),
-            .m_bDescriptorType      = ::usb::UsbCdcFunctionalDescriptorType_e::e_UsbDec_DescrType_Interface,
-            .m_bDescriptorSubtype   = ::usb::UsbCdcFunctionalDescriptorSubtype_e::e_UsbDec_DescrSubtype_Header
-        },
-        .m_bcdCDC = {
-            .m_loByte               = 0x10,
-            .m_hiByte               = 0x01
-        }
-    },
-    .m_cdcFunctDescr_CallMgmt = {
-        .m_cdcFncDescr = {
-            .m_bFunctionLength      = sizeof(decltype(usbConfigurationDescriptor.m_cdcFunctDescr_CallMgmt)),
-            .m_bDescriptorType      = ::usb::UsbCdcFunctionalDescriptorType_e::e_UsbDec_DescrType_Interface,
-            .m_bDescriptorSubtype   = ::usb::UsbCdcFunctionalDescriptorSubtype_e::e_UsbDec_DescrSubtype_CallMgmt
-        },
-        .m_bmCapabilities           = 0,
-        .m_bDataInterface           = 1 /* usbConfigurationDescriptor.m_dataInterface.m_bInterfaceNumber */
-    },
-    .m_cdcFunctDescr_ACM = {
-        .m_cdcFncDescr = {
-            .m_bFunctionLength      = sizeof(decltype(usbConfigurationDescriptor.m_cdcFunctDescr_ACM)),
-            .m_bDescriptorType      = ::usb::UsbCdcFunctionalDescriptorType_e::e_UsbDec_DescrType_Interface,
-            .m_bDescriptorSubtype   = ::usb::UsbCdcFunctionalDescriptorSubtype_e::e_UsbDec_DescrSubtype_AbstractControlMgmt
-        },
-        .m_bmCapabilities           = 0x2
-    },
-    .m_cdcFunctDescr_Union = {
-        .m_cdcFncDescr = {
-            .m_bFunctionLength      = sizeof(decltype(usbConfigurationDescriptor.m_cdcFunctDescr_Union)),
-            .m_bDescriptorType      = ::usb::UsbCdcFunctionalDescriptorType_e::e_UsbDec_DescrType_Interface,
-            .m_bDescriptorSubtype   = ::usb::UsbCdcFunctionalDescriptorSubtype_e::e_UsbDec_DescrSubtype_Union
-        },
-        .m_bControlInterface        = 0 /* usbConfigurationDescriptor.m_cdcInterface.m_bInterfaceNumber */,
-        .m_subordinateInterface     = {
-            1 /* usbConfigurationDescriptor.m_dataInterface.m_bInterfaceNumber */
-        }
-    },
-    .m_notificationEndpoint = {
-        .m_bLength                  = sizeof(decltype(usbConfigurationDescriptor.m_notificationEndpoint)),
-        .m_bDescriptorType          = ::usb::UsbDescriptorTypeId_e::e_Endpoint,
-        .m_bEndpointAddress         = 0x82,
-        .m_bmAttributes             = 3,    // IRQ
-        .m_wMaxPacketSize = {
-            .m_loByte               = 8,
-            .m_hiByte               = 0
-        },
-        .m_bInterval                = 0xFF
-    },
-    .m_dataInterface = {
-        .m_bLength                  = sizeof(decltype(usbConfigurationDescriptor.m_dataInterface)) - sizeof(usbConfigurationDescriptor.m_dataInterface.m_endpoints),
-        .m_bDescriptorType          = ::usb::UsbDescriptorTypeId_e::e_Interface,
-        .m_bInterfaceNumber         = 1,
-        .m_bAlternateSetting        = 0,
-        .m_bNumEndpoints            = 2,
-        .m_bInterfaceClass          = ::usb::UsbInterfaceClass_e::e_UsbInterface_CdcData,
-        .m_bInterfaceSubClass       = 0,
-        .m_bInterfaceProtocol       = 0,
-        .m_iInterface               = 5, /* Index of m_interface within usbStringDescriptors.m_stringDescriptorTable */
-        .m_endpoints                = {
-            /* Index #0 */ {
-                .m_bLength          = sizeof(decltype(usbConfigurationDescriptor.m_dataInterface.m_endpoints[0])),
-                .m_bDescriptorType  = ::usb::UsbDescriptorTypeId_e::e_Endpoint,
-                .m_bEndpointAddress = 0x01,
-                .m_bmAttributes     = 2,    // Bulk
-                .m_wMaxPacketSize = {
-                    .m_loByte       = 64,
-                    .m_hiByte       = 0
-                },
-                .m_bInterval        = 0
-            },
-            /* Index #1 */ {
-                .m_bLength          = sizeof(decltype(usbConfigurationDescriptor.m_dataInterface.m_endpoints[1])),
-                .m_bDescriptorType  = ::usb::UsbDescriptorTypeId_e::e_Endpoint,
-                .m_bEndpointAddress = 0x81,
-                .m_bmAttributes     = 2,    // Bulk
-                .m_wMaxPacketSize = {
-                    .m_loByte       = 64,
-                    .m_hiByte       = 0
-                },
-                .m_bInterval        = 0
-            }
-        }
-    }
+/*******************************************************************************
+ * USB Configuration Descriptor
+ *
+ * Composed at Compile Time by ::usb::descriptor::configuration(). Interface
+ * Numbers, Lengths and String Indices are computed, Endpoints are shared with
+ * main.cpp via UsbDescriptors.hpp.
+ ******************************************************************************/
+#define USB_STRING_INDEX(m_member)                                                  \
+    static_cast<uint8_t>(offsetof(decltype(usbStringDescriptors.m_strings), m_member)  \
+      / sizeof(usbStringDescriptors.m_strings.m_member))
+
+static constexpr uint8_t usbStringIndexConfiguration    = USB_STRING_INDEX(m_configuration);
+static constexpr uint8_t usbStringIndexInterface        = USB_STRING_INDEX(m_interface);
+
+/*
+ * The Strings of the other Functions come after the Table of usbStringDescriptors,
+ * see ::usb::UsbFunctionStringsDevice.
+ */
+static constexpr uint8_t usbStringIndexLoopback         = usbStringIndexInterface + 1;
+static constexpr uint8_t usbStringIndexIsoLoopback      = usbStringIndexInterface + 2;
+static constexpr uint8_t usbStringIndexDfu              = usbStringIndexInterface + 3;
+
+static const uint8_t * const usbFunctionStringTable[] FIXED_DATA = {
+    usbStringDescriptorLoopback.data(),
+    usbStringDescriptorIsoLoopback.data(),
+    usbStringDescriptorDfu.data()
 };
-#endif /* defined(USB_INTERFACE_VCP) */
 
-#if defined(USB_INTERFACE_VENDOR)
-extern const struct UsbConfigurationDescriptor_s {
-    struct ::usb::UsbConfigurationDescriptorT<void *, 0>    m_configDescrHdr;
-    struct ::usb::UsbInterfaceDescriptorT<2>                m_dataInterface;
-} __attribute__((packed)) usbConfigurationDescriptor FIXED_DATA = {
-    .m_configDescrHdr = {
-        .m_bLength                  = sizeof( decltype(usbConfigurationDescriptor.m_configDescrHdr)),
-        .m_bDescriptorType          = ::usb::UsbDescriptorTypeId_e::e_Configuration,
-        .m_wTotalLength = {
-            .m_loByte               = (sizeof(decltype(usbConfigurationDescriptor)) >> 0),
-            .m_hiByte               = (sizeof(decltype(usbConfigurationDescriptor)) >> 8)
-        },
-        .m_bNumInterfaces           = 1,
-        .m_bConfigurationValue      = 1,
-        .m_iConfiguration           = 4, /* Index of m_configuration within usbStringDescriptors.m_stringDescriptorTable */
-        .m_bmAttributes             = 0x80      // USB 2.0 Spec demands this Bit to always be set
-                                    | 0x40,     // Set to 0x40 for Self-powered Device, 0x00 for Bus-powered
-        .m_bMaxPower                = 5,        // Power consumption in Units of 2mA
-        .m_interfaces               = {}
-    },
-    .m_dataInterface = {
-        .m_bLength                  = sizeof(decltype(usbConfigurationDescriptor.m_dataInterface)) - sizeof(usbConfigurationDescriptor.m_dataInterface.m_endpoints),
-        .m_bDescriptorType          = ::usb::UsbDescriptorTypeId_e::e_Interface,
-        .m_bInterfaceNumber         = 1,
-        .m_bAlternateSetting        = 0,
-        .m_bNumEndpoints            = 2,
-        .m_bInterfaceClass          = ::usb::UsbInterfaceClass_e::e_UsbInterface_VendorSpecific,
-        .m_bInterfaceSubClass       = 0x10, /* Magic Number for Test Code to Identify the Loopback Interface */
-        .m_bInterfaceProtocol       = 0x0b, /* Magic Number for Test Code to Identify the Loopback Interface */
-        .m_iInterface               = 5, /* Index of m_interface within usbStringDescriptors.m_stringDescriptorTable */
-        .m_endpoints                = {
-            /* Index #0 */ {
-                .m_bLength          = sizeof(decltype(usbConfigurationDescriptor.m_dataInterface.m_endpoints[0])),
-                .m_bDescriptorType  = ::usb::UsbDescriptorTypeId_e::e_Endpoint,
-                .m_bEndpointAddress = 0x01,
-                .m_bmAttributes     = 2,    // Bulk
-                .m_wMaxPacketSize = {
-                    .m_loByte       = 64,
-                    .m_hiByte       = 0
-                },
-                .m_bInterval        = 0
-            },
-            /* Index #1 */ {
-                .m_bLength          = sizeof(decltype(usbConfigurationDescriptor.m_dataInterface.m_endpoints[1])),
-                .m_bDescriptorType  = ::usb::UsbDescriptorTypeId_e::e_Endpoint,
-                .m_bEndpointAddress = 0x81,
-                .m_bmAttributes     = 2,    // Bulk
-                .m_wMaxPacketSize = {
-                    .m_loByte       = 64,
-                    .m_hiByte       = 0
-                },
-                .m_bInterval        = 0
-            }
-        }
-    }    
+extern const ::usb::UsbFunctionStrings_t usbFunctionStrings FIXED_DATA = {
+    .m_firstIndex   = usbStringIndexLoopback,
+    .m_numStrings   = sizeof(usbFunctionStringTable) / sizeof(usbFunctionStringTable[0]),
+    .m_strings      = usbFunctionStringTable
 };
+
+#if defined(USB_INTERFACE_VCP)
+static constexpr ::usb::descriptor::CdcAcmFunction usbFunction(
+    usbStringIndexInterface,
+    usbNotificationEndpoint,
+    usbBulkOutEndpoint,
+    usbBulkInEndpoint
+);
+#elif defined(USB_INTERFACE_VENDOR)
+static constexpr ::usb::descriptor::VendorFunction usbFunction(
+    usbStringIndexInterface,
+    0x10, /* Magic Number for Test Code to Identify the Loopback Interface */
+    0x0b, /* Magic Number for Test Code to Identify the Loopback Interface */
+    usbBulkOutEndpoint,
+    usbBulkInEndpoint
+);
+#elif defined(USB_INTERFACE_MSC)
+static constexpr ::usb::descriptor::MassStorageFunction usbFunction(
+    usbStringIndexInterface,
+    usbBulkOutEndpoint,
+    usbBulkInEndpoint
+);
 #endif /* defined(USB_INTERFACE_VENDOR) */
 
+#if defined(USB_COMPOSITE_LOOPBACK)
+static constexpr ::usb::descriptor::VendorFunction usbLoopbackFunction(
+    usbStringIndexLoopback,
+    0x10, /* Magic Number for Test Code to Identify the Loopback Interface */
+    0x0b, /* Magic Number for Test Code to Identify the Loopback Interface */
+    usbLoopbackOutEndpoint,
+    usbLoopbackInEndpoint
+);
+#endif /* defined(USB_COMPOSITE_LOOPBACK) */
+
+#if defined(USB_ISO_LOOPBACK)
+static constexpr ::usb::descriptor::VendorIsochronousFunction usbIsoFunction(
+    usbStringIndexIsoLoopback,
+    0x10, /* Magic Number for Test Code to Identify the Isochronous Loopback Interface */
+    0x1c, /* Magic Number for Test Code to Identify the Isochronous Loopback Interface */
+    usbIsoOutEndpoint,
+    usbIsoInEndpoint
+);
+#endif /* defined(USB_ISO_LOOPBACK) */
+
+#if defined(USB_DFU)
+static constexpr ::usb::descriptor::DfuFunction usbDfuFunction(
+    usbStringIndexDfu,
+    usbDfuTransferSize
+);
+#endif /* defined(USB_DFU) */
+
+/* The DFU Interface comes after those of all other Functions */
+static constexpr auto usbFunctions = ::usb::descriptor::functions(
+    usbFunction
+#if defined(USB_COMPOSITE_LOOPBACK)
+    , usbLoopbackFunction
+#endif /* defined(USB_COMPOSITE_LOOPBACK) */
+#if defined(USB_ISO_LOOPBACK)
+    , usbIsoFunction
+#endif /* defined(USB_ISO_LOOPBACK) */
+#if defined(USB_DFU)
+    , usbDfuFunction
+#endif /* defined(USB_DFU) */
+);
+
+static_assert(::usb::descriptor::hasValidEndpoints<usbNumHwEndpoints>(usbFunctions), "Invalid or duplicate Endpoint");
+
+static constexpr auto usbConfigurationDescriptorData = ::usb::descriptor::configuration(
+    /* p_bConfigurationValue = */ 1,
+    usbStringIndexConfiguration,
+    /* p_bmAttributes = */ usbConfigurationAttributes,
+    /* p_bMaxPower = */ 5,          // Power consumption in Units of 2mA
+    usbFunctions
+);
+
+extern const decltype(usbConfigurationDescriptorData) usbConfigurationDescriptor FIXED_DATA = usbConfigurationDescriptorData;
+
+/*******************************************************************************
+ * USB Interface Numbers, see UsbDescriptors.hpp
+ ******************************************************************************/
+#if defined(USB_INTERFACE_VCP)
+extern const uint8_t usbCdcInterfaceNumber = ::usb::descriptor::getInterfaceNumber(usbFunction, usbFunctions);
+#endif /* defined(USB_INTERFACE_VCP) */
+
+#if defined(USB_ISO_LOOPBACK)
+extern const uint8_t usbIsoInterfaceNumber = ::usb::descriptor::getInterfaceNumber(usbIsoFunction, usbFunctions);
+#endif /* defined(USB_ISO_LOOPBACK) */
+
+#if defined(USB_DFU)
+extern const uint8_t usbDfuInterfaceNumber = ::usb::descriptor::getInterfaceNumber(usbDfuFunction, usbFunctions);
+#endif /* defined(USB_DFU) */
+
 
 #if defined(__cplusplus)
 } /* extern "C" */
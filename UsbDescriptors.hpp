@@ -0,0 +1,66 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _USB_DESCRIPTORS_HPP_5A7C2E19_
+#define _USB_DESCRIPTORS_HPP_5A7C2E19_
+
+#include <usb/UsbDescriptorBuilder.hpp>
+
+/*******************************************************************************
+ * USB Endpoints
+ *
+ * Used by UsbDescriptors.cpp to build the Configuration Descriptor and by
+ * main.cpp to set up the matching Hardware Endpoints.
+ ******************************************************************************/
+static constexpr unsigned usbNumHwEndpoints = 4;    /* OTG_FS: EP0 plus three IN and three OUT Endpoints */
+static constexpr uint8_t  usbCtrlMaxPacketSize = 64; /* EP0 */
+
+/* Self-powered (0x40) with Remote Wakeup (0x20), see UsbSuspendViaSTM32F4 in main.cpp */
+static constexpr uint8_t  usbConfigurationRemoteWakeup  = 0x20;
+static constexpr uint8_t  usbConfigurationAttributes    = 0x40 | usbConfigurationRemoteWakeup;
+
+static constexpr ::usb::descriptor::Endpoint_t usbBulkOutEndpoint       = ::usb::descriptor::bulkOut(1, 64);
+static constexpr ::usb::descriptor::Endpoint_t usbBulkInEndpoint        = ::usb::descriptor::bulkIn(1, 64);
+/* CDC SERIAL_STATE (10 Bytes) fits into a single Packet; polled every 16 ms */
+static constexpr ::usb::descriptor::Endpoint_t usbNotificationEndpoint  = ::usb::descriptor::interruptIn(2, 16, 16);
+
+/* Only used with USB_COMPOSITE_LOOPBACK: Bulk Pair of the second, independent Loopback Function */
+static constexpr ::usb::descriptor::Endpoint_t usbLoopbackOutEndpoint   = ::usb::descriptor::bulkOut(2, 64);
+static constexpr ::usb::descriptor::Endpoint_t usbLoopbackInEndpoint    = ::usb::descriptor::bulkIn(3, 64);
+
+/* Only used with USB_ISO_LOOPBACK: 256 Bytes per Frame, i.e. 256 KB/s in each Direction */
+static constexpr ::usb::descriptor::Endpoint_t usbIsoOutEndpoint        = ::usb::descriptor::isochronousOut(3, 256);
+static constexpr ::usb::descriptor::Endpoint_t usbIsoInEndpoint         = ::usb::descriptor::isochronousIn(3, 256);
+
+/* Only used with USB_DFU: 1 KB Blocks (16 Packets on EP0) */
+static constexpr uint16_t usbDfuTransferSize     = 1024;
+
+/*******************************************************************************
+ * USB Interface Numbers
+ *
+ * Derived from the Functions of the Configuration in UsbDescriptors.cpp, see
+ * ::usb::descriptor::getInterfaceNumber().
+ ******************************************************************************/
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+#if defined(USB_INTERFACE_VCP)
+/* Communication Interface of the CDC Function, the Recipient of SERIAL_STATE */
+extern const uint8_t usbCdcInterfaceNumber;
+#endif /* defined(USB_INTERFACE_VCP) */
+
+#if defined(USB_ISO_LOOPBACK)
+/* Selects the Isochronous Endpoints via its Alternate Setting 1 */
+extern const uint8_t usbIsoInterfaceNumber;
+#endif /* defined(USB_ISO_LOOPBACK) */
+
+#if defined(USB_DFU)
+extern const uint8_t usbDfuInterfaceNumber;
+#endif /* defined(USB_DFU) */
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* _USB_DESCRIPTORS_HPP_5A7C2E19_ */
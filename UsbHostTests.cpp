@@ -0,0 +1,943 @@
+/*-
+ * $Copyright$
+-*/
+
+/*******************************************************************************
+ * Host Tests of the USB Device: The Firmware runs against the Register Model
+ * of the OTG Core (stm32::usb::OtgFsRegisterModel) and a simulated Host
+ * (usb::UsbHostSimulation) drives it through one Phase per configured
+ * Function. The Exit Code is zero only if all Phases pass, so ctest can run it.
+ *
+ * The Tests are linked against main.cpp, which is built with USB_HOST_TESTS
+ * to leave out the Firmware's main(). They reach the Device's Objects through
+ * main.hpp.
+ ******************************************************************************/
+#if !defined(HOSTBUILD)
+#error The USB Host Tests require the Host Build.
+#endif /* !defined(HOSTBUILD) */
+
+#include "main.hpp"
+
+#include <usb/UsbHostSimulation.hpp>
+#include <usb/UsbCdcSerialState.hpp>
+#include <usb/UsbMassStorage.hpp>
+#include <usb/UsbDfu.hpp>
+#include <usb/UsbVendorTaskStatsInterface.hpp>
+#include <usb/UsbVendorIrqProfileInterface.hpp>
+#include <usb/IrqProfilerViaSTM32F4.hpp>
+#include <stm32/CycleCounter.hpp>
+
+#include <cstdio>
+#include <cstring>
+
+#if defined(USB_INTERFACE_VCP)
+/*******************************************************************************
+ * Host receives the initial Line State and then one Notification for a Burst of
+ * UART Errors. SET_CONFIGURATION resets the Notification Endpoint.
+ ******************************************************************************/
+static bool
+testSerialState(usb::UsbHostSimulation &p_usbHost) {
+    usb::UsbCdcSerialStateNotification_t notification;
+    size_t length;
+
+    otgFsModel.resetStatistics();
+
+    /* Initial Line State, then one Notification for a Burst of Errors */
+    if (!p_usbHost.interruptIn(usbNotificationEndpoint.getNumber(), 2 * usbNotificationEndpoint.m_bInterval, &notification, sizeof(notification), length)
+      || (length != sizeof(notification)) || (notification.m_bNotification != usb::e_UsbCdcNotification_SerialState)
+      || (notification.m_bmUartState[0] != usbSerialState.getLineState())) {
+        ::printf("FAIL: No initial SERIAL_STATE Notification\n");
+        return (false);
+    }
+
+    usbSerialState.reportEvents(usb::e_UsbCdcSerialState_OverRun);
+    usbSerialState.reportEvents(usb::e_UsbCdcSerialState_Framing);
+    usbSerialState.reportEvents(usb::e_UsbCdcSerialState_OverRun);
+
+    if (!p_usbHost.interruptIn(usbNotificationEndpoint.getNumber(), 2 * usbNotificationEndpoint.m_bInterval, &notification, sizeof(notification), length)
+      || (notification.m_bmUartState[0] != (usbSerialState.getLineState() | usb::e_UsbCdcSerialState_OverRun | usb::e_UsbCdcSerialState_Framing))) {
+        ::printf("FAIL: UART Errors were not reported via SERIAL_STATE\n");
+        return (false);
+    }
+
+    if (p_usbHost.interruptIn(usbNotificationEndpoint.getNumber(), 2 * usbNotificationEndpoint.m_bInterval, &notification, sizeof(notification), length)) {
+        ::printf("FAIL: UART Errors were not coalesced into a single SERIAL_STATE Notification\n");
+        return (false);
+    }
+
+    /* A Notification loaded before SET_CONFIGURATION is stale and must be discarded */
+    usbSerialState.reportEvents(usb::e_UsbCdcSerialState_Parity);
+    otgFsModel.sof();
+    if (!p_usbHost.controlWrite(0x00, 0x09, 1, 0, nullptr, 0)) {
+        ::printf("FAIL: SET_CONFIGURATION failed\n");
+        return (false);
+    }
+    if (p_usbHost.interruptIn(usbNotificationEndpoint.getNumber(), 2 * usbNotificationEndpoint.m_bInterval, &notification, sizeof(notification), length)) {
+        ::printf("FAIL: SERIAL_STATE Notification survived SET_CONFIGURATION\n");
+        return (false);
+    }
+
+    /* The re-configured Endpoint carries Notifications again */
+    usbSerialState.reportEvents(usb::e_UsbCdcSerialState_Break);
+    if (!p_usbHost.interruptIn(usbNotificationEndpoint.getNumber(), 2 * usbNotificationEndpoint.m_bInterval, &notification, sizeof(notification), length)
+      || (notification.m_bmUartState[0] != (usbSerialState.getLineState() | usb::e_UsbCdcSerialState_Break))) {
+        ::printf("FAIL: No SERIAL_STATE Notification after SET_CONFIGURATION\n");
+        return (false);
+    }
+    p_usbHost.printStatistics("Serial State");
+
+    return (true);
+}
+#endif /* defined(USB_INTERFACE_VCP) */
+
+#if defined(USB_APPLICATION_LOOPBACK)
+/*******************************************************************************
+ * Loopback Transfers of several Sizes through the Ring.
+ ******************************************************************************/
+static bool
+testLoopback(usb::UsbHostSimulation &p_usbHost) {
+    for (const size_t transferSz : { 64, 4 * 1024, 16 * 1024 }) {
+        char phase[32];
+
+        otgFsModel.resetStatistics();
+        if (!p_usbHost.bulkLoopback(1, transferSz, 16)) {
+            return (false);
+        }
+
+        ::snprintf(phase, sizeof(phase), "Loopback (%zu Bytes)", transferSz);
+        p_usbHost.printStatistics(phase);
+    }
+
+    /* Throughput: the IRQ Handler must keep up with a saturated Full Speed Bus, i.e. 19 Bulk Packets per Frame */
+    static constexpr double minPacketsPerSecond = 19 * 1000;
+
+    otgFsModel.resetStatistics();
+    if (!p_usbHost.bulkLoopback(1, 16 * 1024, 256)) {
+        return (false);
+    }
+    p_usbHost.printStatistics("Loopback Throughput");
+
+    if (p_usbHost.getPacketsPerSecond() < minPacketsPerSecond) {
+        ::printf("FAIL: Loopback Throughput of %.0f Packets/s is below %.0f Packets/s\n", p_usbHost.getPacketsPerSecond(), minPacketsPerSecond);
+        return (false);
+    }
+
+    return (true);
+}
+#endif /* defined(USB_APPLICATION_LOOPBACK) */
+
+#if defined(USB_FRAMED_STREAM)
+/*******************************************************************************
+ * Frames with Gaps, Reordering and a bad CRC; checks the per-Stream Counters.
+ ******************************************************************************/
+static bool
+testFramedStream(usb::UsbHostSimulation &p_usbHost) {
+    /* Table-driven CRC against a bitwise Reference and the Value the STM32 CRC Unit computes */
+    uint32_t reference = stm32::SoftwareCrc::m_initialValue ^ 0x12345678;
+    for (unsigned bit = 0; bit < 32; bit++) {
+        reference = (reference & 0x80000000) ? ((reference << 1) ^ stm32::SoftwareCrc::m_polynomial) : (reference << 1);
+    }
+
+    const uint32_t word = 0x12345678;
+    if ((stm32::SoftwareCrc::compute(&word, 1) != reference) || (reference != 0xDF8A8A2B)) {
+        ::printf("FAIL: Software CRC does not match the CRC Unit\n");
+        return (false);
+    }
+
+    /* Frames are sent as single Transfers; no Frame Length is a Multiple of the Packet Size */
+    static uint32_t frame[(sizeof(usb::UsbFrameHeader_t) + 1024 + sizeof(uint32_t)) / sizeof(uint32_t)];
+    const struct {
+        uint8_t     m_stream;
+        uint16_t    m_sequence;
+        uint32_t    m_length;
+        bool        m_corrupt;
+    } frames[] = {
+        { 0, 0, 100, false },   /* Sets the Sequence */
+        { 0, 1, 37, false },
+        { 0, 4, 1000, false },  /* Two Frames missing */
+        { 0, 2, 0, false },     /* Out of Order */
+        { 0, 5, 301, false },
+        { 1, 0xFFFF, 64, false },
+        { 1, 0, 200, true },    /* CRC Error */
+        { 1, 1, 3, false },     /* Sequence wraps around, Frame 0 counts as missing */
+    };
+
+    otgFsModel.resetStatistics();
+    usbFramedStream.resetStatistics();
+
+    for (const auto &f : frames) {
+        const usb::UsbFrameHeader_t header = { usb::e_UsbFrameMagic, f.m_stream, f.m_sequence, f.m_length };
+        uint8_t * const payload = reinterpret_cast<uint8_t *>(frame) + sizeof(header);
+        const size_t numWords = (sizeof(header) + f.m_length + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+        ::memset(frame, 0, sizeof(frame));
+        ::memcpy(frame, &header, sizeof(header));
+        for (size_t idx = 0; idx < f.m_length; idx++) {
+            payload[idx] = static_cast<uint8_t>(idx + f.m_sequence);
+        }
+        frame[numWords] = stm32::SoftwareCrc::compute(frame, numWords) ^ (f.m_corrupt ? 1 : 0);
+
+        if (!p_usbHost.bulkLoopback(usbBulkOutEndpoint.getNumber(), usbBulkInEndpoint.getNumber(), frame, (numWords + 1) * sizeof(uint32_t))) {
+            return (false);
+        }
+    }
+
+    /* A Packet without a valid Header */
+    ::memset(frame, 0x5A, 20);
+    if (!p_usbHost.bulkLoopback(usbBulkOutEndpoint.getNumber(), usbBulkInEndpoint.getNumber(), frame, 20)) {
+        return (false);
+    }
+    p_usbHost.printStatistics("Framed Stream");
+
+    const auto &statistics = usbFramedStream.getStatistics();
+    if ((statistics.m_numBadHeaders != 1)
+      || (statistics.m_streams[0].m_numFrames != 5) || (statistics.m_streams[0].m_numDropped != 2)
+      || (statistics.m_streams[0].m_numOutOfOrder != 1) || (statistics.m_streams[0].m_numCrcErrors != 0)
+      || (statistics.m_streams[1].m_numFrames != 2) || (statistics.m_streams[1].m_numDropped != 1)
+      || (statistics.m_streams[1].m_numOutOfOrder != 0) || (statistics.m_streams[1].m_numCrcErrors != 1)) {
+        ::printf("FAIL: Framed Stream Counters do not match the Frames sent\n");
+        return (false);
+    }
+    ::printf("Framed Stream: OK\n");
+
+    return (true);
+}
+#endif /* defined(USB_FRAMED_STREAM) */
+
+#if defined(USB_INTERFACE_MSC)
+/*******************************************************************************
+ * SCSI Commands over the Bulk-Only Transport, incl. the Error Cases.
+ ******************************************************************************/
+static bool
+testMassStorage(usb::UsbHostSimulation &p_usbHost) {
+    static uint8_t      pattern[16 * 1024];
+    static uint8_t      data[16 * 1024];
+    usb::UsbMscCsw_t    csw = {};
+    uint32_t            tag = 0;
+
+    /* One Command through CBW, Data Stage and CSW; returns the CSW Status or -1 on a Transport Error */
+    auto scsi = [&](const uint8_t * const p_cdb, const size_t p_cdbLength, const bool p_isIn, void * const p_data, const uint32_t p_length) -> int {
+        usb::UsbMscCbw_t cbw = {};
+        size_t received;
+
+        cbw.m_dCBWSignature             = usb::e_UsbMscSignature_Cbw;
+        cbw.m_dCBWTag                   = ++tag;
+        cbw.m_dCBWDataTransferLength    = p_length;
+        cbw.m_bmCBWFlags                = p_isIn ? 0x80 : 0x00;
+        cbw.m_bCBWCBLength              = p_cdbLength;
+        ::memcpy(cbw.m_CBWCB, p_cdb, p_cdbLength);
+
+        if (!p_usbHost.bulkWrite(usbBulkOutEndpoint.getNumber(), &cbw, sizeof(cbw))) {
+            return -1;
+        }
+        if ((p_length > 0) && p_isIn && (!p_usbHost.bulkRead(usbBulkInEndpoint.getNumber(), p_data, p_length, received) || (received != p_length))) {
+            return -1;
+        }
+        if ((p_length > 0) && !p_isIn && !p_usbHost.bulkWrite(usbBulkOutEndpoint.getNumber(), p_data, p_length)) {
+            return -1;
+        }
+        if (!p_usbHost.bulkRead(usbBulkInEndpoint.getNumber(), &csw, sizeof(csw), received) || (received != sizeof(csw))
+          || (csw.m_dCSWSignature != usb::e_UsbMscSignature_Csw) || (csw.m_dCSWTag != tag)) {
+            return -1;
+        }
+        return csw.m_bCSWStatus;
+    };
+
+    auto readWrite10 = [&](const uint8_t p_opcode, const uint32_t p_lba, const uint16_t p_numBlocks, void * const p_data) -> int {
+        const uint8_t cdb[10] = {
+            p_opcode, 0,
+            static_cast<uint8_t>(p_lba >> 24), static_cast<uint8_t>(p_lba >> 16), static_cast<uint8_t>(p_lba >> 8), static_cast<uint8_t>(p_lba),
+            0,
+            static_cast<uint8_t>(p_numBlocks >> 8), static_cast<uint8_t>(p_numBlocks),
+            0
+        };
+
+        return scsi(cdb, sizeof(cdb), p_opcode == usb::e_UsbScsiOpcode_Read10, p_data, p_numBlocks * usb::UsbBlockDevice::m_blockSz);
+    };
+
+    const uint8_t inquiry[6]        = { usb::e_UsbScsiOpcode_Inquiry, 0, 0, 0, 36, 0 };
+    const uint8_t testUnitReady[6]  = { usb::e_UsbScsiOpcode_TestUnitReady, 0, 0, 0, 0, 0 };
+    const uint8_t readCapacity[10]  = { usb::e_UsbScsiOpcode_ReadCapacity10, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+    const uint8_t requestSense[6]   = { usb::e_UsbScsiOpcode_RequestSense, 0, 0, 0, 18, 0 };
+    const uint8_t invalid[6]        = { 0xFF, 0, 0, 0, 0, 0 };
+
+    if ((scsi(inquiry, sizeof(inquiry), true, data, 36) != usb::e_UsbMscStatus_Passed) || (data[0] != 0x00) || (data[1] != 0x80)
+      || (scsi(testUnitReady, sizeof(testUnitReady), false, nullptr, 0) != usb::e_UsbMscStatus_Passed)
+      || (scsi(readCapacity, sizeof(readCapacity), true, data, 8) != usb::e_UsbMscStatus_Passed)
+      || (static_cast<uint32_t>((data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3]) != (usbMscDisk.getNumBlocks() - 1))
+      || (static_cast<uint32_t>((data[4] << 24) | (data[5] << 16) | (data[6] << 8) | data[7]) != usb::UsbBlockDevice::m_blockSz)) {
+        ::printf("FAIL: Mass Storage did not identify itself\n");
+        return (false);
+    }
+
+    for (size_t idx = 0; idx < sizeof(pattern); idx++) {
+        pattern[idx] = static_cast<uint8_t>(idx ^ (idx >> 8));
+    }
+
+    /* WRITE(10) lands in the RAM Disk straight from the RX FIFO, READ(10) is sent straight from it */
+    otgFsModel.resetStatistics();
+    if ((readWrite10(usb::e_UsbScsiOpcode_Write10, 16, 32, pattern) != usb::e_UsbMscStatus_Passed) || (csw.m_dCSWDataResidue != 0)
+      || ::memcmp(usbMscDisk.map(16), pattern, sizeof(pattern))) {
+        ::printf("FAIL: Mass Storage WRITE(10) did not reach the Disk\n");
+        return (false);
+    }
+    p_usbHost.printStatistics("Mass Storage WRITE(10) (16 KB)");
+
+    otgFsModel.resetStatistics();
+    if ((readWrite10(usb::e_UsbScsiOpcode_Read10, 16, 32, data) != usb::e_UsbMscStatus_Passed) || (csw.m_dCSWDataResidue != 0)
+      || ::memcmp(data, pattern, sizeof(pattern))) {
+        ::printf("FAIL: Mass Storage READ(10) returned wrong Data\n");
+        return (false);
+    }
+    p_usbHost.printStatistics("Mass Storage READ(10) (16 KB)");
+
+    /* Beyond the End of the Disk: Data Stage is padded, Sense tells why */
+    if ((readWrite10(usb::e_UsbScsiOpcode_Read10, usbMscDisk.getNumBlocks() - 4, 8, data) != usb::e_UsbMscStatus_Failed)
+      || (csw.m_dCSWDataResidue != 8 * usb::UsbBlockDevice::m_blockSz)
+      || (scsi(requestSense, sizeof(requestSense), true, data, 18) != usb::e_UsbMscStatus_Passed)
+      || (data[2] != usb::e_UsbScsiSenseKey_IllegalRequest) || (data[12] != usb::e_UsbScsiAsc_LbaOutOfRange)
+      || (scsi(invalid, sizeof(invalid), false, nullptr, 0) != usb::e_UsbMscStatus_Failed)
+      || (scsi(requestSense, sizeof(requestSense), true, data, 18) != usb::e_UsbMscStatus_Passed)
+      || (data[2] != usb::e_UsbScsiSenseKey_IllegalRequest) || (data[12] != usb::e_UsbScsiAsc_InvalidOpcode)
+      || (scsi(testUnitReady, sizeof(testUnitReady), false, nullptr, 0) != usb::e_UsbMscStatus_Passed)) {
+        ::printf("FAIL: Mass Storage did not report Errors via REQUEST SENSE\n");
+        return (false);
+    }
+
+    /* Host ends WRITE(10) of two Blocks with a short Packet after 100 Bytes: Residue counts the Rest */
+    const usb::UsbMscCbw_t  shortWrite = { usb::e_UsbMscSignature_Cbw, ++tag, 2 * usb::UsbBlockDevice::m_blockSz, 0x00, 0, 10,
+                              { usb::e_UsbScsiOpcode_Write10, 0, 0, 0, 0, 48, 0, 0, 2, 0 } };
+    size_t                  length;
+
+    if (!p_usbHost.bulkWrite(usbBulkOutEndpoint.getNumber(), &shortWrite, sizeof(shortWrite))
+      || !p_usbHost.bulkWrite(usbBulkOutEndpoint.getNumber(), pattern, 100)
+      || !p_usbHost.bulkRead(usbBulkInEndpoint.getNumber(), &csw, sizeof(csw), length) || (length != sizeof(csw))
+      || (csw.m_dCSWTag != tag) || (csw.m_dCSWDataResidue != (2 * usb::UsbBlockDevice::m_blockSz - 100))
+      || ::memcmp(usbMscDisk.map(48), pattern, 100)) {
+        ::printf("FAIL: Mass Storage reported the wrong Residue for short OUT Data\n");
+        return (false);
+    }
+
+    /* A short CBW halts both Bulk Endpoints until the Reset Recovery, see BOT 1.0, Section 6.6.1 */
+    const usb::UsbMscCbw_t  shortCbw = { usb::e_UsbMscSignature_Cbw, ++tag, 0, 0x00, 0, 6, {} };
+
+    if ((otgFsModel.out(usbBulkOutEndpoint.getNumber(), &shortCbw, sizeof(shortCbw) - 1) != usb::UsbHostSimulation::Handshake_t::e_Ack)
+      || (otgFsModel.in(usbBulkInEndpoint.getNumber(), &csw, sizeof(csw), length) != usb::UsbHostSimulation::Handshake_t::e_Stall)
+      || (otgFsModel.out(usbBulkOutEndpoint.getNumber(), &shortCbw, sizeof(shortCbw)) != usb::UsbHostSimulation::Handshake_t::e_Stall)) {
+        ::printf("FAIL: Mass Storage did not halt the Bulk Endpoints on an invalid CBW\n");
+        return (false);
+    }
+
+    /* Reset Recovery: BULK_ONLY_MASS_STORAGE_RESET, then CLEAR_FEATURE(ENDPOINT_HALT) on Bulk IN and Bulk OUT */
+    if (!p_usbHost.controlWrite(0x21, usb::e_UsbMscRequest_BulkOnlyReset, 0, 0, nullptr, 0)
+      || (otgFsModel.in(usbBulkInEndpoint.getNumber(), &csw, sizeof(csw), length) != usb::UsbHostSimulation::Handshake_t::e_Stall)
+      || !p_usbHost.controlWrite(0x02, 0x01, 0, 0x80 | usbBulkInEndpoint.getNumber(), nullptr, 0)
+      || !p_usbHost.controlWrite(0x02, 0x01, 0, usbBulkOutEndpoint.getNumber(), nullptr, 0)
+      || (scsi(testUnitReady, sizeof(testUnitReady), false, nullptr, 0) != usb::e_UsbMscStatus_Passed)) {
+        ::printf("FAIL: Mass Storage did not recover from an invalid CBW\n");
+        return (false);
+    }
+    ::printf("Mass Storage: OK\n");
+
+    return (true);
+}
+#endif /* defined(USB_INTERFACE_MSC) */
+
+#if defined(USB_DFU)
+/*******************************************************************************
+ * DFU Download into the Mock Flash, Upload and a Verify Error.
+ ******************************************************************************/
+static bool
+testDfu(usb::UsbHostSimulation &p_usbHost) {
+    /* Spans three Sectors; the last Block is short and not a Multiple of four Bytes */
+    static uint8_t              image[300 * 1024 + 123];
+    static uint8_t              block[usbDfuTransferSize];
+    usb::UsbDfuStatusReport_t   status = {};
+    size_t                      received;
+    uint64_t                    elapsedInUs = 0;
+    unsigned                    numBusy = 0;
+
+    /* Each Request takes about a Millisecond on the Bus; then the Host sleeps for the Poll Timeout */
+    auto wait = [&](const uint32_t p_timeInUs) {
+        usbDfuFlash.advance(p_timeInUs);
+        elapsedInUs += p_timeInUs;
+    };
+
+    auto getStatus = [&]() -> bool {
+        if (!p_usbHost.controlRead(0xA1, usb::e_UsbDfuRequest_GetStatus, 0, usbDfuInterfaceNumber, &status, sizeof(status), received)
+          || (received != sizeof(status))) {
+            return false;
+        }
+        wait(1000 + status.getPollTimeout() * 1000);
+        return true;
+    };
+
+    auto download = [&](const uint8_t * const p_image, const size_t p_length) -> bool {
+        uint16_t blockNum = 0;
+
+        for (size_t offs = 0; offs < p_length; offs += usbDfuTransferSize, blockNum++) {
+            const uint16_t length = ((p_length - offs) < usbDfuTransferSize) ? (p_length - offs) : usbDfuTransferSize;
+
+            if (!p_usbHost.controlWrite(0x21, usb::e_UsbDfuRequest_Dnload, blockNum, usbDfuInterfaceNumber, &p_image[offs], length)) {
+                return false;
+            }
+            wait(1000);
+
+            do {
+                if (!getStatus()) {
+                    return false;
+                }
+                numBusy += (status.m_bState == usb::e_UsbDfuState_DnBusy) ? 1 : 0;
+            } while (status.m_bState == usb::e_UsbDfuState_DnBusy);
+
+            if (status.m_bState != usb::e_UsbDfuState_DnloadIdle) {
+                return true;
+            }
+        }
+
+        if (!p_usbHost.controlWrite(0x21, usb::e_UsbDfuRequest_Dnload, blockNum, usbDfuInterfaceNumber, nullptr, 0)) {
+            return false;
+        }
+
+        do {
+            if (!getStatus()) {
+                return false;
+            }
+        } while (status.m_bState == usb::e_UsbDfuState_Manifest);
+
+        return true;
+    };
+
+    for (size_t idx = 0; idx < sizeof(image); idx++) {
+        image[idx] = static_cast<uint8_t>((idx * 7) ^ (idx >> 10));
+    }
+
+    otgFsModel.resetStatistics();
+    if (!download(image, sizeof(image))
+      || (status.m_bState != usb::e_UsbDfuState_DfuIdle) || (status.m_bStatus != usb::e_UsbDfuStatus_Ok)
+      || ::memcmp(usbDfuFlash.map(usbDfuSlotOffset), image, sizeof(image))) {
+        ::printf("FAIL: DFU Download did not reach the Flash (State %u, Status %u)\n", status.m_bState, status.m_bStatus);
+        return (false);
+    }
+    p_usbHost.printStatistics("DFU Download (300 KB)");
+    ::printf("DFU Download (300 KB): %u Busy Polls, Flash busy for %lu of %lu ms\n", numBusy,
+      static_cast<unsigned long>(usbDfuFlash.getBusyTimeInUs() / 1000), static_cast<unsigned long>(elapsedInUs / 1000));
+
+    /* Read the Image back, then leave the Upload early */
+    for (size_t offs = 0; offs < sizeof(image); offs += usbDfuTransferSize) {
+        const size_t length = ((sizeof(image) - offs) < usbDfuTransferSize) ? (sizeof(image) - offs) : usbDfuTransferSize;
+
+        if (!p_usbHost.controlRead(0xA1, usb::e_UsbDfuRequest_Upload, offs / usbDfuTransferSize, usbDfuInterfaceNumber, block, usbDfuTransferSize, received)
+          || (received != usbDfuTransferSize) || ::memcmp(block, &image[offs], length)) {
+            ::printf("FAIL: DFU Upload returned wrong Data at Offset %zu\n", offs);
+            return (false);
+        }
+    }
+
+    uint8_t state = 0;
+    if (!p_usbHost.controlWrite(0x21, usb::e_UsbDfuRequest_Abort, 0, usbDfuInterfaceNumber, nullptr, 0)
+      || !p_usbHost.controlRead(0xA1, usb::e_UsbDfuRequest_GetState, 0, usbDfuInterfaceNumber, &state, sizeof(state), received)
+      || (state != usb::e_UsbDfuState_DfuIdle)) {
+        ::printf("FAIL: DFU Abort did not end the Upload\n");
+        return (false);
+    }
+
+    /* A Word that does not program must end the Download in dfuERROR, which DFU_CLRSTATUS clears */
+    usbDfuFlash.setBadWord(usbDfuSlotOffset + 2 * usbDfuTransferSize + 64);
+    if (!download(image, 4 * usbDfuTransferSize)
+      || (status.m_bState != usb::e_UsbDfuState_Error) || (status.m_bStatus != usb::e_UsbDfuStatus_ErrVerify)
+      || !p_usbHost.controlWrite(0x21, usb::e_UsbDfuRequest_ClrStatus, 0, usbDfuInterfaceNumber, nullptr, 0)
+      || !p_usbHost.controlRead(0xA1, usb::e_UsbDfuRequest_GetState, 0, usbDfuInterfaceNumber, &state, sizeof(state), received)
+      || (state != usb::e_UsbDfuState_DfuIdle)) {
+        ::printf("FAIL: DFU did not report a Verify Error (State %u, Status %u)\n", status.m_bState, status.m_bStatus);
+        return (false);
+    }
+    usbDfuFlash.setBadWord(~static_cast<size_t>(0));
+
+    /* Only the empty DFU_DNLOAD may follow a short Block; another Data Block ends in errSTALLEDPKT */
+    if (!p_usbHost.controlWrite(0x21, usb::e_UsbDfuRequest_Dnload, 0, usbDfuInterfaceNumber, image, 100)
+      || !getStatus() || (status.m_bState != usb::e_UsbDfuState_DnloadIdle)
+      || p_usbHost.controlWrite(0x21, usb::e_UsbDfuRequest_Dnload, 1, usbDfuInterfaceNumber, image, usbDfuTransferSize)
+      || !getStatus() || (status.m_bState != usb::e_UsbDfuState_Error) || (status.m_bStatus != usb::e_UsbDfuStatus_ErrStalledPkt)
+      || !p_usbHost.controlWrite(0x21, usb::e_UsbDfuRequest_ClrStatus, 0, usbDfuInterfaceNumber, nullptr, 0)) {
+        ::printf("FAIL: DFU accepted a Data Block after a short Block (State %u, Status %u)\n", status.m_bState, status.m_bStatus);
+        return (false);
+    }
+    ::printf("DFU: OK\n");
+
+    return (true);
+}
+#endif /* defined(USB_DFU) */
+
+#if defined(USB_COMPOSITE_LOOPBACK)
+/*******************************************************************************
+ * Loopback Transfers through the second Interface. SET_CONFIGURATION drops a
+ * pending IN Transfer without stalling the Loopback.
+ ******************************************************************************/
+static bool
+testCompositeLoopback(usb::UsbHostSimulation &p_usbHost) {
+    static const uint8_t    packet[usbLoopbackOutEndpoint.m_wMaxPacketSize / 2] = { 0x5A };
+    uint8_t                 echo[usbLoopbackInEndpoint.m_wMaxPacketSize];
+    size_t                  length;
+
+    if (!p_usbHost.bulkWrite(usbLoopbackOutEndpoint.getNumber(), packet, sizeof(packet))
+      || !p_usbHost.controlWrite(0x00, 0x09, 1, 0, nullptr, 0)
+      || (otgFsModel.in(usbLoopbackInEndpoint.getNumber(), echo, sizeof(echo), length) != usb::UsbHostSimulation::Handshake_t::e_Nak)) {
+        ::printf("FAIL: Loopback IN Transfer survived SET_CONFIGURATION\n");
+        return (false);
+    }
+
+    for (const size_t transferSz : { 1000, 3000 }) {
+        char phase[48];
+
+        otgFsModel.resetStatistics();
+        if (!p_usbHost.bulkLoopback(usbLoopbackOutEndpoint.getNumber(), usbLoopbackInEndpoint.getNumber(), transferSz, 16)) {
+            return (false);
+        }
+
+        ::snprintf(phase, sizeof(phase), "Composite Loopback (%zu Bytes)", transferSz);
+        p_usbHost.printStatistics(phase);
+    }
+
+    return (true);
+}
+#endif /* defined(USB_COMPOSITE_LOOPBACK) */
+
+#if defined(USB_ISO_LOOPBACK)
+/*******************************************************************************
+ * Whether the Host can send a Packet on the isochronous OUT Endpoint.
+ ******************************************************************************/
+static bool
+isIsoOutArmed(void) {
+    static uint8_t packet[usbIsoOutEndpoint.m_wMaxPacketSize];
+
+    otgFsModel.sof();
+    return (otgFsModel.out(usbIsoOutEndpoint.getNumber(), packet, sizeof(packet)) == usb::UsbHostSimulation::Handshake_t::e_Ack);
+}
+
+/*******************************************************************************
+ * Selects the Alternate Setting of the isochronous Interface and reads it back.
+ ******************************************************************************/
+static bool
+setIsoAlternateSetting(usb::UsbHostSimulation &p_usbHost, const uint8_t p_alternateSetting) {
+    uint8_t alternateSetting = 0xFF;
+    size_t received;
+
+    return p_usbHost.controlWrite(0x01, 0x0B, p_alternateSetting, usbIsoInterfaceNumber, nullptr, 0)
+      && p_usbHost.controlRead(0x81, 0x0A, 0, usbIsoInterfaceNumber, &alternateSetting, sizeof(alternateSetting), received)
+      && (received == sizeof(alternateSetting)) && (alternateSetting == p_alternateSetting);
+}
+
+/*******************************************************************************
+ * The isochronous Pair only exists in Alternate Setting 1. Then 1000 Frames
+ * through the Pair; not a single Frame may be missed.
+ ******************************************************************************/
+static bool
+testIsoLoopback(usb::UsbHostSimulation &p_usbHost) {
+    uint8_t alternateSetting = 0xFF;
+    size_t received;
+
+    /* Alternate Setting 0 is the Default and has no Endpoints */
+    if (!p_usbHost.controlRead(0x81, 0x0A, 0, usbIsoInterfaceNumber, &alternateSetting, sizeof(alternateSetting), received)
+      || (received != sizeof(alternateSetting)) || (alternateSetting != 0) || isIsoOutArmed()) {
+        ::printf("FAIL: Isochronous Endpoints are active in Alternate Setting 0\n");
+        return (false);
+    }
+
+    if (p_usbHost.controlWrite(0x01, 0x0B, 2, usbIsoInterfaceNumber, nullptr, 0)) {
+        ::printf("FAIL: SET_INTERFACE accepted Alternate Setting 2\n");
+        return (false);
+    }
+
+    if (!setIsoAlternateSetting(p_usbHost, 1)) {
+        ::printf("FAIL: Could not select Alternate Setting 1\n");
+        return (false);
+    }
+
+    otgFsModel.resetStatistics();
+    isoInEndpoint.resetStatistics();
+    isoOutEndpoint.resetStatistics();
+    if (!p_usbHost.isoLoopback(usbIsoOutEndpoint.getNumber(), usbIsoInEndpoint.getNumber(), usbIsoOutEndpoint.m_wMaxPacketSize, 1000)) {
+        return (false);
+    }
+    p_usbHost.printStatistics("Isochronous Loopback");
+
+    /* The first Frame has no Data to send back yet */
+    if ((isoInEndpoint.getStatistics().m_numIncomplete != 0) || (isoOutEndpoint.getStatistics().m_numIncomplete != 0)
+      || (isoInEndpoint.getStatistics().m_numUnderruns != 1) || (isoOutEndpoint.getStatistics().m_numOverruns != 0)) {
+        ::printf("FAIL: Isochronous Loopback missed Frames\n");
+        return (false);
+    }
+
+    /* Back in Alternate Setting 0, the Host's Packets are dropped */
+    if (!setIsoAlternateSetting(p_usbHost, 0) || isIsoOutArmed()) {
+        ::printf("FAIL: Isochronous Endpoints still active after Alternate Setting 0\n");
+        return (false);
+    }
+
+    return (true);
+}
+#endif /* defined(USB_ISO_LOOPBACK) */
+
+#if defined(RTOS_STATIC_ALLOCATION)
+/*******************************************************************************
+ * Task Snapshot with the Stack Size and High-Water Mark of the Power Task.
+ ******************************************************************************/
+static bool
+testTaskStats(usb::UsbHostSimulation &p_usbHost) {
+    typedef RtosTaskStats_t TaskStats_t;
+
+    TaskStats_t::Table_t table;
+    const TaskStats_t::Entry_t *power = nullptr;
+
+    /* The Scheduler has not been started, so the Snapshot shows the Stacks as created */
+    rtosTaskStats.update();
+
+#if defined(USB_INTERFACE_VENDOR)
+    size_t received;
+
+    if (!p_usbHost.controlRead(0xC1, usb::e_UsbVendorTaskStatsRequest_GetTaskStats, 0, 0, &table, sizeof(table), received)
+      || (received != sizeof(table))) {
+        ::printf("FAIL: GET_TASK_STATS returned no Table\n");
+        return (false);
+    }
+#else
+    (void) p_usbHost;
+
+    ::memcpy(&table, &rtosTaskStats.getTable(), sizeof(table));
+#endif /* defined(USB_INTERFACE_VENDOR) */
+
+    for (unsigned idx = 0; idx < table.m_numTasks; idx++) {
+        if (::strncmp(table.m_entries[idx].m_name, "usbpwr", sizeof(table.m_entries[idx].m_name)) == 0) {
+            power = &table.m_entries[idx];
+        }
+    }
+
+    if ((table.m_sequence != 1) || (table.m_maxTasks != 8) || (power == nullptr)
+      || (power->m_stackDepth != usbPowerTaskStackDepth)
+      || (power->m_stackHighWater == 0) || (power->m_stackHighWater > power->m_stackDepth)) {
+        ::printf("FAIL: Task Statistics do not match the Tasks\n");
+        return (false);
+    }
+
+    /* A Table too small for all Tasks stays empty, but says so */
+    static rtos::TaskStatsT<1> tooSmall;
+
+    tooSmall.update();
+    if ((tooSmall.getTable().m_numTasks != 0) || !(tooSmall.getTable().m_flags & tooSmall.m_flagOverflow)
+      || (rtosTaskStats.getTable().m_flags & rtosTaskStats.m_flagOverflow)) {
+        ::printf("FAIL: Task Statistics did not flag the Overflow\n");
+        return (false);
+    }
+    ::printf("Task Statistics (%u Tasks): usbpwr has %u of %u Words free; OK\n",
+      table.m_numTasks, power->m_stackHighWater, power->m_stackDepth);
+
+    return (true);
+}
+#endif /* defined(RTOS_STATIC_ALLOCATION) */
+
+/*******************************************************************************
+ * Host suspends and resumes the Bus. The Device must only signal Remote Wakeup
+ * while the Host has enabled it via SET_FEATURE(DEVICE_REMOTE_WAKEUP).
+ ******************************************************************************/
+static bool
+testSuspendResume(usb::UsbHostSimulation &p_usbHost) {
+    otgFsModel.suspend();
+    if (!usbSuspend.isSuspended() || !otgFsModel.isPhyClockStopped()) {
+        ::printf("FAIL: Suspend did not stop the PHY Clock\n");
+        return (false);
+    }
+
+    otgFsModel.resume();
+    if (usbSuspend.isSuspended() || otgFsModel.isPhyClockStopped()) {
+        ::printf("FAIL: Resume did not restart the PHY Clock\n");
+        return (false);
+    }
+
+    otgFsModel.suspend();
+    if (usbSuspend.requestRemoteWakeup() || usbSuspend.startRemoteWakeup() || otgFsModel.isRemoteWakeupSignalled()) {
+        ::printf("FAIL: Remote Wakeup was signalled although the Host has not enabled it\n");
+        return (false);
+    }
+    otgFsModel.resume();
+
+    /* SET_FEATURE / CLEAR_FEATURE(DEVICE_REMOTE_WAKEUP) */
+    if (!p_usbHost.controlWrite(0x00, 0x03, 1, 0, nullptr, 0) || !usbSuspend.isRemoteWakeupEnabled()) {
+        ::printf("FAIL: SET_FEATURE(DEVICE_REMOTE_WAKEUP) did not enable Remote Wakeup\n");
+        return (false);
+    }
+    if (!p_usbHost.controlWrite(0x00, 0x01, 1, 0, nullptr, 0) || usbSuspend.isRemoteWakeupEnabled()) {
+        ::printf("FAIL: CLEAR_FEATURE(DEVICE_REMOTE_WAKEUP) did not disable Remote Wakeup\n");
+        return (false);
+    }
+    p_usbHost.controlWrite(0x00, 0x03, 1, 0, nullptr, 0);
+
+    otgFsModel.suspend();
+    if (!usbSuspend.requestRemoteWakeup() || !usbSuspend.startRemoteWakeup()
+      || !otgFsModel.isRemoteWakeupSignalled() || otgFsModel.isPhyClockStopped()) {
+        ::printf("FAIL: Remote Wakeup was not signalled\n");
+        return (false);
+    }
+    usbSuspend.stopRemoteWakeup();
+    otgFsModel.resume();
+
+    if (usbSuspend.isSuspended() || otgFsModel.isRemoteWakeupSignalled()
+      || !p_usbHost.enumerate(&usbDeviceDescriptor, sizeof(usbDeviceDescriptor))) {
+        ::printf("FAIL: Device did not come back from Remote Wakeup\n");
+        return (false);
+    }
+    if (usbSuspend.isRemoteWakeupEnabled()) {
+        ::printf("FAIL: Bus Reset did not disable Remote Wakeup\n");
+        return (false);
+    }
+    ::printf("Suspend / Resume: OK\n");
+
+    return (true);
+}
+
+#if defined(USB_IRQ_PROFILING)
+/*******************************************************************************
+ * Profiler against injected Cycle Counts: min. / max. / Histogram per Source,
+ * then the Device's Profile via GET_IRQ_PROFILE.
+ ******************************************************************************/
+static bool
+testIrqProfile(usb::UsbHostSimulation &p_usbHost) {
+    typedef stm32::usb::IrqProfilerViaSTM32F4<stm32::MockCycleCounter> IrqProfiler_t;
+
+    /* Stub Core that takes the injected Cycles for each unmasked pending Source and clears it */
+    static USB_OTG_GlobalTypeDef regs;
+    struct {
+        uint32_t    m_cycles[32];
+
+        void
+        handleIrq(void) {
+            const uint32_t pending = regs.GINTSTS & regs.GINTMSK;
+
+            for (unsigned bit = 0; bit < 32; bit++) {
+                if (pending & (1u << bit)) {
+                    stm32::MockCycleCounter::advance(m_cycles[bit]);
+                }
+            }
+            regs.GINTSTS &= ~pending;
+        }
+    } core = {};
+
+    static IrqProfiler_t profiler(reinterpret_cast<uintptr_t>(&regs));
+    const uint32_t gintmsk = USB_OTG_GINTSTS_RXFLVL | USB_OTG_GINTSTS_SOF | USB_OTG_GINTSTS_USBSUSP;
+    const struct {
+        uint32_t    m_gintsts;
+        uint32_t    m_rxFlvlCycles;
+        uint32_t    m_sofCycles;
+        uint32_t    m_otherCycles;
+    } irqs[] = {
+        { USB_OTG_GINTSTS_RXFLVL | USB_OTG_GINTSTS_SOF,         40,     70,     0 },
+        { USB_OTG_GINTSTS_RXFLVL,                               5000,   0,      0 },
+        { USB_OTG_GINTSTS_RXFLVL | USB_OTG_GINTSTS_USBSUSP,     100,    0,      300 },
+    };
+
+    for (const auto &irq : irqs) {
+        core.m_cycles[USB_OTG_GINTSTS_RXFLVL_Pos]   = irq.m_rxFlvlCycles;
+        core.m_cycles[USB_OTG_GINTSTS_SOF_Pos]      = irq.m_sofCycles;
+        core.m_cycles[USB_OTG_GINTSTS_USBSUSP_Pos]  = irq.m_otherCycles;
+
+        regs.GINTMSK = gintmsk;
+        regs.GINTSTS = irq.m_gintsts;
+        profiler.handleIrq(core);
+
+        if ((regs.GINTSTS != 0) || (regs.GINTMSK != gintmsk)) {
+            ::printf("FAIL: IRQ Profiler did not dispatch all Sources or did not restore GINTMSK\n");
+            return (false);
+        }
+    }
+
+    const IrqProfiler_t::Profile_t &profile = profiler.getProfile();
+    const auto &rxFlvl  = profile.getEntry(IrqProfiler_t::e_RxFlvl);
+    const auto &sof     = profile.getEntry(IrqProfiler_t::e_Sof);
+    const auto &other   = profile.getEntry(IrqProfiler_t::e_Other);
+    const auto &total   = profile.getEntry(IrqProfiler_t::e_Total);
+
+    /* Bucket 0 is below 64 Cycles, Bucket n covers [2^(5+n), 2^(6+n)) */
+    if ((rxFlvl.m_count != 3) || (rxFlvl.m_minCycles != 40) || (rxFlvl.m_maxCycles != 5000) || (rxFlvl.m_totalCycles != 5140)
+      || (rxFlvl.m_buckets[0] != 1) || (rxFlvl.m_buckets[1] != 1) || (rxFlvl.m_buckets[7] != 1)
+      || (sof.m_count != 1) || (sof.m_minCycles != 70) || (sof.m_maxCycles != 70) || (sof.m_buckets[1] != 1)
+      || (other.m_count != 1) || (other.m_minCycles != 300) || (other.m_buckets[3] != 1)
+      || (total.m_count != 3) || (total.m_minCycles != 110) || (total.m_maxCycles != 5000) || (total.m_totalCycles != 5510)
+      || (profile.getEntry(IrqProfiler_t::e_IepInt).m_count != 0)) {
+        ::printf("FAIL: IRQ Profile does not match the injected Cycle Counts\n");
+        return (false);
+    }
+
+    /* The Device's own Profile has seen the Interrupts of the Enumeration */
+    IrqProfiler_t::Profile_t::Table_t table;
+    size_t received;
+
+    if (!p_usbHost.controlRead(0xC1, usb::e_UsbVendorRequest_GetIrqProfile, 0, 0, &table, sizeof(table), received)
+      || (received != sizeof(table)) || (table.m_numSources != IrqProfiler_t::e_NumSources)
+      || (table.m_entries[IrqProfiler_t::e_Total].m_count == 0)) {
+        ::printf("FAIL: GET_IRQ_PROFILE returned no Profile\n");
+        return (false);
+    }
+    ::printf("IRQ Profile: OK\n");
+
+    return (true);
+}
+#endif /* defined(USB_IRQ_PROFILING) */
+
+#if defined(USB_TRACING)
+/*******************************************************************************
+ * Trace Events come out of the Ring complete and in Order.
+ ******************************************************************************/
+static bool
+testTrace(usb::UsbHostSimulation &p_usbHost) {
+    /* Stub Sink that checks the Events drained from the Ring */
+    struct {
+        usb::UsbTraceEvent_t    m_last;
+        size_t                  m_numEvents;
+
+        void
+        write(const usb::UsbTraceEvent_t * const p_events, const size_t p_numEvents) {
+            m_last = p_events[p_numEvents - 1];
+            m_numEvents += p_numEvents;
+        }
+    } sink = {};
+
+    /* Discard the Events recorded so far, then fill the Ring beyond its Capacity */
+    usbTrace.drain(sink);
+    sink.m_numEvents = 0;
+
+    const uint32_t dropped = usbTrace.getDropped();
+    for (uint32_t idx = 0; idx < 300; idx++) {
+        UsbTraceCycleCounter_t::advance(10);
+        USB_TRACE(usbTrace, "Trace Test: Event %u of %u", idx, 300);
+    }
+
+    if ((usbTrace.drain(sink) != 256) || (sink.m_numEvents != 256) || ((usbTrace.getDropped() - dropped) != 44)
+      || (sink.m_last.m_arg[0] != 255) || (sink.m_last.m_arg[1] != 300) || (sink.m_last.m_timestamp != UsbTraceCycleCounter_t::read() - 44 * 10)) {
+        ::printf("FAIL: Trace Events were lost or out of Order\n");
+        return (false);
+    }
+
+#if defined(USB_INTERFACE_VENDOR)
+    /* GET_TRACE only removes the Events the Host acknowledges via wValue; the Interrupts of each Transfer add more */
+    usb::UsbTraceEvent_t event;
+    size_t received;
+
+    USB_TRACE(usbTrace, "Trace Test: Marker %u", 1);
+    USB_TRACE(usbTrace, "Trace Test: Marker %u", 2);
+
+    if (!p_usbHost.controlRead(0xC1, usb::e_UsbVendorTraceRequest_GetTrace, 0, 0, &event, sizeof(event), received)
+      || (received != sizeof(event)) || (event.m_arg[0] != 1)) {
+        ::printf("FAIL: GET_TRACE did not return the oldest Event\n");
+        return (false);
+    }
+    if (!p_usbHost.controlRead(0xC1, usb::e_UsbVendorTraceRequest_GetTrace, 0, 0, &event, sizeof(event), received)
+      || (received != sizeof(event)) || (event.m_arg[0] != 1)) {
+        ::printf("FAIL: GET_TRACE removed an Event the Host has not acknowledged\n");
+        return (false);
+    }
+    if (!p_usbHost.controlRead(0xC1, usb::e_UsbVendorTraceRequest_GetTrace, 1, 0, &event, sizeof(event), received)
+      || (received != sizeof(event)) || (event.m_arg[0] != 2)) {
+        ::printf("FAIL: GET_TRACE did not remove the acknowledged Event\n");
+        return (false);
+    }
+    const uint32_t markerFormat = event.m_format;
+    if (!p_usbHost.controlRead(0xC1, usb::e_UsbVendorTraceRequest_GetTrace, 1, 0, &event, sizeof(event), received)
+      || (received != sizeof(event)) || (event.m_format == markerFormat)) {
+        ::printf("FAIL: GET_TRACE did not remove the acknowledged Event\n");
+        return (false);
+    }
+#else
+    (void) p_usbHost;
+#endif /* defined(USB_INTERFACE_VENDOR) */
+    ::printf("Trace: OK\n");
+
+    return (true);
+}
+#endif /* defined(USB_TRACING) */
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+int
+main(void) {
+    if (!setup()) {
+        return (1);
+    }
+
+    usb::UsbHostSimulation usbHost(otgFsModel);
+
+    otgFsModel.setWakeupIrqHandler(OTG_FS_WKUP_IRQHandler);
+
+    if (!usbHost.enumerate(&usbDeviceDescriptor, sizeof(usbDeviceDescriptor))) {
+        return (1);
+    }
+    usbHost.printStatistics("Enumeration");
+
+#if defined(USB_INTERFACE_VCP)
+    if (!testSerialState(usbHost)) {
+        return (1);
+    }
+#endif /* defined(USB_INTERFACE_VCP) */
+
+#if defined(USB_APPLICATION_LOOPBACK)
+    if (!testLoopback(usbHost)) {
+        return (1);
+    }
+#endif /* defined(USB_APPLICATION_LOOPBACK) */
+
+#if defined(USB_FRAMED_STREAM)
+    if (!testFramedStream(usbHost)) {
+        return (1);
+    }
+#endif /* defined(USB_FRAMED_STREAM) */
+
+#if defined(USB_INTERFACE_MSC)
+    if (!testMassStorage(usbHost)) {
+        return (1);
+    }
+#endif /* defined(USB_INTERFACE_MSC) */
+
+#if defined(USB_DFU)
+    if (!testDfu(usbHost)) {
+        return (1);
+    }
+#endif /* defined(USB_DFU) */
+
+#if defined(USB_COMPOSITE_LOOPBACK)
+    if (!testCompositeLoopback(usbHost)) {
+        return (1);
+    }
+#endif /* defined(USB_COMPOSITE_LOOPBACK) */
+
+#if defined(USB_ISO_LOOPBACK)
+    if (!testIsoLoopback(usbHost)) {
+        return (1);
+    }
+#endif /* defined(USB_ISO_LOOPBACK) */
+
+#if defined(RTOS_STATIC_ALLOCATION)
+    if (!testTaskStats(usbHost)) {
+        return (1);
+    }
+#endif /* defined(RTOS_STATIC_ALLOCATION) */
+
+    if (!testSuspendResume(usbHost)) {
+        return (1);
+    }
+
+#if defined(USB_IRQ_PROFILING)
+    if (!testIrqProfile(usbHost)) {
+        return (1);
+    }
+#endif /* defined(USB_IRQ_PROFILING) */
+
+#if defined(USB_TRACING)
+    if (!testTrace(usbHost)) {
+        return (1);
+    }
+#endif /* defined(USB_TRACING) */
+
+    ::printf("All USB Host Tests passed\n");
+
+    return (0);
+}
@@ -11,8 +11,10 @@
 #include <stm32/Cpu.hpp>
 
 #include <stm32/Pll.hpp>
+#include <stm32/PllSolver.hpp>
 #include <stm32/Pwr.hpp>
 #include <stm32/Flash.hpp>
+#include <stm32/FlashWaitStates.hpp>
 #include <stm32/Gpio.hpp>
 #include <stm32/Rcc.hpp>
 #include <stm32/Scb.hpp>
@@ -42,6 +44,87 @@
 #include <usb/UsbInterface.hpp>
 
 #include <usb/UsbApplication.hpp>
+#include <usb/UsbBulkInApplication.hpp>
+#include <usb/UsbLoopbackRingApplication.hpp>
+#include <usb/OutEndpointNakViaSTM32F4.hpp>
+#include <usb/BulkOutEndpointZeroCopyViaSTM32F4.hpp>
+#include <usb/BulkInEndpointFifoViaSTM32F4.hpp>
+#include <usb/EndpointDispatcherViaSTM32F4.hpp>
+#include <usb/UsbUartRxBridge.hpp>
+#include <usb/UsbUartDmaApplication.hpp>
+#include <usb/UsbBulkOutStream.hpp>
+#include <usb/UsbBulkInWriter.hpp>
+#include <usb/SofViaSTM32F4.hpp>
+#include <usb/IsoEndpointViaSTM32F4.hpp>
+#include <usb/UsbIsoApplication.hpp>
+#include <usb/UsbAlternateSetting.hpp>
+#include <usb/UsbConfigurationListener.hpp>
+#include <usb/UsbRemoteWakeup.hpp>
+#include <usb/InterruptInEndpointViaSTM32F4.hpp>
+#include <usb/UsbCdcSerialState.hpp>
+#include <usb/UsbCdcLineCoding.hpp>
+#include <usb/UsbSuspendViaSTM32F4.hpp>
+#include <usb/UsbDescriptorBuilder.hpp>
+#include <usb/UsbFunctionStrings.hpp>
+#include <usb/OtgFsFifoPlanner.hpp>
+
+#if defined(USB_IRQ_PROFILING)
+#include <usb/IrqProfilerViaSTM32F4.hpp>
+#include <usb/UsbVendorIrqProfileInterface.hpp>
+#include <stm32/CycleCounter.hpp>
+#endif /* defined(USB_IRQ_PROFILING) */
+
+#include <usb/UsbTrace.hpp>
+#if defined(USB_TRACING)
+#include <usb/UsbVendorTraceInterface.hpp>
+#include <stm32/CycleCounter.hpp>
+#endif /* defined(USB_TRACING) */
+
+#if defined(USB_FRAMED_STREAM)
+#if !defined(USB_INTERFACE_VENDOR) || !defined(USB_APPLICATION_LOOPBACK)
+#error USB_FRAMED_STREAM requires USB_INTERFACE_VENDOR and USB_APPLICATION_LOOPBACK.
+#endif
+#include <usb/UsbFramedStream.hpp>
+#include <usb/UsbVendorFramedStreamInterface.hpp>
+#include <stm32/Crc.hpp>
+#endif /* defined(USB_FRAMED_STREAM) */
+
+#if defined(USB_INTERFACE_MSC)
+#if defined(USB_APPLICATION_LOOPBACK) || defined(USB_APPLICATION_UART) || defined(USB_APPLICATION_STREAM)
+#error USB_INTERFACE_MSC brings its own Application; do not define USB_APPLICATION_*.
+#endif
+#include <usb/UsbBlockDevice.hpp>
+#include <usb/UsbMassStorage.hpp>
+#include <usb/UsbMassStorageInterface.hpp>
+#include <stm32/FlashBlockDevice.hpp>
+#endif /* defined(USB_INTERFACE_MSC) */
+
+#if defined(USB_DFU)
+#if defined(USB_INTERFACE_MSC)
+#error USB_DFU and USB_INTERFACE_MSC both use the upper Flash Sectors.
+#endif
+#include <usb/UsbDfu.hpp>
+#include <usb/UsbDfuInterface.hpp>
+#include <stm32/FlashProgrammer.hpp>
+#endif /* defined(USB_DFU) */
+
+#if defined(RTOS_STATIC_ALLOCATION)
+#include <rtos/StaticTask.hpp>
+#include <rtos/TaskStats.hpp>
+#include <usb/UsbVendorTaskStatsInterface.hpp>
+#include <stm32/CycleCounter.hpp>
+#endif /* defined(RTOS_STATIC_ALLOCATION) */
+
+#if defined(HOSTBUILD)
+#include <usb/OtgFsRegisterModel.hpp>
+#endif /* defined(HOSTBUILD) */
+
+#include <stm32/UartRxDma.hpp>
+#include <stm32/UartTxDma.hpp>
+#include <stm32/LowPower.hpp>
+
+#include "UsbDescriptors.hpp"
+#include "main.hpp"
 
 /*******************************************************************************
  *
@@ -55,6 +138,7 @@ extern "C" {
  ******************************************************************************/
 extern const ::usb::UsbDeviceDescriptor_t usbDeviceDescriptor;
 extern const ::usb::UsbStringDescriptors_t usbStringDescriptors;
+extern const ::usb::UsbFunctionStrings_t usbFunctionStrings;
 extern const ::usb::UsbConfigurationDescriptor_t usbConfigurationDescriptor;
 
 #if defined(__cplusplus)
@@ -65,24 +149,31 @@ extern const ::usb::UsbConfigurationDescriptor_t usbConfigurationDescriptor;
 /*******************************************************************************
  * System Devices
  ******************************************************************************/
-static const constexpr stm32::PllCfg pllCfg = {
-    .m_pllSource        = stm32::PllCfg::PllSource_t::e_PllSourceHSE,
-    .m_hseSpeedInHz     = 8 * 1000 * 1000,
-    .m_pllM             = 8,
-    .m_pllN             = 336,
-    .m_pllP             = stm32::PllCfg::PllP_t::e_PllP_Div2,
-    .m_pllQ             = stm32::PllCfg::PllQ_t::e_PllQ_Div7,
-    .m_sysclkSource     = stm32::PllCfg::SysclkSource_t::e_SysclkPLL,
-    .m_ahbPrescaler     = stm32::PllCfg::AHBPrescaler_t::e_AHBPrescaler_None,
-    .m_apb1Prescaler    = stm32::PllCfg::APBPrescaler_t::e_APBPrescaler_Div4,
-    .m_apb2Prescaler    = stm32::PllCfg::APBPrescaler_t::e_APBPrescaler_Div2
-};
+#if defined(STM32F411xE)
+/* Nucleo-F411RE: 8 MHz HSE from the ST-LINK's MCO */
+static constexpr uint32_t               boardHseSpeedInHz   = 8 * 1000 * 1000;
+static constexpr stm32::ClockLimits_t   boardClockLimits    = stm32::PllSolver::m_limitsStm32F411;
+#else
+/* STM32F4-Discovery: 8 MHz Crystal */
+static constexpr uint32_t               boardHseSpeedInHz   = 8 * 1000 * 1000;
+static constexpr stm32::ClockLimits_t   boardClockLimits    = stm32::PllSolver::m_limitsStm32F407;
+#endif /* defined(STM32F411xE) */
+
+/* Highest SYSCLK that still gives USB an exact 48 MHz Clock */
+static constexpr stm32::PllSolver::Solution_t pllSolution = stm32::PllSolver::solve(boardHseSpeedInHz, boardClockLimits);
+static_assert(pllSolution.m_valid, "No PLL Configuration yields an exact 48 MHz USB Clock from this HSE Frequency!");
+
+static const constexpr stm32::PllCfg pllCfg = stm32::PllSolver::getPllCfg(pllSolution);
 
 static stm32::Scb                       scb(SCB);
 static stm32::Nvic                      nvic(NVIC, scb);
 
 static stm32::Pwr                       pwr(PWR);
 static stm32::Flash                     flash(FLASH);
+#if !defined(HOSTBUILD)
+/* Must be constructed before rcc switches to the PLL */
+static stm32::FlashWaitStates           flashWaitStates(FLASH, pllSolution.m_flashWaitStates);
+#endif /* !defined(HOSTBUILD) */
 static stm32::Rcc                       rcc(RCC, pllCfg, flash, pwr);
 
 /*******************************************************************************
@@ -114,47 +205,342 @@ uart::UartDevice                        g_uart(&uart_access);
 /*******************************************************************************
  * USB Device
  ******************************************************************************/
+static constexpr uintptr_t              usbOtgBase          = USB_OTG_FS_PERIPH_BASE;
+static constexpr IRQn_Type              usbOtgIrq           = OTG_FS_IRQn;
+static constexpr IRQn_Type              usbOtgWakeupIrq     = OTG_FS_WKUP_IRQn;
+static constexpr unsigned               usbOtgWakeupLine    = stm32::usb::UsbSuspendViaSTM32F4::m_extiLineOtgFs;
+static constexpr unsigned               usbFifoRamSzInWords = 320;
+
+#if defined(HOSTBUILD)
+/* Must be set up before the USB Objects below access the OTG Registers */
+stm32::usb::OtgFsRegisterModel          otgFsModel(OTG_FS_IRQHandler, usbOtgBase);
+#endif /* defined(HOSTBUILD) */
+
 static gpio::AlternateFnPin             usb_pin_dm(gpio_engine_A, 11);
 static gpio::AlternateFnPin             usb_pin_dp(gpio_engine_A, 12);
 static gpio::AlternateFnPin             usb_pin_vbus(gpio_engine_A, 9);
 static gpio::AlternateFnPin             usb_pin_id(gpio_engine_A, 10);
 
+static constexpr auto                           usbFifoPlan = stm32::usb::planFifos<usbNumHwEndpoints, usbFifoRamSzInWords>(
+  stm32::usb::FifoDepth_e::e_Double,
+  usbCtrlMaxPacketSize,
+  usbBulkOutEndpoint,
+  usbBulkInEndpoint
+#if defined(USB_INTERFACE_VCP)
+  , usbNotificationEndpoint
+#endif /* defined(USB_INTERFACE_VCP) */
+#if defined(USB_COMPOSITE_LOOPBACK)
+  , usbLoopbackOutEndpoint
+  , usbLoopbackInEndpoint
+#endif /* defined(USB_COMPOSITE_LOOPBACK) */
+#if defined(USB_ISO_LOOPBACK)
+  , usbIsoOutEndpoint
+  , usbIsoInEndpoint
+#endif /* defined(USB_ISO_LOOPBACK) */
+);
+static_assert(usbFifoPlan.isValid(), "USB FIFO Layout does not fit into the OTG FIFO RAM");
+
 static stm32::usb::UsbFullSpeedCoreT<
   decltype(nvic),
   decltype(rcc),
   decltype(usb_pin_dm)
->                                       usbCore(nvic, rcc, usb_pin_dm, usb_pin_dp, usb_pin_vbus, usb_pin_id, /* p_rxFifoSzInWords = */ 256);
+>                                       usbCore(nvic, rcc, usb_pin_dm, usb_pin_dp, usb_pin_vbus, usb_pin_id, /* p_rxFifoSzInWords = */ usbFifoPlan.getRxFifoSzInWords());
 static stm32::usb::UsbDeviceViaSTM32F4          usbHwDevice(usbCore);
-static stm32::usb::CtrlInEndpointViaSTM32F4     defaultHwCtrlInEndpoint(usbHwDevice, /* p_fifoSzInWords = */ 0x20);
 
-static stm32::usb::BulkInEndpointViaSTM32F4     bulkInHwEndp(usbHwDevice, /* p_fifoSzInWords = */ 128, 1);
-static usb::UsbBulkInEndpointT                  bulkInEndpoint(bulkInHwEndp);
+#if defined(USB_IRQ_PROFILING)
+#if defined(HOSTBUILD)
+typedef stm32::MockCycleCounter                 UsbIrqCycleCounter_t;
+#else
+typedef stm32::DwtCycleCounter                  UsbIrqCycleCounter_t;
+#endif /* defined(HOSTBUILD) */
+static stm32::usb::IrqProfilerViaSTM32F4<UsbIrqCycleCounter_t>  usbIrqProfiler(usbOtgBase);
+#endif /* defined(USB_IRQ_PROFILING) */
+#if defined(USB_TRACING)
+UsbTrace_t                                      usbTrace;
+#endif /* defined(USB_TRACING) */
+static stm32::usb::CtrlInEndpointViaSTM32F4     defaultHwCtrlInEndpoint(usbHwDevice, /* p_fifoSzInWords = */ usbFifoPlan.getTxFifoSzInWords(0));
+
+static constexpr unsigned                       bulkInFifoSzInWords = usbFifoPlan.getTxFifoSzInWords(usbBulkInEndpoint.getNumber());
+static_assert(bulkInFifoSzInWords * sizeof(uint32_t) >= usbBulkInEndpoint.m_wMaxPacketSize, "Bulk IN FIFO is smaller than the Endpoint's max. Packet Size");
+static_assert(usbBulkInEndpoint.isIn() && !usbBulkOutEndpoint.isIn(), "Bulk Endpoint Directions do not match the Descriptor");
+
+static stm32::usb::BulkInEndpointViaSTM32F4     bulkInHwEndp(usbHwDevice, bulkInFifoSzInWords, usbBulkInEndpoint.getNumber());
+static usb::UsbBulkInEndpointNotifyT<stm32::usb::BulkInEndpointViaSTM32F4>  bulkInEndpoint(bulkInHwEndp);
+
+#if defined(USB_APPLICATION_LOOPBACK) || defined(USB_INTERFACE_MSC)
+/* Drains the RX FIFO straight into the Loopback Ring or the Disk, see OTG_FS_IRQHandler() */
+static stm32::usb::BulkOutEndpointZeroCopyViaSTM32F4<
+  usbBulkOutEndpoint.getNumber(),
+  usbBulkOutEndpoint.m_wMaxPacketSize
+#if defined(USB_FRAMED_STREAM)
+  /* Checksums each Word on its Way out of the RX FIFO */
+  , UsbFrameCrc_t
+#endif /* defined(USB_FRAMED_STREAM) */
+>                                                                   bulkOutZeroCopy(usbOtgBase);
+#else
+static const stm32::usb::OutEndpointNakViaSTM32F4<usbBulkOutEndpoint.getNumber()> bulkOutNak(usbOtgBase);
+#endif /* defined(USB_APPLICATION_LOOPBACK) || defined(USB_INTERFACE_MSC) */
+
+#if defined(USB_COMPOSITE_LOOPBACK)
+/*
+ * Second Function of the Composite Device: an independent Loopback with its own
+ * Endpoint Pair, TX FIFO and Ring. The Core's Endpoint Drivers only serve the
+ * first Function, so these Endpoints are activated on SET_CONFIGURATION.
+ */
+static constexpr unsigned                                           loopbackInFifoSzInWords = usbFifoPlan.getTxFifoSzInWords(usbLoopbackInEndpoint.getNumber());
+static_assert(usbLoopbackInEndpoint.isIn() && !usbLoopbackOutEndpoint.isIn(), "Loopback Endpoint Directions do not match the Descriptor");
+
+static stm32::usb::BulkInEndpointFifoViaSTM32F4<
+  usbLoopbackInEndpoint.getNumber(),
+  usbLoopbackInEndpoint.m_wMaxPacketSize
+>                                                                   loopbackInEndpoint(usbFifoPlan.getTxFifoOffsetInWords(usbLoopbackInEndpoint.getNumber()),
+                                                                      loopbackInFifoSzInWords, usbOtgBase);
+static stm32::usb::BulkOutEndpointZeroCopyViaSTM32F4<
+  usbLoopbackOutEndpoint.getNumber(),
+  usbLoopbackOutEndpoint.m_wMaxPacketSize
+>                                                                   loopbackOutEndpoint(usbOtgBase);
+static usb::UsbEndpointConfigurationT<decltype(loopbackInEndpoint)>     loopbackInEndpointConfiguration(loopbackInEndpoint);
+static usb::UsbEndpointConfigurationT<decltype(loopbackOutEndpoint)>    loopbackOutEndpointConfiguration(loopbackOutEndpoint);
+static usb::UsbBulkOutLoopbackRingApplicationT<
+  decltype(loopbackInEndpoint),
+  decltype(loopbackOutEndpoint),
+  /* nBufferSz = */ 4 * 1024,
+  loopbackInFifoSzInWords,
+  usbLoopbackInEndpoint.m_wMaxPacketSize
+>                                                                   loopbackApplication(loopbackInEndpoint, loopbackOutEndpoint);
+#endif /* defined(USB_COMPOSITE_LOOPBACK) */
+
+#if defined(USB_APPLICATION_LOOPBACK) || defined(USB_COMPOSITE_LOOPBACK) || defined(USB_INTERFACE_MSC)
+/* Routes the Events of the Endpoints that bypass the Core's Drivers, see OTG_FS_IRQHandler() */
+static stm32::usb::EndpointDispatcherViaSTM32F4<usbNumHwEndpoints>  usbEndpointDispatcher(usbOtgBase);
+#endif /* defined(USB_APPLICATION_LOOPBACK) || defined(USB_COMPOSITE_LOOPBACK) || defined(USB_INTERFACE_MSC) */
 
 #if defined(USB_APPLICATION_LOOPBACK)
-/* TODO I've found that increasing the buffer size beyond 951 Bytes will make things stop working. */
-static usb::UsbBulkOutLoopbackApplicationT<512>                     bulkOutApplication(bulkInEndpoint);
+static usb::UsbBulkOutLoopbackRingApplicationT<
+  decltype(bulkInEndpoint),
+  decltype(bulkOutZeroCopy),
+  /* nBufferSz = */ 8 * 1024,
+  bulkInFifoSzInWords,
+  usbBulkInEndpoint.m_wMaxPacketSize
+>                                                                   bulkOutApplication(bulkInEndpoint, bulkOutZeroCopy);
+
+#if defined(USB_FRAMED_STREAM)
+/* Checks the Frames on their Way into the Loopback Ring */
+UsbFramedStream_t                                                   usbFramedStream(bulkOutApplication);
+#endif /* defined(USB_FRAMED_STREAM) */
 #elif defined(USB_APPLICATION_UART)
-static usb::UsbUartApplicationT<decltype(uart_access)>              bulkOutApplication(uart_access);
+/* USART6_TX is mapped to DMA2, Stream 6, Channel 5 */
+static stm32::Uart::UartTxDmaT<64, /* nNumBuffers = */ 3>           uart_tx_dma(USART6, DMA2, /* p_streamNo = */ 6, /* p_channel = */ 5);
+static usb::UsbUartDmaApplicationT<decltype(uart_tx_dma), decltype(bulkOutNak)> bulkOutApplication(uart_tx_dma, bulkOutNak);
+#elif defined(USB_APPLICATION_STREAM)
+static usb::UsbBulkOutStreamT<
+  decltype(bulkOutNak),
+  /* nBufferSz = */ 4 * 1024,
+  usbBulkOutEndpoint.m_wMaxPacketSize
+>                                                                   bulkOutApplication(bulkOutNak);
+
+static usb::UsbBulkInWriterT<
+  decltype(bulkInEndpoint),
+  /* nBufferSz = */ 1024,
+  usbBulkInEndpoint.m_wMaxPacketSize
+>                                                                   bulkInWriter(bulkInEndpoint, /* p_flushSofs = */ 2);
+#elif defined(USB_INTERFACE_MSC)
+#if defined(HOSTBUILD)
+UsbMscDisk_t                                                        usbMscDisk;
+#elif defined(STM32F411xE)
+/* Sector 7, the last 128 KB of the Flash; must not overlap the Firmware */
+UsbMscDisk_t                                                        usbMscDisk(/* p_sector = */ 7, /* p_base = */ 0x08060000, /* p_sectorSz = */ 128 * 1024);
+#else
+/* Sector 11, the last 128 KB of the Flash; must not overlap the Firmware */
+UsbMscDisk_t                                                        usbMscDisk(/* p_sector = */ 11, /* p_base = */ 0x080E0000, /* p_sectorSz = */ 128 * 1024);
+#endif /* defined(HOSTBUILD) */
+
+/*
+ * Takes over the Bulk IN Endpoint from the Core's Driver like bulkOutZeroCopy
+ * does on the OUT Side, as an invalid CBW must halt both Endpoints.
+ */
+static stm32::usb::BulkInEndpointFifoViaSTM32F4<
+  usbBulkInEndpoint.getNumber(),
+  usbBulkInEndpoint.m_wMaxPacketSize
+>                                                                   bulkInFifo(usbFifoPlan.getTxFifoOffsetInWords(usbBulkInEndpoint.getNumber()),
+                                                                      bulkInFifoSzInWords, usbOtgBase);
+static usb::UsbEndpointConfigurationT<decltype(bulkInFifo)>            bulkInFifoConfiguration(bulkInFifo);
+
+static usb::UsbMassStorageT<
+  decltype(bulkInFifo),
+  decltype(bulkOutZeroCopy),
+  bulkInFifoSzInWords,
+  usbBulkInEndpoint.m_wMaxPacketSize
+>                                                                   bulkOutApplication(bulkInFifo, bulkOutZeroCopy, usbMscDisk);
 #else
 #warning No USB Application defined.
 #endif
 
-#if defined(USB_APPLICATION_LOOPBACK) || defined(USB_APPLICATION_UART)
-static usb::UsbBulkOutEndpointT<stm32::usb::BulkOutEndpointViaSTM32F4>  bulkOutEndpoint(bulkOutApplication);
-static stm32::usb::BulkOutEndpointViaSTM32F4                            bulkOutHwEndp(usbHwDevice, bulkOutEndpoint, 1);
-#endif /* defined(USB_APPLICATION_LOOPBACK) || defined(USB_APPLICATION_UART) */
+#if defined(USB_DFU)
+#if defined(HOSTBUILD)
+extern "C" void FLASH_IRQHandler(void);
+
+UsbDfuFlash_t                                                       usbDfuFlash(FLASH_IRQHandler);
+#else
+UsbDfuFlash_t                                                       usbDfuFlash;
+#endif /* defined(HOSTBUILD) */
+
+static_assert(stm32::FlashLayout::getSectorOffset(stm32::FlashLayout::getSector(usbDfuSlotOffset)) == usbDfuSlotOffset, "DFU Slot must start on a Sector Boundary");
+
+static usb::UsbDfuT<decltype(usbDfuFlash), usbDfuTransferSize>     usbDfu(usbDfuFlash, usbDfuSlotOffset, usbDfuSlotSz);
+
+/* The Function's Interface also takes the Requests to the DFU Interface */
+template<typename InterfaceT> using UsbFunctionInterfaceT = usb::UsbDfuInterfaceT<InterfaceT, decltype(usbDfu)>;
+#else
+template<typename InterfaceT> using UsbFunctionInterfaceT = InterfaceT;
+#endif /* defined(USB_DFU) */
+
+stm32::usb::UsbSuspendViaSTM32F4                                    usbSuspend(usbOtgBase, usbOtgWakeupLine);
+#if defined(USB_APPLICATION_UART)
+/* Received UART Data must be able to wake the CPU, which rules out Stop Mode */
+static const stm32::LowPower                                        lowPower(stm32::LowPower::Mode_e::e_Sleep);
+#else
+static const stm32::LowPower                                        lowPower(stm32::LowPower::Mode_e::e_Stop);
+#endif /* defined(USB_APPLICATION_UART) */
+
+#if defined(USB_APPLICATION_STREAM) || defined(USB_ISO_LOOPBACK) || defined(USB_INTERFACE_VCP) || defined(USB_COMPOSITE_LOOPBACK) || defined(USB_INTERFACE_MSC)
+static const stm32::usb::SofViaSTM32F4                              usbSof(usbOtgBase);
+#endif /* defined(USB_APPLICATION_STREAM) || defined(USB_ISO_LOOPBACK) || defined(USB_INTERFACE_VCP) || defined(USB_COMPOSITE_LOOPBACK) || defined(USB_INTERFACE_MSC) */
 
 #if defined(USB_INTERFACE_VCP)
-static usb::UsbVcpInterface                                         usbInterface(bulkOutEndpoint, bulkInEndpoint);
+static_assert(usbNotificationEndpoint.isIn() && (usbNotificationEndpoint.m_wMaxPacketSize >= sizeof(usb::UsbCdcSerialStateNotification_t)), "SERIAL_STATE Notification must fit into a single Packet");
+
+static UsbNotificationEndpoint_t                                    notificationEndpoint(usbFifoPlan.getTxFifoOffsetInWords(usbNotificationEndpoint.getNumber()),
+                                                                      usbFifoPlan.getTxFifoSzInWords(usbNotificationEndpoint.getNumber()), usbOtgBase);
+static usb::UsbEndpointConfigurationT<decltype(notificationEndpoint)>  notificationEndpointConfiguration(notificationEndpoint);
+UsbSerialState_t                                                    usbSerialState(notificationEndpoint, usbCdcInterfaceNumber, usbNotificationEndpoint.m_bInterval);
+#endif /* defined(USB_INTERFACE_VCP) */
+
+#if defined(USB_ISO_LOOPBACK)
+static_assert((usbIsoInEndpoint.m_bInterval == 1) && (usbIsoOutEndpoint.m_bInterval == 1), "Isochronous Endpoints are serviced in every Frame");
+static_assert(usbFifoPlan.getTxFifoSzInWords(usbIsoInEndpoint.getNumber()) * sizeof(uint32_t) >= usbIsoInEndpoint.m_wMaxPacketSize, "Isochronous IN FIFO is smaller than the Endpoint's max. Packet Size");
+
+UsbIsoInEndpoint_t                                                                                              isoInEndpoint(usbFifoPlan.getTxFifoOffsetInWords(usbIsoInEndpoint.getNumber()),
+                                                                                                                  usbFifoPlan.getTxFifoSzInWords(usbIsoInEndpoint.getNumber()), usbOtgBase);
+UsbIsoOutEndpoint_t                                                                                             isoOutEndpoint(usbOtgBase);
+static usb::UsbIsoLoopbackApplicationT<decltype(isoInEndpoint)>                                                 isoLoopback(isoInEndpoint);
+/* The Isochronous Pair only exists in Alternate Setting 1 of its Interface */
+static usb::UsbEndpointPairAlternateSettingT<decltype(isoOutEndpoint), decltype(isoInEndpoint)>                 isoAlternateSetting(isoOutEndpoint, isoInEndpoint);
+#endif /* defined(USB_ISO_LOOPBACK) */
+
+#if defined(USB_APPLICATION_UART)
+/* USART6_RX is mapped to DMA2, Stream 1, Channel 5 */
+static stm32::Uart::UartRxDmaT<2048>                                uart_rx_dma(USART6, DMA2, /* p_streamNo = */ 1, /* p_channel = */ 5);
+static usb::UsbUartRxBridgeT<decltype(bulkInEndpoint), decltype(uart_rx_dma), usbBulkInEndpoint.m_wMaxPacketSize> uartRxBridge(bulkInEndpoint, uart_rx_dma);
+#endif /* defined(USB_APPLICATION_UART) */
+
+#if defined(USB_INTERFACE_VCP) && defined(USB_APPLICATION_UART)
+/* Passes UART Receive Errors on to the Host as CDC SERIAL_STATE Events */
+static void
+usbReportUartErrors(void) {
+    typedef decltype(uart_rx_dma) UartRxDma_t;
+
+    const uint32_t lineErrors = uart_rx_dma.takeLineErrors();
+    uint16_t events = 0;
+
+    if (lineErrors != 0) {
+        USB_TRACE(usbTrace, "UART Line Errors: 0x%x", lineErrors);
+    }
+
+    if (lineErrors & UartRxDma_t::e_LineError_Overrun) {
+        events |= usb::e_UsbCdcSerialState_OverRun;
+    }
+    if (lineErrors & UartRxDma_t::e_LineError_Framing) {
+        events |= usb::e_UsbCdcSerialState_Framing;
+    }
+    if (lineErrors & UartRxDma_t::e_LineError_Parity) {
+        events |= usb::e_UsbCdcSerialState_Parity;
+    }
+    if (lineErrors & UartRxDma_t::e_LineError_Break) {
+        events |= usb::e_UsbCdcSerialState_Break;
+    }
+
+    usbSerialState.reportEvents(events);
+}
+#endif /* defined(USB_INTERFACE_VCP) && defined(USB_APPLICATION_UART) */
+
+#if defined(RTOS_STATIC_ALLOCATION)
+RtosTaskStats_t                                                         rtosTaskStats;
+#endif /* defined(RTOS_STATIC_ALLOCATION) */
+
+#if defined(USB_APPLICATION_LOOPBACK) || defined(USB_APPLICATION_UART) || defined(USB_APPLICATION_STREAM) || defined(USB_INTERFACE_MSC)
+static usb::UsbBulkOutEndpointT<stm32::usb::BulkOutEndpointViaSTM32F4>  bulkOutEndpoint(bulkOutApplication);
+static stm32::usb::BulkOutEndpointViaSTM32F4                            bulkOutHwEndp(usbHwDevice, bulkOutEndpoint, usbBulkOutEndpoint.getNumber());
+#endif /* defined(USB_APPLICATION_LOOPBACK) || defined(USB_APPLICATION_UART) || defined(USB_APPLICATION_STREAM) || defined(USB_INTERFACE_MSC) */
+
+#if defined(USB_INTERFACE_VENDOR)
+/*
+ * Each Set of Vendor Requests wraps the previous one, so all enabled Sets share
+ * the Vendor Interface. The Constructor Arguments of usbInterface follow the
+ * same Order, outermost Set first.
+ */
+typedef usb::UsbVendorInterface                                                             UsbVendorRequests0_t;
+#if defined(RTOS_STATIC_ALLOCATION)
+typedef usb::UsbVendorTaskStatsInterfaceT<decltype(rtosTaskStats), UsbVendorRequests0_t>     UsbVendorRequests1_t;
+#else
+typedef UsbVendorRequests0_t                                                                UsbVendorRequests1_t;
+#endif /* defined(RTOS_STATIC_ALLOCATION) */
+#if defined(USB_TRACING)
+typedef usb::UsbVendorTraceInterfaceT<decltype(usbTrace), UsbVendorRequests1_t>              UsbVendorRequests2_t;
+#else
+typedef UsbVendorRequests1_t                                                                UsbVendorRequests2_t;
+#endif /* defined(USB_TRACING) */
+#if defined(USB_IRQ_PROFILING)
+typedef usb::UsbVendorIrqProfileInterfaceT<decltype(usbIrqProfiler)::Profile_t, UsbVendorRequests2_t>  UsbVendorRequests3_t;
+#else
+typedef UsbVendorRequests2_t                                                                UsbVendorRequests3_t;
+#endif /* defined(USB_IRQ_PROFILING) */
+#if defined(USB_FRAMED_STREAM)
+typedef usb::UsbVendorFramedStreamInterfaceT<decltype(usbFramedStream), UsbVendorRequests3_t>   UsbVendorRequestsInterface_t;
+#else
+typedef UsbVendorRequests3_t                                                                UsbVendorRequestsInterface_t;
+#endif /* defined(USB_FRAMED_STREAM) */
+#endif /* defined(USB_INTERFACE_VENDOR) */
+
+#if defined(USB_INTERFACE_VCP) && defined(USB_APPLICATION_UART)
+static UsbFunctionInterfaceT<usb::UsbVcpLineCodingInterfaceT<decltype(uart_access), decltype(bulkOutApplication)>>  usbInterface(uart_access, bulkOutApplication, /* p_baudRate = */ 230400, bulkOutEndpoint, bulkInEndpoint);
+#elif defined(USB_INTERFACE_VCP)
+static UsbFunctionInterfaceT<usb::UsbVcpInterface>                                       usbInterface(bulkOutEndpoint, bulkInEndpoint);
 #elif defined(USB_INTERFACE_VENDOR)
-static usb::UsbVendorInterface                                      usbInterface(bulkOutEndpoint, bulkInEndpoint);
+static UsbFunctionInterfaceT<UsbVendorRequestsInterface_t>                               usbInterface(
+#if defined(USB_FRAMED_STREAM)
+  usbFramedStream,
+#endif /* defined(USB_FRAMED_STREAM) */
+#if defined(USB_IRQ_PROFILING)
+  usbIrqProfiler.getProfile(),
+#endif /* defined(USB_IRQ_PROFILING) */
+#if defined(USB_TRACING)
+  usbTrace,
+#endif /* defined(USB_TRACING) */
+#if defined(RTOS_STATIC_ALLOCATION)
+  rtosTaskStats,
+#endif /* defined(RTOS_STATIC_ALLOCATION) */
+  bulkOutEndpoint, bulkInEndpoint);
+#elif defined(USB_INTERFACE_MSC)
+static UsbFunctionInterfaceT<usb::UsbMassStorageInterfaceT<decltype(bulkOutApplication)>>    usbInterface(bulkOutApplication, bulkOutEndpoint, bulkInEndpoint);
 #else
 #error No USB Interface defined.
 #endif
 
 static usb::UsbConfiguration                                                usbConfiguration(usbInterface, usbConfigurationDescriptor);
 
-static usb::UsbDevice                                                       genericUsbDevice(usbHwDevice, usbDeviceDescriptor, usbStringDescriptors, { &usbConfiguration });
+typedef usb::UsbRemoteWakeupDeviceT<
+  usb::UsbConfigurationListenerDeviceT<usb::UsbFunctionStringsDevice>,
+  stm32::usb::UsbSuspendViaSTM32F4
+>                                                                           UsbRemoteWakeupDevice_t;
+
+#if defined(USB_ISO_LOOPBACK)
+typedef usb::UsbAlternateSettingDeviceT<UsbRemoteWakeupDevice_t>            UsbGenericDevice_t;
+#else
+typedef UsbRemoteWakeupDevice_t                                             UsbGenericDevice_t;
+#endif /* defined(USB_ISO_LOOPBACK) */
+
+static UsbGenericDevice_t                                                   genericUsbDevice(usbHwDevice, usbDeviceDescriptor, usbStringDescriptors, { &usbConfiguration });
 
 static usb::UsbCtrlInEndpointT                                              ctrlInEndp(defaultHwCtrlInEndpoint);
 static usb::UsbControlPipe                                                  defaultCtrlPipe(genericUsbDevice, ctrlInEndp);
@@ -167,31 +553,143 @@ static stm32::usb::CtrlOutEndpointViaSTM32F4                                defa
  ******************************************************************************/
 static tasks::HeartbeatT<decltype(g_led_green)> heartbeat_gn("hrtbt_g", g_led_green, 3, 500);
 
+#if defined(RTOS_STATIC_ALLOCATION)
+/*
+ * Each Task owns its Control Block and Stack, so the Linker accounts for them
+ * and creating a Task takes nothing from the FreeRTOS Heap.
+ */
+template<size_t nStackDepth> using TaskMemoryT = rtos::StaticTaskT<nStackDepth>;
+
+/* Handed to the Kernel via vApplicationGetIdleTaskMemory() / vApplicationGetTimerTaskMemory() */
+static TaskMemoryT<configMINIMAL_STACK_SIZE>        rtosIdleTaskMemory;
+#if (configUSE_TIMERS == 1)
+static TaskMemoryT<configTIMER_TASK_STACK_DEPTH>    rtosTimerTaskMemory;
+#endif /* (configUSE_TIMERS == 1) */
+#else
+/*
+ * Control Block and Stack of each Task come from the FreeRTOS Heap.
+ */
+template<size_t nStackDepth>
+struct TaskMemoryT {
+    bool
+    create(TaskFunction_t p_function, const char * const p_name, void * const p_parameters, const UBaseType_t p_priority) {
+        return (xTaskCreate(p_function, p_name, nStackDepth, p_parameters, p_priority, nullptr) == pdPASS);
+    }
+};
+#endif /* defined(RTOS_STATIC_ALLOCATION) */
+
+#if defined(RTOS_STATIC_ALLOCATION)
+/*
+ * Takes a Snapshot of the Stack Usage and Run Time of all Tasks once per
+ * Second. With USB_INTERFACE_VENDOR, the Host reads it via a Vendor Request.
+ */
+static TaskMemoryT<128> rtosStatsTaskMemory;
+
+static void
+rtosStatsTask(void * /* p_parameters */) {
+    while (1) {
+        rtosTaskStats.update();
+        vTaskDelay(pdMS_TO_TICKS(1000));
+    }
+}
+#endif /* defined(RTOS_STATIC_ALLOCATION) */
+
+#if defined(USB_APPLICATION_STREAM)
+/*
+ * Drains the Bulk OUT Stream at Task Level and echoes it back in small Records,
+ * which the Bulk IN Writer coalesces into full Packets; replace by a real Consumer.
+ */
+static volatile size_t usbStreamBytesReceived = 0;
+static TaskMemoryT<256> usbStreamTaskMemory;
+
+static void
+usbStreamTask(void * /* p_parameters */) {
+    static uint8_t record[16];
+
+    while (1) {
+        const size_t length = bulkOutApplication.read(record, sizeof(record));
+
+        for (size_t written = 0; written < length; ) {
+            written += bulkInWriter.write(&record[written], length - written);
+            if (written < length) {
+                vTaskDelay(1);
+            }
+        }
+
+        usbStreamBytesReceived += length;
+    }
+}
+#endif /* defined(USB_APPLICATION_STREAM) */
+
+#if defined(USB_TRACING) && !defined(USB_INTERFACE_VENDOR)
+/*
+ * Prints the Trace Events as raw Hex Words on the Debug UART, for
+ * usbtrace-decode.py. Runs at Idle Priority, so the Formatting never delays
+ * the Code that records the Events. With USB_INTERFACE_VENDOR, the Host drains
+ * the Trace via a Vendor Request instead.
+ */
+struct UsbTraceUartSink {
+    void
+    write(const usb::UsbTraceEvent_t * const p_events, const size_t p_numEvents) const {
+        for (size_t idx = 0; idx < p_numEvents; idx++) {
+            PHISCH_LOG("T %08lx %08lx %08lx %08lx\r\n",
+              static_cast<unsigned long>(p_events[idx].m_format), static_cast<unsigned long>(p_events[idx].m_timestamp),
+              static_cast<unsigned long>(p_events[idx].m_arg[0]), static_cast<unsigned long>(p_events[idx].m_arg[1]));
+        }
+    }
+};
+
+static TaskMemoryT<256> usbTraceTaskMemory;
+
+static void
+usbTraceTask(void * /* p_parameters */) {
+    UsbTraceUartSink sink;
+
+    while (1) {
+        usbTrace.drain(sink);
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
+#endif /* defined(USB_TRACING) && !defined(USB_INTERFACE_VENDOR) */
+
+static TaskMemoryT<usbPowerTaskStackDepth> usbPowerTaskMemory;
+
+/*
+ * Puts the CPU into a low-power Mode while the Bus is suspended and signals
+ * Remote Wakeup when the Application asked for it. Runs at Idle Priority.
+ */
+static void
+usbPowerTask(void * /* p_parameters */) {
+    while (1) {
+        if (usbSuspend.isRemoteWakeupRequested() && usbSuspend.startRemoteWakeup()) {
+            vTaskDelay(pdMS_TO_TICKS(5));   /* Resume Signalling must last 1 to 15 ms */
+            usbSuspend.stopRemoteWakeup();
+        }
+
+        if (!lowPower.enterIf([] { return usbSuspend.isSuspended() && !usbSuspend.isRemoteWakeupRequested(); })) {
+            vTaskDelay(1);
+        }
+    }
+}
+
 /*******************************************************************************
  *
  ******************************************************************************/
 const uint32_t SystemCoreClock = pllCfg.getSysclkSpeedInHz();
 
-static_assert(pllCfg.isValid() == true,                             "PLL Configuration is not valid!");
-static_assert(SystemCoreClock               == 168 * 1000 * 1000,   "Expected System Clock to be at 168 MHz!");
-static_assert(pllCfg.getAhbSpeedInHz()      == 168 * 1000 * 1000,   "Expected AHB to be running at 168 MHz!");
-static_assert(pllCfg.getApb1SpeedInHz()     ==  42 * 1000 * 1000,   "Expected APB1 to be running at 42 MHz!");
-static_assert(pllCfg.getApb2SpeedInHz()     ==  84 * 1000 * 1000,   "Expected APB2 to be running at 84 MHz!");
+static_assert(pllCfg.isValid() == true,                                         "PLL Configuration is not valid!");
+static_assert(pllSolution.m_pll48SpeedInHz  == stm32::PllSolver::m_usbClockInHz, "Expected USB Clock to be at exactly 48 MHz!");
+static_assert(SystemCoreClock               == pllSolution.m_sysclkSpeedInHz,   "System Clock does not match the PLL Solution!");
+static_assert(pllCfg.getAhbSpeedInHz()      == pllSolution.m_sysclkSpeedInHz,   "Expected AHB to be running at the System Clock!");
+static_assert(pllCfg.getApb1SpeedInHz()     <= boardClockLimits.m_apb1MaxInHz,  "APB1 exceeds the Device's Limit!");
+static_assert(pllCfg.getApb2SpeedInHz()     <= boardClockLimits.m_apb2MaxInHz,  "APB2 exceeds the Device's Limit!");
 
 /*******************************************************************************
- *
+ * Sets up the Clocks, the UART and the USB Device and creates the Tasks. Shared
+ * by the Firmware's main() and the Host Tests in UsbHostTests.cpp.
  ******************************************************************************/
-#if defined(__cplusplus)
-extern "C" {
-#endif /* defined(__cplusplus) */
-
-#if defined(HOSTBUILD)
-int
-#else
-[[noreturn]]
-void
-#endif
-main(void) {
+bool
+setup(void) {
     rcc.setMCO(g_mco1, decltype(rcc)::MCO1Output_e::e_PLL, decltype(rcc)::MCOPrescaler_t::e_MCOPre_5);
 
     uart_access.setBaudRate(decltype(uart_access)::BaudRate_e::e_230400);
@@ -206,11 +704,165 @@ main(void) {
     /* Inform FreeRTOS about clock speed */
     if (SysTick_Config(SystemCoreClock / configTICK_RATE_HZ)) {
         PHISCH_LOG("FATAL: Capture Error!\r\n");
-        goto bad;
+        return (false);
     }
 
+#if defined(USB_IRQ_PROFILING)
+    UsbIrqCycleCounter_t::enable();
+#endif /* defined(USB_IRQ_PROFILING) */
+#if defined(USB_TRACING)
+    UsbTraceCycleCounter_t::enable();
+#endif /* defined(USB_TRACING) */
+#if defined(RTOS_STATIC_ALLOCATION) && !defined(HOSTBUILD)
+    /* Time Base of the FreeRTOS Run-Time Stats, see CMakeLists.txt */
+    stm32::DwtCycleCounter::enable();
+#endif /* defined(RTOS_STATIC_ALLOCATION) && !defined(HOSTBUILD) */
+
+#if defined(USB_FRAMED_STREAM)
+    UsbFrameCrc_t::enable();
+    bulkOutZeroCopy.registerApplication(usbFramedStream);
+#elif defined(USB_APPLICATION_LOOPBACK) || defined(USB_INTERFACE_MSC)
+    bulkOutZeroCopy.registerApplication(bulkOutApplication);
+#endif /* defined(USB_FRAMED_STREAM) */
+#if defined(USB_APPLICATION_LOOPBACK) || defined(USB_INTERFACE_MSC)
+    usbEndpointDispatcher.registerOutEndpoint<usbBulkOutEndpoint.getNumber()>(bulkOutZeroCopy);
+#endif /* defined(USB_APPLICATION_LOOPBACK) || defined(USB_INTERFACE_MSC) */
+#if defined(USB_INTERFACE_MSC)
+    usbEndpointDispatcher.registerInEndpoint<usbBulkInEndpoint.getNumber()>(bulkInFifo);
+    genericUsbDevice.addConfigurationListener(bulkInFifoConfiguration);
+#endif /* defined(USB_INTERFACE_MSC) */
+
+#if defined(USB_COMPOSITE_LOOPBACK)
+    loopbackOutEndpoint.registerApplication(loopbackApplication);
+    usbEndpointDispatcher.registerOutEndpoint<usbLoopbackOutEndpoint.getNumber()>(loopbackOutEndpoint);
+    usbEndpointDispatcher.registerInEndpoint<usbLoopbackInEndpoint.getNumber()>(loopbackInEndpoint);
+    genericUsbDevice.addConfigurationListener(loopbackOutEndpointConfiguration);
+    genericUsbDevice.addConfigurationListener(loopbackInEndpointConfiguration);
+#endif /* defined(USB_COMPOSITE_LOOPBACK) */
+
+#if defined(USB_INTERFACE_VCP)
+    genericUsbDevice.addConfigurationListener(notificationEndpointConfiguration);
+
+    /* USART6 has no Modem Control Lines, so the Line is always reported as connected */
+    usbSerialState.setLineState(usb::e_UsbCdcSerialState_RxCarrier | usb::e_UsbCdcSerialState_TxCarrier);
+#if defined(USB_APPLICATION_UART)
+    usbInterface.setSerialState(usbSerialState);
+#endif /* defined(USB_APPLICATION_UART) */
+#endif /* defined(USB_INTERFACE_VCP) */
+
+    genericUsbDevice.setFunctionStrings(usbFunctionStrings);
+    /* Remote Wakeup stays off until the Host enables it via SET_FEATURE(DEVICE_REMOTE_WAKEUP) */
+    genericUsbDevice.setRemoteWakeup(usbSuspend);
+#if defined(USB_ISO_LOOPBACK)
+    genericUsbDevice.setAlternateSettingHandler(isoAlternateSetting, usbIsoInterfaceNumber);
+#endif /* defined(USB_ISO_LOOPBACK) */
+
+#if defined(USB_DFU)
+    usbInterface.setDfu(usbDfu, usbDfuInterfaceNumber);
+
+    /* Flash Interrupt drives the DFU Download, so it must not preempt the USB Interrupt (or vice versa) */
+    NVIC_SetPriority(FLASH_IRQn, NVIC_GetPriority(usbOtgIrq));
+    NVIC_EnableIRQ(FLASH_IRQn);
+#endif /* defined(USB_DFU) */
+
     usbHwDevice.start();
 
+    usbSuspend.enable();
+    NVIC_SetPriority(usbOtgWakeupIrq, NVIC_GetPriority(usbOtgIrq));
+    NVIC_EnableIRQ(usbOtgWakeupIrq);
+
+#if defined(USB_APPLICATION_UART)
+    /* UART Rx Path feeds the Bulk IN Endpoint, so it must not preempt the USB Interrupt (or vice versa) */
+    NVIC_SetPriority(USART6_IRQn, NVIC_GetPriority(usbOtgIrq));
+    NVIC_SetPriority(DMA2_Stream1_IRQn, NVIC_GetPriority(usbOtgIrq));
+    NVIC_SetPriority(DMA2_Stream6_IRQn, NVIC_GetPriority(usbOtgIrq));
+
+#if defined(USB_INTERFACE_VCP)
+    /* Host may change the Baud Rate via SET_LINE_CODING later on */
+    if (!usbInterface.start()) {
+        PHISCH_LOG("FATAL: Baud Rate not supported!\r\n");
+        return (false);
+    }
+#endif /* defined(USB_INTERFACE_VCP) */
+
+    bulkOutApplication.start();
+    uartRxBridge.start();
+
+    NVIC_EnableIRQ(USART6_IRQn);
+    NVIC_EnableIRQ(DMA2_Stream1_IRQn);
+    NVIC_EnableIRQ(DMA2_Stream6_IRQn);
+#endif /* defined(USB_APPLICATION_UART) */
+
+#if defined(USB_APPLICATION_STREAM) || defined(USB_ISO_LOOPBACK) || defined(USB_INTERFACE_VCP) || defined(USB_COMPOSITE_LOOPBACK) || defined(USB_INTERFACE_MSC)
+    usbSof.enable();
+#endif /* defined(USB_APPLICATION_STREAM) || defined(USB_ISO_LOOPBACK) || defined(USB_INTERFACE_VCP) || defined(USB_COMPOSITE_LOOPBACK) || defined(USB_INTERFACE_MSC) */
+
+#if defined(USB_ISO_LOOPBACK)
+    isoOutEndpoint.registerApplication(isoLoopback);
+#endif /* defined(USB_ISO_LOOPBACK) */
+
+#if defined(USB_APPLICATION_STREAM)
+    if (!usbStreamTaskMemory.create(usbStreamTask, "usbstrm", nullptr, tskIDLE_PRIORITY + 1)) {
+        PHISCH_LOG("FATAL: Could not create USB Stream Task!\r\n");
+        return (false);
+    }
+#endif /* defined(USB_APPLICATION_STREAM) */
+
+    if (!usbPowerTaskMemory.create(usbPowerTask, "usbpwr", nullptr, tskIDLE_PRIORITY)) {
+        PHISCH_LOG("FATAL: Could not create USB Power Task!\r\n");
+        return (false);
+    }
+
+#if defined(USB_TRACING) && !defined(USB_INTERFACE_VENDOR)
+    if (!usbTraceTaskMemory.create(usbTraceTask, "usbtrc", nullptr, tskIDLE_PRIORITY)) {
+        PHISCH_LOG("FATAL: Could not create USB Trace Task!\r\n");
+        return (false);
+    }
+#endif /* defined(USB_TRACING) && !defined(USB_INTERFACE_VENDOR) */
+
+#if defined(RTOS_STATIC_ALLOCATION)
+    if (!rtosStatsTaskMemory.create(rtosStatsTask, "rtstats", nullptr, tskIDLE_PRIORITY)) {
+        PHISCH_LOG("FATAL: Could not create Task Statistics Task!\r\n");
+        return (false);
+    }
+
+    /* Stack Sizes for the Statistics; Tasks on the Heap, e.g. the Heartbeat, are reported without */
+    rtosTaskStats.add(rtosIdleTaskMemory);
+#if (configUSE_TIMERS == 1)
+    rtosTaskStats.add(rtosTimerTaskMemory);
+#endif /* (configUSE_TIMERS == 1) */
+    rtosTaskStats.add(rtosStatsTaskMemory);
+    rtosTaskStats.add(usbPowerTaskMemory);
+#if defined(USB_APPLICATION_STREAM)
+    rtosTaskStats.add(usbStreamTaskMemory);
+#endif /* defined(USB_APPLICATION_STREAM) */
+#if defined(USB_TRACING) && !defined(USB_INTERFACE_VENDOR)
+    rtosTaskStats.add(usbTraceTaskMemory);
+#endif /* defined(USB_TRACING) && !defined(USB_INTERFACE_VENDOR) */
+#endif /* defined(RTOS_STATIC_ALLOCATION) */
+
+    return (true);
+}
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+#if !defined(USB_HOST_TESTS)
+#if defined(HOSTBUILD)
+int
+#else
+[[noreturn]]
+void
+#endif
+main(void) {
+    if (!setup()) {
+        goto bad;
+    }
+
     PHISCH_LOG("Starting FreeRTOS Scheduler...\r\n");
     vTaskStartScheduler();
 
@@ -224,6 +876,7 @@ bad:
     return (0);
 #endif
 }
+#endif /* !defined(USB_HOST_TESTS) */
 
 #if defined(__cplusplus)
 } /* extern "C" */
@@ -238,12 +891,55 @@ extern "C" {
 
 void
 OTG_FS_WKUP_IRQHandler(void) {
-    while (1) ;
+    usbSuspend.handleWakeupIrq();
 }
 
 void
 OTG_FS_IRQHandler(void) {
+    USB_TRACE(usbTrace, "OTG IRQ: GINTSTS=0x%08x GINTMSK=0x%08x",
+      reinterpret_cast<USB_OTG_GlobalTypeDef *>(usbOtgBase)->GINTSTS, reinterpret_cast<USB_OTG_GlobalTypeDef *>(usbOtgBase)->GINTMSK);
+
+    if (usbSuspend.handleIrq()) {
+        USB_TRACE(usbTrace, "USB Suspend: suspended=%u", usbSuspend.isSuspended());
+    }
+
+#if defined(USB_APPLICATION_LOOPBACK) || defined(USB_COMPOSITE_LOOPBACK) || defined(USB_INTERFACE_MSC)
+    usbEndpointDispatcher.handleIrq();
+#endif /* defined(USB_APPLICATION_LOOPBACK) || defined(USB_COMPOSITE_LOOPBACK) || defined(USB_INTERFACE_MSC) */
+
+#if defined(USB_ISO_LOOPBACK)
+    isoOutEndpoint.handleIrq();
+    isoInEndpoint.handleIrq();
+#endif /* defined(USB_ISO_LOOPBACK) */
+
+#if defined(USB_APPLICATION_STREAM) || defined(USB_ISO_LOOPBACK) || defined(USB_INTERFACE_VCP) || defined(USB_COMPOSITE_LOOPBACK) || defined(USB_INTERFACE_MSC)
+    if (usbSof.handleIrq()) {
+#if defined(USB_ISO_LOOPBACK)
+        /* OUT first, so the Packet of the last Frame goes out in this one */
+        isoOutEndpoint.handleSof();
+        isoInEndpoint.handleSof();
+#endif /* defined(USB_ISO_LOOPBACK) */
+#if defined(USB_INTERFACE_VCP)
+        notificationEndpoint.handleSof();
+        usbSerialState.handleSof();
+#endif /* defined(USB_INTERFACE_VCP) */
+#if defined(USB_COMPOSITE_LOOPBACK)
+        loopbackInEndpoint.handleSof();
+#endif /* defined(USB_COMPOSITE_LOOPBACK) */
+#if defined(USB_APPLICATION_STREAM)
+        bulkInWriter.handleSof();
+#endif /* defined(USB_APPLICATION_STREAM) */
+#if defined(USB_INTERFACE_MSC)
+        bulkInFifo.handleSof();
+#endif /* defined(USB_INTERFACE_MSC) */
+    }
+#endif /* defined(USB_APPLICATION_STREAM) || defined(USB_ISO_LOOPBACK) || defined(USB_INTERFACE_VCP) || defined(USB_COMPOSITE_LOOPBACK) || defined(USB_INTERFACE_MSC) */
+
+#if defined(USB_IRQ_PROFILING)
+    usbIrqProfiler.handleIrq(usbCore);
+#else
     usbCore.handleIrq();
+#endif /* defined(USB_IRQ_PROFILING) */
 }
 
 void
@@ -257,15 +953,72 @@ OTG_HS_EP1_IN_IRQHandler(void) {
 }
 
 void
-OTG_HS_WKUP_IRQHandler(void) {
+OTG_HS_IRQHandler(void) {
     while (1) ;
 }
 
 void
-OTG_HS_IRQHandler(void) {
+OTG_HS_WKUP_IRQHandler(void) {
     while (1) ;
 }
 
+#if defined(USB_APPLICATION_UART)
+void
+USART6_IRQHandler(void) {
+    uartRxBridge.handleUartIrq();
+#if defined(USB_INTERFACE_VCP)
+    usbReportUartErrors();
+    /* Transmit Path drained after SET_LINE_CODING */
+    usbInterface.handleUartTxIrq();
+#endif /* defined(USB_INTERFACE_VCP) */
+
+    /* Data for the Host has arrived; no-op unless the Bus is suspended */
+    usbSuspend.requestRemoteWakeup();
+}
+
+void
+DMA2_Stream1_IRQHandler(void) {
+    uartRxBridge.handleDmaIrq();
+}
+
+void
+DMA2_Stream6_IRQHandler(void) {
+    bulkOutApplication.handleDmaIrq();
+#if defined(USB_INTERFACE_VCP)
+    usbInterface.handleUartTxIrq();
+#endif /* defined(USB_INTERFACE_VCP) */
+}
+#endif /* defined(USB_APPLICATION_UART) */
+
+#if defined(USB_DFU)
+void
+FLASH_IRQHandler(void) {
+    usbDfu.handleFlashIrq();
+}
+#endif /* defined(USB_DFU) */
+
+#if defined(RTOS_STATIC_ALLOCATION)
+/*
+ * With configSUPPORT_STATIC_ALLOCATION, the Kernel asks for the Memory of the
+ * Tasks it creates itself instead of taking it from the Heap.
+ */
+void
+vApplicationGetIdleTaskMemory(StaticTask_t **p_tcb, StackType_t **p_stack, uint32_t *p_stackDepth) {
+    *p_tcb          = rtosIdleTaskMemory.getTcb();
+    *p_stack        = rtosIdleTaskMemory.getStack();
+    *p_stackDepth   = rtosIdleTaskMemory.getStackDepth();
+}
+
+#if (configUSE_TIMERS == 1)
+void
+vApplicationGetTimerTaskMemory(StaticTask_t **p_tcb, StackType_t **p_stack, uint32_t *p_stackDepth) {
+    *p_tcb          = rtosTimerTaskMemory.getTcb();
+    *p_stack        = rtosTimerTaskMemory.getStack();
+    *p_stackDepth   = rtosTimerTaskMemory.getStackDepth();
+}
+#endif /* (configUSE_TIMERS == 1) */
+#endif /* defined(RTOS_STATIC_ALLOCATION) */
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined (__cplusplus) */
@@ -0,0 +1,151 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _MAIN_HPP_2C8E5B17_
+#define _MAIN_HPP_2C8E5B17_
+
+#include <usb/UsbSuspendViaSTM32F4.hpp>
+
+#if defined(HOSTBUILD)
+#include <usb/OtgFsRegisterModel.hpp>
+#endif /* defined(HOSTBUILD) */
+
+#if defined(USB_INTERFACE_VCP)
+#include <usb/InterruptInEndpointViaSTM32F4.hpp>
+#include <usb/UsbCdcSerialState.hpp>
+#endif /* defined(USB_INTERFACE_VCP) */
+
+#if defined(USB_FRAMED_STREAM)
+#include <usb/UsbFramedStream.hpp>
+#include <stm32/Crc.hpp>
+#endif /* defined(USB_FRAMED_STREAM) */
+
+#if defined(USB_INTERFACE_MSC)
+#include <usb/UsbBlockDevice.hpp>
+#include <stm32/FlashBlockDevice.hpp>
+#endif /* defined(USB_INTERFACE_MSC) */
+
+#if defined(USB_DFU)
+#include <stm32/FlashProgrammer.hpp>
+#endif /* defined(USB_DFU) */
+
+#if defined(USB_ISO_LOOPBACK)
+#include <usb/IsoEndpointViaSTM32F4.hpp>
+#endif /* defined(USB_ISO_LOOPBACK) */
+
+#if defined(USB_TRACING)
+#include <usb/UsbTrace.hpp>
+#include <stm32/CycleCounter.hpp>
+#endif /* defined(USB_TRACING) */
+
+#if defined(RTOS_STATIC_ALLOCATION)
+#include <rtos/TaskStats.hpp>
+#endif /* defined(RTOS_STATIC_ALLOCATION) */
+
+#include "UsbDescriptors.hpp"
+
+#include <cstddef>
+
+/*******************************************************************************
+ * Objects of the Firmware (main.cpp) that the USB Host Tests (UsbHostTests.cpp)
+ * link against. The Types are defined here, so both Sides agree on them.
+ ******************************************************************************/
+bool setup(void);
+
+#if defined(HOSTBUILD)
+extern "C" void OTG_FS_IRQHandler(void);
+extern "C" void OTG_FS_WKUP_IRQHandler(void);
+
+extern stm32::usb::OtgFsRegisterModel       otgFsModel;
+#endif /* defined(HOSTBUILD) */
+
+extern stm32::usb::UsbSuspendViaSTM32F4     usbSuspend;
+
+/* Stack Depth of the Power Task in Words */
+static constexpr size_t                     usbPowerTaskStackDepth = 128;
+
+#if defined(USB_INTERFACE_VCP)
+typedef stm32::usb::InterruptInEndpointViaSTM32F4<
+  usbNotificationEndpoint.getNumber(),
+  usbNotificationEndpoint.m_wMaxPacketSize
+>                                                                   UsbNotificationEndpoint_t;
+typedef usb::UsbCdcSerialStateNotifierT<UsbNotificationEndpoint_t>  UsbSerialState_t;
+
+extern UsbSerialState_t                     usbSerialState;
+#endif /* defined(USB_INTERFACE_VCP) */
+
+#if defined(USB_FRAMED_STREAM)
+#if defined(HOSTBUILD)
+typedef stm32::SoftwareCrc                  UsbFrameCrc_t;
+#else
+typedef stm32::CrcViaSTM32F4                UsbFrameCrc_t;
+#endif /* defined(HOSTBUILD) */
+
+typedef usb::UsbFramedStreamT<
+  UsbFrameCrc_t,
+  /* nNumStreams = */ 4,
+  usbBulkOutEndpoint.m_wMaxPacketSize
+>                                                                   UsbFramedStream_t;
+
+extern UsbFramedStream_t                    usbFramedStream;
+#endif /* defined(USB_FRAMED_STREAM) */
+
+#if defined(USB_INTERFACE_MSC)
+#if defined(HOSTBUILD)
+/* 32 KB, enough for a FAT12 Volume */
+typedef usb::UsbRamDiskT</* nNumBlocks = */ 64>    UsbMscDisk_t;
+#else
+typedef stm32::FlashBlockDeviceViaSTM32F4           UsbMscDisk_t;
+#endif /* defined(HOSTBUILD) */
+
+extern UsbMscDisk_t                         usbMscDisk;
+#endif /* defined(USB_INTERFACE_MSC) */
+
+#if defined(USB_DFU)
+#if defined(HOSTBUILD)
+typedef stm32::MockFlashT</* nSize = */ 1024 * 1024>   UsbDfuFlash_t;
+#else
+typedef stm32::FlashProgrammerViaSTM32F4                UsbDfuFlash_t;
+#endif /* defined(HOSTBUILD) */
+
+#if defined(STM32F411xE) && !defined(HOSTBUILD)
+/* Sectors 6 and 7, the upper 256 KB of the Flash; the Firmware must fit into the lower Half */
+static constexpr size_t                     usbDfuSlotOffset    = 256 * 1024;
+static constexpr size_t                     usbDfuSlotSz        = 256 * 1024;
+#else
+/* Sectors 8 to 11, the upper 512 KB of the Flash; the Firmware must fit into the lower Half */
+static constexpr size_t                     usbDfuSlotOffset    = 512 * 1024;
+static constexpr size_t                     usbDfuSlotSz        = 512 * 1024;
+#endif /* defined(STM32F411xE) && !defined(HOSTBUILD) */
+
+extern UsbDfuFlash_t                        usbDfuFlash;
+#endif /* defined(USB_DFU) */
+
+#if defined(USB_ISO_LOOPBACK)
+typedef stm32::usb::IsoInEndpointViaSTM32F4<usbIsoInEndpoint.getNumber(), usbIsoInEndpoint.m_wMaxPacketSize>     UsbIsoInEndpoint_t;
+typedef stm32::usb::IsoOutEndpointViaSTM32F4<usbIsoOutEndpoint.getNumber(), usbIsoOutEndpoint.m_wMaxPacketSize>  UsbIsoOutEndpoint_t;
+
+extern UsbIsoInEndpoint_t                   isoInEndpoint;
+extern UsbIsoOutEndpoint_t                  isoOutEndpoint;
+#endif /* defined(USB_ISO_LOOPBACK) */
+
+#if defined(USB_TRACING)
+#if defined(HOSTBUILD)
+typedef stm32::MockCycleCounter             UsbTraceCycleCounter_t;
+#else
+typedef stm32::DwtCycleCounter              UsbTraceCycleCounter_t;
+#endif /* defined(HOSTBUILD) */
+
+typedef usb::UsbTraceT<UsbTraceCycleCounter_t, 256>   UsbTrace_t;
+
+extern UsbTrace_t                           usbTrace;
+#endif /* defined(USB_TRACING) */
+
+#if defined(RTOS_STATIC_ALLOCATION)
+/* Stack Usage and Run Time of all Tasks; updated by rtosStatsTask() */
+typedef rtos::TaskStatsT<8>                 RtosTaskStats_t;
+
+extern RtosTaskStats_t                      rtosTaskStats;
+#endif /* defined(RTOS_STATIC_ALLOCATION) */
+
+#endif /* _MAIN_HPP_2C8E5B17_ */
@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+#-
+# $Copyright$
+#
+"""Report how much RAM the Firmware uses and what for.
+
+Reads the Section Headers and the Symbol Table of the linked ELF File and, for
+each Memory Region, prints the Bytes taken by the allocated Sections (.data,
+.bss, the Linker's Stack / Heap Reservation, ...) and the Bytes left. It then
+lists the Memory of all static Tasks (rtos::StaticTaskT Objects named
+...TaskMemory), the FreeRTOS Heap and the largest Objects.
+
+Usage:
+    ram-report.py [--region NAME:START:SIZE ...] [--top N] firmware.elf
+"""
+
+import argparse
+import shutil
+import struct
+import subprocess
+import sys
+
+SHT_SYMTAB = 2
+SHF_ALLOC = 0x2
+STT_OBJECT = 1
+
+# STM32F407: 128 KB SRAM (SRAM1 + SRAM2) and 64 KB Core-Coupled Memory
+DEFAULT_REGIONS = ['RAM:0x20000000:128K', 'CCM:0x10000000:64K']
+
+
+def parse_region(text):
+    """Parse NAME:START:SIZE, where SIZE may end in K."""
+    name, start, size = text.split(':')
+    scale = 1024 if size[-1] in 'kK' else 1
+    return name, int(start, 0), int(size.rstrip('kK'), 0) * scale
+
+
+def read_elf(elf_path):
+    """Return the allocated Sections as (Name, Address, Size) and the Objects as (Name, Address, Size)."""
+    with open(elf_path, 'rb') as elf_file:
+        elf = elf_file.read()
+
+    if elf[:4] != b'\x7fELF' or elf[5] != 1:
+        raise ValueError('%s is not a Little-Endian ELF File' % elf_path)
+
+    if elf[4] == 1:
+        shoff, = struct.unpack_from('<I', elf, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from('<HHH', elf, 0x2E)
+        sh_fmt, sym_fmt = '<IIIIIIIIII', '<IIIBBH'
+    else:
+        shoff, = struct.unpack_from('<Q', elf, 0x28)
+        shentsize, shnum, shstrndx = struct.unpack_from('<HHH', elf, 0x3A)
+        sh_fmt, sym_fmt = '<IIQQQQIIQQ', '<IBBHQQ'
+
+    sections = [struct.unpack_from(sh_fmt, elf, shoff + idx * shentsize) for idx in range(shnum)]
+
+    def string(table, offset):
+        start = sections[table][4] + offset
+        return elf[start:elf.index(b'\0', start)].decode('ascii', 'replace')
+
+    allocated = [(string(shstrndx, section[0]), section[3], section[5])
+                 for section in sections if section[2] & SHF_ALLOC and section[5] > 0]
+    objects = []
+
+    for section in sections:
+        if section[1] != SHT_SYMTAB:
+            continue
+
+        for offset in range(section[4], section[4] + section[5], section[9]):
+            if elf[4] == 1:
+                name, value, size, info, _other, shndx = struct.unpack_from(sym_fmt, elf, offset)
+            else:
+                name, info, _other, shndx, value, size = struct.unpack_from(sym_fmt, elf, offset)
+
+            if (info & 0xF) == STT_OBJECT and size > 0 and shndx != 0:
+                objects.append((string(section[6], name), value, size))
+
+    return allocated, objects
+
+
+def demangle(names, cxxfilt):
+    """Demangle C++ Names via c++filt, if available."""
+    tool = shutil.which(cxxfilt)
+    if tool is None or not names:
+        return names
+
+    result = subprocess.run([tool], input='\n'.join(names), stdout=subprocess.PIPE, universal_newlines=True, check=False)
+    demangled = result.stdout.splitlines()
+    return demangled if len(demangled) == len(names) else names
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Report the RAM Usage of the Firmware.')
+    parser.add_argument('--region', action='append', help='Memory Region NAME:START:SIZE (default: %s)' % ', '.join(DEFAULT_REGIONS))
+    parser.add_argument('--top', type=int, default=15, help='Number of largest Objects to list (default: 15)')
+    parser.add_argument('--cxxfilt', default='c++filt', help='Demangler, e.g. arm-none-eabi-c++filt (default: c++filt)')
+    parser.add_argument('elf', help='Firmware ELF File')
+    options = parser.parse_args()
+
+    regions = [parse_region(text) for text in (options.region or DEFAULT_REGIONS)]
+    allocated, objects = read_elf(options.elf)
+
+    def in_region(address, region):
+        return region[1] <= address < region[1] + region[2]
+
+    for region in regions:
+        sections = [section for section in allocated if in_region(section[1], region)]
+        used = sum(section[2] for section in sections)
+        if not sections:
+            continue
+
+        print('%-6s %8u Bytes used of %8u (%5.1f%%), %8u Bytes free' % (region[0], used, region[2], 100.0 * used / region[2], region[2] - used))
+        for name, address, size in sorted(sections, key=lambda section: section[1]):
+            print('    %-24s 0x%08x %8u' % (name, address, size))
+
+    objects = [entry for entry in objects if any(in_region(entry[1], region) for region in regions)]
+    names = demangle([entry[0] for entry in objects], options.cxxfilt)
+    objects = [(name, entry[1], entry[2]) for name, entry in zip(names, objects)]
+
+    tasks = [entry for entry in objects if entry[0].endswith('TaskMemory')]
+    print('Task Memory (TCB + Stack): %u Bytes in %u Tasks' % (sum(entry[2] for entry in tasks), len(tasks)))
+    for name, _address, size in sorted(tasks, key=lambda entry: -entry[2]):
+        print('    %-40s %8u' % (name, size))
+
+    for name, _address, size in objects:
+        if name == 'ucHeap':
+            print('FreeRTOS Heap (ucHeap): %u Bytes' % size)
+
+    print('Largest Objects:')
+    for name, address, size in sorted(objects, key=lambda entry: -entry[2])[:options.top]:
+        print('    %-40s 0x%08x %8u' % (name, address, size))
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,82 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _RTOS_STATIC_TASK_HPP_B37E1B33_
+#define _RTOS_STATIC_TASK_HPP_B37E1B33_
+
+#include <FreeRTOS.h>
+#include <FreeRTOS/include/task.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#if (configSUPPORT_STATIC_ALLOCATION != 1)
+#error rtos::StaticTaskT requires configSUPPORT_STATIC_ALLOCATION.
+#endif /* (configSUPPORT_STATIC_ALLOCATION != 1) */
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace rtos {
+
+/***************************************************************************//**
+ * @brief FreeRTOS Task whose Control Block and Stack are static Storage.
+ *
+ * The Object holds the Memory that \c xTaskCreate() would take from the Heap.
+ * The Linker accounts for the Stack, and creating the Task cannot fail for
+ * lack of Memory. The Object must outlive the Task, i.e. it is meant to be a
+ * static Object itself.
+ *
+ * @tparam nStackDepth Stack Size in Words, as passed to \c xTaskCreate().
+ ******************************************************************************/
+template<size_t nStackDepth>
+class StaticTaskT {
+    StaticTask_t    m_tcb;
+    StackType_t     m_stack[nStackDepth];
+    TaskHandle_t    m_handle;
+
+public:
+    StaticTaskT(void) : m_tcb {}, m_stack {}, m_handle(nullptr) {
+
+    }
+
+    bool
+    create(TaskFunction_t p_function, const char * const p_name, void * const p_parameters, const UBaseType_t p_priority) {
+        m_handle = xTaskCreateStatic(p_function, p_name, nStackDepth, p_parameters, p_priority, m_stack, &m_tcb);
+
+        return (m_handle != nullptr);
+    }
+
+    TaskHandle_t
+    getHandle(void) const {
+        return m_handle;
+    }
+
+    /*
+     * For Tasks that the Kernel creates itself, e.g. via
+     * vApplicationGetIdleTaskMemory().
+     */
+    StaticTask_t *
+    getTcb(void) {
+        return &m_tcb;
+    }
+
+    StackType_t *
+    getStack(void) {
+        return m_stack;
+    }
+
+    const StackType_t *
+    getStack(void) const {
+        return m_stack;
+    }
+
+    static constexpr size_t
+    getStackDepth(void) {
+        return nStackDepth;
+    }
+};
+
+} /* namespace rtos */
+
+#endif /* _RTOS_STATIC_TASK_HPP_B37E1B33_ */
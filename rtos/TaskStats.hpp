@@ -0,0 +1,175 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _RTOS_TASK_STATS_HPP_DC1B69F5_
+#define _RTOS_TASK_STATS_HPP_DC1B69F5_
+
+#include <FreeRTOS.h>
+#include <FreeRTOS/include/task.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if (configUSE_TRACE_FACILITY != 1)
+#error rtos::TaskStatsT requires configUSE_TRACE_FACILITY.
+#endif /* (configUSE_TRACE_FACILITY != 1) */
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace rtos {
+
+/***************************************************************************//**
+ * @brief Snapshot of the Stack Usage and Run Time of all FreeRTOS Tasks.
+ *
+ * update() takes the Snapshot via \c uxTaskGetSystemState(), so it must be
+ * called at Task Level, e.g. once per Second by a low-priority Task. The
+ * Snapshot is double-buffered: getTable() always returns the last complete
+ * one, so an Interrupt can copy it while the next one is taken.
+ *
+ * Per Task, the Table holds:
+ * - The Stack Size in Words, for Stacks registered via add(). Zero means that
+ *   the Task's Stack was not registered, e.g. because it is on the Heap.
+ * - The Stack High-Water Mark, i.e. the min. Number of free Words so far.
+ * - The Run-Time Counter, in Units of \c portGET_RUN_TIME_COUNTER_VALUE().
+ *
+ * The Run-Time Counters wrap, so the Host computes the CPU Load of a Task as
+ * the unsigned Difference of its Counter between two Snapshots, divided by
+ * that of \c m_totalRunTime.
+ *
+ * The Table is a packed Structure with a small Header so that it can be sent
+ * to the Host as-is.
+ *
+ * FreeRTOS only reports all Tasks or none. If there are more than
+ * \p nMaxTasks Tasks, the Snapshot therefore has no Entries and no Total Run
+ * Time, and the Header carries \c m_flagOverflow, so the Host can tell it
+ * from a System without Tasks.
+ *
+ * @tparam nMaxTasks Max. Number of Tasks, incl. the Idle and Timer Task.
+ ******************************************************************************/
+template<unsigned nMaxTasks = 8>
+class TaskStatsT {
+    static_assert(nMaxTasks <= 0xFF, "Too many Tasks");
+
+public:
+    static constexpr size_t m_maxNameLength = 8;
+
+    typedef struct Entry_s {
+        char        m_name[m_maxNameLength];    /* Zero-padded, not necessarily terminated */
+        uint8_t     m_number;
+        uint8_t     m_priority;
+        uint8_t     m_state;                    /* eTaskState */
+        uint8_t     m_reserved;
+        uint16_t    m_stackDepth;
+        uint16_t    m_stackHighWater;
+        uint32_t    m_runTime;
+    } __attribute__((packed)) Entry_t;
+
+    /** @brief Flag in Table_t::m_flags: More than \p nMaxTasks Tasks; the Snapshot has no Entries. */
+    static constexpr uint8_t m_flagOverflow = 0x01;
+
+    typedef struct Table_s {
+        uint8_t     m_numTasks;
+        uint8_t     m_maxTasks;
+        uint16_t    m_sequence;                 /* Incremented with every Snapshot */
+        uint32_t    m_totalRunTime;
+        uint8_t     m_flags;
+        uint8_t     m_reserved[3];
+        Entry_t     m_entries[nMaxTasks];
+    } __attribute__((packed)) Table_t;
+
+private:
+    typedef struct Stack_s {
+        const StackType_t * m_base;
+        size_t              m_depth;
+    } Stack_t;
+
+    Stack_t             m_stacks[nMaxTasks];
+    unsigned            m_numStacks;
+    TaskStatus_t        m_status[nMaxTasks];
+    Table_t             m_tables[2];
+    volatile unsigned   m_current;
+
+    size_t
+    getStackDepth(const StackType_t * const p_base) const {
+        for (unsigned idx = 0; idx < m_numStacks; idx++) {
+            if (m_stacks[idx].m_base == p_base) {
+                return m_stacks[idx].m_depth;
+            }
+        }
+
+        return 0;
+    }
+
+public:
+    TaskStatsT(void) : m_stacks {}, m_numStacks(0), m_status {}, m_tables {}, m_current(0) {
+        m_tables[0].m_maxTasks = nMaxTasks;
+        m_tables[1].m_maxTasks = nMaxTasks;
+    }
+
+    bool
+    add(const StackType_t * const p_stack, const size_t p_stackDepth) {
+        if (m_numStacks >= nMaxTasks) {
+            return false;
+        }
+
+        m_stacks[m_numStacks].m_base    = p_stack;
+        m_stacks[m_numStacks].m_depth   = p_stackDepth;
+        m_numStacks++;
+
+        return true;
+    }
+
+    /*
+     * For ::rtos::StaticTaskT Objects.
+     */
+    template<typename TaskT>
+    bool
+    add(const TaskT &p_task) {
+        return add(p_task.getStack(), p_task.getStackDepth());
+    }
+
+    void
+    update(void) {
+        const unsigned next = m_current ^ 1;
+        Table_t &table = m_tables[next];
+        uint32_t totalRunTime = 0;
+
+        /* Zero if there are more than nMaxTasks Tasks */
+        const UBaseType_t numTasks = uxTaskGetSystemState(m_status, nMaxTasks, &totalRunTime);
+        const bool overflow = (numTasks == 0) && (uxTaskGetNumberOfTasks() > nMaxTasks);
+
+        ::memset(table.m_entries, 0, sizeof(table.m_entries));
+        for (UBaseType_t idx = 0; idx < numTasks; idx++) {
+            const TaskStatus_t &status = m_status[idx];
+            Entry_t &entry = table.m_entries[idx];
+
+            for (size_t pos = 0; (pos < sizeof(entry.m_name)) && (status.pcTaskName[pos] != '\0'); pos++) {
+                entry.m_name[pos] = status.pcTaskName[pos];
+            }
+            entry.m_number          = static_cast<uint8_t>(status.xTaskNumber);
+            entry.m_priority        = static_cast<uint8_t>(status.uxCurrentPriority);
+            entry.m_state           = static_cast<uint8_t>(status.eCurrentState);
+            entry.m_stackDepth      = static_cast<uint16_t>(getStackDepth(status.pxStackBase));
+            entry.m_stackHighWater  = static_cast<uint16_t>(status.usStackHighWaterMark);
+            entry.m_runTime         = static_cast<uint32_t>(status.ulRunTimeCounter);
+        }
+
+        table.m_numTasks        = static_cast<uint8_t>(numTasks);
+        table.m_sequence        = m_tables[m_current].m_sequence + 1;
+        table.m_totalRunTime    = totalRunTime;
+        table.m_flags           = overflow ? m_flagOverflow : 0;
+
+        m_current = next;
+    }
+
+    const Table_t &
+    getTable(void) const {
+        return m_tables[m_current];
+    }
+};
+
+} /* namespace rtos */
+
+#endif /* _RTOS_TASK_STATS_HPP_DC1B69F5_ */
@@ -0,0 +1,42 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _RTOS_CONFIG_FREERTOS_CONFIG_H_6C1F9A52_
+#define _RTOS_CONFIG_FREERTOS_CONFIG_H_6C1F9A52_
+
+/*******************************************************************************
+ * FreeRTOS Configuration Overlay for RTOS_STATIC_ALLOCATION.
+ *
+ * CMakeLists.txt puts this Directory in front of the Include Path, so the
+ * Kernel's #include "FreeRTOSConfig.h" lands here. The Configuration from
+ * common/ is included first, then the Settings for static Tasks and Run-Time
+ * Stats are applied on top of it.
+ *
+ * The Switches are redefined, as the Build depends on them. The Port Hooks are
+ * guarded and only defined if common/ does not provide them.
+ ******************************************************************************/
+#include_next <FreeRTOSConfig.h>
+
+#undef configSUPPORT_STATIC_ALLOCATION
+#define configSUPPORT_STATIC_ALLOCATION             1
+
+#undef configUSE_TRACE_FACILITY
+#define configUSE_TRACE_FACILITY                    1
+
+#undef configGENERATE_RUN_TIME_STATS
+#define configGENERATE_RUN_TIME_STATS               1
+
+#ifndef portCONFIGURE_TIMER_FOR_RUN_TIME_STATS
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#endif /* portCONFIGURE_TIMER_FOR_RUN_TIME_STATS */
+
+#ifndef portGET_RUN_TIME_COUNTER_VALUE
+#if defined(HOSTBUILD)
+#define portGET_RUN_TIME_COUNTER_VALUE()            0
+#else
+/* DWT Cycle Counter (DWT->CYCCNT), enabled in main() */
+#define portGET_RUN_TIME_COUNTER_VALUE()            (*(volatile unsigned long *) 0xE0001004UL)
+#endif /* defined(HOSTBUILD) */
+#endif /* portGET_RUN_TIME_COUNTER_VALUE */
+
+#endif /* _RTOS_CONFIG_FREERTOS_CONFIG_H_6C1F9A52_ */
@@ -0,0 +1,139 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _STM32_CRC_HPP_5E2A90D7_
+#define _STM32_CRC_HPP_5E2A90D7_
+
+#include <stm32f4xx.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace stm32 {
+
+/***************************************************************************//**
+ * @brief CRC Calculation Unit of the STM32F4.
+ *
+ * Computes a CRC-32 with the Polynomial \c 0x04C11DB7, an Initial Value of
+ * \c 0xFFFFFFFF, no Reflection and no final XOR (i.e. CRC-32/MPEG-2). The Unit
+ * takes one 32-Bit Word per Write and processes it MSB first, i.e. a Word that
+ * was read from Memory in Little-Endian Order is checksummed Byte 3 first.
+ *
+ * The Unit has a single Accumulator, which reset() sets back to the Initial
+ * Value. There is no Way to load an intermediate Value, so only one Stream can
+ * be checksummed at a Time.
+ ******************************************************************************/
+class CrcViaSTM32F4 {
+public:
+    static void
+    enable(void) {
+        RCC->AHB1ENR |= RCC_AHB1ENR_CRCEN;
+        reset();
+    }
+
+    static void
+    reset(void) {
+        CRC->CR = CRC_CR_RESET;
+    }
+
+    static void
+    update(const uint32_t p_word) {
+        CRC->DR = p_word;
+    }
+
+    static uint32_t
+    read(void) {
+        return CRC->DR;
+    }
+};
+
+/***************************************************************************//**
+ * @brief Lookup Table of ::stm32::SoftwareCrc, built at Compile Time.
+ ******************************************************************************/
+struct SoftwareCrcTable {
+    static constexpr uint32_t   m_polynomial    = 0x04C11DB7;
+
+    static constexpr std::array<uint32_t, 256>
+    make(void) {
+        std::array<uint32_t, 256> table {};
+
+        for (uint32_t idx = 0; idx < 256; idx++) {
+            uint32_t crc = idx << 24;
+
+            for (unsigned bit = 0; bit < 8; bit++) {
+                crc = (crc & 0x80000000) ? ((crc << 1) ^ m_polynomial) : (crc << 1);
+            }
+            table[idx] = crc;
+        }
+
+        return table;
+    }
+};
+
+/***************************************************************************//**
+ * @brief Table-driven Software Implementation of ::stm32::CrcViaSTM32F4.
+ *
+ * Drop-in Replacement in the Host Build. It computes the same Checksum, four
+ * Table Lookups per Word. compute() is also available without the shared
+ * Accumulator, e.g. to build Test Data.
+ ******************************************************************************/
+class SoftwareCrc {
+public:
+    static constexpr uint32_t   m_polynomial    = SoftwareCrcTable::m_polynomial;
+    static constexpr uint32_t   m_initialValue  = 0xFFFFFFFF;
+
+private:
+    static constexpr std::array<uint32_t, 256>  m_table = SoftwareCrcTable::make();
+
+    static inline uint32_t                      m_crc = m_initialValue;
+
+public:
+    static constexpr uint32_t
+    update(uint32_t p_crc, const uint32_t p_word) {
+        for (unsigned shift = 32; shift > 0; shift -= 8) {
+            p_crc = (p_crc << 8) ^ m_table[((p_crc >> 24) ^ (p_word >> (shift - 8))) & 0xFF];
+        }
+
+        return p_crc;
+    }
+
+    /** @brief Checksum of \p p_numWords Words, starting from the Initial Value. */
+    static constexpr uint32_t
+    compute(const uint32_t * const p_words, const size_t p_numWords) {
+        uint32_t crc = m_initialValue;
+
+        for (size_t idx = 0; idx < p_numWords; idx++) {
+            crc = update(crc, p_words[idx]);
+        }
+
+        return crc;
+    }
+
+    static void
+    enable(void) {
+        reset();
+    }
+
+    static void
+    reset(void) {
+        m_crc = m_initialValue;
+    }
+
+    static void
+    update(const uint32_t p_word) {
+        m_crc = update(m_crc, p_word);
+    }
+
+    static uint32_t
+    read(void) {
+        return m_crc;
+    }
+};
+
+} /* namespace stm32 */
+
+#endif /* _STM32_CRC_HPP_5E2A90D7_ */
@@ -0,0 +1,70 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _STM32_CYCLE_COUNTER_HPP_91E0C5A3_
+#define _STM32_CYCLE_COUNTER_HPP_91E0C5A3_
+
+#include <stm32f4xx.h>
+
+#include <cstdint>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace stm32 {
+
+/***************************************************************************//**
+ * @brief CPU Cycle Counter of the Cortex-M4 Data Watchpoint and Trace Unit.
+ *
+ * The Counter is 32 Bits wide, i.e. it wraps after ~25s at 168 MHz. Durations
+ * must therefore be computed as the unsigned Difference of two Readings.
+ ******************************************************************************/
+class DwtCycleCounter {
+public:
+    static void
+    enable(void) {
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CYCCNT = 0;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    }
+
+    static uint32_t
+    read(void) {
+        return DWT->CYCCNT;
+    }
+};
+
+/***************************************************************************//**
+ * @brief Drop-in Replacement for ::stm32::DwtCycleCounter in the Host Build.
+ *
+ * The Counter only moves when told to, so Code that measures Durations can be
+ * tested with exact, reproducible Cycle Counts.
+ ******************************************************************************/
+class MockCycleCounter {
+    static inline uint32_t m_cycles = 0;
+
+public:
+    static void
+    enable(void) {
+        m_cycles = 0;
+    }
+
+    static uint32_t
+    read(void) {
+        return m_cycles;
+    }
+
+    static void
+    set(const uint32_t p_cycles) {
+        m_cycles = p_cycles;
+    }
+
+    static void
+    advance(const uint32_t p_cycles) {
+        m_cycles += p_cycles;
+    }
+};
+
+} /* namespace stm32 */
+
+#endif /* _STM32_CYCLE_COUNTER_HPP_91E0C5A3_ */
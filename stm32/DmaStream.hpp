@@ -0,0 +1,78 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _STM32_DMA_STREAM_HPP_D07A6C31_
+#define _STM32_DMA_STREAM_HPP_D07A6C31_
+
+#include <stm32f4xx.h>
+
+#include <cstdint>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace stm32 {
+
+/***************************************************************************//**
+ * @brief Access to a single Stream of the STM32F4 DMA Controllers.
+ *
+ * Hides the Layout of the shared Interrupt Status / Flag Clear Registers so that
+ * Drivers can deal with the Stream Flags as if they were per-Stream Registers.
+ ******************************************************************************/
+class DmaStream {
+    /** @brief Bit Offsets of the Stream Flags within \c LISR / \c HISR. */
+    static constexpr unsigned m_flagOffsets[] = { 0, 6, 16, 22 };
+
+    DMA_TypeDef * const         m_dma;
+    DMA_Stream_TypeDef * const  m_stream;
+    const unsigned              m_streamNo;
+
+public:
+    static constexpr uint32_t m_flagFifoError        = (1u << 0);
+    static constexpr uint32_t m_flagDirectModeError  = (1u << 2);
+    static constexpr uint32_t m_flagTransferError    = (1u << 3);
+    static constexpr uint32_t m_flagHalfTransfer     = (1u << 4);
+    static constexpr uint32_t m_flagTransferComplete = (1u << 5);
+    static constexpr uint32_t m_flagAll              = 0x3D;
+
+    DmaStream(DMA_TypeDef * const p_dma, const unsigned p_streamNo)
+      : m_dma(p_dma),
+        m_stream(reinterpret_cast<DMA_Stream_TypeDef *>(reinterpret_cast<uintptr_t>(p_dma) + 0x10 + (0x18 * p_streamNo))),
+        m_streamNo(p_streamNo) {
+
+    }
+
+    DMA_Stream_TypeDef *
+    operator->(void) const {
+        return m_stream;
+    }
+
+    void
+    enableClock(void) const {
+        RCC->AHB1ENR |= (m_dma == DMA1) ? RCC_AHB1ENR_DMA1EN : RCC_AHB1ENR_DMA2EN;
+    }
+
+    void
+    disable(void) const {
+        m_stream->CR &= ~DMA_SxCR_EN;
+        while (m_stream->CR & DMA_SxCR_EN) ;
+    }
+
+    uint32_t
+    getFlags(void) const {
+        const uint32_t isr = (m_streamNo < 4) ? m_dma->LISR : m_dma->HISR;
+
+        return (isr >> m_flagOffsets[m_streamNo % 4]) & m_flagAll;
+    }
+
+    void
+    clearFlags(const uint32_t p_flags) const {
+        volatile uint32_t &ifcr = (m_streamNo < 4) ? m_dma->LIFCR : m_dma->HIFCR;
+
+        ifcr = (p_flags & m_flagAll) << m_flagOffsets[m_streamNo % 4];
+    }
+};
+
+} /* namespace stm32 */
+
+#endif /* _STM32_DMA_STREAM_HPP_D07A6C31_ */
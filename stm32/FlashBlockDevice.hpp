@@ -0,0 +1,156 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _STM32_FLASH_BLOCK_DEVICE_HPP_E6D47A05_
+#define _STM32_FLASH_BLOCK_DEVICE_HPP_E6D47A05_
+
+#include <stm32f4xx.h>
+#include <usb/UsbBlockDevice.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace stm32 {
+
+/***************************************************************************//**
+ * @brief Block Device on a Sector of the internal Flash of the STM32F4.
+ *
+ * Meant to export Data that the Firmware has logged to Flash. Reads are
+ * memory-mapped, so READ(10) sends straight from the Flash.
+ *
+ * The Medium is write-protected towards the Host, so WRITE(10) fails with
+ * DATA PROTECT. Flash can only be erased by whole Sectors (16 KB to 128 KB)
+ * and programming can only clear Bits, so a Host's Write would need a
+ * Read-Modify-Write of the whole Sector. Besides, programming busy-waits and
+ * stalls Instruction Fetches from the same Flash Bank (about 16 us per Word,
+ * see RM0090, Section 3.5), which must not happen in the USB Interrupt.
+ *
+ * The Firmware writes its Log from Task Level instead: erase() erases the
+ * whole Sector before a new Log starts, and write() programs Word by Word and
+ * fails if a Word does not read back as written, i.e. if the Area had not been
+ * erased before.
+ *
+ * The Registers are accessed directly, like in ::stm32::LowPower, as
+ * ::stm32::Flash only covers the Latency Settings. Requires a Supply Voltage of
+ * 2.7 V or more for 32-Bit Programming.
+ ******************************************************************************/
+class FlashBlockDeviceViaSTM32F4 : public ::usb::UsbBlockDevice {
+    static constexpr uint32_t   m_key1  = 0x45670123;
+    static constexpr uint32_t   m_key2  = 0xCDEF89AB;
+    static constexpr uint32_t   m_errorFlags = FLASH_SR_WRPERR | FLASH_SR_PGAERR | FLASH_SR_PGPERR | FLASH_SR_PGSERR;
+
+    const unsigned      m_sector;
+    const uintptr_t     m_base;
+    const uint32_t      m_numBlocks;
+
+    static void
+    unlock(void) {
+        if (FLASH->CR & FLASH_CR_LOCK) {
+            FLASH->KEYR = m_key1;
+            FLASH->KEYR = m_key2;
+        }
+    }
+
+    static void
+    lock(void) {
+        FLASH->CR |= FLASH_CR_LOCK;
+    }
+
+    static bool
+    waitReady(void) {
+        while (FLASH->SR & FLASH_SR_BSY) ;
+
+        const uint32_t sr = FLASH->SR;
+        FLASH->SR = sr & (m_errorFlags | FLASH_SR_EOP);
+
+        return (sr & m_errorFlags) == 0;
+    }
+
+public:
+    /**
+     * @param p_sector Number of the Flash Sector, e.g. \c 11 for the last
+     *   128 KB Sector of an STM32F407.
+     * @param p_base Start Address of the Sector.
+     * @param p_sectorSz Size of the Sector in Bytes.
+     */
+    constexpr FlashBlockDeviceViaSTM32F4(const unsigned p_sector, const uintptr_t p_base, const size_t p_sectorSz)
+      : m_sector(p_sector), m_base(p_base), m_numBlocks(p_sectorSz / m_blockSz) {
+
+    }
+
+    /** @brief Erase the whole Sector; takes one to two Seconds for 128 KB. */
+    bool
+    erase(void) const {
+        unlock();
+        waitReady();
+
+        FLASH->CR = (FLASH->CR & ~(FLASH_CR_PSIZE | FLASH_CR_SNB)) | FLASH_CR_PSIZE_1 | FLASH_CR_SER | (m_sector << FLASH_CR_SNB_Pos);
+        FLASH->CR |= FLASH_CR_STRT;
+        const bool ok = waitReady();
+        FLASH->CR &= ~FLASH_CR_SER;
+
+        lock();
+
+        return ok;
+    }
+
+    uint32_t
+    getNumBlocks(void) const override {
+        return m_numBlocks;
+    }
+
+    /** @brief The Host may only read; see the Class Description. */
+    bool
+    isWriteProtected(void) const override {
+        return true;
+    }
+
+    const void *
+    map(const uint32_t p_block) const override {
+        return reinterpret_cast<const void *>(m_base + p_block * m_blockSz);
+    }
+
+    void *
+    lend(const uint32_t /* p_block */, const size_t /* p_offset */, const size_t /* p_length */) override {
+        return nullptr;
+    }
+
+    bool
+    read(const uint32_t p_block, const size_t p_offset, void * const p_buffer, const size_t p_length) override {
+        ::memcpy(p_buffer, reinterpret_cast<const void *>(m_base + p_block * m_blockSz + p_offset), p_length);
+        return true;
+    }
+
+    bool
+    write(const uint32_t p_block, const size_t p_offset, const void * const p_data, const size_t p_length) override {
+        const uint8_t * const   src = static_cast<const uint8_t *>(p_data);
+        volatile uint32_t *     dst = reinterpret_cast<volatile uint32_t *>(m_base + p_block * m_blockSz + p_offset);
+        bool                    ok  = ((p_offset % sizeof(uint32_t)) == 0) && ((p_length % sizeof(uint32_t)) == 0);
+
+        unlock();
+        waitReady();
+        FLASH->CR = (FLASH->CR & ~FLASH_CR_PSIZE) | FLASH_CR_PSIZE_1 | FLASH_CR_PG;
+
+        for (size_t offs = 0; ok && (offs < p_length); offs += sizeof(uint32_t), dst++) {
+            uint32_t word;
+
+            ::memcpy(&word, &src[offs], sizeof(word));
+            *dst = word;
+
+            ok = waitReady() && (*dst == word);
+        }
+
+        FLASH->CR &= ~FLASH_CR_PG;
+        lock();
+
+        return ok;
+    }
+};
+
+} /* namespace stm32 */
+
+#endif /* _STM32_FLASH_BLOCK_DEVICE_HPP_E6D47A05_ */
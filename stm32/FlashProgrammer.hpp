@@ -0,0 +1,398 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _STM32_FLASH_PROGRAMMER_HPP_4D92B7E1_
+#define _STM32_FLASH_PROGRAMMER_HPP_4D92B7E1_
+
+#include <stm32f4xx.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace stm32 {
+
+/***************************************************************************//**
+ * @brief Sector Layout and typical Timing of the first Flash Bank of the STM32F4.
+ *
+ * Four 16 KB Sectors, one 64 KB Sector, then 128 KB Sectors, i.e. Sectors 0 to
+ * 11 on an STM32F407 (1 MB) and 0 to 7 on an STM32F411 (512 KB). Offsets are
+ * counted from the Start of the Flash.
+ *
+ * Times are typical Values for 32-Bit Parallelism, see the STM32F407
+ * Datasheet, Table 40.
+ ******************************************************************************/
+struct FlashLayout {
+    static constexpr size_t     m_minSectorSz           = 16 * 1024;
+    static constexpr uint32_t   m_programWordTimeInUs   = 16;
+
+    static constexpr unsigned
+    getSector(const size_t p_offset) {
+        return (p_offset < 64 * 1024) ? (p_offset / (16 * 1024))
+          : ((p_offset < 128 * 1024) ? 4 : (5 + (p_offset - 128 * 1024) / (128 * 1024)));
+    }
+
+    static constexpr size_t
+    getSectorOffset(const unsigned p_sector) {
+        return (p_sector < 4) ? (p_sector * 16 * 1024)
+          : ((p_sector == 4) ? (64 * 1024) : (128 * 1024 + (p_sector - 5) * 128 * 1024));
+    }
+
+    static constexpr size_t
+    getSectorSize(const unsigned p_sector) {
+        return (p_sector < 4) ? (16 * 1024) : ((p_sector == 4) ? (64 * 1024) : (128 * 1024));
+    }
+
+    static constexpr uint32_t
+    getEraseTimeInMs(const unsigned p_sector) {
+        return (p_sector < 4) ? 250 : ((p_sector == 4) ? 700 : 1000);
+    }
+};
+
+/***************************************************************************//**
+ * @brief Interrupt-driven Erase and Program Engine for the internal Flash.
+ *
+ * erase() and program() only start a Job and return. The Flash Interrupt
+ * (End of Operation or Error) must call handleIrq(), which programs the next
+ * Word or ends the Job, so no Code ever spins on the \c BSY Flag. Each Word is
+ * read back before the next one is written.
+ *
+ * The CPU still stalls when it fetches Instructions or Data from the Flash
+ * while the Flash is busy (see RM0090, Section 3.5). The USB Core keeps
+ * receiving into its FIFO meanwhile and NAKs once it is full, so Data is
+ * not lost; the Host just sees the Device as busy.
+ *
+ * Like ::stm32::FlashBlockDeviceViaSTM32F4, the Registers are accessed
+ * directly. Requires a Supply Voltage of 2.7 V or more for 32-Bit Programming.
+ ******************************************************************************/
+class FlashProgrammerViaSTM32F4 : public FlashLayout {
+public:
+    enum class Error_e : uint8_t {
+        e_None,
+        e_Erase,
+        e_Program,
+        e_Verify
+    };
+
+private:
+    enum class Job_e : uint8_t {
+        e_None,
+        e_Erase,
+        e_Program
+    };
+
+    static constexpr uint32_t   m_key1  = 0x45670123;
+    static constexpr uint32_t   m_key2  = 0xCDEF89AB;
+    static constexpr uint32_t   m_errorFlags = FLASH_SR_SOP | FLASH_SR_WRPERR | FLASH_SR_PGAERR | FLASH_SR_PGPERR | FLASH_SR_PGSERR;
+
+    const uintptr_t             m_base;
+    Job_e                       m_job;
+    Error_e                     m_error;
+    volatile uint32_t *         m_dst;
+    const uint32_t *            m_src;
+    size_t                      m_numWords;
+
+    static void
+    unlock(void) {
+        if (FLASH->CR & FLASH_CR_LOCK) {
+            FLASH->KEYR = m_key1;
+            FLASH->KEYR = m_key2;
+        }
+        FLASH->SR = m_errorFlags | FLASH_SR_EOP;
+    }
+
+    bool
+    finish(const Error_e p_error) {
+        FLASH->CR &= ~(FLASH_CR_SER | FLASH_CR_PG | FLASH_CR_EOPIE | FLASH_CR_ERRIE);
+        FLASH->CR |= FLASH_CR_LOCK;
+
+        m_job   = Job_e::e_None;
+        m_error = p_error;
+
+        return true;
+    }
+
+public:
+    FlashProgrammerViaSTM32F4(const uintptr_t p_base = FLASH_BASE)
+      : m_base(p_base), m_job(Job_e::e_None), m_error(Error_e::e_None), m_dst(nullptr), m_src(nullptr), m_numWords(0) {
+
+    }
+
+    const void *
+    map(const size_t p_offset) const {
+        return reinterpret_cast<const void *>(m_base + p_offset);
+    }
+
+    bool
+    isBusy(void) const {
+        return m_job != Job_e::e_None;
+    }
+
+    /** @brief Error of the last Job, valid once handleIrq() has returned \c true. */
+    Error_e
+    getError(void) const {
+        return m_error;
+    }
+
+    size_t
+    getRemainingWords(void) const {
+        return m_numWords;
+    }
+
+    /** @return \c false if a Job is still running. */
+    bool
+    erase(const unsigned p_sector) {
+        if (isBusy()) {
+            return false;
+        }
+
+        unlock();
+        FLASH->CR = (FLASH->CR & ~(FLASH_CR_PSIZE | FLASH_CR_SNB | FLASH_CR_PG))
+          | FLASH_CR_PSIZE_1 | FLASH_CR_SER | (p_sector << FLASH_CR_SNB_Pos) | FLASH_CR_EOPIE | FLASH_CR_ERRIE;
+
+        m_job   = Job_e::e_Erase;
+        m_error = Error_e::e_None;
+
+        FLASH->CR |= FLASH_CR_STRT;
+
+        return true;
+    }
+
+    /**
+     * @brief Program \p p_numWords Words from \p p_data at \p p_offset.
+     *
+     * \p p_data must stay valid until the Job has ended.
+     *
+     * @return \c false if a Job is still running.
+     */
+    bool
+    program(const size_t p_offset, const uint32_t * const p_data, const size_t p_numWords) {
+        if (isBusy() || (p_numWords == 0)) {
+            return false;
+        }
+
+        unlock();
+        FLASH->CR = (FLASH->CR & ~(FLASH_CR_PSIZE | FLASH_CR_SNB | FLASH_CR_SER))
+          | FLASH_CR_PSIZE_1 | FLASH_CR_PG | FLASH_CR_EOPIE | FLASH_CR_ERRIE;
+
+        m_job       = Job_e::e_Program;
+        m_error     = Error_e::e_None;
+        m_dst       = reinterpret_cast<volatile uint32_t *>(m_base + p_offset);
+        m_src       = p_data;
+        m_numWords  = p_numWords;
+
+        *m_dst = *m_src;
+
+        return true;
+    }
+
+    /**
+     * @brief Handle the Flash Interrupt.
+     *
+     * @return \c true if the Job has ended, see getError().
+     */
+    bool
+    handleIrq(void) {
+        const uint32_t sr = FLASH->SR;
+
+        if (!isBusy() || (sr & FLASH_SR_BSY)) {
+            return false;
+        }
+        FLASH->SR = sr & (m_errorFlags | FLASH_SR_EOP);
+
+        if (sr & m_errorFlags) {
+            m_numWords = 0;
+            return finish((m_job == Job_e::e_Erase) ? Error_e::e_Erase : Error_e::e_Program);
+        }
+
+        if (m_job == Job_e::e_Program) {
+            if (*m_dst != *m_src) {
+                m_numWords = 0;
+                return finish(Error_e::e_Verify);
+            }
+
+            if (--m_numWords > 0) {
+                *(++m_dst) = *(++m_src);
+                return false;
+            }
+        }
+
+        return finish(Error_e::e_None);
+    }
+};
+
+/***************************************************************************//**
+ * @brief Drop-in Replacement for ::stm32::FlashProgrammerViaSTM32F4 in the
+ *   Host Build.
+ *
+ * Keeps the Flash Contents in RAM. Programming can only clear Bits, like on
+ * the real Flash. Time only passes when advance() is called, which completes
+ * the Operations that fit into the given Time and calls the Interrupt Handler
+ * after each of them, so the Overlap of Flash Jobs and USB Traffic can be
+ * tested with reproducible Timing.
+ *
+ * @tparam nSize Size of the simulated Flash in Bytes.
+ ******************************************************************************/
+template<size_t nSize>
+class MockFlashT : public FlashLayout {
+public:
+    typedef FlashProgrammerViaSTM32F4::Error_e Error_e;
+
+private:
+    enum class Job_e : uint8_t {
+        e_None,
+        e_Erase,
+        e_Program
+    };
+
+    void                (* const m_irqHandler)(void);
+
+    alignas(4) uint8_t  m_memory[nSize];
+    Job_e               m_job;
+    Error_e             m_error;
+    bool                m_endOfOperation;
+    unsigned            m_sector;
+    size_t              m_offset;
+    const uint32_t *    m_src;
+    size_t              m_numWords;
+    uint32_t            m_remainingInUs;
+    uint64_t            m_busyInUs;
+    size_t              m_badWord;
+
+    bool
+    finish(const Error_e p_error) {
+        m_job       = Job_e::e_None;
+        m_error     = p_error;
+        m_numWords  = 0;
+        return true;
+    }
+
+public:
+    MockFlashT(void (* const p_irqHandler)(void))
+      : m_irqHandler(p_irqHandler), m_job(Job_e::e_None), m_error(Error_e::e_None), m_endOfOperation(false),
+        m_sector(0), m_offset(0), m_src(nullptr), m_numWords(0), m_remainingInUs(0), m_busyInUs(0), m_badWord(nSize) {
+        ::memset(m_memory, 0xFF, sizeof(m_memory));
+    }
+
+    const void *
+    map(const size_t p_offset) const {
+        return &m_memory[p_offset];
+    }
+
+    bool
+    isBusy(void) const {
+        return m_job != Job_e::e_None;
+    }
+
+    Error_e
+    getError(void) const {
+        return m_error;
+    }
+
+    size_t
+    getRemainingWords(void) const {
+        return m_numWords;
+    }
+
+    bool
+    erase(const unsigned p_sector) {
+        if (isBusy() || ((getSectorOffset(p_sector) + getSectorSize(p_sector)) > nSize)) {
+            return false;
+        }
+
+        m_job           = Job_e::e_Erase;
+        m_error         = Error_e::e_None;
+        m_sector        = p_sector;
+        m_remainingInUs = getEraseTimeInMs(p_sector) * 1000;
+
+        return true;
+    }
+
+    bool
+    program(const size_t p_offset, const uint32_t * const p_data, const size_t p_numWords) {
+        if (isBusy() || (p_numWords == 0) || ((p_offset % sizeof(uint32_t)) != 0) || ((p_offset + p_numWords * sizeof(uint32_t)) > nSize)) {
+            return false;
+        }
+
+        m_job           = Job_e::e_Program;
+        m_error         = Error_e::e_None;
+        m_offset        = p_offset;
+        m_src           = p_data;
+        m_numWords      = p_numWords;
+        m_remainingInUs = m_programWordTimeInUs;
+
+        return true;
+    }
+
+    bool
+    handleIrq(void) {
+        if (!m_endOfOperation) {
+            return false;
+        }
+        m_endOfOperation = false;
+
+        if (m_job == Job_e::e_Program) {
+            if (::memcmp(&m_memory[m_offset], m_src, sizeof(uint32_t))) {
+                return finish(Error_e::e_Verify);
+            }
+
+            if (--m_numWords > 0) {
+                m_offset += sizeof(uint32_t);
+                m_src++;
+                m_remainingInUs = m_programWordTimeInUs;
+                return false;
+            }
+        }
+
+        return finish(Error_e::e_None);
+    }
+
+    /** @brief Let \p p_timeInUs pass; completed Operations raise the Interrupt. */
+    void
+    advance(uint32_t p_timeInUs) {
+        while (isBusy()) {
+            if (m_remainingInUs > p_timeInUs) {
+                m_remainingInUs -= p_timeInUs;
+                m_busyInUs      += p_timeInUs;
+                return;
+            }
+            p_timeInUs      -= m_remainingInUs;
+            m_busyInUs      += m_remainingInUs;
+            m_remainingInUs  = 0;
+
+            if (m_job == Job_e::e_Erase) {
+                ::memset(&m_memory[getSectorOffset(m_sector)], 0xFF, getSectorSize(m_sector));
+            } else if (m_offset != m_badWord) {
+                for (size_t idx = 0; idx < sizeof(uint32_t); idx++) {
+                    m_memory[m_offset + idx] &= reinterpret_cast<const uint8_t *>(m_src)[idx];
+                }
+            }
+
+            m_endOfOperation = true;
+            m_irqHandler();
+            if (m_endOfOperation) {
+                /* Interrupt was not serviced */
+                return;
+            }
+        }
+    }
+
+    /** @brief Time the simulated Flash has spent erasing and programming. */
+    uint64_t
+    getBusyTimeInUs(void) const {
+        return m_busyInUs;
+    }
+
+    /** @brief Make the Word at \p p_offset fail to program, e.g. to test Verify Errors. */
+    void
+    setBadWord(const size_t p_offset) {
+        m_badWord = p_offset;
+    }
+};
+
+} /* namespace stm32 */
+
+#endif /* _STM32_FLASH_PROGRAMMER_HPP_4D92B7E1_ */
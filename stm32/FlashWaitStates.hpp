@@ -0,0 +1,42 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _STM32_FLASH_WAIT_STATES_HPP_5B07E2C4_
+#define _STM32_FLASH_WAIT_STATES_HPP_5B07E2C4_
+
+#include <stm32f4xx.h>
+
+#include <cstdint>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace stm32 {
+
+/***************************************************************************//**
+ * @brief Raises the Flash Latency before the System Clock is switched.
+ *
+ * ::stm32::Rcc switches to the PLL in its Constructor, i.e. during static
+ * Initialization. Static Objects of a Translation Unit are constructed in the
+ * Order of their Definition, so an Instance defined before the ::stm32::Rcc
+ * Object makes sure that the Flash is never read with fewer Wait States than
+ * ::stm32::PllSolver derived for the new Clock.
+ *
+ * The Latency is only raised, never lowered. As required by RM0090, 3.5.1,
+ * the new Value is read back before the Constructor returns.
+ ******************************************************************************/
+class FlashWaitStates {
+public:
+    FlashWaitStates(FLASH_TypeDef * const p_flash, const unsigned p_waitStates) {
+        if ((p_flash->ACR & FLASH_ACR_LATENCY) >= p_waitStates) {
+            return;
+        }
+
+        p_flash->ACR = (p_flash->ACR & ~FLASH_ACR_LATENCY) | p_waitStates;
+        while ((p_flash->ACR & FLASH_ACR_LATENCY) != p_waitStates) ;
+    }
+};
+
+} /* namespace stm32 */
+
+#endif /* _STM32_FLASH_WAIT_STATES_HPP_5B07E2C4_ */
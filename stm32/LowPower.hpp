@@ -0,0 +1,122 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _STM32_LOW_POWER_HPP_3C9E52A8_
+#define _STM32_LOW_POWER_HPP_3C9E52A8_
+
+#include <stm32f4xx.h>
+
+#include <cstdint>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace stm32 {
+
+/***************************************************************************//**
+ * @brief Low-Power Modes of the STM32F4 CPU.
+ *
+ * In Sleep Mode, only the CPU Clock is stopped; all Peripherals keep running
+ * and any Interrupt wakes the CPU up again. In Stop Mode, the PLL, HSE and HSI
+ * are stopped as well and the Regulator is put into Low-Power Mode, which
+ * brings the Current down from tens of mA to a few hundred uA. Only EXTI Lines
+ * can wake the CPU up, e.g. the USB OTG Wakeup Line. SysTick stops, too.
+ *
+ * The CPU leaves Stop Mode running from the HSI. enterIf() restores HSE, PLL and
+ * the System Clock before it returns, using the PLL Configuration that is kept
+ * in \c RCC_PLLCFGR. Restoring takes the HSE Start-up Time plus the PLL Lock
+ * Time, i.e. about 2 ms, which is well within the 10 ms Resume Recovery Time
+ * of USB.
+ *
+ * The Registers are accessed directly, as ::stm32::Pwr and ::stm32::Rcc do not
+ * cover Stop Mode.
+ ******************************************************************************/
+class LowPower {
+public:
+    enum class Mode_e {
+        e_Sleep,
+        e_Stop
+    };
+
+private:
+    const Mode_e    m_mode;
+
+    static void
+    restoreClocks(const uint32_t p_rccCr, const uint32_t p_rccCfgr) {
+        if (p_rccCr & RCC_CR_HSEON) {
+            RCC->CR |= RCC_CR_HSEON;
+            while (!(RCC->CR & RCC_CR_HSERDY)) ;
+        }
+
+        if (p_rccCr & RCC_CR_PLLON) {
+            RCC->CR |= RCC_CR_PLLON;
+            while (!(RCC->CR & RCC_CR_PLLRDY)) ;
+        }
+
+        RCC->CFGR = (RCC->CFGR & ~RCC_CFGR_SW) | (p_rccCfgr & RCC_CFGR_SW);
+        while ((RCC->CFGR & RCC_CFGR_SWS) != ((p_rccCfgr & RCC_CFGR_SW) << RCC_CFGR_SWS_Pos)) ;
+    }
+
+public:
+    constexpr LowPower(const Mode_e p_mode)
+      : m_mode(p_mode) {
+
+    }
+
+    Mode_e
+    getMode(void) const {
+        return m_mode;
+    }
+
+    /**
+     * @brief Stop the CPU until the next Interrupt, provided that
+     *   \p p_condition still holds with Interrupts masked.
+     *
+     * Checking the Condition with Interrupts masked closes the Window in which
+     * the Event that ends the low-power Phase could fire just before \c WFI.
+     * \c WFI still returns on a pending Interrupt; its Handler runs after the
+     * Clocks have been restored.
+     *
+     * @return \c true if the CPU was stopped.
+     */
+    template<typename ConditionT>
+    bool
+    enterIf(const ConditionT &p_condition) const {
+        bool entered = false;
+
+#if !defined(HOSTBUILD)
+        __disable_irq();
+
+        if (p_condition()) {
+            const uint32_t rccCr    = RCC->CR;
+            const uint32_t rccCfgr  = RCC->CFGR;
+
+            if (m_mode == Mode_e::e_Stop) {
+                PWR->CR = (PWR->CR & ~PWR_CR_PDDS) | PWR_CR_LPDS;
+                SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+            }
+
+            __DSB();
+            __WFI();
+
+            if (m_mode == Mode_e::e_Stop) {
+                SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+                restoreClocks(rccCr, rccCfgr);
+            }
+
+            entered = true;
+        }
+
+        __enable_irq();
+#else
+        /* No CPU to stop in the Host Build */
+        (void) p_condition;
+#endif /* !defined(HOSTBUILD) */
+
+        return entered;
+    }
+};
+
+} /* namespace stm32 */
+
+#endif /* _STM32_LOW_POWER_HPP_3C9E52A8_ */
@@ -0,0 +1,222 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _STM32_PLL_SOLVER_HPP_4B7E19C2_
+#define _STM32_PLL_SOLVER_HPP_4B7E19C2_
+
+#include <stm32/Pll.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace stm32 {
+
+/***************************************************************************//**
+ * @brief Clock Limits of an STM32F4 Device at 2.7 V to 3.6 V.
+ ******************************************************************************/
+typedef struct ClockLimits_s {
+    uint32_t    m_sysclkMaxInHz;
+    uint32_t    m_apb1MaxInHz;
+    uint32_t    m_apb2MaxInHz;
+    /** Max. HCLK for 0, 1, 2, ... Flash Wait States; 0 terminates the Table. */
+    uint32_t    m_flashMaxInHz[8];
+} ClockLimits_t;
+
+/***************************************************************************//**
+ * @brief Finds the PLL Configuration with the highest SYSCLK that still yields
+ *   an exact 48 MHz PLL48CK for the USB OTG Cores.
+ *
+ * The Search runs at Compile Time over all M, N, P and Q Values that keep the
+ * VCO Input within 1 to 2 MHz and the VCO Output within 100 to 432 MHz (see
+ * RM0090, Section 6.3.2). If several Configurations reach the same SYSCLK,
+ * the one with the highest VCO Input Frequency is used, as it has the least
+ * PLL Jitter.
+ *
+ * HCLK runs at SYSCLK. APB1 and APB2 get the smallest Prescaler that keeps
+ * them within the Device's Limits. The Flash Wait States follow from HCLK.
+ *
+ * If there is no exact Solution, \c Solution_t::m_valid is \c false, which
+ * the Caller is expected to \c static_assert on.
+ ******************************************************************************/
+class PllSolver {
+public:
+    static constexpr uint32_t   m_usbClockInHz      = 48 * 1000 * 1000;
+
+    /** @brief STM32F405 / F407, see RM0090, Table 10 and DS8626, Section 3.17. */
+    static constexpr ClockLimits_t   m_limitsStm32F407 = {
+        /* m_sysclkMaxInHz = */ 168 * 1000 * 1000,
+        /* m_apb1MaxInHz = */    42 * 1000 * 1000,
+        /* m_apb2MaxInHz = */    84 * 1000 * 1000,
+        /* m_flashMaxInHz = */ { 30 * 1000 * 1000, 60 * 1000 * 1000, 90 * 1000 * 1000, 120 * 1000 * 1000, 150 * 1000 * 1000, 168 * 1000 * 1000, 0, 0 }
+    };
+
+    /** @brief STM32F411, see RM0383, Table 5 and DS10314, Section 3.15. */
+    static constexpr ClockLimits_t   m_limitsStm32F411 = {
+        /* m_sysclkMaxInHz = */ 100 * 1000 * 1000,
+        /* m_apb1MaxInHz = */    50 * 1000 * 1000,
+        /* m_apb2MaxInHz = */   100 * 1000 * 1000,
+        /* m_flashMaxInHz = */ { 30 * 1000 * 1000, 64 * 1000 * 1000, 90 * 1000 * 1000, 100 * 1000 * 1000, 0, 0, 0, 0 }
+    };
+
+    typedef struct Solution_s {
+        bool        m_valid;
+        uint32_t    m_hseSpeedInHz;
+        unsigned    m_pllM;
+        unsigned    m_pllN;
+        unsigned    m_pllP;
+        unsigned    m_pllQ;
+        unsigned    m_apb1Div;
+        unsigned    m_apb2Div;
+        uint32_t    m_sysclkSpeedInHz;
+        uint32_t    m_pll48SpeedInHz;
+        unsigned    m_flashWaitStates;
+    } Solution_t;
+
+private:
+    static constexpr uint32_t   m_vcoInMinInHz      =   1 * 1000 * 1000;
+    static constexpr uint32_t   m_vcoInMaxInHz      =   2 * 1000 * 1000;
+    static constexpr uint32_t   m_vcoOutMinInHz     = 100 * 1000 * 1000;
+    static constexpr uint32_t   m_vcoOutMaxInHz     = 432 * 1000 * 1000;
+
+    static constexpr unsigned   m_pllMMin = 2,  m_pllMMax = 63;
+    static constexpr unsigned   m_pllNMin = 50, m_pllNMax = 432;
+    static constexpr unsigned   m_pllQMin = 2,  m_pllQMax = 15;
+
+    static constexpr unsigned
+    getApbDiv(const uint32_t p_hclkInHz, const uint32_t p_apbMaxInHz) {
+        unsigned div = 1;
+
+        while ((div < 16) && ((p_hclkInHz / div) > p_apbMaxInHz)) {
+            div *= 2;
+        }
+
+        return div;
+    }
+
+    static constexpr unsigned
+    getFlashWaitStates(const uint32_t p_hclkInHz, const ClockLimits_t &p_limits) {
+        for (unsigned ws = 0; (ws < 8) && (p_limits.m_flashMaxInHz[ws] != 0); ws++) {
+            if (p_hclkInHz <= p_limits.m_flashMaxInHz[ws]) {
+                return ws;
+            }
+        }
+
+        return 8; /* Out of Range */
+    }
+
+public:
+    static constexpr Solution_t
+    solve(const uint32_t p_hseSpeedInHz, const ClockLimits_t &p_limits) {
+        Solution_t best = {};
+
+        for (unsigned m = m_pllMMin; m <= m_pllMMax; m++) {
+            /* VCO Input may be fractional, so only compare it via Products */
+            if (((uint64_t) m * m_vcoInMinInHz > p_hseSpeedInHz) || ((uint64_t) m * m_vcoInMaxInHz < p_hseSpeedInHz)) {
+                continue;
+            }
+
+            for (unsigned q = m_pllQMin; q <= m_pllQMax; q++) {
+                const uint64_t vcoOut = (uint64_t) m_usbClockInHz * q;
+                if ((vcoOut < m_vcoOutMinInHz) || (vcoOut > m_vcoOutMaxInHz) || (((vcoOut * m) % p_hseSpeedInHz) != 0)) {
+                    continue;
+                }
+
+                const uint64_t n = (vcoOut * m) / p_hseSpeedInHz;
+                if ((n < m_pllNMin) || (n > m_pllNMax)) {
+                    continue;
+                }
+
+                for (unsigned p = 2; p <= 8; p += 2) {
+                    const uint64_t sysclk = vcoOut / p;
+                    if (((vcoOut % p) != 0) || (sysclk > p_limits.m_sysclkMaxInHz) || (sysclk <= best.m_sysclkSpeedInHz)) {
+                        continue;
+                    }
+
+                    best.m_valid            = true;
+                    best.m_hseSpeedInHz     = p_hseSpeedInHz;
+                    best.m_pllM             = m;
+                    best.m_pllN             = static_cast<unsigned>(n);
+                    best.m_pllP             = p;
+                    best.m_pllQ             = q;
+                    best.m_sysclkSpeedInHz  = static_cast<uint32_t>(sysclk);
+                    best.m_pll48SpeedInHz   = static_cast<uint32_t>(vcoOut / q);
+                }
+            }
+        }
+
+        if (best.m_valid) {
+            best.m_apb1Div          = getApbDiv(best.m_sysclkSpeedInHz, p_limits.m_apb1MaxInHz);
+            best.m_apb2Div          = getApbDiv(best.m_sysclkSpeedInHz, p_limits.m_apb2MaxInHz);
+            best.m_flashWaitStates  = getFlashWaitStates(best.m_sysclkSpeedInHz, p_limits);
+            best.m_valid            = (best.m_flashWaitStates < 8)
+                                   && ((best.m_sysclkSpeedInHz / best.m_apb1Div) <= p_limits.m_apb1MaxInHz)
+                                   && ((best.m_sysclkSpeedInHz / best.m_apb2Div) <= p_limits.m_apb2MaxInHz);
+        }
+
+        return best;
+    }
+
+    static constexpr PllCfg::PllP_t
+    getPllP(const unsigned p_pllP) {
+        switch (p_pllP) {
+        case 2:     return PllCfg::PllP_t::e_PllP_Div2;
+        case 4:     return PllCfg::PllP_t::e_PllP_Div4;
+        case 6:     return PllCfg::PllP_t::e_PllP_Div6;
+        default:    return PllCfg::PllP_t::e_PllP_Div8;
+        }
+    }
+
+    static constexpr PllCfg::PllQ_t
+    getPllQ(const unsigned p_pllQ) {
+        switch (p_pllQ) {
+        case 2:     return PllCfg::PllQ_t::e_PllQ_Div2;
+        case 3:     return PllCfg::PllQ_t::e_PllQ_Div3;
+        case 4:     return PllCfg::PllQ_t::e_PllQ_Div4;
+        case 5:     return PllCfg::PllQ_t::e_PllQ_Div5;
+        case 6:     return PllCfg::PllQ_t::e_PllQ_Div6;
+        case 7:     return PllCfg::PllQ_t::e_PllQ_Div7;
+        case 8:     return PllCfg::PllQ_t::e_PllQ_Div8;
+        case 9:     return PllCfg::PllQ_t::e_PllQ_Div9;
+        case 10:    return PllCfg::PllQ_t::e_PllQ_Div10;
+        case 11:    return PllCfg::PllQ_t::e_PllQ_Div11;
+        case 12:    return PllCfg::PllQ_t::e_PllQ_Div12;
+        case 13:    return PllCfg::PllQ_t::e_PllQ_Div13;
+        case 14:    return PllCfg::PllQ_t::e_PllQ_Div14;
+        default:    return PllCfg::PllQ_t::e_PllQ_Div15;
+        }
+    }
+
+    static constexpr PllCfg::APBPrescaler_t
+    getApbPrescaler(const unsigned p_apbDiv) {
+        switch (p_apbDiv) {
+        case 1:     return PllCfg::APBPrescaler_t::e_APBPrescaler_None;
+        case 2:     return PllCfg::APBPrescaler_t::e_APBPrescaler_Div2;
+        case 4:     return PllCfg::APBPrescaler_t::e_APBPrescaler_Div4;
+        case 8:     return PllCfg::APBPrescaler_t::e_APBPrescaler_Div8;
+        default:    return PllCfg::APBPrescaler_t::e_APBPrescaler_Div16;
+        }
+    }
+
+    static constexpr PllCfg
+    getPllCfg(const Solution_t &p_solution) {
+        return {
+            .m_pllSource        = PllCfg::PllSource_t::e_PllSourceHSE,
+            .m_hseSpeedInHz     = p_solution.m_hseSpeedInHz,
+            .m_pllM             = p_solution.m_pllM,
+            .m_pllN             = p_solution.m_pllN,
+            .m_pllP             = getPllP(p_solution.m_pllP),
+            .m_pllQ             = getPllQ(p_solution.m_pllQ),
+            .m_sysclkSource     = PllCfg::SysclkSource_t::e_SysclkPLL,
+            .m_ahbPrescaler     = PllCfg::AHBPrescaler_t::e_AHBPrescaler_None,
+            .m_apb1Prescaler    = getApbPrescaler(p_solution.m_apb1Div),
+            .m_apb2Prescaler    = getApbPrescaler(p_solution.m_apb2Div)
+        };
+    }
+};
+
+} /* namespace stm32 */
+
+#endif /* _STM32_PLL_SOLVER_HPP_4B7E19C2_ */
@@ -0,0 +1,256 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _STM32_UART_RX_DMA_HPP_91C03E5B_
+#define _STM32_UART_RX_DMA_HPP_91C03E5B_
+
+#include <stm32f4xx.h>
+#include <stm32/DmaStream.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace stm32 {
+    namespace Uart {
+
+/***************************************************************************//**
+ * @brief UART Receive Path via a circular DMA Buffer.
+ *
+ * The DMA Stream runs in circular Mode and writes all received Bytes into the
+ * Buffer. The CPU is only interrupted when the Line goes idle (\c USART_SR_IDLE)
+ * and when the DMA Stream reaches the half and the end of the Buffer. There is
+ * no per-Byte Interrupt.
+ *
+ * The Receive Path is independent of the UART Driver in \c stm32::Uart::Usart6
+ * which still owns the Pins, the Clock and the Baud Rate Setting.
+ *
+ * Received Data is handed out as contiguous Regions of the Buffer, i.e. the
+ * Consumer can pass it on without copying. The Region must be released via
+ * consume() before the DMA Stream wraps around and overwrites it, and peek()
+ * must not be called while a Region is handed out.
+ *
+ * The UART cannot be throttled, so the DMA Stream overwrites unconsumed Data
+ * if the Consumer falls behind by more than \p nBufferSz Bytes. This is
+ * detected by counting the received Bytes on every Half-Transfer /
+ * Transfer-Complete Interrupt, i.e. at least every half Buffer, and on every
+ * Call to peek() and consume(). A Buffer Overrun is counted and reported as
+ * ::stm32::Uart::UartRxDmaT::e_LineError_Overrun. All unconsumed Data is then
+ * discarded, so the next Region starts at the current Write Position again.
+ * A Region that was handed out when the Overrun happened may already have
+ * been sent partly overwritten; the Overrun Report tells the Host so.
+ *
+ * Receive Errors raise the UART Interrupt as well and are collected until they
+ * are fetched via takeLineErrors(). A Break is detected via the LIN Break
+ * Detection of the UART, which works alongside the 8N1 Mode of the UART
+ * Driver. As a Break also violates the Stop Bit, it may additionally be
+ * reported as a Framing Error.
+ *
+ * @tparam nBufferSz Size of the circular Buffer in Bytes.
+ ******************************************************************************/
+template<size_t nBufferSz>
+class UartRxDmaT {
+public:
+    typedef enum LineError_e : uint32_t {
+        e_LineError_Overrun = (1u << 0),
+        e_LineError_Framing = (1u << 1),
+        e_LineError_Parity  = (1u << 2),
+        e_LineError_Break   = (1u << 3)
+    } LineError_t;
+
+private:
+    static_assert(nBufferSz > 0, "Buffer must not be empty");
+    static_assert(nBufferSz <= 0xFFFF, "DMA Stream can transfer at most 65535 Items");
+
+    USART_TypeDef * const       m_usart;
+    const DmaStream             m_stream;
+    const unsigned              m_channel;
+
+    alignas(4) uint8_t          m_buffer[nBufferSz];
+    size_t                      m_readPos;
+    size_t                      m_lastWritePos;
+    size_t                      m_unread;           /* Incl. the Region handed out */
+    bool                        m_discarded;        /* Region handed out was dropped by an Overrun */
+    unsigned                    m_overruns;
+    unsigned                    m_bufferOverruns;
+    uint32_t                    m_lineErrors;
+
+    size_t
+    getWritePos(void) const {
+        const size_t pos = nBufferSz - m_stream->NDTR;
+
+        return (pos == nBufferSz) ? 0 : pos;
+    }
+
+    /*
+     * Accounts for the Bytes the DMA Stream has written since the last Call.
+     * Called at least every half Buffer, so the Distance is unambiguous.
+     */
+    void
+    update(void) {
+        const size_t writePos = getWritePos();
+
+        m_unread       += (writePos + nBufferSz - m_lastWritePos) % nBufferSz;
+        m_lastWritePos  = writePos;
+
+        if (m_unread > nBufferSz) {
+            m_bufferOverruns++;
+            m_lineErrors   |= e_LineError_Overrun;
+
+            /* Everything unconsumed may be overwritten; start over at the Write Position */
+            m_readPos       = writePos;
+            m_unread        = 0;
+            m_discarded     = true;
+        }
+    }
+
+public:
+    UartRxDmaT(USART_TypeDef * const p_usart, DMA_TypeDef * const p_dma, const unsigned p_streamNo, const unsigned p_channel)
+      : m_usart(p_usart), m_stream(p_dma, p_streamNo), m_channel(p_channel), m_readPos(0), m_lastWritePos(0), m_unread(0),
+        m_discarded(false), m_overruns(0), m_bufferOverruns(0), m_lineErrors(0) {
+
+    }
+
+    void
+    start(void) {
+        m_stream.enableClock();
+        m_stream.disable();
+        m_stream.clearFlags(DmaStream::m_flagAll);
+
+        m_stream->PAR   = reinterpret_cast<uintptr_t>(&m_usart->DR);
+        m_stream->M0AR  = reinterpret_cast<uintptr_t>(m_buffer);
+        m_stream->NDTR  = nBufferSz;
+        m_stream->FCR   = 0; /* Direct Mode */
+        m_stream->CR    = (m_channel << DMA_SxCR_CHSEL_Pos)
+                        | DMA_SxCR_PL_1     /* High Priority */
+                        | DMA_SxCR_MINC
+                        | DMA_SxCR_CIRC
+                        | DMA_SxCR_HTIE
+                        | DMA_SxCR_TCIE;    /* DIR = 00b: Peripheral to Memory */
+
+        m_readPos       = 0;
+        m_lastWritePos  = 0;
+        m_unread        = 0;
+        m_discarded     = false;
+
+        m_stream->CR    |= DMA_SxCR_EN;
+
+        m_usart->CR2    |= USART_CR2_LINEN | USART_CR2_LBDIE;
+        m_usart->CR3    |= USART_CR3_DMAR | USART_CR3_EIE;
+        m_usart->CR1    |= USART_CR1_IDLEIE | USART_CR1_PEIE | USART_CR1_RE;
+    }
+
+    void
+    stop(void) {
+        m_usart->CR1    &= ~(USART_CR1_IDLEIE | USART_CR1_PEIE | USART_CR1_RE);
+        m_usart->CR3    &= ~(USART_CR3_DMAR | USART_CR3_EIE);
+        m_usart->CR2    &= ~(USART_CR2_LINEN | USART_CR2_LBDIE);
+        m_stream.disable();
+    }
+
+    /**
+     * @brief Handle the UART Interrupt.
+     *
+     * @return \c true if the Line went idle, i.e. the Sender paused.
+     */
+    bool
+    handleUartIrq(void) {
+        const uint32_t sr = m_usart->SR;
+
+        if (sr & USART_SR_ORE) {
+            m_overruns++;
+            m_lineErrors |= e_LineError_Overrun;
+        }
+        if (sr & USART_SR_FE) {
+            m_lineErrors |= e_LineError_Framing;
+        }
+        if (sr & USART_SR_PE) {
+            m_lineErrors |= e_LineError_Parity;
+        }
+        if (sr & USART_SR_LBD) {
+            m_lineErrors |= e_LineError_Break;
+            m_usart->SR = ~USART_SR_LBD;
+        }
+
+        if (sr & (USART_SR_IDLE | USART_SR_ORE | USART_SR_FE | USART_SR_NE | USART_SR_PE)) {
+            /* Flags are cleared by reading SR followed by DR */
+            (void) m_usart->DR;
+        }
+
+        return (sr & USART_SR_IDLE) != 0;
+    }
+
+    /**
+     * @brief Handle the DMA Stream Interrupt.
+     *
+     * @return Half-Transfer / Transfer-Complete Flags that were set.
+     */
+    uint32_t
+    handleDmaIrq(void) {
+        const uint32_t flags = m_stream.getFlags();
+
+        m_stream.clearFlags(flags);
+        update();
+
+        return flags & (DmaStream::m_flagHalfTransfer | DmaStream::m_flagTransferComplete);
+    }
+
+    /**
+     * @brief Get the contiguous Region of received, unconsumed Data.
+     *
+     * If the received Data wraps around the End of the Buffer, only the Part up
+     * to the End of the Buffer is returned.
+     */
+    size_t
+    peek(const uint8_t ** const p_data) {
+        update();
+        m_discarded = false;
+
+        *p_data = &m_buffer[m_readPos];
+
+        return ((m_readPos + m_unread) <= nBufferSz) ? m_unread : (nBufferSz - m_readPos);
+    }
+
+    void
+    consume(const size_t p_length) {
+        update();
+
+        /* Nothing to release if a Buffer Overrun has discarded the Region */
+        if (m_discarded) {
+            m_discarded = false;
+            return;
+        }
+
+        m_readPos   = (m_readPos + p_length) % nBufferSz;
+        m_unread   -= p_length;
+    }
+
+    /** @brief Overruns of the UART's Receive Register, i.e. the DMA Stream was too slow. */
+    unsigned
+    getOverruns(void) const {
+        return m_overruns;
+    }
+
+    /** @brief Overruns of the circular Buffer, i.e. the Consumer was too slow. */
+    unsigned
+    getBufferOverruns(void) const {
+        return m_bufferOverruns;
+    }
+
+    /** @brief Receive Errors since the last Call, see ::stm32::Uart::UartRxDmaT::LineError_e. */
+    uint32_t
+    takeLineErrors(void) {
+        const uint32_t lineErrors = m_lineErrors;
+
+        m_lineErrors = 0;
+
+        return lineErrors;
+    }
+};
+
+    } /* namespace Uart */
+} /* namespace stm32 */
+
+#endif /* _STM32_UART_RX_DMA_HPP_91C03E5B_ */
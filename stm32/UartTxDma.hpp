@@ -0,0 +1,192 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _STM32_UART_TX_DMA_HPP_58E2F9A4_
+#define _STM32_UART_TX_DMA_HPP_58E2F9A4_
+
+#include <stm32f4xx.h>
+#include <stm32/DmaStream.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace stm32 {
+    namespace Uart {
+
+/***************************************************************************//**
+ * @brief UART Transmit Path via a multi-buffered DMA Stream.
+ *
+ * Each Call to submit() copies one Block (e.g. one USB Packet) into a free
+ * Buffer. While the DMA Stream sends one Buffer, the others can be filled.
+ * The CPU is only interrupted once per Block.
+ *
+ * Like ::stm32::Uart::UartRxDmaT, this is independent of the UART Driver in
+ * \c stm32::Uart::Usart6 which still owns the Pins, Clock and Baud Rate.
+ *
+ * The DMA Stream is done with a Block before the UART has sent it. Before the
+ * Baud Rate is changed, the Caller must stop submitting and wait until
+ * isDrained(). The UART Interrupt can signal this, see setDrainIrq().
+ *
+ * @tparam nBufferSz Size of each Buffer in Bytes.
+ * @tparam nNumBuffers Number of Buffers, incl. the one the DMA Stream sends.
+ ******************************************************************************/
+template<size_t nBufferSz = 64, unsigned nNumBuffers = 2>
+class UartTxDmaT {
+    static_assert(nBufferSz > 0, "Buffer must not be empty");
+    static_assert(nNumBuffers >= 2, "Need at least two Buffers to fill one while the other is sent");
+    static_assert(nBufferSz <= 0xFFFF, "DMA Stream can transfer at most 65535 Items");
+
+    USART_TypeDef * const       m_usart;
+    const DmaStream             m_stream;
+    const unsigned              m_channel;
+
+    alignas(4) uint8_t          m_buffer[nNumBuffers][nBufferSz];
+    size_t                      m_length[nNumBuffers];
+    unsigned                    m_active;
+    unsigned                    m_numQueued;
+
+    void
+    startTransfer(const unsigned p_idx) {
+        m_stream.clearFlags(DmaStream::m_flagAll);
+
+        /* TC is set again once the UART has sent the last Bit of the Block */
+        m_usart->SR     = ~USART_SR_TC;
+
+        m_stream->M0AR  = reinterpret_cast<uintptr_t>(m_buffer[p_idx]);
+        m_stream->NDTR  = m_length[p_idx];
+        m_stream->CR    |= DMA_SxCR_EN;
+    }
+
+public:
+    UartTxDmaT(USART_TypeDef * const p_usart, DMA_TypeDef * const p_dma, const unsigned p_streamNo, const unsigned p_channel)
+      : m_usart(p_usart), m_stream(p_dma, p_streamNo), m_channel(p_channel), m_length {}, m_active(0), m_numQueued(0) {
+
+    }
+
+    void
+    start(void) {
+        m_stream.enableClock();
+        m_stream.disable();
+        m_stream.clearFlags(DmaStream::m_flagAll);
+
+        m_stream->PAR   = reinterpret_cast<uintptr_t>(&m_usart->DR);
+        m_stream->FCR   = 0; /* Direct Mode */
+        m_stream->CR    = (m_channel << DMA_SxCR_CHSEL_Pos)
+                        | DMA_SxCR_PL_0     /* Medium Priority */
+                        | DMA_SxCR_MINC
+                        | DMA_SxCR_DIR_0    /* Memory to Peripheral */
+                        | DMA_SxCR_TCIE;
+
+        m_active    = 0;
+        m_numQueued = 0;
+
+        m_usart->CR3    |= USART_CR3_DMAT;
+    }
+
+    void
+    stop(void) {
+        m_usart->CR3    &= ~USART_CR3_DMAT;
+        m_stream.disable();
+
+        m_numQueued = 0;
+    }
+
+    bool
+    isFull(void) const {
+        return (m_numQueued == nNumBuffers);
+    }
+
+    unsigned
+    getNumFree(void) const {
+        return (nNumBuffers - m_numQueued);
+    }
+
+    bool
+    isIdle(void) const {
+        return (m_numQueued == 0);
+    }
+
+    /** @brief Whether the UART has sent the last Bit of all queued Blocks. */
+    bool
+    isDrained(void) const {
+        return isIdle() && ((m_usart->SR & USART_SR_TC) != 0);
+    }
+
+    /**
+     * @brief Raise the UART Interrupt when the UART is drained.
+     *
+     * The UART Interrupt keeps firing while the UART is drained, so this must
+     * be disabled again once the Caller has seen it.
+     */
+    void
+    setDrainIrq(const bool p_enable) {
+        if (p_enable) {
+            m_usart->CR1 |= USART_CR1_TCIE;
+        } else {
+            m_usart->CR1 &= ~USART_CR1_TCIE;
+        }
+    }
+
+    /**
+     * @brief Queue a Block for Transmission.
+     *
+     * @return \c false if all Buffers are busy. The Block is not queued then.
+     */
+    bool
+    submit(const void * const p_data, const size_t p_length) {
+        if (isFull()) {
+            return false;
+        }
+
+        const unsigned idx = (m_active + m_numQueued) % nNumBuffers;
+        const size_t length = (p_length < nBufferSz) ? p_length : nBufferSz;
+
+        if (length == 0) {
+            return true;
+        }
+
+        ::memcpy(m_buffer[idx], p_data, length);
+        m_length[idx] = length;
+
+        m_numQueued++;
+        if (m_numQueued == 1) {
+            startTransfer(idx);
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief Handle the DMA Stream Interrupt.
+     *
+     * @return \c true if a Buffer was released.
+     */
+    bool
+    handleDmaIrq(void) {
+        const uint32_t flags = m_stream.getFlags();
+
+        m_stream.clearFlags(flags);
+
+        if (!(flags & DmaStream::m_flagTransferComplete) || (m_numQueued == 0)) {
+            return false;
+        }
+
+        m_active = (m_active + 1) % nNumBuffers;
+        m_numQueued--;
+
+        if (m_numQueued > 0) {
+            startTransfer(m_active);
+        }
+
+        return true;
+    }
+};
+
+    } /* namespace Uart */
+} /* namespace stm32 */
+
+#endif /* _STM32_UART_TX_DMA_HPP_58E2F9A4_ */
@@ -0,0 +1,286 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _BULK_IN_ENDPOINT_FIFO_VIA_STM32F4_HPP_93B2D7E4_
+#define _BULK_IN_ENDPOINT_FIFO_VIA_STM32F4_HPP_93B2D7E4_
+
+#include <usb/UsbBulkInApplication.hpp>
+#include <usb/EndpointDispatcherViaSTM32F4.hpp>
+
+#include <stm32f4xx.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace stm32 {
+    namespace usb {
+
+/***************************************************************************//**
+ * @brief Bulk IN Endpoint of the STM32F4 OTG Core for a further Function of a
+ *   Composite Device.
+ *
+ * The Core's Endpoint Drivers only serve the Endpoints of the Configuration's
+ * Interface. Like ::stm32::usb::InterruptInEndpointViaSTM32F4, this Endpoint
+ * is therefore set up by activate() when the Host sets the Configuration, see
+ * ::usb::UsbEndpointConfigurationT. Each \c SET_CONFIGURATION activates it
+ * again, which drops a pending Transfer and resets the Data Toggle to DATA0.
+ * The dropped Transfer is reported as complete once the Endpoint is active
+ * again, so the Application does not wait for it forever. A Bus Reset clears
+ * the Address, which handleSof() notices; the Endpoint then stays inactive
+ * until the Device is configured again.
+ *
+ * write() starts a Transfer of any Length. The TX FIFO is filled with as many
+ * Packets as fit; the Rest is loaded from the \c TXFE Interrupt, which is only
+ * unmasked in \c DIEPEMPMSK while Data is left. Once the Host has taken the
+ * last Packet, the registered ::usb::UsbBulkInApplication is notified via
+ * \c inTransferComplete(). The Buffer passed to write() must stay valid until
+ * then.
+ *
+ * setStall() halts the Endpoint, e.g. when a Mass Storage Function rejects a
+ * CBW. The Core then answers all IN Tokens with STALL until clearStall() or the
+ * Host's \c CLEAR_FEATURE(ENDPOINT_HALT) clears \c DIEPCTLx.STALL again.
+ *
+ * The Endpoint's Events are routed via
+ * ::stm32::usb::EndpointDispatcherViaSTM32F4, so the Core never sees them.
+ * handleSof(), write(), activate(), deactivate() and the Stall Functions must
+ * be called from the OTG Interrupt Handler or with the OTG Interrupt masked.
+ *
+ * @tparam nEndpointNumber IN Endpoint Number, e.g. \c 3 for \c 0x83.
+ * @tparam nPacketSz Max. Packet Size of the Endpoint.
+ ******************************************************************************/
+template<unsigned nEndpointNumber, size_t nPacketSz = 64>
+class BulkInEndpointFifoViaSTM32F4 : public UsbEndpointIrqHandler {
+    static_assert((nEndpointNumber > 0) && (nEndpointNumber < 4), "OTG_FS Core only supports IN Endpoints 1..3 for Bulk Transfers");
+    static_assert((nPacketSz > 0) && (nPacketSz <= 64) && ((nPacketSz & (nPacketSz - 1)) == 0),
+      "Full Speed Bulk Endpoints support Max. Packet Sizes of 8, 16, 32 or 64 Bytes");
+
+    const uintptr_t                     m_otgBase;
+    const unsigned                      m_txFifoOffsetInWords;
+    const unsigned                      m_txFifoSzInWords;
+    ::usb::UsbBulkInApplication *       m_application;
+
+    const uint8_t *                     m_data;
+    size_t                              m_remaining;
+    bool                                m_active;
+    /** @brief A Transfer was dropped by deactivate(); activate() reports it as complete. */
+    bool                                m_dropped;
+
+    USB_OTG_GlobalTypeDef *
+    global(void) const {
+        return reinterpret_cast<USB_OTG_GlobalTypeDef *>(m_otgBase);
+    }
+
+    USB_OTG_DeviceTypeDef *
+    device(void) const {
+        return reinterpret_cast<USB_OTG_DeviceTypeDef *>(m_otgBase + USB_OTG_DEVICE_BASE);
+    }
+
+    USB_OTG_INEndpointTypeDef *
+    inEndpoint(void) const {
+        return reinterpret_cast<USB_OTG_INEndpointTypeDef *>(m_otgBase + USB_OTG_IN_ENDPOINT_BASE + nEndpointNumber * USB_OTG_EP_REG_SIZE);
+    }
+
+    volatile uint32_t *
+    txFifo(void) const {
+        return reinterpret_cast<volatile uint32_t *>(m_otgBase + USB_OTG_FIFO_BASE + nEndpointNumber * USB_OTG_FIFO_SIZE);
+    }
+
+    bool
+    isAddressed(void) const {
+        return (device()->DCFG & USB_OTG_DCFG_DAD) != 0;
+    }
+
+    /** @brief Load whole Packets into the TX FIFO while there is Room. */
+    void
+    fill(void) {
+        while (m_remaining > 0) {
+            const size_t length     = (m_remaining < nPacketSz) ? m_remaining : nPacketSz;
+            const size_t numWords   = (length + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+            if ((inEndpoint()->DTXFSTS & USB_OTG_DTXFSTS_INEPTFSAV) < numWords) {
+                break;
+            }
+
+            for (size_t offs = 0; offs < length; offs += sizeof(uint32_t)) {
+                uint32_t word = 0;
+
+                ::memcpy(&word, &m_data[offs], ((length - offs) < sizeof(word)) ? (length - offs) : sizeof(word));
+                *txFifo() = word;
+            }
+
+            m_data      += length;
+            m_remaining -= length;
+        }
+
+        if (m_remaining == 0) {
+            device()->DIEPEMPMSK &= ~(1u << nEndpointNumber);
+        } else {
+            device()->DIEPEMPMSK |= (1u << nEndpointNumber);
+        }
+    }
+
+public:
+    /**
+     * @param p_txFifoOffsetInWords Start of the TX FIFO, see
+     *   ::stm32::usb::FifoPlanT::getTxFifoOffsetInWords().
+     * @param p_txFifoSzInWords Size of the TX FIFO, must hold one Packet.
+     * @param p_otgBase Base Address of the OTG Register Block.
+     */
+    constexpr BulkInEndpointFifoViaSTM32F4(const unsigned p_txFifoOffsetInWords, const unsigned p_txFifoSzInWords, const uintptr_t p_otgBase = USB_OTG_FS_PERIPH_BASE)
+      : m_otgBase(p_otgBase), m_txFifoOffsetInWords(p_txFifoOffsetInWords), m_txFifoSzInWords(p_txFifoSzInWords),
+        m_application(nullptr), m_data(nullptr), m_remaining(0), m_active(false), m_dropped(false) {
+
+    }
+
+    void
+    registerApplication(::usb::UsbBulkInApplication &p_application) {
+        m_application = &p_application;
+    }
+
+    void
+    unregisterApplication(void) {
+        m_application = nullptr;
+    }
+
+    /** @brief Set up the Endpoint and its TX FIFO. A pending Transfer is dropped, the next Packet is sent as DATA0. */
+    void
+    activate(void) {
+        deactivate();
+
+        global()->DIEPTXF[nEndpointNumber - 1] = (m_txFifoSzInWords << USB_OTG_DIEPTXF_INEPTXFD_Pos) | m_txFifoOffsetInWords;
+
+        inEndpoint()->DIEPCTL = USB_OTG_DIEPCTL_USBAEP
+                              | (0x2u << USB_OTG_DIEPCTL_EPTYP_Pos)     /* Bulk */
+                              | (nEndpointNumber << USB_OTG_DIEPCTL_TXFNUM_Pos)
+                              | USB_OTG_DIEPCTL_SD0PID_SEVNFRM
+                              | USB_OTG_DIEPCTL_SNAK
+                              | nPacketSz;
+        device()->DAINTMSK |= (1u << nEndpointNumber);
+
+        m_active = true;
+
+        if (m_dropped) {
+            m_dropped = false;
+
+            if (m_application != nullptr) {
+                m_application->inTransferComplete();
+            }
+        }
+    }
+
+    /** @brief Disable the Endpoint and flush its TX FIFO, e.g. when the Device is unconfigured. */
+    void
+    deactivate(void) {
+        device()->DAINTMSK      &= ~(1u << nEndpointNumber);
+        device()->DIEPEMPMSK    &= ~(1u << nEndpointNumber);
+
+        /* In Progress, or complete but not yet reported */
+        if ((inEndpoint()->DIEPCTL & USB_OTG_DIEPCTL_EPENA) || (inEndpoint()->DIEPINT & USB_OTG_DIEPINT_XFRC)) {
+            m_dropped = true;
+        }
+
+        if (inEndpoint()->DIEPCTL & USB_OTG_DIEPCTL_EPENA) {
+            inEndpoint()->DIEPCTL |= USB_OTG_DIEPCTL_SNAK | USB_OTG_DIEPCTL_EPDIS;
+            while ((inEndpoint()->DIEPINT & USB_OTG_DIEPINT_EPDISD) == 0) ;
+        }
+        inEndpoint()->DIEPINT = USB_OTG_DIEPINT_EPDISD | USB_OTG_DIEPINT_XFRC;
+
+        global()->GRSTCTL = USB_OTG_GRSTCTL_TXFFLSH | (nEndpointNumber << USB_OTG_GRSTCTL_TXFNUM_Pos);
+        while (global()->GRSTCTL & USB_OTG_GRSTCTL_TXFFLSH) ;
+
+        inEndpoint()->DIEPCTL &= ~USB_OTG_DIEPCTL_USBAEP;
+
+        m_data      = nullptr;
+        m_remaining = 0;
+        m_active    = false;
+    }
+
+    /** @brief \c true if the Endpoint is set up, not halted and no Transfer is in Progress. */
+    bool
+    isReady(void) const {
+        return m_active && ((inEndpoint()->DIEPCTL & (USB_OTG_DIEPCTL_EPENA | USB_OTG_DIEPCTL_STALL)) == 0);
+    }
+
+    /**
+     * @brief Halt the Endpoint.
+     *
+     * Must only be called while no Transfer is in Progress, so there is no
+     * Data in the TX FIFO that would have to be flushed.
+     */
+    void
+    setStall(void) const {
+        inEndpoint()->DIEPCTL |= USB_OTG_DIEPCTL_STALL;
+    }
+
+    /** @brief Lift the Halt; the next Packet is sent as DATA0, see USB 2.0, 9.4.5. */
+    void
+    clearStall(void) const {
+        inEndpoint()->DIEPCTL = (inEndpoint()->DIEPCTL & ~USB_OTG_DIEPCTL_STALL) | USB_OTG_DIEPCTL_SD0PID_SEVNFRM;
+    }
+
+    bool
+    isStalled(void) const {
+        return (inEndpoint()->DIEPCTL & USB_OTG_DIEPCTL_STALL) != 0;
+    }
+
+    /**
+     * @brief Start an IN Transfer of \p p_length Bytes from \p p_data.
+     *
+     * A Length of zero sends a Zero-Length Packet.
+     *
+     * @return \c false if the Endpoint is not ready, see isReady().
+     */
+    bool
+    write(const void * const p_data, const size_t p_length) {
+        if (!isReady()) {
+            return false;
+        }
+
+        const uint32_t pktcnt = (p_length == 0) ? 1 : ((p_length + nPacketSz - 1) / nPacketSz);
+
+        m_data      = static_cast<const uint8_t *>(p_data);
+        m_remaining = p_length;
+
+        inEndpoint()->DIEPINT   = USB_OTG_DIEPINT_XFRC;
+        inEndpoint()->DIEPTSIZ  = (pktcnt << USB_OTG_DIEPTSIZ_PKTCNT_Pos) | p_length;
+        inEndpoint()->DIEPCTL   |= USB_OTG_DIEPCTL_EPENA | USB_OTG_DIEPCTL_CNAK;
+
+        fill();
+
+        return true;
+    }
+
+    void
+    handleEndpointIrq(void) override {
+        const uint32_t diepint = inEndpoint()->DIEPINT;
+
+        if ((diepint & USB_OTG_DIEPINT_TXFE) && (m_remaining > 0)) {
+            fill();
+        }
+
+        if (diepint & USB_OTG_DIEPINT_XFRC) {
+            inEndpoint()->DIEPINT = USB_OTG_DIEPINT_XFRC;
+
+            if (m_application != nullptr) {
+                m_application->inTransferComplete();
+            }
+        }
+    }
+
+    /** @brief Notice a Bus Reset, after which the Endpoint must be activated again. */
+    void
+    handleSof(void) {
+        if (!isAddressed()) {
+            m_active = false;
+        }
+    }
+};
+
+    } /* namespace usb */
+} /* namespace stm32 */
+
+#endif /* _BULK_IN_ENDPOINT_FIFO_VIA_STM32F4_HPP_93B2D7E4_ */
@@ -0,0 +1,278 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _BULK_OUT_ENDPOINT_ZERO_COPY_VIA_STM32F4_HPP_5A07D3C8_
+#define _BULK_OUT_ENDPOINT_ZERO_COPY_VIA_STM32F4_HPP_5A07D3C8_
+
+#include <usb/UsbBulkOutZeroCopyApplication.hpp>
+#include <usb/EndpointDispatcherViaSTM32F4.hpp>
+
+#include <stm32f4xx.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace stm32 {
+    namespace usb {
+
+/***************************************************************************//**
+ * @brief Default for the \c RxCrcT Parameter of
+ *   ::stm32::usb::BulkOutEndpointZeroCopyViaSTM32F4: No Checksum.
+ ******************************************************************************/
+struct NoRxCrc {
+    static void update(const uint32_t /* p_word */) { }
+};
+
+/***************************************************************************//**
+ * @brief Bulk OUT Endpoint of the STM32F4 OTG Core that drains the RX FIFO
+ *   straight into a Buffer lent by the Application.
+ *
+ * The regular Path pops each Packet into a Buffer of the Endpoint Driver and
+ * the Application then copies it again. Here, the Application lends its
+ * Destination (e.g. the next Slot of a Ring) ahead of Time via
+ * ::usb::UsbBulkOutZeroCopyApplication::lendOutBuffer(). The RX FIFO Words are
+ * stored directly into that Buffer; a Tail of less than four Bytes is copied
+ * out of the last Word. Ownership returns to the Application with
+ * \c packetReceived() once the Transfer is complete. The Endpoint is then
+ * re-armed with the next lent Buffer.
+ *
+ * The Endpoint registers with ::stm32::usb::EndpointDispatcherViaSTM32F4,
+ * which hands it the RX FIFO Entries and the Transfer Complete Event of its
+ * Endpoint, so the Core only sees the Events of the other Endpoints. On the
+ * Endpoint that the Core's OUT Endpoint Driver activates upon
+ * \c SET_CONFIGURATION, nothing else is needed. An Endpoint of a further
+ * Function in a Composite Device has no Core Driver. Like
+ * ::stm32::usb::InterruptInEndpointViaSTM32F4, it is then set up by activate()
+ * when the Host sets the Configuration, see ::usb::UsbEndpointConfigurationT,
+ * which also resets the Data Toggle on Re-Configuration.
+ *
+ * The Class provides the same Flow Control Interface as
+ * ::stm32::usb::OutEndpointNakViaSTM32F4, i.e. it can be passed to the
+ * Application as its \c OutFlowControlT. While the Application has no Buffer to
+ * lend, the Endpoint is not re-armed, so the Core NAKs the Host. On top of
+ * that, setStall() halts the Endpoint, i.e. the Core answers OUT Tokens with
+ * STALL until clearStall() or the Host's \c CLEAR_FEATURE(ENDPOINT_HALT)
+ * clears \c DOEPCTLx.STALL again.
+ *
+ * The Base Address of the OTG Register Block is a Constructor Parameter so that
+ * the Class can be pointed at a Register Model in the Host Build.
+ *
+ * @tparam nEndpointNumber OUT Endpoint Number, e.g. \c 1 for \c 0x01.
+ * @tparam nPacketSz Max. Packet Size of the Endpoint.
+ * @tparam RxCrcT Checksum Unit that is fed each Word as it leaves the RX FIFO,
+ *   e.g. ::stm32::CrcViaSTM32F4. A Tail of less than four Bytes is fed
+ *   zero-padded. Packets dropped for lack of a Buffer are not fed.
+ ******************************************************************************/
+template<unsigned nEndpointNumber, size_t nPacketSz = 64, typename RxCrcT = NoRxCrc>
+class BulkOutEndpointZeroCopyViaSTM32F4 : public UsbRxFifoHandler {
+    static_assert((nEndpointNumber > 0) && (nEndpointNumber < 4), "OTG_FS Core only supports OUT Endpoints 1..3 for Bulk Transfers");
+    static_assert(nPacketSz <= 0x7FF, "Max. Packet Size exceeds MPSIZ");
+
+    const uintptr_t                             m_otgBase;
+    ::usb::UsbBulkOutZeroCopyApplication *      m_application;
+
+    /* Changed by clearNak(), which Applications call via a const Reference */
+    mutable uint8_t *                           m_buffer;
+    mutable size_t                              m_length;
+    mutable bool                                m_naked;
+    unsigned                                    m_numDropped;
+
+    USB_OTG_DeviceTypeDef *
+    device(void) const {
+        return reinterpret_cast<USB_OTG_DeviceTypeDef *>(m_otgBase + USB_OTG_DEVICE_BASE);
+    }
+
+    USB_OTG_OUTEndpointTypeDef *
+    outEndpoint(void) const {
+        return reinterpret_cast<USB_OTG_OUTEndpointTypeDef *>(m_otgBase + USB_OTG_OUT_ENDPOINT_BASE + nEndpointNumber * USB_OTG_EP_REG_SIZE);
+    }
+
+    volatile uint32_t *
+    rxFifo(void) const {
+        return reinterpret_cast<volatile uint32_t *>(m_otgBase + USB_OTG_FIFO_BASE);
+    }
+
+    void
+    lend(void) const {
+        if ((m_buffer == nullptr) && !m_naked && (m_application != nullptr)) {
+            m_buffer = static_cast<uint8_t *>(m_application->lendOutBuffer());
+            m_length = 0;
+        }
+    }
+
+    void
+    arm(void) const {
+        lend();
+        if (m_buffer == nullptr) {
+            return;
+        }
+
+        outEndpoint()->DOEPTSIZ = (1u << USB_OTG_DOEPTSIZ_PKTCNT_Pos) | nPacketSz;
+        outEndpoint()->DOEPCTL  |= USB_OTG_DOEPCTL_EPENA | USB_OTG_DOEPCTL_CNAK;
+    }
+
+    void
+    drain(const size_t p_length) {
+        const size_t numWords = p_length / sizeof(uint32_t);
+        const size_t tail     = p_length % sizeof(uint32_t);
+
+        /* First Packet after SET_CONFIGURATION, the Core's Driver has armed the Endpoint */
+        lend();
+
+        if ((m_buffer == nullptr) || ((m_length + p_length) > nPacketSz)) {
+            for (size_t idx = 0; idx < (numWords + (tail ? 1 : 0)); idx++) {
+                (void) *rxFifo();
+            }
+            m_numDropped++;
+            return;
+        }
+
+        uint32_t * const dst = reinterpret_cast<uint32_t *>(&m_buffer[m_length]);
+        for (size_t idx = 0; idx < numWords; idx++) {
+            const uint32_t word = *rxFifo();
+
+            dst[idx] = word;
+            RxCrcT::update(word);
+        }
+
+        if (tail) {
+            const uint32_t last = *rxFifo() & ((1u << (8 * tail)) - 1);
+
+            ::memcpy(&dst[numWords], &last, tail);
+            RxCrcT::update(last);
+        }
+
+        m_length += p_length;
+    }
+
+    void
+    complete(void) {
+        uint8_t * const buffer = m_buffer;
+        const size_t    length = m_length;
+
+        m_buffer = nullptr;
+        m_length = 0;
+
+        if ((buffer != nullptr) && (m_application != nullptr)) {
+            m_application->packetReceived(buffer, length);
+        }
+
+        arm();
+    }
+
+public:
+    constexpr BulkOutEndpointZeroCopyViaSTM32F4(const uintptr_t p_otgBase = USB_OTG_FS_PERIPH_BASE)
+      : m_otgBase(p_otgBase), m_application(nullptr), m_buffer(nullptr), m_length(0), m_naked(false), m_numDropped(0) {
+
+    }
+
+    /** @brief Not a Constructor Parameter, as the Application usually takes this Object as its Flow Control. */
+    void
+    registerApplication(::usb::UsbBulkOutZeroCopyApplication &p_application) {
+        m_application = &p_application;
+    }
+
+    void
+    unregisterApplication(void) {
+        m_application = nullptr;
+    }
+
+    /**
+     * @brief Set up the Endpoint; only for an Endpoint without a Core Driver.
+     *
+     * The next Packet is expected as DATA0. A Buffer lent before is still the
+     * Application's next Slot; what was partially received into it is dropped.
+     */
+    void
+    activate(void) {
+        deactivate();
+
+        outEndpoint()->DOEPCTL = USB_OTG_DOEPCTL_USBAEP
+                               | (0x2u << USB_OTG_DOEPCTL_EPTYP_Pos)    /* Bulk */
+                               | USB_OTG_DOEPCTL_SD0PID_SEVNFRM
+                               | USB_OTG_DOEPCTL_SNAK
+                               | nPacketSz;
+        device()->DAINTMSK |= (1u << (16 + nEndpointNumber));
+
+        m_length = 0;
+        if (!m_naked) {
+            arm();
+        }
+    }
+
+    /**
+     * @brief NAK the Host and deactivate the Endpoint, e.g. when the Device is
+     *   unconfigured.
+     *
+     * Disabling an armed OUT Endpoint would need a global OUT NAK, so the
+     * Endpoint is only NAKed; activate() re-arms it.
+     */
+    void
+    deactivate(void) {
+        device()->DAINTMSK &= ~(1u << (16 + nEndpointNumber));
+
+        outEndpoint()->DOEPCTL = (outEndpoint()->DOEPCTL & ~USB_OTG_DOEPCTL_USBAEP) | USB_OTG_DOEPCTL_SNAK;
+        outEndpoint()->DOEPINT = USB_OTG_DOEPINT_XFRC;
+    }
+
+    /** @brief Number of Packets discarded because no Buffer was lent. Should stay at zero. */
+    unsigned
+    getNumDropped(void) const {
+        return m_numDropped;
+    }
+
+    void setNak(void) const {
+        m_naked = true;
+        outEndpoint()->DOEPCTL |= USB_OTG_DOEPCTL_SNAK;
+    }
+
+    /** @brief Lift the NAK; re-arms the Endpoint if it was left idle for lack of a Buffer. */
+    void clearNak(void) const {
+        m_naked = false;
+        if (outEndpoint()->DOEPCTL & USB_OTG_DOEPCTL_EPENA) {
+            outEndpoint()->DOEPCTL |= USB_OTG_DOEPCTL_CNAK;
+        } else {
+            arm();
+        }
+    }
+
+    bool isNak(void) const {
+        return (outEndpoint()->DOEPCTL & USB_OTG_DOEPCTL_NAKSTS) != 0;
+    }
+
+    /** @brief Halt the Endpoint. A lent Buffer stays with the Endpoint. */
+    void setStall(void) const {
+        outEndpoint()->DOEPCTL |= USB_OTG_DOEPCTL_STALL;
+    }
+
+    /** @brief Lift the Halt; the next Packet is expected as DATA0, see USB 2.0, 9.4.5. */
+    void clearStall(void) const {
+        outEndpoint()->DOEPCTL = (outEndpoint()->DOEPCTL & ~USB_OTG_DOEPCTL_STALL) | USB_OTG_DOEPCTL_SD0PID_SEVNFRM;
+    }
+
+    bool isStalled(void) const {
+        return (outEndpoint()->DOEPCTL & USB_OTG_DOEPCTL_STALL) != 0;
+    }
+
+    void
+    handleRxData(const size_t p_length) override {
+        drain(p_length);
+    }
+
+    void
+    handleEndpointIrq(void) override {
+        if (outEndpoint()->DOEPINT & USB_OTG_DOEPINT_XFRC) {
+            outEndpoint()->DOEPINT = USB_OTG_DOEPINT_XFRC;
+            complete();
+        }
+    }
+};
+
+    } /* namespace usb */
+} /* namespace stm32 */
+
+#endif /* _BULK_OUT_ENDPOINT_ZERO_COPY_VIA_STM32F4_HPP_5A07D3C8_ */
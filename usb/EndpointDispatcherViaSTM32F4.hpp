@@ -0,0 +1,163 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _ENDPOINT_DISPATCHER_VIA_STM32F4_HPP_C81E4F06_
+#define _ENDPOINT_DISPATCHER_VIA_STM32F4_HPP_C81E4F06_
+
+#include <stm32f4xx.h>
+
+#include <cstddef>
+#include <cstdint>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace stm32 {
+    namespace usb {
+
+/***************************************************************************//**
+ * @brief Interface for Endpoint Drivers serviced by
+ *   ::stm32::usb::EndpointDispatcherViaSTM32F4.
+ *
+ * handleEndpointIrq() is called when the Endpoint's Bit is set in \c DAINT. It
+ * must clear the \c DIEPINTx / \c DOEPINTx Events it has handled.
+ ******************************************************************************/
+class UsbEndpointIrqHandler {
+public:
+    virtual void handleEndpointIrq(void) = 0;
+
+protected:
+    ~UsbEndpointIrqHandler() = default;
+};
+
+/***************************************************************************//**
+ * @brief Interface for OUT Endpoint Drivers that drain the shared RX FIFO.
+ *
+ * handleRxData() is called once the \c OUT_DATA Entry of the Endpoint has been
+ * popped off \c GRXSTSP. The Driver must then read \p p_length Bytes, i.e. the
+ * Packet rounded up to full Words, from the RX FIFO.
+ ******************************************************************************/
+class UsbRxFifoHandler : public UsbEndpointIrqHandler {
+public:
+    virtual void handleRxData(const size_t p_length) = 0;
+
+protected:
+    ~UsbRxFifoHandler() = default;
+};
+
+/***************************************************************************//**
+ * @brief Routes Endpoint Events of the STM32F4 OTG Core to the Drivers of a
+ *   Composite Device.
+ *
+ * Each Function of a Composite Device has its own Endpoint Drivers, which
+ * register with the Dispatcher by Endpoint Number. The Dispatcher keeps a Table
+ * per Direction, so an Event is routed with a single Lookup:
+ * - RX FIFO Entries are looked up by the \c EPNUM Field of \c GRXSTSR.
+ * - Endpoint Interrupts are taken from the Set Bits of \c DAINT, masked by the
+ *   registered Endpoints, so only Endpoints with a pending Event are visited.
+ *
+ * handleIrq() must be called from the OTG Interrupt Handler before the Core's
+ * own \c handleIrq(). RX FIFO Entries are only taken from the Head of the FIFO
+ * and only as long as they belong to a registered Endpoint. Entries of the
+ * Control Endpoint and of Endpoints driven by the Core are left to the Core,
+ * which pops one Entry per \c RXFLVL Interrupt. As the registered Drivers clear
+ * their Events, the Core only sees the Events of its own Endpoints.
+ *
+ * The Base Address of the OTG Register Block is a Constructor Parameter so that
+ * the Class can be pointed at a Register Model in the Host Build.
+ *
+ * @tparam nNumEndpoints Number of IN and OUT Endpoints of the Core, incl. EP0.
+ ******************************************************************************/
+template<unsigned nNumEndpoints = 4>
+class EndpointDispatcherViaSTM32F4 {
+    static_assert(nNumEndpoints <= 16, "DAINT covers at most 16 Endpoints per Direction");
+
+    static constexpr uint32_t m_pktStsOutData = 2;
+    static constexpr uint32_t m_pktStsOutDone = 3;
+
+    const uintptr_t             m_otgBase;
+    UsbEndpointIrqHandler *     m_inHandlers[nNumEndpoints];
+    UsbRxFifoHandler *          m_outHandlers[nNumEndpoints];
+    /** @brief \c DAINT Bits of the registered Endpoints. */
+    uint32_t                    m_daintMask;
+
+    USB_OTG_GlobalTypeDef *
+    global(void) const {
+        return reinterpret_cast<USB_OTG_GlobalTypeDef *>(m_otgBase);
+    }
+
+    USB_OTG_DeviceTypeDef *
+    device(void) const {
+        return reinterpret_cast<USB_OTG_DeviceTypeDef *>(m_otgBase + USB_OTG_DEVICE_BASE);
+    }
+
+public:
+    constexpr EndpointDispatcherViaSTM32F4(const uintptr_t p_otgBase = USB_OTG_FS_PERIPH_BASE)
+      : m_otgBase(p_otgBase), m_inHandlers {}, m_outHandlers {}, m_daintMask(0) {
+
+    }
+
+    template<unsigned nEndpointNumber>
+    void
+    registerInEndpoint(UsbEndpointIrqHandler &p_handler) {
+        static_assert((nEndpointNumber > 0) && (nEndpointNumber < nNumEndpoints), "EP0 is driven by the Core");
+
+        m_inHandlers[nEndpointNumber] = &p_handler;
+        m_daintMask |= (1u << nEndpointNumber);
+    }
+
+    template<unsigned nEndpointNumber>
+    void
+    registerOutEndpoint(UsbRxFifoHandler &p_handler) {
+        static_assert((nEndpointNumber > 0) && (nEndpointNumber < nNumEndpoints), "EP0 is driven by the Core");
+
+        m_outHandlers[nEndpointNumber] = &p_handler;
+        m_daintMask |= (1u << (16 + nEndpointNumber));
+    }
+
+    /**
+     * @brief Service the RX FIFO Entries and Endpoint Events of the registered Endpoints.
+     *
+     * @return \c true if an Event of a registered Endpoint was handled.
+     */
+    bool
+    handleIrq(void) const {
+        bool handled = false;
+
+        while (global()->GINTSTS & USB_OTG_GINTSTS_RXFLVL) {
+            const uint32_t status = global()->GRXSTSR;
+            const uint32_t pktsts = (status & USB_OTG_GRXSTSP_PKTSTS) >> USB_OTG_GRXSTSP_PKTSTS_Pos;
+            const uint32_t epnum  = status & USB_OTG_GRXSTSP_EPNUM;
+            /* EPNUM covers 16 Endpoints; those beyond the Core's are left to the Core */
+            UsbRxFifoHandler * const handler = (epnum < nNumEndpoints) ? m_outHandlers[epnum] : nullptr;
+
+            if ((handler == nullptr) || ((pktsts != m_pktStsOutData) && (pktsts != m_pktStsOutDone))) {
+                break;
+            }
+
+            (void) global()->GRXSTSP;
+            if (pktsts == m_pktStsOutData) {
+                handler->handleRxData((status & USB_OTG_GRXSTSP_BCNT) >> USB_OTG_GRXSTSP_BCNT_Pos);
+            }
+            handled = true;
+        }
+
+        for (uint32_t pending = device()->DAINT & m_daintMask; pending != 0; pending &= (pending - 1)) {
+            const unsigned bit = __builtin_ctz(pending);
+
+            if (bit >= 16) {
+                m_outHandlers[bit - 16]->handleEndpointIrq();
+            } else {
+                m_inHandlers[bit]->handleEndpointIrq();
+            }
+            handled = true;
+        }
+
+        return handled;
+    }
+};
+
+    } /* namespace usb */
+} /* namespace stm32 */
+
+#endif /* _ENDPOINT_DISPATCHER_VIA_STM32F4_HPP_C81E4F06_ */
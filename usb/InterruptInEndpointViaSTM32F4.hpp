@@ -0,0 +1,177 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _INTERRUPT_IN_ENDPOINT_VIA_STM32F4_HPP_2E7C51B9_
+#define _INTERRUPT_IN_ENDPOINT_VIA_STM32F4_HPP_2E7C51B9_
+
+#include <stm32f4xx.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace stm32 {
+    namespace usb {
+
+/***************************************************************************//**
+ * @brief Interrupt IN Endpoint of the STM32F4 OTG Core for short, sporadic
+ *   Messages such as CDC Notifications.
+ *
+ * Like the Isochronous Endpoints, the Endpoint is not known to the Core's
+ * Endpoint Drivers. activate() sets up the Endpoint and its TX FIFO when the
+ * Host sets the Configuration, see ::usb::UsbEndpointConfigurationT. A Bus
+ * Reset clears the Address, after which the Endpoint stays inactive until the
+ * Device is configured again. As its Bit in \c DAINTMSK is never set, the
+ * Endpoint's Events do not reach the Core's Interrupt Handler.
+ *
+ * write() loads a single Packet into the TX FIFO. The Core then answers the
+ * Host's next Poll with it and NAKs all Polls in between. There is no
+ * Completion Interrupt; the Endpoint is ready for the next Packet as soon as
+ * the Core has cleared \c EPENA.
+ *
+ * handleSof(), write(), activate() and deactivate() must be called from the
+ * OTG Interrupt Handler, see ::stm32::usb::SofViaSTM32F4, or with the OTG
+ * Interrupt masked.
+ *
+ * @tparam nEndpointNumber IN Endpoint Number, e.g. \c 2 for \c 0x82.
+ * @tparam nPacketSz Max. Packet Size of the Endpoint, up to 64 Bytes.
+ ******************************************************************************/
+template<unsigned nEndpointNumber, size_t nPacketSz>
+class InterruptInEndpointViaSTM32F4 {
+    static_assert((nEndpointNumber > 0) && (nEndpointNumber < 4), "OTG_FS Core only supports IN Endpoints 1..3 for Interrupt Transfers");
+    static_assert((nPacketSz > 0) && (nPacketSz <= 64), "Full Speed Interrupt Endpoints support Max. Packet Sizes of up to 64 Bytes");
+
+    const uintptr_t     m_otgBase;
+    const unsigned      m_txFifoOffsetInWords;
+    const unsigned      m_txFifoSzInWords;
+    bool                m_active;
+
+    USB_OTG_GlobalTypeDef *
+    global(void) const {
+        return reinterpret_cast<USB_OTG_GlobalTypeDef *>(m_otgBase);
+    }
+
+    USB_OTG_DeviceTypeDef *
+    device(void) const {
+        return reinterpret_cast<USB_OTG_DeviceTypeDef *>(m_otgBase + USB_OTG_DEVICE_BASE);
+    }
+
+    USB_OTG_INEndpointTypeDef *
+    inEndpoint(void) const {
+        return reinterpret_cast<USB_OTG_INEndpointTypeDef *>(m_otgBase + USB_OTG_IN_ENDPOINT_BASE + nEndpointNumber * USB_OTG_EP_REG_SIZE);
+    }
+
+    volatile uint32_t *
+    txFifo(void) const {
+        return reinterpret_cast<volatile uint32_t *>(m_otgBase + USB_OTG_FIFO_BASE + nEndpointNumber * USB_OTG_FIFO_SIZE);
+    }
+
+    bool
+    isAddressed(void) const {
+        return (device()->DCFG & USB_OTG_DCFG_DAD) != 0;
+    }
+
+public:
+    /**
+     * @param p_txFifoOffsetInWords Start of the TX FIFO, see
+     *   ::stm32::usb::FifoPlanT::getTxFifoOffsetInWords().
+     * @param p_txFifoSzInWords Size of the TX FIFO, must hold one Packet.
+     * @param p_otgBase Base Address of the OTG Register Block.
+     */
+    constexpr InterruptInEndpointViaSTM32F4(const unsigned p_txFifoOffsetInWords, const unsigned p_txFifoSzInWords, const uintptr_t p_otgBase = USB_OTG_FS_PERIPH_BASE)
+      : m_otgBase(p_otgBase), m_txFifoOffsetInWords(p_txFifoOffsetInWords), m_txFifoSzInWords(p_txFifoSzInWords), m_active(false) {
+
+    }
+
+    /**
+     * @brief Set up the Endpoint and its TX FIFO.
+     *
+     * A Packet loaded before is stale now and discarded. The Data Toggle starts
+     * over with \c DATA0.
+     */
+    void
+    activate(void) {
+        deactivate();
+
+        global()->DIEPTXF[nEndpointNumber - 1] = (m_txFifoSzInWords << USB_OTG_DIEPTXF_INEPTXFD_Pos) | m_txFifoOffsetInWords;
+
+        inEndpoint()->DIEPCTL = USB_OTG_DIEPCTL_USBAEP
+                              | (0x3u << USB_OTG_DIEPCTL_EPTYP_Pos)     /* Interrupt */
+                              | (nEndpointNumber << USB_OTG_DIEPCTL_TXFNUM_Pos)
+                              | USB_OTG_DIEPCTL_SD0PID_SEVNFRM
+                              | USB_OTG_DIEPCTL_SNAK
+                              | nPacketSz;
+
+        m_active = true;
+    }
+
+    /**
+     * @brief Disable the Endpoint and flush its TX FIFO.
+     *
+     * The TX FIFO is only flushed once the Core has disabled the Endpoint.
+     */
+    void
+    deactivate(void) {
+        if (inEndpoint()->DIEPCTL & USB_OTG_DIEPCTL_EPENA) {
+            inEndpoint()->DIEPCTL |= USB_OTG_DIEPCTL_SNAK | USB_OTG_DIEPCTL_EPDIS;
+            while ((inEndpoint()->DIEPINT & USB_OTG_DIEPINT_EPDISD) == 0) ;
+        }
+        inEndpoint()->DIEPINT = USB_OTG_DIEPINT_EPDISD | USB_OTG_DIEPINT_XFRC;
+
+        global()->GRSTCTL = USB_OTG_GRSTCTL_TXFFLSH | (nEndpointNumber << USB_OTG_GRSTCTL_TXFNUM_Pos);
+        while (global()->GRSTCTL & USB_OTG_GRSTCTL_TXFFLSH) ;
+
+        inEndpoint()->DIEPCTL &= ~USB_OTG_DIEPCTL_USBAEP;
+
+        m_active = false;
+    }
+
+    /** @brief \c true if the Endpoint is set up and the last Packet has been taken by the Host. */
+    bool
+    isReady(void) const {
+        return m_active && ((inEndpoint()->DIEPCTL & USB_OTG_DIEPCTL_EPENA) == 0);
+    }
+
+    /**
+     * @brief Load a Packet of up to \p nPacketSz Bytes for the Host's next Poll.
+     *
+     * @return \c false if the Endpoint is not ready, see isReady().
+     */
+    bool
+    write(const void * const p_data, const size_t p_length) const {
+        if (!isReady() || (p_length > nPacketSz)) {
+            return false;
+        }
+
+        const uint8_t * const data = static_cast<const uint8_t *>(p_data);
+
+        inEndpoint()->DIEPINT   = USB_OTG_DIEPINT_XFRC;
+        inEndpoint()->DIEPTSIZ  = (1u << USB_OTG_DIEPTSIZ_PKTCNT_Pos) | p_length;
+        inEndpoint()->DIEPCTL   |= USB_OTG_DIEPCTL_EPENA | USB_OTG_DIEPCTL_CNAK;
+
+        for (size_t offs = 0; offs < p_length; offs += sizeof(uint32_t)) {
+            uint32_t word = 0;
+
+            ::memcpy(&word, &data[offs], ((p_length - offs) < sizeof(word)) ? (p_length - offs) : sizeof(word));
+            *txFifo() = word;
+        }
+
+        return true;
+    }
+
+    /** @brief Notice a Bus Reset, after which the Endpoint must be activated again. */
+    void
+    handleSof(void) {
+        if (!isAddressed()) {
+            m_active = false;
+        }
+    }
+};
+
+    } /* namespace usb */
+} /* namespace stm32 */
+
+#endif /* _INTERRUPT_IN_ENDPOINT_VIA_STM32F4_HPP_2E7C51B9_ */
@@ -0,0 +1,137 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _IRQ_PROFILER_VIA_STM32F4_HPP_3A8F62D1_
+#define _IRQ_PROFILER_VIA_STM32F4_HPP_3A8F62D1_
+
+#include <usb/UsbIrqProfile.hpp>
+
+#include <stm32f4xx.h>
+
+#include <cstdint>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace stm32 {
+    namespace usb {
+
+/***************************************************************************//**
+ * @brief Measures the Duration of each Interrupt Source of the STM32F4 OTG Core.
+ *
+ * Wraps the Core's \c handleIrq() Method. Each pending Source in \c GINTSTS is
+ * dispatched on its own: All other pending Sources are masked in \c GINTMSK,
+ * \c handleIrq() is called and the Cycles it takes are recorded for the Source.
+ * The other pending Sources are unmasked again afterwards.
+ *
+ * Sources that are not pending stay unmasked while the Handler runs, so every
+ * Change that the Handler makes to their Mask Bits is kept, e.g. masking or
+ * unmasking Interrupts after Enumeration. The one Case that is lost is the
+ * Handler masking a different Source that is pending at the same Time: Its Mask
+ * Bit is set again when it is unmasked after the Handler.
+ *
+ * Sources other than the ones listed in Source_e are dispatched together as
+ * e_Other. The Duration of the whole Interrupt, incl. the Profiling Overhead,
+ * is recorded as e_Total.
+ *
+ * The Base Address of the OTG Register Block is a Constructor Parameter so that
+ * the Class can be pointed at a Register Model in the Host Build.
+ *
+ * @tparam CycleCounterT Cycle Counter, e.g. ::stm32::DwtCycleCounter or
+ *   ::stm32::MockCycleCounter.
+ ******************************************************************************/
+template<typename CycleCounterT>
+class IrqProfilerViaSTM32F4 {
+public:
+    typedef enum Source_e : uint8_t {
+        e_RxFlvl    = 0,
+        e_IepInt    = 1,
+        e_OepInt    = 2,
+        e_UsbRst    = 3,
+        e_EnumDne   = 4,
+        e_Sof       = 5,
+        e_Other     = 6,
+        e_Total     = 7,
+        e_NumSources
+    } Source_t;
+
+    typedef ::usb::UsbIrqProfileT<e_NumSources> Profile_t;
+
+private:
+    struct SourceMap_s {
+        uint32_t    m_gintsts;
+        Source_t    m_source;
+    };
+
+    static constexpr SourceMap_s m_sources[] = {
+        { USB_OTG_GINTSTS_RXFLVL,   e_RxFlvl    },
+        { USB_OTG_GINTSTS_IEPINT,   e_IepInt    },
+        { USB_OTG_GINTSTS_OEPINT,   e_OepInt    },
+        { USB_OTG_GINTSTS_USBRST,   e_UsbRst    },
+        { USB_OTG_GINTSTS_ENUMDNE,  e_EnumDne   },
+        { USB_OTG_GINTSTS_SOF,      e_Sof       },
+    };
+
+    const uintptr_t m_otgBase;
+    Profile_t       m_profile;
+
+    USB_OTG_GlobalTypeDef *
+    global(void) const {
+        return reinterpret_cast<USB_OTG_GlobalTypeDef *>(m_otgBase);
+    }
+
+    template<typename CoreT>
+    void
+    dispatch(CoreT &p_core, const uint32_t p_gintsts, const Source_t p_source) {
+        const uint32_t mask     = global()->GINTMSK;
+        const uint32_t hidden   = global()->GINTSTS & mask & ~p_gintsts;
+
+        global()->GINTMSK = mask & ~hidden;
+
+        const uint32_t start = CycleCounterT::read();
+        p_core.handleIrq();
+        const uint32_t cycles = CycleCounterT::read() - start;
+
+        /* Hidden Bits were all set before; all other Bits are as the Handler left them */
+        global()->GINTMSK = global()->GINTMSK | hidden;
+
+        m_profile.record(p_source, cycles);
+    }
+
+public:
+    constexpr IrqProfilerViaSTM32F4(const uintptr_t p_otgBase = USB_OTG_FS_PERIPH_BASE)
+      : m_otgBase(p_otgBase), m_profile() {
+
+    }
+
+    template<typename CoreT>
+    void
+    handleIrq(CoreT &p_core) {
+        const uint32_t start = CycleCounterT::read();
+
+        uint32_t pending = global()->GINTSTS & global()->GINTMSK;
+
+        for (const auto &entry : m_sources) {
+            if (pending & entry.m_gintsts) {
+                dispatch(p_core, entry.m_gintsts, entry.m_source);
+                pending &= ~entry.m_gintsts;
+            }
+        }
+
+        if (pending) {
+            dispatch(p_core, pending, e_Other);
+        }
+
+        m_profile.record(e_Total, CycleCounterT::read() - start);
+    }
+
+    Profile_t &
+    getProfile(void) {
+        return m_profile;
+    }
+};
+
+    } /* namespace usb */
+} /* namespace stm32 */
+
+#endif /* _IRQ_PROFILER_VIA_STM32F4_HPP_3A8F62D1_ */
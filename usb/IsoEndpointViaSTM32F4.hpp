@@ -0,0 +1,473 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _ISO_ENDPOINT_VIA_STM32F4_HPP_C81F3A6E_
+#define _ISO_ENDPOINT_VIA_STM32F4_HPP_C81F3A6E_
+
+#include <usb/UsbIsoApplication.hpp>
+
+#include <stm32f4xx.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace stm32 {
+    namespace usb {
+
+/***************************************************************************//**
+ * @brief Counters of an Isochronous Endpoint.
+ ******************************************************************************/
+typedef struct IsoStatistics_s {
+    uint32_t    m_numFrames;        /**< Frames in which the Endpoint was armed. */
+    uint32_t    m_numIncomplete;    /**< Incomplete Isochronous Transfers reported by the Core. */
+    uint32_t    m_numUnderruns;     /**< IN: No new Data at SOF, a Zero-Length Packet was sent instead. */
+    uint32_t    m_numOverruns;      /**< OUT: Packets dropped because they exceeded the Buffer. */
+} IsoStatistics_t;
+
+/***************************************************************************//**
+ * @brief Common Part of the Isochronous Endpoints of the STM32F4 OTG Core.
+ *
+ * Isochronous Endpoints are not known to the Core's Endpoint Drivers. They
+ * live in Alternate Setting 1 of their Interface, so activate() and
+ * deactivate() are called when the Host selects an Alternate Setting via
+ * \c SET_INTERFACE, see ::usb::UsbAlternateSettingDeviceT. A Bus Reset clears
+ * the Address, after which the Endpoint stays inactive until it is selected
+ * again. As its Bit in \c DAINTMSK is never set, the Endpoint's Events do not
+ * reach the Core's Interrupt Handler.
+ *
+ * The Endpoint is armed for the current Frame in the SOF Handler, with the
+ * Even / Odd Frame Bit taken from \c DSTS.FNSOF.
+ ******************************************************************************/
+class IsoEndpointBaseViaSTM32F4 {
+protected:
+    const uintptr_t     m_otgBase;
+    bool                m_active;
+    IsoStatistics_t     m_statistics;
+
+    constexpr IsoEndpointBaseViaSTM32F4(const uintptr_t p_otgBase)
+      : m_otgBase(p_otgBase), m_active(false), m_statistics {} {
+
+    }
+
+    USB_OTG_GlobalTypeDef *
+    global(void) const {
+        return reinterpret_cast<USB_OTG_GlobalTypeDef *>(m_otgBase);
+    }
+
+    USB_OTG_DeviceTypeDef *
+    device(void) const {
+        return reinterpret_cast<USB_OTG_DeviceTypeDef *>(m_otgBase + USB_OTG_DEVICE_BASE);
+    }
+
+    bool
+    isAddressed(void) const {
+        return (device()->DCFG & USB_OTG_DCFG_DAD) != 0;
+    }
+
+    /** @brief \c SD0PID_SEVNFRM or \c SODDFRM, matching the Frame that has just started. */
+    uint32_t
+    currentFrameParity(void) const {
+        return (device()->DSTS & (1u << USB_OTG_DSTS_FNSOF_Pos)) ? USB_OTG_DIEPCTL_SODDFRM : USB_OTG_DIEPCTL_SD0PID_SEVNFRM;
+    }
+
+public:
+    const IsoStatistics_t &
+    getStatistics(void) const {
+        return m_statistics;
+    }
+
+    void
+    resetStatistics(void) {
+        m_statistics = {};
+    }
+};
+
+/***************************************************************************//**
+ * @brief Isochronous IN Endpoint with SOF-synchronized Double Buffering.
+ *
+ * The Application fills the Back Buffer via write() at any Time during a Frame.
+ * On the next SOF, handleSof() swaps the Buffers and loads the Packet into the
+ * TX FIFO for the Frame that has just started, so Data is sent with a fixed
+ * Latency of one Frame. If the Application did not provide new Data, a
+ * Zero-Length Packet is sent and an Underrun is counted. A Packet the Host did
+ * not take stays armed and is moved to the next Frame, like on the OUT Side,
+ * so the Endpoint is never disabled and the TX FIFO is never flushed from the
+ * Interrupt Handler. The Data written meanwhile goes out one Frame later.
+ *
+ * handleIrq() and handleSof() must be called from the OTG Interrupt Handler
+ * before the Core's own \c handleIrq(), see ::stm32::usb::SofViaSTM32F4.
+ * write() must be called from the same Interrupt Context or with the OTG
+ * Interrupt masked. The TX FIFO is set up upon Activation and must hold one
+ * Packet.
+ *
+ * Only a single Isochronous IN Endpoint is supported, as the Incomplete IN
+ * Interrupt is not specific to an Endpoint.
+ *
+ * @tparam nEndpointNumber IN Endpoint Number, e.g. \c 3 for \c 0x83.
+ * @tparam nPacketSz Max. Packet Size of the Endpoint, up to 1023 Bytes.
+ ******************************************************************************/
+template<unsigned nEndpointNumber, size_t nPacketSz>
+class IsoInEndpointViaSTM32F4 : public IsoEndpointBaseViaSTM32F4 {
+    static_assert((nEndpointNumber > 0) && (nEndpointNumber < 4), "OTG_FS Core only supports IN Endpoints 1..3 for Isochronous Transfers");
+    static_assert((nPacketSz > 0) && (nPacketSz <= 1023), "Full Speed Isochronous Endpoints support Max. Packet Sizes of up to 1023 Bytes");
+
+    static constexpr size_t m_bufferSz = (nPacketSz + 3) & ~static_cast<size_t>(3);
+
+    const unsigned      m_txFifoOffsetInWords;
+    const unsigned      m_txFifoSzInWords;
+
+    alignas(4) uint8_t  m_buffer[2][m_bufferSz];
+    size_t              m_length[2];
+    unsigned            m_back;
+    bool                m_ready;
+
+    USB_OTG_INEndpointTypeDef *
+    inEndpoint(void) const {
+        return reinterpret_cast<USB_OTG_INEndpointTypeDef *>(m_otgBase + USB_OTG_IN_ENDPOINT_BASE + nEndpointNumber * USB_OTG_EP_REG_SIZE);
+    }
+
+    volatile uint32_t *
+    txFifo(void) const {
+        return reinterpret_cast<volatile uint32_t *>(m_otgBase + USB_OTG_FIFO_BASE + nEndpointNumber * USB_OTG_FIFO_SIZE);
+    }
+
+    void
+    send(const unsigned p_buffer) const {
+        const size_t length = m_length[p_buffer];
+        const uint32_t * const data = reinterpret_cast<const uint32_t *>(m_buffer[p_buffer]);
+
+        inEndpoint()->DIEPTSIZ  = (1u << USB_OTG_DIEPTSIZ_MULCNT_Pos) | (1u << USB_OTG_DIEPTSIZ_PKTCNT_Pos) | length;
+        inEndpoint()->DIEPCTL   |= USB_OTG_DIEPCTL_EPENA | USB_OTG_DIEPCTL_CNAK | currentFrameParity();
+
+        for (size_t idx = 0; idx < ((length + 3) / 4); idx++) {
+            *txFifo() = data[idx];
+        }
+    }
+
+public:
+    /**
+     * @param p_txFifoOffsetInWords Start of the TX FIFO, see
+     *   ::stm32::usb::FifoPlanT::getTxFifoOffsetInWords().
+     * @param p_txFifoSzInWords Size of the TX FIFO.
+     * @param p_otgBase Base Address of the OTG Register Block.
+     */
+    constexpr IsoInEndpointViaSTM32F4(const unsigned p_txFifoOffsetInWords, const unsigned p_txFifoSzInWords, const uintptr_t p_otgBase = USB_OTG_FS_PERIPH_BASE)
+      : IsoEndpointBaseViaSTM32F4(p_otgBase), m_txFifoOffsetInWords(p_txFifoOffsetInWords), m_txFifoSzInWords(p_txFifoSzInWords), m_buffer {}, m_length { 0, 0 }, m_back(0), m_ready(false) {
+
+    }
+
+    /**
+     * @brief Set up the Endpoint and its TX FIFO.
+     *
+     * A Packet that is still armed from before is discarded. The Endpoint sends
+     * its first Packet in the Frame after the next SOF.
+     */
+    void
+    activate(void) {
+        deactivate();
+
+        global()->DIEPTXF[nEndpointNumber - 1] = (m_txFifoSzInWords << USB_OTG_DIEPTXF_INEPTXFD_Pos) | m_txFifoOffsetInWords;
+
+        inEndpoint()->DIEPCTL = USB_OTG_DIEPCTL_USBAEP
+                              | (0x1u << USB_OTG_DIEPCTL_EPTYP_Pos)     /* Isochronous */
+                              | (nEndpointNumber << USB_OTG_DIEPCTL_TXFNUM_Pos)
+                              | USB_OTG_DIEPCTL_SNAK
+                              | nPacketSz;
+        global()->GINTMSK |= USB_OTG_GINTMSK_IISOIXFRM;
+
+        m_back      = 0;
+        m_ready     = false;
+        m_active    = true;
+    }
+
+    /**
+     * @brief Disable the Endpoint and flush its TX FIFO.
+     *
+     * The TX FIFO is only flushed once the Core has disabled the Endpoint.
+     */
+    void
+    deactivate(void) {
+        if (inEndpoint()->DIEPCTL & USB_OTG_DIEPCTL_EPENA) {
+            inEndpoint()->DIEPCTL |= USB_OTG_DIEPCTL_SNAK | USB_OTG_DIEPCTL_EPDIS;
+            while ((inEndpoint()->DIEPINT & USB_OTG_DIEPINT_EPDISD) == 0) ;
+        }
+        inEndpoint()->DIEPINT = USB_OTG_DIEPINT_EPDISD | USB_OTG_DIEPINT_XFRC;
+
+        global()->GRSTCTL = USB_OTG_GRSTCTL_TXFFLSH | (nEndpointNumber << USB_OTG_GRSTCTL_TXFNUM_Pos);
+        while (global()->GRSTCTL & USB_OTG_GRSTCTL_TXFFLSH) ;
+
+        inEndpoint()->DIEPCTL   &= ~USB_OTG_DIEPCTL_USBAEP;
+        global()->GINTMSK       &= ~USB_OTG_GINTMSK_IISOIXFRM;
+
+        m_active = false;
+    }
+
+    /**
+     * @brief Provide the Packet for the next Frame.
+     *
+     * Replaces Data that was written earlier in the same Frame.
+     */
+    void
+    write(const void * const p_data, const size_t p_length) {
+        const size_t length = (p_length < nPacketSz) ? p_length : nPacketSz;
+
+        ::memcpy(m_buffer[m_back], p_data, length);
+        m_length[m_back]    = length;
+        m_ready             = true;
+    }
+
+    void
+    handleSof(void) {
+        if (!isAddressed()) {
+            m_active = false;
+        }
+
+        if (!m_active) {
+            return;
+        }
+
+        m_statistics.m_numFrames++;
+
+        /*
+         * Not taken by the Host in the last Frame, counted via handleIrq(). The
+         * Packet is still in the TX FIFO, so it is moved on to the current Frame
+         * and new Data waits for the next SOF.
+         */
+        if (inEndpoint()->DIEPCTL & USB_OTG_DIEPCTL_EPENA) {
+            inEndpoint()->DIEPCTL |= currentFrameParity();
+            return;
+        }
+        inEndpoint()->DIEPINT = USB_OTG_DIEPINT_XFRC;
+
+        const unsigned front = m_back;
+        if (m_ready) {
+            m_back  ^= 1;
+            m_ready = false;
+        } else {
+            m_length[front] = 0;
+            m_statistics.m_numUnderruns++;
+        }
+
+        send(front);
+    }
+
+    /** @brief Count Incomplete Isochronous IN Transfers. */
+    bool
+    handleIrq(void) {
+        if ((global()->GINTSTS & global()->GINTMSK & USB_OTG_GINTSTS_IISOIXFR) == 0) {
+            return false;
+        }
+
+        global()->GINTSTS = USB_OTG_GINTSTS_IISOIXFR;
+        m_statistics.m_numIncomplete++;
+        return true;
+    }
+};
+
+/***************************************************************************//**
+ * @brief Isochronous OUT Endpoint with SOF-synchronized Double Buffering.
+ *
+ * The RX FIFO is drained into the Front Buffer while the Frame is running. On
+ * the next SOF, handleSof() hands the Packet to the Application via
+ * ::usb::UsbIsoOutApplication::isoFrameReceived() and re-arms the Endpoint
+ * with the other Buffer. The Packet stays valid until the following SOF.
+ *
+ * handleIrq() and handleSof() must be called from the OTG Interrupt Handler
+ * before the Core's own \c handleIrq(), see ::stm32::usb::SofViaSTM32F4.
+ * handleIrq() takes the RX FIFO Entries of its Endpoint from the Head of the
+ * RX FIFO, so this relies on the Core popping one Entry per \c RXFLVL
+ * Interrupt.
+ *
+ * A Frame in which the Host did not send Data is reported by the Core as an
+ * Incomplete Isochronous OUT Transfer. The Endpoint then stays armed and is
+ * moved to the next Frame.
+ *
+ * @tparam nEndpointNumber OUT Endpoint Number, e.g. \c 3 for \c 0x03.
+ * @tparam nPacketSz Max. Packet Size of the Endpoint, up to 1023 Bytes.
+ ******************************************************************************/
+template<unsigned nEndpointNumber, size_t nPacketSz>
+class IsoOutEndpointViaSTM32F4 : public IsoEndpointBaseViaSTM32F4 {
+    static_assert((nEndpointNumber > 0) && (nEndpointNumber < 4), "OTG_FS Core only supports OUT Endpoints 1..3 for Isochronous Transfers");
+    static_assert((nPacketSz > 0) && (nPacketSz <= 1023), "Full Speed Isochronous Endpoints support Max. Packet Sizes of up to 1023 Bytes");
+
+    static constexpr uint32_t   m_pktStsOutData = 2;
+    static constexpr uint32_t   m_pktStsOutDone = 3;
+    static constexpr size_t     m_bufferSz      = (nPacketSz + 3) & ~static_cast<size_t>(3);
+
+    ::usb::UsbIsoOutApplication *   m_application;
+
+    alignas(4) uint8_t  m_buffer[2][m_bufferSz];
+    size_t              m_length;
+    unsigned            m_fill;
+    bool                m_complete;
+
+    USB_OTG_OUTEndpointTypeDef *
+    outEndpoint(void) const {
+        return reinterpret_cast<USB_OTG_OUTEndpointTypeDef *>(m_otgBase + USB_OTG_OUT_ENDPOINT_BASE + nEndpointNumber * USB_OTG_EP_REG_SIZE);
+    }
+
+    volatile uint32_t *
+    rxFifo(void) const {
+        return reinterpret_cast<volatile uint32_t *>(m_otgBase + USB_OTG_FIFO_BASE);
+    }
+
+    void
+    arm(void) const {
+        outEndpoint()->DOEPTSIZ = (1u << USB_OTG_DOEPTSIZ_PKTCNT_Pos) | nPacketSz;
+        outEndpoint()->DOEPCTL  |= USB_OTG_DOEPCTL_EPENA | USB_OTG_DOEPCTL_CNAK | currentFrameParity();
+    }
+
+    void
+    drain(const size_t p_length) {
+        const size_t numWords = (p_length + 3) / 4;
+
+        if ((m_length + p_length) > nPacketSz) {
+            for (size_t idx = 0; idx < numWords; idx++) {
+                (void) *rxFifo();
+            }
+            m_statistics.m_numOverruns++;
+            return;
+        }
+
+        /* Buffers are padded to a multiple of four Bytes, so the last Word fits */
+        uint32_t * const dst = reinterpret_cast<uint32_t *>(&m_buffer[m_fill][m_length]);
+        for (size_t idx = 0; idx < numWords; idx++) {
+            dst[idx] = *rxFifo();
+        }
+
+        m_length += p_length;
+    }
+
+public:
+    constexpr IsoOutEndpointViaSTM32F4(const uintptr_t p_otgBase = USB_OTG_FS_PERIPH_BASE)
+      : IsoEndpointBaseViaSTM32F4(p_otgBase), m_application(nullptr), m_buffer {}, m_length(0), m_fill(0), m_complete(false) {
+
+    }
+
+    void
+    registerApplication(::usb::UsbIsoOutApplication &p_application) {
+        m_application = &p_application;
+    }
+
+    void
+    unregisterApplication(void) {
+        m_application = nullptr;
+    }
+
+    /**
+     * @brief Set up the Endpoint. It is armed on the next SOF.
+     *
+     * A Packet that was received, but not yet handed to the Application, is
+     * discarded.
+     */
+    void
+    activate(void) {
+        outEndpoint()->DOEPCTL = USB_OTG_DOEPCTL_USBAEP
+                               | (0x1u << USB_OTG_DOEPCTL_EPTYP_Pos)    /* Isochronous */
+                               | USB_OTG_DOEPCTL_CNAK
+                               | nPacketSz;
+        global()->GINTMSK |= USB_OTG_GINTMSK_PXFRM_IISOOXFRM;
+
+        m_length    = 0;
+        m_fill      = 0;
+        m_complete  = false;
+        m_active    = true;
+    }
+
+    /**
+     * @brief Stop receiving on the Endpoint.
+     *
+     * An OUT Endpoint can only be disabled under a global OUT NAK, which would
+     * hold up the RX FIFO the Control Endpoint is served from. Instead, the
+     * Endpoint is NAK'ed, so the Core drops the Host's Packets, and marked as
+     * inactive. An Arming left over is re-used by activate().
+     */
+    void
+    deactivate(void) {
+        outEndpoint()->DOEPCTL  |= USB_OTG_DOEPCTL_SNAK;
+        outEndpoint()->DOEPCTL  &= ~USB_OTG_DOEPCTL_USBAEP;
+        global()->GINTMSK       &= ~USB_OTG_GINTMSK_PXFRM_IISOOXFRM;
+
+        m_length    = 0;
+        m_complete  = false;
+        m_active    = false;
+    }
+
+    void
+    handleSof(void) {
+        if (!isAddressed()) {
+            m_active = false;
+        }
+
+        if (!m_active) {
+            return;
+        }
+
+        if (m_complete) {
+            const unsigned  received    = m_fill;
+            const size_t    length      = m_length;
+
+            m_fill      ^= 1;
+            m_length    = 0;
+            m_complete  = false;
+
+            if (m_application != nullptr) {
+                m_application->isoFrameReceived(m_buffer[received], length);
+            }
+        }
+
+        if (outEndpoint()->DOEPCTL & USB_OTG_DOEPCTL_EPENA) {
+            /* Nothing received in the last Frame, move on to the current one */
+            outEndpoint()->DOEPCTL |= currentFrameParity();
+        } else {
+            arm();
+        }
+
+        m_statistics.m_numFrames++;
+    }
+
+    /** @brief Drain the RX FIFO Entries of the Endpoint and count Incomplete Isochronous OUT Transfers. */
+    bool
+    handleIrq(void) {
+        bool handled = false;
+
+        while (global()->GINTSTS & USB_OTG_GINTSTS_RXFLVL) {
+            const uint32_t status = global()->GRXSTSR;
+            const uint32_t pktsts = (status & USB_OTG_GRXSTSP_PKTSTS) >> USB_OTG_GRXSTSP_PKTSTS_Pos;
+
+            if (((status & USB_OTG_GRXSTSP_EPNUM) != nEndpointNumber)
+              || ((pktsts != m_pktStsOutData) && (pktsts != m_pktStsOutDone))) {
+                break;
+            }
+
+            (void) global()->GRXSTSP;
+            if (pktsts == m_pktStsOutData) {
+                drain((status & USB_OTG_GRXSTSP_BCNT) >> USB_OTG_GRXSTSP_BCNT_Pos);
+            }
+            handled = true;
+        }
+
+        if (outEndpoint()->DOEPINT & USB_OTG_DOEPINT_XFRC) {
+            outEndpoint()->DOEPINT = USB_OTG_DOEPINT_XFRC;
+            m_complete = true;
+            handled = true;
+        }
+
+        if (global()->GINTSTS & global()->GINTMSK & USB_OTG_GINTSTS_PXFR_INCOMPISOOUT) {
+            global()->GINTSTS = USB_OTG_GINTSTS_PXFR_INCOMPISOOUT;
+            m_statistics.m_numIncomplete++;
+            handled = true;
+        }
+
+        return handled;
+    }
+};
+
+    } /* namespace usb */
+} /* namespace stm32 */
+
+#endif /* _ISO_ENDPOINT_VIA_STM32F4_HPP_C81F3A6E_ */
@@ -0,0 +1,234 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _OTG_FS_FIFO_PLANNER_HPP_4B9D13E7_
+#define _OTG_FS_FIFO_PLANNER_HPP_4B9D13E7_
+
+#include <usb/UsbDescriptorBuilder.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace stm32 {
+    namespace usb {
+
+/***************************************************************************//**
+ * @brief Number of Packets each IN Endpoint's TX FIFO shall hold.
+ *
+ * With more than one Packet in the FIFO, the Core can send the next Packet
+ * right after the previous one has been ACK'ed, i.e. without waiting for the
+ * Software to refill the FIFO.
+ ******************************************************************************/
+enum class FifoDepth_e : unsigned {
+    e_Single    = 1,
+    e_Double    = 2,
+    e_Triple    = 3
+};
+
+/***************************************************************************//**
+ * @brief Layout of the shared FIFO RAM of the STM32F4 OTG Core.
+ *
+ * Created at Compile Time by ::stm32::usb::planFifos(). All Sizes are in 32-Bit
+ * Words. A TX FIFO Size of zero means that the IN Endpoint is not used.
+ *
+ * @tparam nNumEndpoints Number of IN Endpoints of the Core, incl. EP0.
+ ******************************************************************************/
+template<unsigned nNumEndpoints>
+struct FifoPlanT {
+    /** @brief Min. / Max. Depth of a single FIFO, see RM0090, \c GRXFSIZ and \c DIEPTXFx. */
+    static constexpr unsigned m_minFifoSzInWords = 16;
+    static constexpr unsigned m_maxFifoSzInWords = 256;
+
+    unsigned    m_fifoRamSzInWords;
+    unsigned    m_rxFifoSzInWords;
+    unsigned    m_txFifoSzInWords[nNumEndpoints];
+
+    constexpr unsigned
+    getRxFifoSzInWords(void) const {
+        return m_rxFifoSzInWords;
+    }
+
+    constexpr unsigned
+    getTxFifoSzInWords(const unsigned p_endpoint) const {
+        return m_txFifoSzInWords[p_endpoint];
+    }
+
+    /**
+     * @brief Start of an IN Endpoint's TX FIFO in the FIFO RAM.
+     *
+     * The RX FIFO comes first, followed by the TX FIFOs in the Order of their
+     * Endpoint Numbers. This matches the Core, which places the FIFOs of the
+     * Endpoints it drives (EP0 and the Bulk IN Endpoint) one after the other.
+     * Endpoint Drivers that set up their own TX FIFO, e.g.
+     * ::stm32::usb::IsoInEndpointViaSTM32F4, use this to find their Place.
+     */
+    constexpr unsigned
+    getTxFifoOffsetInWords(const unsigned p_endpoint) const {
+        unsigned offset = m_rxFifoSzInWords;
+
+        for (unsigned ep = 0; ep < p_endpoint; ep++) {
+            offset += m_txFifoSzInWords[ep];
+        }
+
+        return offset;
+    }
+
+    constexpr unsigned
+    getTotalSzInWords(void) const {
+        unsigned total = m_rxFifoSzInWords;
+
+        for (unsigned ep = 0; ep < nNumEndpoints; ep++) {
+            total += m_txFifoSzInWords[ep];
+        }
+
+        return total;
+    }
+
+    constexpr bool
+    isValid(void) const {
+        if ((m_rxFifoSzInWords < m_minFifoSzInWords) || (m_rxFifoSzInWords > m_maxFifoSzInWords)) {
+            return false;
+        }
+
+        for (unsigned ep = 0; ep < nNumEndpoints; ep++) {
+            if ((m_txFifoSzInWords[ep] != 0) && ((m_txFifoSzInWords[ep] < m_minFifoSzInWords) || (m_txFifoSzInWords[ep] > m_maxFifoSzInWords))) {
+                return false;
+            }
+        }
+
+        return getTotalSzInWords() <= m_fifoRamSzInWords;
+    }
+};
+
+/***************************************************************************//**
+ * @brief Compile-time Planner for the shared FIFO RAM of the STM32F4 OTG Core.
+ *
+ * First, each FIFO gets its minimum Size:
+ * - The Control IN FIFO holds one Packet of EP0.
+ * - Each Interrupt IN FIFO holds one Packet.
+ * - Each Bulk / Isochronous IN FIFO holds \p p_depth Packets.
+ * - The RX FIFO is sized according to the Formula in RM0090, Section "FIFO RAM
+ *   allocation": Room for the SETUP Packets, one max. sized Packet plus its
+ *   Status Word, two Words per OUT Endpoint and one Word for Global OUT NAK.
+ *
+ * The remaining RAM is then handed out one Packet at a Time, alternating
+ * between the RX FIFO and the Bulk / Isochronous IN FIFOs, so that both
+ * Directions can buffer more Packets while the Software is busy. Words that
+ * are left over in the End go to the RX FIFO.
+ *
+ * The Result must be checked via FifoPlanT::isValid() in a \c static_assert,
+ * so a Layout that does not fit fails the Build.
+ *
+ * Example:
+ * \code
+ * static constexpr auto plan = ::stm32::usb::planFifos<4>(::stm32::usb::FifoDepth_e::e_Double, 64, bulkOutEp, bulkInEp);
+ * static_assert(plan.isValid(), "FIFO Layout does not fit");
+ * \endcode
+ *
+ * @tparam nNumEndpoints Number of IN Endpoints of the Core, incl. EP0.
+ * @tparam nFifoRamSzInWords Size of the FIFO RAM, 320 Words (1.25 KB) on OTG_FS.
+ ******************************************************************************/
+template<unsigned nNumEndpoints = 4, unsigned nFifoRamSzInWords = 320, typename... EndpointsT>
+constexpr FifoPlanT<nNumEndpoints>
+planFifos(const FifoDepth_e p_depth, const uint16_t p_ctrlMaxPacketSz, const EndpointsT &... p_endpoints) {
+    typedef FifoPlanT<nNumEndpoints> Plan_t;
+
+    constexpr unsigned numEndpoints = sizeof...(EndpointsT);
+    const ::usb::descriptor::Endpoint_t endpoints[numEndpoints + 1] = { p_endpoints..., {} };
+
+    const auto inWords = [](const unsigned p_packetSz) {
+        return (p_packetSz + 3) / 4;
+    };
+    const auto atLeast = [](const unsigned p_value, const unsigned p_min) {
+        return (p_value < p_min) ? p_min : p_value;
+    };
+
+    Plan_t plan {};
+    plan.m_fifoRamSzInWords = nFifoRamSzInWords;
+
+    /* Minimum Sizes */
+    unsigned maxOutPacketSz = p_ctrlMaxPacketSz;
+    unsigned numOutEndpoints = 1;   /* EP0 OUT */
+    bool isStreaming[nNumEndpoints] {};
+
+    plan.m_txFifoSzInWords[0] = atLeast(inWords(p_ctrlMaxPacketSz), Plan_t::m_minFifoSzInWords);
+
+    for (unsigned idx = 0; idx < numEndpoints; idx++) {
+        const ::usb::descriptor::Endpoint_t &ep = endpoints[idx];
+
+        if ((ep.getNumber() == 0) || (ep.getNumber() >= nNumEndpoints)) {
+            /* Not available on this Core, make the Plan invalid */
+            plan.m_rxFifoSzInWords = 0;
+            return plan;
+        }
+
+        if (ep.isIn()) {
+            const bool streaming = (ep.m_bmAttributes == ::usb::descriptor::Endpoint_t::e_Bulk)
+                                || (ep.m_bmAttributes == ::usb::descriptor::Endpoint_t::e_Isochronous);
+            const unsigned packets = streaming ? static_cast<unsigned>(p_depth) : 1;
+
+            isStreaming[ep.getNumber()] = streaming;
+            plan.m_txFifoSzInWords[ep.getNumber()] = atLeast(packets * inWords(ep.m_wMaxPacketSize), Plan_t::m_minFifoSzInWords);
+        } else {
+            numOutEndpoints++;
+            if (ep.m_wMaxPacketSize > maxOutPacketSz) {
+                maxOutPacketSz = ep.m_wMaxPacketSize;
+            }
+        }
+    }
+
+    plan.m_rxFifoSzInWords = atLeast((5 * 1 + 8)    /* One Control Endpoint */
+                                   + (inWords(maxOutPacketSz) + 1)
+                                   + (2 * numOutEndpoints)
+                                   + 1,
+                                   Plan_t::m_minFifoSzInWords);
+
+    if (plan.getTotalSzInWords() > nFifoRamSzInWords) {
+        return plan;
+    }
+
+    /* Hand out the remaining RAM one Packet at a Time */
+    unsigned remaining = nFifoRamSzInWords - plan.getTotalSzInWords();
+    bool granted = true;
+
+    while (granted) {
+        granted = false;
+
+        const unsigned rxPacket = inWords(maxOutPacketSz) + 1;
+        if ((rxPacket <= remaining) && ((plan.m_rxFifoSzInWords + rxPacket) <= Plan_t::m_maxFifoSzInWords)) {
+            plan.m_rxFifoSzInWords += rxPacket;
+            remaining -= rxPacket;
+            granted = true;
+        }
+
+        for (unsigned idx = 0; idx < numEndpoints; idx++) {
+            const ::usb::descriptor::Endpoint_t &ep = endpoints[idx];
+            const unsigned txPacket = inWords(ep.m_wMaxPacketSize);
+
+            if (!ep.isIn() || !isStreaming[ep.getNumber()]) {
+                continue;
+            }
+
+            if ((txPacket <= remaining) && ((plan.m_txFifoSzInWords[ep.getNumber()] + txPacket) <= Plan_t::m_maxFifoSzInWords)) {
+                plan.m_txFifoSzInWords[ep.getNumber()] += txPacket;
+                remaining -= txPacket;
+                granted = true;
+            }
+        }
+    }
+
+    plan.m_rxFifoSzInWords += remaining;
+    if (plan.m_rxFifoSzInWords > Plan_t::m_maxFifoSzInWords) {
+        plan.m_rxFifoSzInWords = Plan_t::m_maxFifoSzInWords;
+    }
+
+    return plan;
+}
+
+    } /* namespace usb */
+} /* namespace stm32 */
+
+#endif /* _OTG_FS_FIFO_PLANNER_HPP_4B9D13E7_ */
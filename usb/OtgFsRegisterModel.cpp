@@ -0,0 +1,825 @@
+/*-
+ * $Copyright$
+-*/
+#if defined(HOSTBUILD)
+
+#include <usb/OtgFsRegisterModel.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <time.h>
+#include <ucontext.h>
+#include <x86intrin.h>
+
+#if !defined(__x86_64__) || !defined(__linux__)
+#error The OTG_FS Register Model requires Linux on x86-64.
+#endif
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace stm32 {
+    namespace usb {
+
+/*******************************************************************************
+ * Register Offsets and Bits, see RM0090, Chapter 34.
+ ******************************************************************************/
+namespace {
+
+enum Offset_e : size_t {
+    e_GOTGCTL       = 0x000,
+    e_GAHBCFG       = 0x008,
+    e_GRSTCTL       = 0x010,
+    e_GINTSTS       = 0x014,
+    e_GINTMSK       = 0x018,
+    e_GRXSTSR       = 0x01C,
+    e_GRXSTSP       = 0x020,
+    e_DIEPTXF0      = 0x028,
+    e_CID           = 0x03C,
+    e_DIEPTXF1      = 0x104,
+    e_DCFG          = 0x800,
+    e_DCTL          = 0x804,
+    e_DSTS          = 0x808,
+    e_DIEPMSK       = 0x810,
+    e_DOEPMSK       = 0x814,
+    e_DAINT         = 0x818,
+    e_DAINTMSK      = 0x81C,
+    e_DIEPEMPMSK    = 0x834,
+    e_DIEPCTL0      = 0x900,
+    e_DOEPCTL0      = 0xB00,
+    e_PCGCCTL       = 0xE00,
+    e_FIFO0         = 0x1000
+};
+
+constexpr size_t m_epRegSz      = 0x20;
+constexpr size_t m_fifoWindowSz = 0x1000;
+
+constexpr size_t e_DIEPCTL(const unsigned p_ep)  { return e_DIEPCTL0 + p_ep * m_epRegSz + 0x00; }
+constexpr size_t e_DIEPINT(const unsigned p_ep)  { return e_DIEPCTL0 + p_ep * m_epRegSz + 0x08; }
+constexpr size_t e_DIEPTSIZ(const unsigned p_ep) { return e_DIEPCTL0 + p_ep * m_epRegSz + 0x10; }
+constexpr size_t e_DTXFSTS(const unsigned p_ep)  { return e_DIEPCTL0 + p_ep * m_epRegSz + 0x18; }
+constexpr size_t e_DOEPCTL(const unsigned p_ep)  { return e_DOEPCTL0 + p_ep * m_epRegSz + 0x00; }
+constexpr size_t e_DOEPINT(const unsigned p_ep)  { return e_DOEPCTL0 + p_ep * m_epRegSz + 0x08; }
+constexpr size_t e_DOEPTSIZ(const unsigned p_ep) { return e_DOEPCTL0 + p_ep * m_epRegSz + 0x10; }
+
+constexpr uint32_t GAHBCFG_GINT         = (1u << 0);
+constexpr uint32_t GAHBCFG_TXFELVL      = (1u << 7);
+
+constexpr uint32_t GRSTCTL_CSRST        = (1u << 0);
+constexpr uint32_t GRSTCTL_RXFFLSH      = (1u << 4);
+constexpr uint32_t GRSTCTL_TXFFLSH      = (1u << 5);
+constexpr uint32_t GRSTCTL_SELFCLEAR    = 0x37;
+constexpr uint32_t GRSTCTL_AHBIDL       = (1u << 31);
+
+constexpr uint32_t GINTSTS_SOF          = (1u << 3);
+constexpr uint32_t GINTSTS_RXFLVL       = (1u << 4);
+constexpr uint32_t GINTSTS_USBSUSP      = (1u << 11);
+constexpr uint32_t GINTSTS_USBRST       = (1u << 12);
+constexpr uint32_t GINTSTS_ENUMDNE      = (1u << 13);
+constexpr uint32_t GINTSTS_IEPINT       = (1u << 18);
+constexpr uint32_t GINTSTS_OEPINT       = (1u << 19);
+constexpr uint32_t GINTSTS_IISOIXFR     = (1u << 20);
+constexpr uint32_t GINTSTS_INCOMPISOOUT = (1u << 21);
+constexpr uint32_t GINTSTS_WKUPINT      = (1u << 31);
+constexpr uint32_t GINTSTS_W1C          = 0xF030FC0A;
+
+constexpr uint32_t GRXSTS_PKTSTS_OUT_DATA   = (2u << 17);
+constexpr uint32_t GRXSTS_PKTSTS_OUT_DONE   = (3u << 17);
+constexpr uint32_t GRXSTS_PKTSTS_SETUP_DONE = (4u << 17);
+constexpr uint32_t GRXSTS_PKTSTS_SETUP_DATA = (6u << 17);
+constexpr uint32_t GRXSTS_PKTSTS_MASK       = (0xFu << 17);
+
+constexpr uint32_t DCTL_RWUSIG          = (1u << 0);
+constexpr uint32_t DCTL_SDIS            = (1u << 1);
+constexpr uint32_t DSTS_SUSPSTS         = (1u << 0);
+constexpr uint32_t DSTS_ENUMSPD_FS48    = (3u << 1);
+
+constexpr uint32_t PCGCCTL_STPPCLK      = (1u << 0);
+
+constexpr uint32_t DEPCTL_EPENA         = (1u << 31);
+constexpr uint32_t DEPCTL_EPDIS         = (1u << 30);
+constexpr uint32_t DEPCTL_WRITEONLY     = (0xFu << 26);     /* SODDFRM, SD0PID, SNAK, CNAK */
+constexpr uint32_t DEPCTL_SODDFRM       = (1u << 29);
+constexpr uint32_t DEPCTL_SEVNFRM       = (1u << 28);
+constexpr uint32_t DEPCTL_EPTYP_MASK    = (3u << 18);
+constexpr uint32_t DEPCTL_EPTYP_ISO     = (1u << 18);
+constexpr uint32_t DEPCTL_SNAK          = (1u << 27);
+constexpr uint32_t DEPCTL_CNAK          = (1u << 26);
+constexpr uint32_t DEPCTL_STALL         = (1u << 21);
+constexpr uint32_t DEPCTL_NAKSTS        = (1u << 17);
+constexpr uint32_t DEPCTL_EONUM         = (1u << 16);
+
+constexpr uint32_t DEPINT_XFRC          = (1u << 0);
+constexpr uint32_t DEPINT_EPDISD        = (1u << 1);
+constexpr uint32_t DOEPINT_STUP         = (1u << 3);
+constexpr uint32_t DIEPINT_TXFE         = (1u << 7);
+
+constexpr uint32_t DEPTSIZ_XFRSIZ_MASK  = 0x7FFFF;
+constexpr unsigned DEPTSIZ_PKTCNT_POS   = 19;
+constexpr uint32_t DEPTSIZ_PKTCNT_MASK  = (0x3FFu << DEPTSIZ_PKTCNT_POS);
+constexpr unsigned DOEPTSIZ_STUPCNT_POS = 29;
+constexpr uint32_t DOEPTSIZ_STUPCNT_MASK = (0x3u << DOEPTSIZ_STUPCNT_POS);
+
+constexpr unsigned m_calibrationLoops   = 200;
+constexpr unsigned m_calibrationBatches = 15;
+
+} /* namespace */
+
+OtgFsRegisterModel *    OtgFsRegisterModel::m_instance = nullptr;
+struct sigaction        OtgFsRegisterModel::m_oldSegvAction;
+struct sigaction        OtgFsRegisterModel::m_oldTrapAction;
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+OtgFsRegisterModel::OtgFsRegisterModel(const IrqHandler_t p_irqHandler, const uintptr_t p_base)
+  : m_irqHandler(p_irqHandler), m_wakeupHandler(nullptr), m_base(p_base), m_mapping(nullptr), m_perfFd(-1), m_inIrq(false), m_csr {},
+    m_rxStatus {}, m_rxStatusHead(0), m_rxStatusCount(0), m_rxFifo {}, m_rxFifoHead(0), m_rxFifoCount(0), m_rxWordsLeft(0),
+    m_txFifo {}, m_pendingOffset(0), m_pendingWrite(false), m_pendingOld(0),
+    m_statistics {}, m_trapCycles(0), m_cyclesPerSecond(0) {
+    assert(m_instance == nullptr);
+
+    m_mapping = ::mmap(reinterpret_cast<void *>(m_base), m_regionSz, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+    if (m_mapping != reinterpret_cast<void *>(m_base)) {
+        ::fprintf(stderr, "OtgFsRegisterModel: Cannot map Register Block at %p\n", reinterpret_cast<void *>(m_base));
+        ::abort();
+    }
+
+    m_instance = this;
+
+    struct perf_event_attr attr = {};
+    attr.size           = sizeof(attr);
+    attr.type           = PERF_TYPE_HARDWARE;
+    attr.config         = PERF_COUNT_HW_INSTRUCTIONS;
+    attr.disabled       = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+    m_perfFd = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+
+    struct sigaction action = {};
+    action.sa_flags = SA_SIGINFO;
+    sigemptyset(&action.sa_mask);
+
+    action.sa_sigaction = &OtgFsRegisterModel::segvHandler;
+    ::sigaction(SIGSEGV, &action, &m_oldSegvAction);
+
+    action.sa_sigaction = &OtgFsRegisterModel::trapHandler;
+    ::sigaction(SIGTRAP, &action, &m_oldTrapAction);
+
+    /* Reset Values of the Registers that are polled by the Driver */
+    csr(e_GOTGCTL)  = (1u << 16) /* CIDSTS: B-Device */ | (1u << 19) /* BSVLD */;
+    csr(e_CID)      = 0x00001200;
+    csr(e_DCTL)     = DCTL_SDIS;
+    for (unsigned ep = 0; ep < m_numEndpoints; ep++) {
+        csr(e_DIEPCTL(ep)) = DEPCTL_NAKSTS;
+        csr(e_DOEPCTL(ep)) = DEPCTL_NAKSTS;
+    }
+
+    calibrate();
+}
+
+OtgFsRegisterModel::~OtgFsRegisterModel() {
+    ::sigaction(SIGTRAP, &m_oldTrapAction, nullptr);
+    ::sigaction(SIGSEGV, &m_oldSegvAction, nullptr);
+
+    ::munmap(m_mapping, m_regionSz);
+
+    if (m_perfFd >= 0) {
+        ::close(m_perfFd);
+    }
+
+    m_instance = nullptr;
+}
+
+/*******************************************************************************
+ * Access Traps
+ ******************************************************************************/
+void
+OtgFsRegisterModel::segvHandler(int /* p_signal */, siginfo_t *p_info, void *p_context) {
+    OtgFsRegisterModel * const  model   = m_instance;
+    ucontext_t * const          context = static_cast<ucontext_t *>(p_context);
+    const uintptr_t             addr    = reinterpret_cast<uintptr_t>(p_info->si_addr);
+
+    if ((model == nullptr) || (addr < model->m_base) || (addr >= (model->m_base + m_regionSz))) {
+        /* Not ours: Restore the previous Handler and let the Access fault again */
+        ::sigaction(SIGSEGV, &m_oldSegvAction, nullptr);
+        return;
+    }
+
+    if (model->m_inIrq && (model->m_perfFd >= 0)) {
+        ::ioctl(model->m_perfFd, PERF_EVENT_IOC_DISABLE, 0);
+    }
+
+    model->m_statistics.m_numTraps++;
+
+    model->m_pendingOffset  = (addr - model->m_base) & ~static_cast<uintptr_t>(0x3);
+    model->m_pendingWrite   = (context->uc_mcontext.gregs[REG_ERR] & 0x2) != 0;
+
+    ::mprotect(model->m_mapping, m_regionSz, PROT_READ | PROT_WRITE);
+
+    const bool isFifo   = (model->m_pendingOffset >= e_FIFO0);
+    const bool isPop    = isFifo || (model->m_pendingOffset == e_GRXSTSP);
+
+    /* Read-Modify-Write Instructions are reported as Writes, so prepare the Read Value for those, too. */
+    if (!model->m_pendingWrite || !isPop) {
+        *model->bus(model->m_pendingOffset) = model->readCsr(model->m_pendingOffset);
+    }
+    model->m_pendingOld = *model->bus(model->m_pendingOffset);
+
+    /* Single-step the faulting Instruction */
+    context->uc_mcontext.gregs[REG_EFL] |= 0x100;
+}
+
+void
+OtgFsRegisterModel::trapHandler(int /* p_signal */, siginfo_t * /* p_info */, void *p_context) {
+    OtgFsRegisterModel * const  model   = m_instance;
+    ucontext_t * const          context = static_cast<ucontext_t *>(p_context);
+
+    context->uc_mcontext.gregs[REG_EFL] &= ~0x100;
+
+    if (model == nullptr) {
+        return;
+    }
+
+    if (model->m_pendingWrite) {
+        model->writeCsr(model->m_pendingOffset, model->m_pendingOld, *model->bus(model->m_pendingOffset));
+    }
+
+    ::mprotect(model->m_mapping, m_regionSz, PROT_NONE);
+
+    if (model->m_inIrq && (model->m_perfFd >= 0)) {
+        ::ioctl(model->m_perfFd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+void
+OtgFsRegisterModel::calibrate(void) {
+    struct timespec start, end;
+    double batches[m_calibrationBatches];
+
+    ::clock_gettime(CLOCK_MONOTONIC, &start);
+    const uint64_t tscStart = __rdtsc();
+
+    for (unsigned batch = 0; batch < m_calibrationBatches; batch++) {
+        const uint64_t batchStart = __rdtsc();
+
+        for (unsigned idx = 0; idx < m_calibrationLoops; idx++) {
+            (void) *bus(e_CID);
+        }
+
+        batches[batch] = static_cast<double>(__rdtsc() - batchStart) / m_calibrationLoops;
+    }
+
+    const uint64_t tscEnd = __rdtsc();
+    ::clock_gettime(CLOCK_MONOTONIC, &end);
+
+    /* Median of the Batches is robust against Preemption by other Processes */
+    std::sort(&batches[0], &batches[m_calibrationBatches]);
+
+    const double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    m_trapCycles        = batches[m_calibrationBatches / 2];
+    m_cyclesPerSecond   = static_cast<double>(tscEnd - tscStart) / seconds;
+
+    resetStatistics();
+}
+
+void
+OtgFsRegisterModel::setWakeupIrqHandler(const IrqHandler_t p_wakeupHandler) {
+    m_wakeupHandler = p_wakeupHandler;
+}
+
+uint64_t
+OtgFsRegisterModel::readInstructionCounter(void) const {
+    uint64_t value = 0;
+
+    if ((m_perfFd < 0) || (::read(m_perfFd, &value, sizeof(value)) != sizeof(value))) {
+        return 0;
+    }
+
+    return value;
+}
+
+void
+OtgFsRegisterModel::resetStatistics(void) {
+    ::memset(&m_statistics, 0, sizeof(m_statistics));
+}
+
+/*******************************************************************************
+ * Register Semantics
+ ******************************************************************************/
+uint32_t
+OtgFsRegisterModel::readCsr(const size_t p_offset) {
+    if (p_offset >= e_FIFO0) {
+        return popRxWord();
+    }
+
+    for (unsigned ep = 0; ep < m_numEndpoints; ep++) {
+        if (p_offset == e_DIEPINT(ep)) {
+            const bool empty = (csr(e_GAHBCFG) & GAHBCFG_TXFELVL)
+              ? (m_txFifo[ep].m_numWords == 0)
+              : (m_txFifo[ep].m_numWords <= (getTxFifoDepth(ep) / 2));
+
+            return csr(p_offset) | (empty ? DIEPINT_TXFE : 0);
+        } else if (p_offset == e_DTXFSTS(ep)) {
+            return getTxFifoDepth(ep) - m_txFifo[ep].m_numWords;
+        }
+    }
+
+    switch (p_offset) {
+    case e_GRSTCTL:
+        return csr(p_offset) | GRSTCTL_AHBIDL;
+    case e_GINTSTS:
+        return getGintsts();
+    case e_GRXSTSR:
+        return (m_rxStatusCount > 0) ? m_rxStatus[m_rxStatusHead].m_grxstsp : 0;
+    case e_GRXSTSP:
+        return popRxStatus();
+    case e_DAINT:
+        return getDaint();
+    default:
+        return csr(p_offset);
+    }
+}
+
+void
+OtgFsRegisterModel::writeCsr(const size_t p_offset, const uint32_t p_old, const uint32_t p_new) {
+    if (p_offset >= e_FIFO0) {
+        pushTx((p_offset - e_FIFO0) / m_fifoWindowSz, p_new);
+        return;
+    }
+
+    for (unsigned ep = 0; ep < m_numEndpoints; ep++) {
+        if ((p_offset == e_DIEPINT(ep)) || (p_offset == e_DOEPINT(ep))) {
+            csr(p_offset) &= ~p_new;
+            return;
+        } else if ((p_offset == e_DIEPCTL(ep)) || (p_offset == e_DOEPCTL(ep))) {
+            const bool isIn = (p_offset == e_DIEPCTL(ep));
+            uint32_t ctl = (csr(p_offset) & DEPCTL_NAKSTS) | (p_new & ~(DEPCTL_WRITEONLY | DEPCTL_NAKSTS));
+
+            if (p_new & DEPCTL_SNAK) {
+                ctl |= DEPCTL_NAKSTS;
+            }
+            if (p_new & DEPCTL_CNAK) {
+                ctl &= ~DEPCTL_NAKSTS;
+            }
+            if (p_new & DEPCTL_SEVNFRM) {
+                ctl &= ~DEPCTL_EONUM;
+            }
+            if (p_new & DEPCTL_SODDFRM) {
+                ctl |= DEPCTL_EONUM;
+            }
+            if (ctl & DEPCTL_EPDIS) {
+                if (csr(p_offset) & DEPCTL_EPENA) {
+                    csr(isIn ? e_DIEPINT(ep) : e_DOEPINT(ep)) |= DEPINT_EPDISD;
+                }
+                ctl &= ~(DEPCTL_EPENA | DEPCTL_EPDIS);
+            }
+
+            csr(p_offset) = ctl;
+            return;
+        }
+    }
+
+    switch (p_offset) {
+    case e_GINTSTS:
+        csr(p_offset) &= ~(p_new & GINTSTS_W1C);
+        break;
+    case e_GRSTCTL:
+        if (p_new & GRSTCTL_CSRST) {
+            csr(e_GINTSTS) = 0;
+        }
+        if (p_new & GRSTCTL_RXFFLSH) {
+            m_rxStatusCount = 0;
+            m_rxFifoCount   = 0;
+            m_rxWordsLeft   = 0;
+        }
+        if (p_new & GRSTCTL_TXFFLSH) {
+            const unsigned txfnum = (p_new >> 6) & 0x1F;
+
+            for (unsigned ep = 0; ep < m_numEndpoints; ep++) {
+                if ((txfnum == 0x10) || (txfnum == ep)) {
+                    flushTx(ep);
+                }
+            }
+        }
+        csr(p_offset) = p_new & ~GRSTCTL_SELFCLEAR;
+        break;
+    case e_GRXSTSR:
+    case e_GRXSTSP:
+    case e_DAINT:
+    case e_DSTS:
+        /* Read-only */
+        break;
+    default:
+        (void) p_old;
+        csr(p_offset) = p_new;
+        break;
+    }
+}
+
+uint32_t
+OtgFsRegisterModel::getDaint(void) const {
+    uint32_t daint = 0;
+
+    for (unsigned ep = 0; ep < m_numEndpoints; ep++) {
+        const bool empty = (m_txFifo[ep].m_numWords == 0);
+        const uint32_t inMask = csr(e_DIEPMSK) | ((csr(e_DIEPEMPMSK) & (1u << ep)) ? DIEPINT_TXFE : 0);
+        const uint32_t inInt = csr(e_DIEPINT(ep)) | ((empty && (csr(e_DIEPCTL(ep)) & DEPCTL_EPENA)) ? DIEPINT_TXFE : 0);
+
+        if (inInt & inMask) {
+            daint |= (1u << ep);
+        }
+        if (csr(e_DOEPINT(ep)) & csr(e_DOEPMSK)) {
+            daint |= (1u << (16 + ep));
+        }
+    }
+
+    return daint;
+}
+
+uint32_t
+OtgFsRegisterModel::getGintsts(void) const {
+    uint32_t gintsts = csr(e_GINTSTS);
+    const uint32_t daint = getDaint() & csr(e_DAINTMSK);
+
+    if (m_rxStatusCount > 0) {
+        gintsts |= GINTSTS_RXFLVL;
+    }
+    if (daint & 0x0000FFFF) {
+        gintsts |= GINTSTS_IEPINT;
+    }
+    if (daint & 0xFFFF0000) {
+        gintsts |= GINTSTS_OEPINT;
+    }
+
+    return gintsts;
+}
+
+size_t
+OtgFsRegisterModel::getTxFifoDepth(const unsigned p_endpoint) const {
+    const uint32_t txf = (p_endpoint == 0) ? csr(e_DIEPTXF0) : csr(e_DIEPTXF1 + (p_endpoint - 1) * sizeof(uint32_t));
+    const size_t depth = txf >> 16;
+
+    return ((depth == 0) || (depth > m_txFifoSzInWords)) ? m_txFifoSzInWords : depth;
+}
+
+unsigned
+OtgFsRegisterModel::getInMaxPacketSize(const unsigned p_endpoint) const {
+    static constexpr unsigned ep0Mps[] = { 64, 32, 16, 8 };
+
+    if (p_endpoint == 0) {
+        return ep0Mps[csr(e_DIEPCTL(0)) & 0x3];
+    }
+    return csr(e_DIEPCTL(p_endpoint)) & 0x7FF;
+}
+
+unsigned
+OtgFsRegisterModel::getOutMaxPacketSize(const unsigned p_endpoint) const {
+    if (p_endpoint == 0) {
+        return getInMaxPacketSize(0);
+    }
+    return csr(e_DOEPCTL(p_endpoint)) & 0x7FF;
+}
+
+/*******************************************************************************
+ * FIFOs
+ ******************************************************************************/
+bool
+OtgFsRegisterModel::pushRx(const uint32_t p_grxstsp, const void * const p_data, const size_t p_length) {
+    const unsigned numWords = (p_length + 3) / 4;
+
+    if ((m_rxStatusCount == m_numRxStatus) || ((m_rxFifoCount + numWords) > m_rxFifoSzInWords)) {
+        return false;
+    }
+
+    for (unsigned idx = 0; idx < numWords; idx++) {
+        uint32_t word = 0;
+        const size_t chunk = ((p_length - idx * 4) < 4) ? (p_length - idx * 4) : 4;
+
+        ::memcpy(&word, static_cast<const uint8_t *>(p_data) + idx * 4, chunk);
+        m_rxFifo[(m_rxFifoHead + m_rxFifoCount) % m_rxFifoSzInWords] = word;
+        m_rxFifoCount++;
+    }
+
+    m_rxStatus[(m_rxStatusHead + m_rxStatusCount) % m_numRxStatus] = { p_grxstsp, numWords };
+    m_rxStatusCount++;
+
+    return true;
+}
+
+uint32_t
+OtgFsRegisterModel::popRxStatus(void) {
+    /* Discard whatever the Driver did not read of the previous Packet */
+    m_rxFifoHead    = (m_rxFifoHead + m_rxWordsLeft) % m_rxFifoSzInWords;
+    m_rxFifoCount   -= m_rxWordsLeft;
+    m_rxWordsLeft   = 0;
+
+    if (m_rxStatusCount == 0) {
+        return 0;
+    }
+
+    const RxStatus_s &status = m_rxStatus[m_rxStatusHead];
+    const unsigned ep = status.m_grxstsp & 0xF;
+
+    m_rxStatusHead  = (m_rxStatusHead + 1) % m_numRxStatus;
+    m_rxStatusCount--;
+    m_rxWordsLeft   = status.m_numWords;
+
+    switch (status.m_grxstsp & GRXSTS_PKTSTS_MASK) {
+    case GRXSTS_PKTSTS_OUT_DONE:
+        csr(e_DOEPINT(ep)) |= DEPINT_XFRC;
+        break;
+    case GRXSTS_PKTSTS_SETUP_DONE:
+        csr(e_DOEPINT(ep)) |= DOEPINT_STUP;
+        break;
+    default:
+        break;
+    }
+
+    return status.m_grxstsp;
+}
+
+uint32_t
+OtgFsRegisterModel::popRxWord(void) {
+    if (m_rxWordsLeft == 0) {
+        return 0;
+    }
+
+    const uint32_t word = m_rxFifo[m_rxFifoHead];
+
+    m_rxFifoHead = (m_rxFifoHead + 1) % m_rxFifoSzInWords;
+    m_rxFifoCount--;
+    m_rxWordsLeft--;
+
+    return word;
+}
+
+void
+OtgFsRegisterModel::pushTx(const unsigned p_endpoint, const uint32_t p_word) {
+    TxFifo_s &fifo = m_txFifo[p_endpoint % m_numEndpoints];
+
+    if (fifo.m_numWords < getTxFifoDepth(p_endpoint)) {
+        fifo.m_data[(fifo.m_head + fifo.m_numWords) % m_txFifoSzInWords] = p_word;
+        fifo.m_numWords++;
+    }
+}
+
+void
+OtgFsRegisterModel::flushTx(const unsigned p_endpoint) {
+    m_txFifo[p_endpoint].m_head     = 0;
+    m_txFifo[p_endpoint].m_numWords = 0;
+}
+
+/*******************************************************************************
+ * Host Side of the Bus
+ ******************************************************************************/
+void
+OtgFsRegisterModel::callIrqHandler(const IrqHandler_t p_handler) {
+    const uint64_t traps        = m_statistics.m_numTraps;
+    const uint64_t instructions = readInstructionCounter();
+    const uint64_t start        = __rdtsc();
+
+    m_inIrq = true;
+    if (m_perfFd >= 0) {
+        ::ioctl(m_perfFd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+
+    p_handler();
+
+    if (m_perfFd >= 0) {
+        ::ioctl(m_perfFd, PERF_EVENT_IOC_DISABLE, 0);
+    }
+    m_inIrq = false;
+
+    const uint64_t cycles   = __rdtsc() - start;
+    const uint64_t overhead = static_cast<uint64_t>((m_statistics.m_numTraps - traps) * m_trapCycles);
+
+    m_statistics.m_numIrqs++;
+    m_statistics.m_irqCycles += (cycles > overhead) ? (cycles - overhead) : 0;
+    m_statistics.m_irqInstructions += readInstructionCounter() - instructions;
+}
+
+void
+OtgFsRegisterModel::raiseIrq(void) {
+    for (unsigned loop = 0; loop < m_maxIrqLoops; loop++) {
+        if (!(csr(e_GAHBCFG) & GAHBCFG_GINT) || !(getGintsts() & csr(e_GINTMSK))) {
+            break;
+        }
+
+        callIrqHandler(m_irqHandler);
+    }
+}
+
+void
+OtgFsRegisterModel::busReset(void) {
+    wakeUp();
+
+    for (unsigned ep = 0; ep < m_numEndpoints; ep++) {
+        flushTx(ep);
+    }
+    m_rxStatusCount = 0;
+    m_rxFifoCount   = 0;
+    m_rxWordsLeft   = 0;
+
+    csr(e_GINTSTS) |= GINTSTS_USBRST;
+    raiseIrq();
+
+    csr(e_DSTS) = DSTS_ENUMSPD_FS48;
+    csr(e_GINTSTS) |= GINTSTS_ENUMDNE;
+    raiseIrq();
+}
+
+bool
+OtgFsRegisterModel::isIsoReady(const uint32_t p_ctl) const {
+    const bool odd = ((csr(e_DSTS) >> 8) & 1) != 0;
+
+    return ((p_ctl & DEPCTL_EPTYP_MASK) != DEPCTL_EPTYP_ISO) || (((p_ctl & DEPCTL_EONUM) != 0) == odd);
+}
+
+void
+OtgFsRegisterModel::sof(void) {
+    /* End of the periodic Frame: Isochronous Endpoints armed for it, but not serviced */
+    for (unsigned ep = 1; ep < m_numEndpoints; ep++) {
+        const uint32_t inCtl  = csr(e_DIEPCTL(ep));
+        const uint32_t outCtl = csr(e_DOEPCTL(ep));
+
+        if (((inCtl & DEPCTL_EPTYP_MASK) == DEPCTL_EPTYP_ISO) && (inCtl & DEPCTL_EPENA) && isIsoReady(inCtl)) {
+            csr(e_GINTSTS) |= GINTSTS_IISOIXFR;
+        }
+        if (((outCtl & DEPCTL_EPTYP_MASK) == DEPCTL_EPTYP_ISO) && (outCtl & DEPCTL_EPENA) && isIsoReady(outCtl)) {
+            csr(e_GINTSTS) |= GINTSTS_INCOMPISOOUT;
+        }
+    }
+
+    const uint32_t fnsof = ((csr(e_DSTS) >> 8) + 1) & 0x3FFF;
+
+    csr(e_DSTS) = (csr(e_DSTS) & ~(0x3FFFu << 8)) | (fnsof << 8);
+    csr(e_GINTSTS) |= GINTSTS_SOF;
+    raiseIrq();
+}
+
+/* The Core cannot see the Bus while its PHY Clock is stopped, but the Wakeup EXTI Line can */
+void
+OtgFsRegisterModel::wakeUp(void) {
+    if ((csr(e_PCGCCTL) & PCGCCTL_STPPCLK) && (m_wakeupHandler != nullptr)) {
+        callIrqHandler(m_wakeupHandler);
+    }
+}
+
+void
+OtgFsRegisterModel::suspend(void) {
+    csr(e_DSTS) |= DSTS_SUSPSTS;
+    csr(e_GINTSTS) |= GINTSTS_USBSUSP;
+    raiseIrq();
+}
+
+void
+OtgFsRegisterModel::resume(void) {
+    wakeUp();
+
+    csr(e_DSTS) &= ~DSTS_SUSPSTS;
+    csr(e_GINTSTS) |= GINTSTS_WKUPINT;
+    raiseIrq();
+}
+
+OtgFsRegisterModel::Handshake_t
+OtgFsRegisterModel::setup(const unsigned p_endpoint, const uint8_t (&p_setupPacket)[8]) {
+    const uint32_t ep = p_endpoint & 0xF;
+
+    if (!pushRx(ep | (8u << 4) | GRXSTS_PKTSTS_SETUP_DATA, p_setupPacket, sizeof(p_setupPacket))
+      || !pushRx(ep | GRXSTS_PKTSTS_SETUP_DONE, nullptr, 0)) {
+        /* SETUP Packets cannot be NAK'ed by the Device */
+        return Handshake_t::e_Nak;
+    }
+
+    uint32_t &tsiz = csr(e_DOEPTSIZ(ep));
+    const uint32_t stupcnt = (tsiz & DOEPTSIZ_STUPCNT_MASK) >> DOEPTSIZ_STUPCNT_POS;
+    tsiz = (tsiz & ~DOEPTSIZ_STUPCNT_MASK) | (((stupcnt > 0) ? stupcnt - 1 : 0) << DOEPTSIZ_STUPCNT_POS);
+
+    raiseIrq();
+
+    return Handshake_t::e_Ack;
+}
+
+OtgFsRegisterModel::Handshake_t
+OtgFsRegisterModel::out(const unsigned p_endpoint, const void * const p_data, const size_t p_length) {
+    const unsigned ep = p_endpoint % m_numEndpoints;
+    uint32_t &ctl = csr(e_DOEPCTL(ep));
+    uint32_t &tsiz = csr(e_DOEPTSIZ(ep));
+    const unsigned mps = getOutMaxPacketSize(ep);
+
+    if (ctl & DEPCTL_STALL) {
+        return Handshake_t::e_Stall;
+    }
+
+    const uint32_t xfrsiz = tsiz & DEPTSIZ_XFRSIZ_MASK;
+
+    if (!(ctl & DEPCTL_EPENA) || (ctl & DEPCTL_NAKSTS) || (p_length > mps) || !isIsoReady(ctl)) {
+        m_statistics.m_numNaks++;
+        return Handshake_t::e_Nak;
+    }
+
+    if (!pushRx(ep | (p_length << 4) | GRXSTS_PKTSTS_OUT_DATA, p_data, p_length)) {
+        m_statistics.m_numNaks++;
+        return Handshake_t::e_Nak;
+    }
+
+    const uint32_t pktcnt = (tsiz & DEPTSIZ_PKTCNT_MASK) >> DEPTSIZ_PKTCNT_POS;
+    const uint32_t newXfrsiz = (xfrsiz > p_length) ? (xfrsiz - p_length) : 0;
+    const uint32_t newPktcnt = (pktcnt > 0) ? (pktcnt - 1) : 0;
+
+    tsiz = (tsiz & ~(DEPTSIZ_XFRSIZ_MASK | DEPTSIZ_PKTCNT_MASK)) | newXfrsiz | (newPktcnt << DEPTSIZ_PKTCNT_POS);
+
+    if ((p_length < mps) || (newPktcnt == 0)) {
+        ctl &= ~DEPCTL_EPENA;
+        ctl |= DEPCTL_NAKSTS;
+        pushRx(ep | GRXSTS_PKTSTS_OUT_DONE, nullptr, 0);
+    }
+
+    m_statistics.m_numOutPackets++;
+    raiseIrq();
+
+    return Handshake_t::e_Ack;
+}
+
+OtgFsRegisterModel::Handshake_t
+OtgFsRegisterModel::in(const unsigned p_endpoint, void * const p_buffer, const size_t p_bufferSz, size_t &p_length) {
+    const unsigned ep = p_endpoint % m_numEndpoints;
+    uint32_t &ctl = csr(e_DIEPCTL(ep));
+    uint32_t &tsiz = csr(e_DIEPTSIZ(ep));
+    TxFifo_s &fifo = m_txFifo[ep];
+
+    p_length = 0;
+
+    if (ctl & DEPCTL_STALL) {
+        return Handshake_t::e_Stall;
+    }
+
+    const uint32_t xfrsiz = tsiz & DEPTSIZ_XFRSIZ_MASK;
+    const uint32_t pktcnt = (tsiz & DEPTSIZ_PKTCNT_MASK) >> DEPTSIZ_PKTCNT_POS;
+    const size_t length = (xfrsiz < getInMaxPacketSize(ep)) ? xfrsiz : getInMaxPacketSize(ep);
+    const size_t numWords = (length + 3) / 4;
+
+    if (!(ctl & DEPCTL_EPENA) || (ctl & DEPCTL_NAKSTS) || (pktcnt == 0) || (fifo.m_numWords < numWords) || (length > p_bufferSz) || !isIsoReady(ctl)) {
+        m_statistics.m_numNaks++;
+        raiseIrq();
+        return Handshake_t::e_Nak;
+    }
+
+    for (unsigned idx = 0; idx < numWords; idx++) {
+        const uint32_t word = fifo.m_data[fifo.m_head];
+        const size_t chunk = ((length - idx * 4) < 4) ? (length - idx * 4) : 4;
+
+        ::memcpy(static_cast<uint8_t *>(p_buffer) + idx * 4, &word, chunk);
+        fifo.m_head = (fifo.m_head + 1) % m_txFifoSzInWords;
+        fifo.m_numWords--;
+    }
+    p_length = length;
+
+    tsiz = (tsiz & ~(DEPTSIZ_XFRSIZ_MASK | DEPTSIZ_PKTCNT_MASK)) | (xfrsiz - length) | ((pktcnt - 1) << DEPTSIZ_PKTCNT_POS);
+
+    if (pktcnt == 1) {
+        ctl &= ~DEPCTL_EPENA;
+        csr(e_DIEPINT(ep)) |= DEPINT_XFRC;
+    }
+
+    m_statistics.m_numInPackets++;
+    raiseIrq();
+
+    return Handshake_t::e_Ack;
+}
+
+uint8_t
+OtgFsRegisterModel::getDeviceAddress(void) const {
+    return (csr(e_DCFG) >> 4) & 0x7F;
+}
+
+bool
+OtgFsRegisterModel::isConnected(void) const {
+    return (csr(e_DCTL) & DCTL_SDIS) == 0;
+}
+
+bool
+OtgFsRegisterModel::isPhyClockStopped(void) const {
+    return (csr(e_PCGCCTL) & PCGCCTL_STPPCLK) != 0;
+}
+
+bool
+OtgFsRegisterModel::isRemoteWakeupSignalled(void) const {
+    return (csr(e_DCTL) & DCTL_RWUSIG) != 0;
+}
+
+    } /* namespace usb */
+} /* namespace stm32 */
+
+#endif /* defined(HOSTBUILD) */
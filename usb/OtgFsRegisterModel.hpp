@@ -0,0 +1,195 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _OTG_FS_REGISTER_MODEL_HPP_C41D8E62_
+#define _OTG_FS_REGISTER_MODEL_HPP_C41D8E62_
+
+#if defined(HOSTBUILD)
+
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace stm32 {
+    namespace usb {
+
+/***************************************************************************//**
+ * @brief Register-level Model of the STM32F4 OTG_FS Core for the Host Build.
+ *
+ * The Model maps the OTG_FS Register Block at its real Address
+ * (\c USB_OTG_FS_PERIPH_BASE) with all Access Rights removed. Every Register or
+ * FIFO Access by the Device Stack faults. The Model then emulates the Access
+ * and single-steps the faulting Instruction. This covers e.g. the
+ * Write-1-to-clear Interrupt Registers, popping \c GRXSTSP and the RX FIFO, and
+ * pushing to the TX FIFOs. The Drivers run unmodified.
+ *
+ * Each faulting Instruction is emulated as a single, aligned 32-Bit Access to
+ * the Word that holds the Fault Address. Further Words touched by the same
+ * Instruction, e.g. by a \c memcpy() from a FIFO, a 64-Bit or a vectorized
+ * Access, are read from / written to the Model's Image without Emulation. The
+ * Drivers access the Core only via \c volatile 32-Bit Loads and Stores, which
+ * the Compiler neither merges nor widens.
+ *
+ * The Host Side of the Bus is driven via busReset(), setup(), out() and in().
+ * Each Call updates the Register State and then raises the Interrupt, i.e.
+ * calls the IRQ Handler as long as an unmasked Interrupt is pending.
+ *
+ * The Time spent in the IRQ Handler is measured with the Time Stamp Counter.
+ * The Overhead of the Access Traps is calibrated at Start-up and subtracted.
+ * What is left approximates the Cycles spent in the Device Stack itself. The
+ * Number of Register Accesses per Packet is exact. If the Kernel grants access
+ * to the PMU, the User-Mode Instructions of the Device Stack are counted as
+ * well; the Counter is paused while an Access Trap is handled.
+ *
+ * Isochronous Endpoints only take Part in the Frame selected by their Even /
+ * Odd Frame Bit. An Isochronous Endpoint that is still armed for a Frame when
+ * the next SOF is sent raises the Incomplete Isochronous IN / OUT Interrupt.
+ * Like on the Bus, there is no Handshake: \c e_Nak means that no Data was
+ * transferred.
+ *
+ * suspend() and resume() stand in for the Host suspending and resuming the
+ * Bus. If the Device has stopped the PHY Clock via \c PCGCCTL, resume() first
+ * calls the Wakeup Handler, like the OTG Wakeup EXTI Line would (see
+ * setWakeupIrqHandler()). Remote Wakeup Signalling by the Device is visible via
+ * isRemoteWakeupSignalled().
+ *
+ * Only a single Instance may exist at a Time. Requires Linux on x86-64.
+ ******************************************************************************/
+class OtgFsRegisterModel {
+public:
+    typedef void (*IrqHandler_t)(void);
+
+    typedef enum class Handshake_e {
+        e_Ack,
+        e_Nak,
+        e_Stall
+    } Handshake_t;
+
+    typedef struct Statistics_s {
+        uint64_t    m_numIrqs;
+        uint64_t    m_numTraps;
+        uint64_t    m_irqCycles;        /**< Cycles in the IRQ Handler, Trap Overhead removed. */
+        uint64_t    m_irqInstructions;  /**< Instructions in the IRQ Handler, zero if no PMU is available. */
+        uint64_t    m_numOutPackets;
+        uint64_t    m_numInPackets;
+        uint64_t    m_numNaks;
+    } Statistics_t;
+
+    static constexpr unsigned   m_numEndpoints      = 4;
+    static constexpr size_t     m_regionSz          = 0x5000;   /* CSRs plus one FIFO Window per Endpoint */
+
+    OtgFsRegisterModel(const IrqHandler_t p_irqHandler, const uintptr_t p_base);
+    ~OtgFsRegisterModel();
+
+    void        setWakeupIrqHandler(const IrqHandler_t p_wakeupHandler);
+
+    void        busReset(void);
+    void        sof(void);
+    void        suspend(void);
+    void        resume(void);
+    Handshake_t setup(const unsigned p_endpoint, const uint8_t (&p_setupPacket)[8]);
+    Handshake_t out(const unsigned p_endpoint, const void * const p_data, const size_t p_length);
+    Handshake_t in(const unsigned p_endpoint, void * const p_buffer, const size_t p_bufferSz, size_t &p_length);
+
+    uint8_t     getDeviceAddress(void) const;
+    bool        isConnected(void) const;
+    bool        isPhyClockStopped(void) const;
+    bool        isRemoteWakeupSignalled(void) const;
+
+    const Statistics_t &    getStatistics(void) const { return m_statistics; }
+    void                    resetStatistics(void);
+    double                  getTrapCycles(void) const { return m_trapCycles; }
+    double                  getCyclesPerSecond(void) const { return m_cyclesPerSecond; }
+    bool                    hasInstructionCounter(void) const { return m_perfFd >= 0; }
+
+private:
+    static constexpr size_t     m_numCsrWords       = 0x1000 / sizeof(uint32_t);
+    static constexpr size_t     m_rxFifoSzInWords   = 512;
+    static constexpr size_t     m_txFifoSzInWords   = 256;
+    static constexpr unsigned   m_numRxStatus       = 64;
+    static constexpr unsigned   m_maxIrqLoops       = 32;
+
+    struct RxStatus_s {
+        uint32_t    m_grxstsp;
+        unsigned    m_numWords;
+    };
+
+    struct TxFifo_s {
+        uint32_t    m_data[m_txFifoSzInWords];
+        size_t      m_head;
+        size_t      m_numWords;
+    };
+
+    const IrqHandler_t  m_irqHandler;
+    IrqHandler_t        m_wakeupHandler;
+    const uintptr_t     m_base;
+    void *              m_mapping;
+    int                 m_perfFd;
+    bool                m_inIrq;
+
+    uint32_t            m_csr[m_numCsrWords];
+
+    RxStatus_s          m_rxStatus[m_numRxStatus];
+    unsigned            m_rxStatusHead;
+    unsigned            m_rxStatusCount;
+    uint32_t            m_rxFifo[m_rxFifoSzInWords];
+    size_t              m_rxFifoHead;
+    size_t              m_rxFifoCount;
+    unsigned            m_rxWordsLeft;
+
+    TxFifo_s            m_txFifo[m_numEndpoints];
+
+    /* State of the Access currently being single-stepped */
+    size_t              m_pendingOffset;
+    bool                m_pendingWrite;
+    uint32_t            m_pendingOld;
+
+    Statistics_t        m_statistics;
+    double              m_trapCycles;
+    double              m_cyclesPerSecond;
+
+    static OtgFsRegisterModel * m_instance;
+
+    static struct sigaction m_oldSegvAction;
+    static struct sigaction m_oldTrapAction;
+
+    static void         segvHandler(int p_signal, siginfo_t *p_info, void *p_context);
+    static void         trapHandler(int p_signal, siginfo_t *p_info, void *p_context);
+
+    void                calibrate(void);
+    uint64_t            readInstructionCounter(void) const;
+    void                raiseIrq(void);
+    void                callIrqHandler(const IrqHandler_t p_handler);
+    void                wakeUp(void);
+
+    bool                isIsoReady(const uint32_t p_ctl) const;
+
+    uint32_t &          csr(const size_t p_offset) { return m_csr[p_offset / sizeof(uint32_t)]; }
+    uint32_t            csr(const size_t p_offset) const { return m_csr[p_offset / sizeof(uint32_t)]; }
+    volatile uint32_t * bus(const size_t p_offset) const { return reinterpret_cast<volatile uint32_t *>(m_base + p_offset); }
+
+    uint32_t            readCsr(const size_t p_offset);
+    void                writeCsr(const size_t p_offset, const uint32_t p_old, const uint32_t p_new);
+
+    uint32_t            getGintsts(void) const;
+    uint32_t            getDaint(void) const;
+    size_t              getTxFifoDepth(const unsigned p_endpoint) const;
+    unsigned            getInMaxPacketSize(const unsigned p_endpoint) const;
+    unsigned            getOutMaxPacketSize(const unsigned p_endpoint) const;
+
+    bool                pushRx(const uint32_t p_grxstsp, const void * const p_data, const size_t p_length);
+    uint32_t            popRxStatus(void);
+    uint32_t            popRxWord(void);
+    void                pushTx(const unsigned p_endpoint, const uint32_t p_word);
+    void                flushTx(const unsigned p_endpoint);
+};
+
+    } /* namespace usb */
+} /* namespace stm32 */
+
+#endif /* defined(HOSTBUILD) */
+
+#endif /* _OTG_FS_REGISTER_MODEL_HPP_C41D8E62_ */
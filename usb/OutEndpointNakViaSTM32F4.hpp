@@ -0,0 +1,63 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _OUT_ENDPOINT_NAK_VIA_STM32F4_HPP_2C7E0B19_
+#define _OUT_ENDPOINT_NAK_VIA_STM32F4_HPP_2C7E0B19_
+
+#include <stm32f4xx.h>
+
+#include <cstdint>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace stm32 {
+    namespace usb {
+
+/***************************************************************************//**
+ * @brief NAK-based Flow Control for an OUT Endpoint of the STM32F4 OTG Core.
+ *
+ * Setting the NAK Bit in \c DOEPCTLx makes the Core answer all OUT Tokens on the
+ * Endpoint with NAK, i.e. the Host will retry the Transaction later. This gives
+ * Applications a lossless way to apply back-pressure when they run out of buffer
+ * space.
+ *
+ * The Base Address of the OTG Register Block is a Constructor Parameter so that
+ * the Class can be pointed at a Register Model in the Host Build.
+ *
+ * @tparam nEndpointNumber OUT Endpoint Number, e.g. \c 1 for \c 0x01.
+ ******************************************************************************/
+template<unsigned nEndpointNumber>
+class OutEndpointNakViaSTM32F4 {
+    static_assert(nEndpointNumber < 4, "OTG_FS Core only supports OUT Endpoints 0..3");
+
+    const uintptr_t m_otgBase;
+
+    USB_OTG_OUTEndpointTypeDef *
+    outEndpoint(void) const {
+        return reinterpret_cast<USB_OTG_OUTEndpointTypeDef *>(m_otgBase + USB_OTG_OUT_ENDPOINT_BASE + nEndpointNumber * USB_OTG_EP_REG_SIZE);
+    }
+
+public:
+    constexpr OutEndpointNakViaSTM32F4(const uintptr_t p_otgBase = USB_OTG_FS_PERIPH_BASE)
+      : m_otgBase(p_otgBase) {
+
+    }
+
+    void setNak(void) const {
+        outEndpoint()->DOEPCTL |= USB_OTG_DOEPCTL_SNAK;
+    }
+
+    void clearNak(void) const {
+        outEndpoint()->DOEPCTL |= USB_OTG_DOEPCTL_CNAK;
+    }
+
+    bool isNak(void) const {
+        return (outEndpoint()->DOEPCTL & USB_OTG_DOEPCTL_NAKSTS) != 0;
+    }
+};
+
+    } /* namespace usb */
+} /* namespace stm32 */
+
+#endif /* _OUT_ENDPOINT_NAK_VIA_STM32F4_HPP_2C7E0B19_ */
@@ -0,0 +1,68 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _SOF_VIA_STM32F4_HPP_7F2B94C0_
+#define _SOF_VIA_STM32F4_HPP_7F2B94C0_
+
+#include <stm32f4xx.h>
+
+#include <cstdint>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace stm32 {
+    namespace usb {
+
+/***************************************************************************//**
+ * @brief Start-of-Frame Interrupt of the STM32F4 OTG Core.
+ *
+ * The Host sends a SOF Token every Millisecond, so counting SOFs gives
+ * Applications a Time Base that is tied to the Bus. handleIrq() must be called
+ * from the OTG Interrupt Handler before the Core's own \c handleIrq().
+ *
+ * The Base Address of the OTG Register Block is a Constructor Parameter so that
+ * the Class can be pointed at a Register Model in the Host Build.
+ ******************************************************************************/
+class SofViaSTM32F4 {
+    const uintptr_t m_otgBase;
+
+    USB_OTG_GlobalTypeDef *
+    global(void) const {
+        return reinterpret_cast<USB_OTG_GlobalTypeDef *>(m_otgBase);
+    }
+
+public:
+    constexpr SofViaSTM32F4(const uintptr_t p_otgBase = USB_OTG_FS_PERIPH_BASE)
+      : m_otgBase(p_otgBase) {
+
+    }
+
+    /** @brief Unmask the SOF Interrupt. Must be called after the Core has been started. */
+    void enable(void) const {
+        global()->GINTMSK |= USB_OTG_GINTMSK_SOFM;
+    }
+
+    void disable(void) const {
+        global()->GINTMSK &= ~USB_OTG_GINTMSK_SOFM;
+    }
+
+    /**
+     * @brief Acknowledge a pending SOF Interrupt.
+     *
+     * @return \c true if a SOF was pending.
+     */
+    bool handleIrq(void) const {
+        if ((global()->GINTSTS & global()->GINTMSK & USB_OTG_GINTSTS_SOF) == 0) {
+            return false;
+        }
+
+        global()->GINTSTS = USB_OTG_GINTSTS_SOF;
+        return true;
+    }
+};
+
+    } /* namespace usb */
+} /* namespace stm32 */
+
+#endif /* _SOF_VIA_STM32F4_HPP_7F2B94C0_ */
@@ -0,0 +1,140 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _USB_ALTERNATE_SETTING_HPP_6B2D94E1_
+#define _USB_ALTERNATE_SETTING_HPP_6B2D94E1_
+
+#include <usb/UsbTypes.hpp>
+#include <usb/UsbControlPipe.hpp>
+
+#include <cstdint>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace usb {
+
+/***************************************************************************//**
+ * @brief Interface for Functions with more than one Alternate Setting.
+ *
+ * setAlternateSetting() is called from the Control Pipe, i.e. from the OTG
+ * Interrupt Handler, when the Host selects an Alternate Setting via
+ * \c SET_INTERFACE, and with Alternate Setting 0 when the Host sets the
+ * Configuration.
+ ******************************************************************************/
+class UsbAlternateSettingHandler {
+public:
+    /** @return \c false if the Alternate Setting does not exist. */
+    virtual bool setAlternateSetting(const uint8_t p_alternateSetting) = 0;
+
+protected:
+    ~UsbAlternateSettingHandler() = default;
+};
+
+/***************************************************************************//**
+ * @brief Endpoint Pair that only exists in Alternate Setting 1, e.g. the
+ *   Isochronous Pair of ::usb::descriptor::VendorIsochronousFunction.
+ *
+ * Alternate Setting 0 has no Endpoints, so it takes no Bandwidth.
+ *
+ * @tparam OutEndpointT OUT Endpoint with \c activate() and \c deactivate(),
+ *   e.g. ::stm32::usb::IsoOutEndpointViaSTM32F4.
+ * @tparam InEndpointT IN Endpoint, e.g. ::stm32::usb::IsoInEndpointViaSTM32F4.
+ ******************************************************************************/
+template<typename OutEndpointT, typename InEndpointT>
+class UsbEndpointPairAlternateSettingT : public UsbAlternateSettingHandler {
+    OutEndpointT &  m_outEndpoint;
+    InEndpointT &   m_inEndpoint;
+
+public:
+    UsbEndpointPairAlternateSettingT(OutEndpointT &p_outEndpoint, InEndpointT &p_inEndpoint)
+      : m_outEndpoint(p_outEndpoint), m_inEndpoint(p_inEndpoint) {
+
+    }
+
+    bool
+    setAlternateSetting(const uint8_t p_alternateSetting) override {
+        switch (p_alternateSetting) {
+        case 0:
+            m_inEndpoint.deactivate();
+            m_outEndpoint.deactivate();
+            return true;
+        case 1:
+            m_outEndpoint.activate();
+            m_inEndpoint.activate();
+            return true;
+        }
+
+        return false;
+    }
+};
+
+/***************************************************************************//**
+ * @brief Adds \c SET_INTERFACE and \c GET_INTERFACE for one Interface with
+ *   Alternate Settings to a Device.
+ *
+ * Like ::usb::UsbFunctionStringsDevice, this intercepts the Requests before
+ * they reach \p DeviceT and passes all others on unchanged, as do the
+ * Constructor Arguments. \c SET_CONFIGURATION is passed on as well, but
+ * first returns the Interface to Alternate Setting 0 (see USB 2.0 Spec,
+ * Section 9.1.1.5).
+ *
+ * Until setAlternateSettingHandler() is called, the Class behaves exactly like
+ * \p DeviceT.
+ *
+ * @tparam DeviceT Device Class, e.g. ::usb::UsbFunctionStringsDevice.
+ ******************************************************************************/
+template<typename DeviceT>
+class UsbAlternateSettingDeviceT : public DeviceT {
+    static constexpr uint8_t    m_requestSetConfiguration   = 0x09;
+    static constexpr uint8_t    m_requestGetInterface       = 0x0A;
+    static constexpr uint8_t    m_requestSetInterface       = 0x0B;
+
+    UsbAlternateSettingHandler *    m_handler           = nullptr;
+    uint16_t                        m_interface         = 0xFFFF;
+    uint8_t                         m_alternateSetting  = 0;
+
+public:
+    using DeviceT::DeviceT;
+
+    void
+    setAlternateSettingHandler(UsbAlternateSettingHandler &p_handler, const uint8_t p_interface) {
+        m_handler   = &p_handler;
+        m_interface = p_interface;
+    }
+
+    void
+    handleCtrlRequest(const UsbSetupPacket_t &p_setupPacket, UsbControlPipe &p_ctrlPipe) override {
+        const uint8_t bmRequestType = static_cast<uint8_t>(p_setupPacket.m_bmRequestType);
+
+        if (m_handler == nullptr) {
+            DeviceT::handleCtrlRequest(p_setupPacket, p_ctrlPipe);
+            return;
+        }
+
+        /* Standard Request, Host to Device, Recipient Device */
+        if ((bmRequestType == 0x00) && (p_setupPacket.m_bRequest == m_requestSetConfiguration)) {
+            m_handler->setAlternateSetting(0);
+            m_alternateSetting = 0;
+        /* Standard Request, Host to Device, Recipient Interface */
+        } else if ((bmRequestType == 0x01) && (p_setupPacket.m_bRequest == m_requestSetInterface) && (p_setupPacket.m_wIndex == m_interface)) {
+            if ((p_setupPacket.m_wValue <= 0xFF) && m_handler->setAlternateSetting(p_setupPacket.m_wValue)) {
+                m_alternateSetting = p_setupPacket.m_wValue;
+                p_ctrlPipe.write(nullptr, 0); /* Status Stage */
+            } else {
+                p_ctrlPipe.stall();
+            }
+            return;
+        /* Standard Request, Device to Host, Recipient Interface */
+        } else if ((bmRequestType == 0x81) && (p_setupPacket.m_bRequest == m_requestGetInterface) && (p_setupPacket.m_wIndex == m_interface)) {
+            p_ctrlPipe.write(&m_alternateSetting, (p_setupPacket.m_wLength < sizeof(m_alternateSetting)) ? p_setupPacket.m_wLength : sizeof(m_alternateSetting));
+            return;
+        }
+
+        DeviceT::handleCtrlRequest(p_setupPacket, p_ctrlPipe);
+    }
+};
+
+} /* namespace usb */
+
+#endif /* _USB_ALTERNATE_SETTING_HPP_6B2D94E1_ */
@@ -0,0 +1,118 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _USB_BLOCK_DEVICE_HPP_3C8E52A1_
+#define _USB_BLOCK_DEVICE_HPP_3C8E52A1_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace usb {
+
+/***************************************************************************//**
+ * @brief Medium behind a Mass Storage Function, see ::usb::UsbMassStorageT.
+ *
+ * The Medium is addressed in Blocks of m_blockSz Bytes. read() and write()
+ * take any Part of a single Block, so the Function can move the Data of a
+ * Transfer Packet by Packet instead of buffering whole Blocks.
+ *
+ * A memory-mapped Medium can avoid Copies altogether:
+ * - map() returns the Address of a Block, which the Function then sends to the
+ *   Host straight from the Medium.
+ * - lend() returns where the Data of a Write shall go, which the OUT Endpoint
+ *   then stores the Packet at. write() is still called; it should check
+ *   whether \c p_data already points to where the Data belongs.
+ *
+ * All Methods are called from the Context of the USB Interrupt.
+ ******************************************************************************/
+class UsbBlockDevice {
+public:
+    static constexpr size_t m_blockSz = 512;
+
+    virtual uint32_t    getNumBlocks(void) const = 0;
+
+    virtual bool        isWriteProtected(void) const = 0;
+
+    /** @brief Address of Block \p p_block or \c nullptr if the Medium is not memory-mapped. */
+    virtual const void *map(const uint32_t p_block) const = 0;
+
+    /**
+     * @brief Destination of \p p_length Bytes at \p p_offset in Block \p p_block.
+     *
+     * @return \c nullptr if the Data must be passed to write() from a Buffer of
+     *   the Caller.
+     */
+    virtual void *      lend(const uint32_t p_block, const size_t p_offset, const size_t p_length) = 0;
+
+    /** @return \c false on a Read Error. */
+    virtual bool        read(const uint32_t p_block, const size_t p_offset, void * const p_buffer, const size_t p_length) = 0;
+
+    /** @return \c false on a Write Error. */
+    virtual bool        write(const uint32_t p_block, const size_t p_offset, const void * const p_data, const size_t p_length) = 0;
+
+protected:
+    ~UsbBlockDevice() = default;
+};
+
+/***************************************************************************//**
+ * @brief Block Device in RAM.
+ *
+ * Memory-mapped in both Directions, i.e. READ(10) sends straight from the Disk
+ * and a zero-copy OUT Endpoint stores WRITE(10) Data straight into it.
+ *
+ * @tparam nNumBlocks Size of the Disk in Blocks of ::usb::UsbBlockDevice::m_blockSz Bytes.
+ ******************************************************************************/
+template<uint32_t nNumBlocks>
+class UsbRamDiskT : public UsbBlockDevice {
+    static_assert(nNumBlocks > 0, "RAM Disk must hold at least one Block");
+
+    alignas(4) uint8_t  m_data[nNumBlocks][m_blockSz];
+
+public:
+    constexpr UsbRamDiskT(void) : m_data {} {
+
+    }
+
+    uint32_t
+    getNumBlocks(void) const override {
+        return nNumBlocks;
+    }
+
+    bool
+    isWriteProtected(void) const override {
+        return false;
+    }
+
+    const void *
+    map(const uint32_t p_block) const override {
+        return m_data[p_block];
+    }
+
+    void *
+    lend(const uint32_t p_block, const size_t p_offset, const size_t /* p_length */) override {
+        return &m_data[p_block][p_offset];
+    }
+
+    bool
+    read(const uint32_t p_block, const size_t p_offset, void * const p_buffer, const size_t p_length) override {
+        ::memcpy(p_buffer, &m_data[p_block][p_offset], p_length);
+        return true;
+    }
+
+    bool
+    write(const uint32_t p_block, const size_t p_offset, const void * const p_data, const size_t p_length) override {
+        /* Already in Place if the Endpoint wrote to the lent Buffer */
+        if (p_data != &m_data[p_block][p_offset]) {
+            ::memcpy(&m_data[p_block][p_offset], p_data, p_length);
+        }
+        return true;
+    }
+};
+
+} /* namespace usb */
+
+#endif /* _USB_BLOCK_DEVICE_HPP_3C8E52A1_ */
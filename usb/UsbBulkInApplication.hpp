@@ -0,0 +1,65 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _USB_BULK_IN_APPLICATION_HPP_EBA45D8C_
+#define _USB_BULK_IN_APPLICATION_HPP_EBA45D8C_
+
+#include <usb/UsbInEndpoint.hpp>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace usb {
+
+/***************************************************************************//**
+ * @brief Interface for Applications that feed a Bulk IN Endpoint.
+ *
+ * Applications that keep data in flight on a Bulk IN Endpoint (e.g. a ring
+ * buffer that is drained by the Hardware) need to know when the Endpoint is
+ * done with a buffer so that they can re-use it.
+ ******************************************************************************/
+class UsbBulkInApplication {
+public:
+    virtual void inTransferComplete(void) = 0;
+
+protected:
+    ~UsbBulkInApplication() = default;
+};
+
+/***************************************************************************//**
+ * @brief Bulk IN Endpoint that reports completed Transfers to an Application.
+ *
+ * Drop-in replacement for ::usb::UsbBulkInEndpointT. The Hardware Endpoint
+ * signals a completed IN Transfer via transferComplete(); this class forwards
+ * the event to the registered UsbBulkInApplication, if any.
+ ******************************************************************************/
+template<typename UsbHwBulkInEndpointT>
+class UsbBulkInEndpointNotifyT : public UsbBulkInEndpointT<UsbHwBulkInEndpointT> {
+    UsbBulkInApplication *  m_application;
+
+public:
+    UsbBulkInEndpointNotifyT(UsbHwBulkInEndpointT &p_hwEndpoint)
+      : UsbBulkInEndpointT<UsbHwBulkInEndpointT>(p_hwEndpoint), m_application(nullptr) {
+
+    }
+
+    void registerApplication(UsbBulkInApplication &p_application) {
+        m_application = &p_application;
+    }
+
+    void unregisterApplication(void) {
+        m_application = nullptr;
+    }
+
+    void transferComplete(void) override {
+        UsbBulkInEndpointT<UsbHwBulkInEndpointT>::transferComplete();
+
+        if (m_application != nullptr) {
+            m_application->inTransferComplete();
+        }
+    }
+};
+
+} /* namespace usb */
+
+#endif /* _USB_BULK_IN_APPLICATION_HPP_EBA45D8C_ */
@@ -0,0 +1,180 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _USB_BULK_IN_WRITER_HPP_1C5F7A93_
+#define _USB_BULK_IN_WRITER_HPP_1C5F7A93_
+
+#include <usb/UsbBulkInApplication.hpp>
+
+#include <FreeRTOS.h>
+#include <FreeRTOS/include/task.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace usb {
+
+/***************************************************************************//**
+ * @brief Buffered Writer that coalesces small Writes into full Bulk IN Packets.
+ *
+ * Data passed to write() is appended to one Half of a double Buffer. As soon
+ * as the IN Endpoint is idle and at least one full Packet has been collected,
+ * all full Packets are sent as one multi-Packet Transfer, so the Core can send
+ * them back-to-back from the TX FIFO. A trailing partial Packet is moved to the
+ * other Half and keeps collecting Data.
+ *
+ * Partial Packets are flushed when flush() is called or when no Transfer has
+ * been started for \c p_flushSofs Frames, i.e. the Latency of a single Byte is
+ * bounded to \c p_flushSofs Milliseconds. If the last Transfer ended on a
+ * Packet Boundary, the Flush sends a Zero-Length Packet so the Host sees the
+ * End of the Transfer.
+ *
+ * write() and flush() may be called from a FreeRTOS Task; they use a Critical
+ * Section to keep the USB Interrupt out. The USB Interrupt must therefore run
+ * at or below \c configMAX_SYSCALL_INTERRUPT_PRIORITY.
+ *
+ * @tparam InEndpointT Bulk IN Endpoint, e.g. ::usb::UsbBulkInEndpointNotifyT.
+ * @tparam nBufferSz Total Size of the double Buffer in Bytes.
+ * @tparam nPacketSz Max. Packet Size of the Bulk IN Endpoint.
+ ******************************************************************************/
+template<typename InEndpointT, size_t nBufferSz = 1024, size_t nPacketSz = 64>
+class UsbBulkInWriterT : public UsbBulkInApplication {
+public:
+    static constexpr size_t m_halfSz = nBufferSz / 2;
+
+private:
+    static_assert((m_halfSz % nPacketSz) == 0, "Each Half of the Buffer must hold a whole Number of Packets");
+    static_assert(m_halfSz >= (2 * nPacketSz), "Each Half of the Buffer must hold at least two Packets");
+
+    InEndpointT &           m_inEndpoint;
+    const unsigned          m_flushSofs;
+
+    alignas(4) uint8_t      m_buffer[2][m_halfSz];
+    size_t                  m_length;
+    unsigned                m_fill;
+    unsigned                m_sofs;
+    bool                    m_inFlight;
+    bool                    m_needZlp;
+    bool                    m_flushPending;
+
+    void
+    submit(const size_t p_length) {
+        const unsigned  other       = m_fill ^ 1;
+        const size_t    remainder   = m_length - p_length;
+        const uint8_t * data        = m_buffer[m_fill];
+
+        ::memcpy(m_buffer[other], &m_buffer[m_fill][p_length], remainder);
+
+        m_fill      = other;
+        m_length    = remainder;
+        m_sofs      = 0;
+        m_inFlight  = true;
+        m_needZlp   = (p_length != 0) && ((p_length % nPacketSz) == 0);
+
+        m_inEndpoint.write(data, p_length);
+    }
+
+    void
+    kick(void) {
+        if (m_inFlight) {
+            return;
+        }
+
+        if (m_flushPending) {
+            if (m_length > 0) {
+                submit(m_length);
+                /* Keep the Flush pending if a ZLP has to follow */
+                m_flushPending = m_needZlp;
+            } else {
+                if (m_needZlp) {
+                    submit(0);
+                }
+                m_flushPending = false;
+            }
+            return;
+        }
+
+        const size_t full = m_length - (m_length % nPacketSz);
+        if (full > 0) {
+            submit(full);
+        }
+    }
+
+public:
+    /**
+     * @param p_inEndpoint Bulk IN Endpoint.
+     * @param p_flushSofs Number of Frames after which a partial Packet is sent.
+     *   Zero disables the timed Flush.
+     */
+    UsbBulkInWriterT(InEndpointT &p_inEndpoint, const unsigned p_flushSofs = 2)
+      : m_inEndpoint(p_inEndpoint), m_flushSofs(p_flushSofs), m_length(0), m_fill(0), m_sofs(0),
+        m_inFlight(false), m_needZlp(false), m_flushPending(false) {
+        m_inEndpoint.registerApplication(*this);
+    }
+
+    ~UsbBulkInWriterT() {
+        m_inEndpoint.unregisterApplication();
+    }
+
+    /**
+     * @brief Queue Data for Transmission.
+     *
+     * @return Number of Bytes taken, less than \p p_length if the Buffer is full.
+     */
+    size_t
+    write(const void * const p_data, const size_t p_length) {
+        taskENTER_CRITICAL();
+
+        const size_t length = (p_length < (m_halfSz - m_length)) ? p_length : (m_halfSz - m_length);
+
+        ::memcpy(&m_buffer[m_fill][m_length], p_data, length);
+        m_length += length;
+        kick();
+
+        taskEXIT_CRITICAL();
+
+        return length;
+    }
+
+    /**
+     * @brief Send all queued Data now, incl. a trailing partial Packet or ZLP.
+     */
+    void
+    flush(void) {
+        taskENTER_CRITICAL();
+
+        m_flushPending = true;
+        kick();
+
+        taskEXIT_CRITICAL();
+    }
+
+    /**
+     * @brief Start-of-Frame Callback, must be called from the USB Interrupt.
+     */
+    void
+    handleSof(void) {
+        if ((m_flushSofs == 0) || m_flushPending || ((m_length == 0) && !m_needZlp)) {
+            return;
+        }
+
+        if (++m_sofs >= m_flushSofs) {
+            m_flushPending = true;
+            kick();
+        }
+    }
+
+    void
+    inTransferComplete(void) override {
+        m_inFlight = false;
+        kick();
+    }
+};
+
+} /* namespace usb */
+
+#endif /* _USB_BULK_IN_WRITER_HPP_1C5F7A93_ */
@@ -0,0 +1,210 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _USB_BULK_OUT_STREAM_HPP_B7D40E96_
+#define _USB_BULK_OUT_STREAM_HPP_B7D40E96_
+
+#include <usb/UsbApplication.hpp>
+
+#include <FreeRTOS.h>
+#include <FreeRTOS/include/task.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace usb {
+
+/***************************************************************************//**
+ * @brief Lock-free Byte Ring for exactly one Producer and one Consumer.
+ *
+ * Read and Write Index run freely and are only reduced modulo the Buffer Size
+ * when the Buffer is accessed. The Producer only ever writes the Write Index,
+ * the Consumer only ever writes the Read Index, so neither Side needs a Lock.
+ *
+ * @tparam nBufferSz Size of the Ring in Bytes, must be a Power of Two.
+ ******************************************************************************/
+template<size_t nBufferSz>
+class SpscByteRingT {
+    static_assert((nBufferSz > 0) && ((nBufferSz & (nBufferSz - 1)) == 0), "Ring Size must be a Power of Two");
+
+    uint8_t                 m_buffer[nBufferSz];
+    std::atomic<uint32_t>   m_writeIdx;
+    std::atomic<uint32_t>   m_readIdx;
+
+public:
+    SpscByteRingT(void) : m_writeIdx(0), m_readIdx(0) {
+
+    }
+
+    size_t
+    getUsed(void) const {
+        return m_writeIdx.load(std::memory_order_acquire) - m_readIdx.load(std::memory_order_acquire);
+    }
+
+    size_t
+    getFree(void) const {
+        return nBufferSz - getUsed();
+    }
+
+    /** @brief Producer Side. Returns the Number of Bytes written. */
+    size_t
+    write(const void * const p_data, const size_t p_length) {
+        const uint32_t writeIdx = m_writeIdx.load(std::memory_order_relaxed);
+        const uint32_t readIdx  = m_readIdx.load(std::memory_order_acquire);
+        const size_t   length   = (p_length < (nBufferSz - (writeIdx - readIdx))) ? p_length : (nBufferSz - (writeIdx - readIdx));
+        const size_t   offset   = writeIdx % nBufferSz;
+        const size_t   first    = ((offset + length) <= nBufferSz) ? length : (nBufferSz - offset);
+
+        ::memcpy(&m_buffer[offset], p_data, first);
+        ::memcpy(&m_buffer[0], static_cast<const uint8_t *>(p_data) + first, length - first);
+
+        m_writeIdx.store(writeIdx + length, std::memory_order_release);
+        return length;
+    }
+
+    /** @brief Consumer Side. Returns the Number of Bytes read. */
+    size_t
+    read(void * const p_buffer, const size_t p_length) {
+        const uint32_t readIdx  = m_readIdx.load(std::memory_order_relaxed);
+        const uint32_t writeIdx = m_writeIdx.load(std::memory_order_acquire);
+        const size_t   length   = (p_length < (writeIdx - readIdx)) ? p_length : (writeIdx - readIdx);
+        const size_t   offset   = readIdx % nBufferSz;
+        const size_t   first    = ((offset + length) <= nBufferSz) ? length : (nBufferSz - offset);
+
+        ::memcpy(p_buffer, &m_buffer[offset], first);
+        ::memcpy(static_cast<uint8_t *>(p_buffer) + first, &m_buffer[0], length - first);
+
+        m_readIdx.store(readIdx + length, std::memory_order_release);
+        return length;
+    }
+};
+
+/***************************************************************************//**
+ * @brief Bulk OUT Application that queues received Data for a FreeRTOS Task.
+ *
+ * The USB Interrupt only copies each Packet into a lock-free Ring (see
+ * ::usb::SpscByteRingT) and wakes up the Reader, so the Time spent in the
+ * Interrupt is bounded no matter how slow the Consumer is.
+ *
+ * As soon as the Ring cannot take two more full Packets, the OUT Endpoint is
+ * NAK'ed. One Packet of Headroom is not enough: The Core may already have
+ * accepted the next Packet into its RX FIFO before the NAK takes effect, and
+ * that Packet is delivered after the NAK was set. The Host then retries until
+ * the Reader has drained the Ring to half its Size, at which Point the Endpoint
+ * is re-armed. No Data is dropped.
+ *
+ * Only a single Task may call read().
+ *
+ * The USB Interrupt must run at or below \c configMAX_SYSCALL_INTERRUPT_PRIORITY
+ * as it uses the FreeRTOS \c FromISR API.
+ *
+ * @tparam OutFlowControlT NAK Control of the OUT Endpoint, e.g.
+ *   ::stm32::usb::OutEndpointNakViaSTM32F4.
+ * @tparam nBufferSz Size of the Ring in Bytes, must be a Power of Two.
+ * @tparam nPacketSz Max. Packet Size of the Bulk OUT Endpoint.
+ ******************************************************************************/
+template<typename OutFlowControlT, size_t nBufferSz, size_t nPacketSz = 64>
+class UsbBulkOutStreamT : public UsbBulkOutApplication {
+    static_assert(nBufferSz >= (4 * nPacketSz), "Ring must hold at least four Packets");
+
+    /** @brief Free Space at which a NAK'ed Endpoint is re-armed. */
+    static constexpr size_t m_resumeThreshold = nBufferSz / 2;
+
+    SpscByteRingT<nBufferSz>    m_ring;
+    const OutFlowControlT &     m_outFlowControl;
+    std::atomic<TaskHandle_t>   m_reader;
+    volatile bool               m_outNaked;
+    unsigned                    m_dropped;
+
+    void
+    resume(void) {
+        if (!m_outNaked || (m_ring.getFree() < m_resumeThreshold)) {
+            return;
+        }
+
+        taskENTER_CRITICAL();
+        if (m_outNaked) {
+            m_outNaked = false;
+            m_outFlowControl.clearNak();
+        }
+        taskEXIT_CRITICAL();
+    }
+
+public:
+    UsbBulkOutStreamT(const OutFlowControlT &p_outFlowControl)
+      : m_outFlowControl(p_outFlowControl), m_reader(nullptr), m_outNaked(false), m_dropped(0) {
+
+    }
+
+    void
+    packetReceived(const void * const p_data, const size_t p_length) override {
+        if (m_ring.write(p_data, p_length) != p_length) {
+            /* Can only happen if the Host ignored the NAK, e.g. after a Bus Reset */
+            m_dropped++;
+        }
+
+        /* Room for one more Packet that may already be in the RX FIFO */
+        if (m_ring.getFree() < (2 * nPacketSz)) {
+            m_outFlowControl.setNak();
+            m_outNaked = true;
+        }
+
+        const TaskHandle_t reader = m_reader.load(std::memory_order_acquire);
+        if (reader != nullptr) {
+            BaseType_t woken = pdFALSE;
+            vTaskNotifyGiveFromISR(reader, &woken);
+            portYIELD_FROM_ISR(woken);
+        }
+    }
+
+    /**
+     * @brief Read up to \p p_length Bytes from the Stream.
+     *
+     * Blocks until at least one Byte is available or the Timeout expires.
+     *
+     * @param p_buffer Destination Buffer.
+     * @param p_length Size of the Destination Buffer.
+     * @param p_timeout Max. Time to wait in Ticks; \c portMAX_DELAY waits forever.
+     *
+     * @return Number of Bytes read, zero if the Timeout expired.
+     */
+    size_t
+    read(void * const p_buffer, const size_t p_length, TickType_t p_timeout = portMAX_DELAY) {
+        TimeOut_t timeOut;
+        size_t length;
+
+        m_reader.store(xTaskGetCurrentTaskHandle(), std::memory_order_release);
+        vTaskSetTimeOutState(&timeOut);
+
+        while ((length = m_ring.read(p_buffer, p_length)) == 0) {
+            resume();
+
+            if (xTaskCheckForTimeOut(&timeOut, &p_timeout) != pdFALSE) {
+                break;
+            }
+            ulTaskNotifyTake(pdTRUE, p_timeout);
+        }
+
+        resume();
+        return length;
+    }
+
+    size_t
+    getAvailable(void) const {
+        return m_ring.getUsed();
+    }
+
+    unsigned
+    getDropped(void) const {
+        return m_dropped;
+    }
+};
+
+} /* namespace usb */
+
+#endif /* _USB_BULK_OUT_STREAM_HPP_B7D40E96_ */
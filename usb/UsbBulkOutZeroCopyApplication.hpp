@@ -0,0 +1,45 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _USB_BULK_OUT_ZERO_COPY_APPLICATION_HPP_91C4E2B6_
+#define _USB_BULK_OUT_ZERO_COPY_APPLICATION_HPP_91C4E2B6_
+
+#include <usb/UsbApplication.hpp>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace usb {
+
+/***************************************************************************//**
+ * @brief Interface for Bulk OUT Applications that lend their own Buffers.
+ *
+ * Before a Packet arrives, the Endpoint asks the Application for the Buffer the
+ * Packet shall land in via lendOutBuffer(). The Endpoint owns the Buffer until
+ * it hands it back via packetReceived(), i.e. \c p_data then points into the
+ * lent Buffer and the Application does not need to copy the Data again.
+ *
+ * A lent Buffer must be 4-Byte aligned and hold one max. sized Packet.
+ *
+ * Since the Interface extends ::usb::UsbBulkOutApplication, an Application can
+ * also be used with a regular (copying) OUT Endpoint. It should then check
+ * whether \c p_data already points to where the Data belongs.
+ ******************************************************************************/
+class UsbBulkOutZeroCopyApplication : public UsbBulkOutApplication {
+public:
+    /**
+     * @brief Provide the Buffer for the next OUT Packet.
+     *
+     * @return Buffer for one Packet or \c nullptr if the Application has no
+     *   Space left. In the latter Case, the Endpoint is NAK'ed until the
+     *   Application calls \c clearNak() on it.
+     */
+    virtual void * lendOutBuffer(void) = 0;
+
+protected:
+    ~UsbBulkOutZeroCopyApplication() = default;
+};
+
+} /* namespace usb */
+
+#endif /* _USB_BULK_OUT_ZERO_COPY_APPLICATION_HPP_91C4E2B6_ */
@@ -0,0 +1,231 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _USB_CDC_LINE_CODING_HPP_7B25E9D1_
+#define _USB_CDC_LINE_CODING_HPP_7B25E9D1_
+
+#include <usb/UsbTypes.hpp>
+#include <usb/UsbInterface.hpp>
+#include <usb/UsbControlPipe.hpp>
+#include <usb/UsbCdcSerialState.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace usb {
+
+/***************************************************************************//**
+ * @brief CDC PSTN Class-specific Requests (see CDC PSTN Spec, Table 13).
+ ******************************************************************************/
+typedef enum UsbCdcRequest_e : uint8_t {
+    e_UsbCdcRequest_SetLineCoding           = 0x20,
+    e_UsbCdcRequest_GetLineCoding           = 0x21,
+    e_UsbCdcRequest_SetControlLineState     = 0x22,
+    e_UsbCdcRequest_SendBreak               = 0x23
+} UsbCdcRequest_t;
+
+/***************************************************************************//**
+ * @brief CDC Line Coding Structure (see CDC PSTN Spec, Table 17).
+ ******************************************************************************/
+typedef struct UsbCdcLineCoding_s {
+    uint8_t     m_dwDTERate[4];     /**< Data Terminal Rate in Bits/s, Little Endian. */
+    uint8_t     m_bCharFormat;      /**< 0 - 1 Stop Bit; 1 - 1.5 Stop Bits; 2 - 2 Stop Bits */
+    uint8_t     m_bParityType;      /**< 0 - None; 1 - Odd; 2 - Even; 3 - Mark; 4 - Space */
+    uint8_t     m_bDataBits;        /**< 5, 6, 7, 8 or 16 */
+
+    constexpr uint32_t
+    getBaudRate(void) const {
+        return (m_dwDTERate[0] <<  0)
+          | (m_dwDTERate[1] <<  8)
+          | (m_dwDTERate[2] << 16)
+          | (m_dwDTERate[3] << 24);
+    }
+
+    void
+    setBaudRate(const uint32_t p_baudRate) {
+        m_dwDTERate[0] = (p_baudRate >>  0) & 0xFF;
+        m_dwDTERate[1] = (p_baudRate >>  8) & 0xFF;
+        m_dwDTERate[2] = (p_baudRate >> 16) & 0xFF;
+        m_dwDTERate[3] = (p_baudRate >> 24) & 0xFF;
+    }
+} __attribute__((packed)) UsbCdcLineCoding_t;
+
+static_assert(sizeof(UsbCdcLineCoding_t) == 7, "CDC Line Coding Structure must be 7 Bytes");
+
+/***************************************************************************//**
+ * @brief Virtual COM Port Interface that lets the Host set the UART Baud Rate.
+ *
+ * Extends ::usb::UsbVcpInterface by the CDC \c SET_LINE_CODING and
+ * \c GET_LINE_CODING Requests. The UART Driver is always operated in 8N1 Mode,
+ * so only the Baud Rate can be changed.
+ *
+ * Line Codings other than 8N1 and Baud Rates that the UART Driver does not
+ * support are rejected with a STALL and the previous Setting is kept.
+ *
+ * Data from the Host may still be on its Way out of the UART when
+ * \c SET_LINE_CODING arrives. The Transmit Path is therefore paused and the
+ * new Baud Rate is only applied once it has been drained. handleUartTxIrq()
+ * must be called from the UART and UART Tx DMA Interrupts for that.
+ *
+ * If a ::usb::UsbCdcSerialState is attached via setSerialState(), the current
+ * \c SERIAL_STATE is sent again whenever the Host opens or closes the Port via
+ * \c SET_CONTROL_LINE_STATE.
+ *
+ * @tparam UartT UART Driver, e.g. \c stm32::Uart::Usart6.
+ * @tparam UartTxT Transmit Path of the UART, e.g. ::usb::UsbUartDmaApplicationT.
+ ******************************************************************************/
+template<typename UartT, typename UartTxT>
+class UsbVcpLineCodingInterfaceT : public UsbVcpInterface {
+    typedef typename UartT::BaudRate_e BaudRate_t;
+
+    struct BaudRateMap_s {
+        uint32_t    m_baudRate;
+        BaudRate_t  m_uartBaudRate;
+    };
+
+    static constexpr BaudRateMap_s m_baudRates[] = {
+        {   9600, BaudRate_t::e_9600    },
+        {  19200, BaudRate_t::e_19200   },
+        {  38400, BaudRate_t::e_38400   },
+        {  57600, BaudRate_t::e_57600   },
+        { 115200, BaudRate_t::e_115200  },
+        { 230400, BaudRate_t::e_230400  },
+        { 460800, BaudRate_t::e_460800  },
+        { 921600, BaudRate_t::e_921600  },
+    };
+
+    UartT &             m_uart;
+    UartTxT &           m_uartTx;
+    UsbCdcLineCoding_t  m_lineCoding;
+    UsbCdcLineCoding_t  m_dataStage;
+    UsbCdcSerialState * m_serialState;
+    const BaudRateMap_s * m_pendingBaudRate;
+
+    static const BaudRateMap_s *
+    findBaudRate(const UsbCdcLineCoding_t &p_lineCoding) {
+        if ((p_lineCoding.m_bCharFormat != 0) || (p_lineCoding.m_bParityType != 0) || (p_lineCoding.m_bDataBits != 8)) {
+            return nullptr;
+        }
+
+        for (const auto &entry : m_baudRates) {
+            if (entry.m_baudRate == p_lineCoding.getBaudRate()) {
+                return &entry;
+            }
+        }
+
+        return nullptr;
+    }
+
+    void
+    applyPendingBaudRate(void) {
+        if ((m_pendingBaudRate == nullptr) || !m_uartTx.isDrained()) {
+            return;
+        }
+
+        m_uart.setBaudRate(m_pendingBaudRate->m_uartBaudRate);
+        m_pendingBaudRate = nullptr;
+
+        m_uartTx.resume();
+    }
+
+public:
+    template<typename UsbBulkOutEndpointT, typename UsbBulkInEndpointT>
+    UsbVcpLineCodingInterfaceT(UartT &p_uart, UartTxT &p_uartTx, const uint32_t p_baudRate, UsbBulkOutEndpointT &p_outEndpoint, UsbBulkInEndpointT &p_inEndpoint)
+      : UsbVcpInterface(p_outEndpoint, p_inEndpoint), m_uart(p_uart), m_uartTx(p_uartTx),
+        m_lineCoding { { 0, 0, 0, 0 }, 0, 0, 8 }, m_dataStage {}, m_serialState(nullptr), m_pendingBaudRate(nullptr) {
+        m_lineCoding.setBaudRate(p_baudRate);
+    }
+
+    /**
+     * @brief Apply the initial Line Coding to the UART.
+     *
+     * Must be called before the Transmit Path is started.
+     *
+     * @return \c false if the Baud Rate passed to the Constructor is not supported.
+     */
+    bool
+    start(void) {
+        const BaudRateMap_s * const baudRate = findBaudRate(m_lineCoding);
+
+        if (baudRate == nullptr) {
+            return false;
+        }
+
+        m_uart.setBaudRate(baudRate->m_uartBaudRate);
+
+        return true;
+    }
+
+    /** @brief Apply a pending Baud Rate once the Transmit Path has been drained. */
+    void
+    handleUartTxIrq(void) {
+        applyPendingBaudRate();
+    }
+
+    const UsbCdcLineCoding_t &
+    getLineCoding(void) const {
+        return m_lineCoding;
+    }
+
+    void
+    setSerialState(UsbCdcSerialState &p_serialState) {
+        m_serialState = &p_serialState;
+    }
+
+    void
+    handleCtrlRequest(const UsbSetupPacket_t &p_setupPacket, UsbControlPipe &p_ctrlPipe) override {
+        switch (p_setupPacket.m_bRequest) {
+        case e_UsbCdcRequest_GetLineCoding:
+            p_ctrlPipe.write(reinterpret_cast<const uint8_t *>(&m_lineCoding),
+              (p_setupPacket.m_wLength < sizeof(m_lineCoding)) ? p_setupPacket.m_wLength : sizeof(m_lineCoding));
+            break;
+        case e_UsbCdcRequest_SetLineCoding:
+            if (p_setupPacket.m_wLength != sizeof(m_dataStage)) {
+                p_ctrlPipe.stall();
+                break;
+            }
+            p_ctrlPipe.expectDataStage(reinterpret_cast<uint8_t *>(&m_dataStage), sizeof(m_dataStage));
+            break;
+        case e_UsbCdcRequest_SetControlLineState:
+            if (m_serialState != nullptr) {
+                m_serialState->requestUpdate();
+            }
+            UsbVcpInterface::handleCtrlRequest(p_setupPacket, p_ctrlPipe);
+            break;
+        default:
+            UsbVcpInterface::handleCtrlRequest(p_setupPacket, p_ctrlPipe);
+            break;
+        }
+    }
+
+    void
+    handleCtrlDataStage(const UsbSetupPacket_t &p_setupPacket, const size_t p_length, UsbControlPipe &p_ctrlPipe) override {
+        if (p_setupPacket.m_bRequest != e_UsbCdcRequest_SetLineCoding) {
+            UsbVcpInterface::handleCtrlDataStage(p_setupPacket, p_length, p_ctrlPipe);
+            return;
+        }
+
+        const BaudRateMap_s * const baudRate = (p_length == sizeof(m_dataStage)) ? findBaudRate(m_dataStage) : nullptr;
+
+        if (baudRate == nullptr) {
+            p_ctrlPipe.stall();
+            return;
+        }
+
+        m_lineCoding = m_dataStage;
+        if (m_pendingBaudRate == nullptr) {
+            m_uartTx.pause();
+        }
+        m_pendingBaudRate = baudRate;
+        applyPendingBaudRate();
+
+        p_ctrlPipe.write(nullptr, 0); /* Status Stage */
+    }
+};
+
+} /* namespace usb */
+
+#endif /* _USB_CDC_LINE_CODING_HPP_7B25E9D1_ */
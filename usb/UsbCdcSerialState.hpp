@@ -0,0 +1,177 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _USB_CDC_SERIAL_STATE_HPP_A43E07D2_
+#define _USB_CDC_SERIAL_STATE_HPP_A43E07D2_
+
+#include <cstddef>
+#include <cstdint>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace usb {
+
+/***************************************************************************//**
+ * @brief CDC PSTN Notifications (see CDC PSTN Spec, Table 30).
+ ******************************************************************************/
+typedef enum UsbCdcNotification_e : uint8_t {
+    e_UsbCdcNotification_SerialState        = 0x20
+} UsbCdcNotification_t;
+
+/***************************************************************************//**
+ * @brief Bits of the CDC \c SERIAL_STATE Bitmap (see CDC PSTN Spec, Table 31).
+ *
+ * DCD and DSR report the current Level of the Line. All other Bits are
+ * irregular Events; they are set in a single Notification and cleared again.
+ ******************************************************************************/
+typedef enum UsbCdcSerialState_e : uint16_t {
+    e_UsbCdcSerialState_RxCarrier           = (1u << 0),    /**< DCD */
+    e_UsbCdcSerialState_TxCarrier           = (1u << 1),    /**< DSR */
+    e_UsbCdcSerialState_Break               = (1u << 2),
+    e_UsbCdcSerialState_RingSignal          = (1u << 3),
+    e_UsbCdcSerialState_Framing             = (1u << 4),
+    e_UsbCdcSerialState_Parity              = (1u << 5),
+    e_UsbCdcSerialState_OverRun             = (1u << 6)
+} UsbCdcSerialState_t;
+
+/***************************************************************************//**
+ * @brief CDC \c SERIAL_STATE Notification as sent on the Interrupt IN Endpoint.
+ ******************************************************************************/
+typedef struct UsbCdcSerialStateNotification_s {
+    uint8_t     m_bmRequestType;    /**< \c 0xA1: Device to Host, Class, Interface */
+    uint8_t     m_bNotification;
+    uint8_t     m_wValue[2];
+    uint8_t     m_wIndex[2];        /**< Communication Class Interface */
+    uint8_t     m_wLength[2];
+    uint8_t     m_bmUartState[2];
+} __attribute__((packed)) UsbCdcSerialStateNotification_t;
+
+static_assert(sizeof(UsbCdcSerialStateNotification_t) == 10, "CDC SERIAL_STATE Notification must be 10 Bytes");
+
+/***************************************************************************//**
+ * @brief State of a Virtual COM Port's UART as reported to the Host.
+ *
+ * Collects Line State Changes and UART Errors until they are sent by
+ * ::usb::UsbCdcSerialStateNotifierT. Events that are reported several Times
+ * before the next Notification are merged into one Bit.
+ *
+ * All Methods must be called from Contexts that do not preempt each other,
+ * e.g. the UART and the USB Interrupt at the same Priority.
+ ******************************************************************************/
+class UsbCdcSerialState {
+public:
+    static constexpr uint16_t m_lineStateMask = e_UsbCdcSerialState_RxCarrier | e_UsbCdcSerialState_TxCarrier;
+
+protected:
+    uint16_t    m_lineState;
+    uint16_t    m_sentLineState;
+    uint16_t    m_events;
+    bool        m_updateRequested;
+
+    constexpr UsbCdcSerialState(void)
+      : m_lineState(0), m_sentLineState(0), m_events(0), m_updateRequested(true) {
+
+    }
+
+    ~UsbCdcSerialState() = default;
+
+    bool
+    isPending(void) const {
+        return m_updateRequested || (m_events != 0) || (m_lineState != m_sentLineState);
+    }
+
+    /** @brief Bitmap for the next Notification; clears the irregular Bits. */
+    uint16_t
+    takeUartState(void) {
+        const uint16_t uartState = m_lineState | m_events;
+
+        m_sentLineState     = m_lineState;
+        m_events            = 0;
+        m_updateRequested   = false;
+
+        return uartState;
+    }
+
+public:
+    /** @brief Set the Level of DCD and DSR, see ::usb::UsbCdcSerialState_e. */
+    void
+    setLineState(const uint16_t p_lineState) {
+        m_lineState = p_lineState & m_lineStateMask;
+    }
+
+    uint16_t
+    getLineState(void) const {
+        return m_lineState;
+    }
+
+    /** @brief Report irregular Events, e.g. \c e_UsbCdcSerialState_OverRun. */
+    void
+    reportEvents(const uint16_t p_events) {
+        m_events |= (p_events & ~m_lineStateMask);
+    }
+
+    /** @brief Send the current State even if it has not changed, e.g. when the Host opens the Port. */
+    void
+    requestUpdate(void) {
+        m_updateRequested = true;
+    }
+};
+
+/***************************************************************************//**
+ * @brief Sends CDC \c SERIAL_STATE Notifications on an Interrupt IN Endpoint.
+ *
+ * handleSof() sends at most one Notification per Polling Interval of the
+ * Endpoint, and only if the State has changed or an Event was reported. A
+ * Burst of UART Errors therefore results in a single Notification. If the Host
+ * has not yet taken the previous Notification, the new one is held back.
+ *
+ * @tparam InterruptInEndpointT Interrupt IN Endpoint, e.g.
+ *   ::stm32::usb::InterruptInEndpointViaSTM32F4.
+ ******************************************************************************/
+template<typename InterruptInEndpointT>
+class UsbCdcSerialStateNotifierT : public UsbCdcSerialState {
+    InterruptInEndpointT &  m_endpoint;
+    const uint16_t          m_interface;
+    const unsigned          m_intervalInFrames;
+    unsigned                m_framesSinceSent;
+
+public:
+    /**
+     * @param p_endpoint Interrupt IN Endpoint of the Communication Class Interface.
+     * @param p_interface Number of the Communication Class Interface.
+     * @param p_intervalInFrames \c bInterval of the Endpoint.
+     */
+    constexpr UsbCdcSerialStateNotifierT(InterruptInEndpointT &p_endpoint, const uint16_t p_interface, const unsigned p_intervalInFrames)
+      : m_endpoint(p_endpoint), m_interface(p_interface), m_intervalInFrames(p_intervalInFrames), m_framesSinceSent(p_intervalInFrames) {
+
+    }
+
+    void
+    handleSof(void) {
+        if (m_framesSinceSent < m_intervalInFrames) {
+            m_framesSinceSent++;
+        }
+
+        if (!isPending() || (m_framesSinceSent < m_intervalInFrames) || !m_endpoint.isReady()) {
+            return;
+        }
+
+        const uint16_t uartState = takeUartState();
+        const UsbCdcSerialStateNotification_t notification = {
+            .m_bmRequestType    = 0xA1,
+            .m_bNotification    = e_UsbCdcNotification_SerialState,
+            .m_wValue           = { 0, 0 },
+            .m_wIndex           = { static_cast<uint8_t>(m_interface & 0xFF), static_cast<uint8_t>(m_interface >> 8) },
+            .m_wLength          = { 2, 0 },
+            .m_bmUartState      = { static_cast<uint8_t>(uartState & 0xFF), static_cast<uint8_t>(uartState >> 8) }
+        };
+
+        m_endpoint.write(&notification, sizeof(notification));
+        m_framesSinceSent = 0;
+    }
+};
+
+} /* namespace usb */
+
+#endif /* _USB_CDC_SERIAL_STATE_HPP_A43E07D2_ */
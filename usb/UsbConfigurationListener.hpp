@@ -0,0 +1,112 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _USB_CONFIGURATION_LISTENER_HPP_D05A7C38_
+#define _USB_CONFIGURATION_LISTENER_HPP_D05A7C38_
+
+#include <usb/UsbTypes.hpp>
+#include <usb/UsbControlPipe.hpp>
+
+#include <cstdint>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace usb {
+
+/***************************************************************************//**
+ * @brief Interface for Objects that follow the Configuration of the Device,
+ *   e.g. Endpoints that are not known to the Core's Endpoint Drivers.
+ *
+ * setConfiguration() is called from the Control Pipe, i.e. from the OTG
+ * Interrupt Handler, each Time the Host sends \c SET_CONFIGURATION, incl.
+ * for a Configuration that is already set.
+ ******************************************************************************/
+class UsbConfigurationListener {
+public:
+    /** @param p_configuration \c bConfigurationValue, zero if the Device is unconfigured. */
+    virtual void setConfiguration(const uint8_t p_configuration) = 0;
+
+protected:
+    ~UsbConfigurationListener() = default;
+};
+
+/***************************************************************************//**
+ * @brief Endpoint that is activated when the Device is configured and
+ *   deactivated when it is unconfigured.
+ *
+ * Re-configuring the Device activates the Endpoint again, which resets it.
+ *
+ * @tparam EndpointT Endpoint with \c activate() and \c deactivate(), e.g.
+ *   ::stm32::usb::InterruptInEndpointViaSTM32F4.
+ ******************************************************************************/
+template<typename EndpointT>
+class UsbEndpointConfigurationT : public UsbConfigurationListener {
+    EndpointT &     m_endpoint;
+
+public:
+    constexpr UsbEndpointConfigurationT(EndpointT &p_endpoint) : m_endpoint(p_endpoint) {
+
+    }
+
+    void
+    setConfiguration(const uint8_t p_configuration) override {
+        if (p_configuration != 0) {
+            m_endpoint.activate();
+        } else {
+            m_endpoint.deactivate();
+        }
+    }
+};
+
+/***************************************************************************//**
+ * @brief Passes \c SET_CONFIGURATION on to ::usb::UsbConfigurationListener
+ *   Objects.
+ *
+ * Like ::usb::UsbFunctionStringsDevice, this derives from \p DeviceT and takes
+ * the same Constructor Arguments. All Requests go to \p DeviceT unchanged.
+ * After \p DeviceT has handled \c SET_CONFIGURATION, the Listeners are called
+ * in the Order in which they were added.
+ *
+ * @tparam DeviceT Device Class, e.g. ::usb::UsbFunctionStringsDevice.
+ * @tparam nMaxListeners Max. Number of Listeners.
+ ******************************************************************************/
+template<typename DeviceT, unsigned nMaxListeners = 4>
+class UsbConfigurationListenerDeviceT : public DeviceT {
+    static constexpr uint8_t    m_requestSetConfiguration = 0x09;
+
+    UsbConfigurationListener *  m_listeners[nMaxListeners] = {};
+    unsigned                    m_numListeners = 0;
+
+public:
+    using DeviceT::DeviceT;
+
+    /** @return \c false if there are already \p nMaxListeners Listeners. */
+    bool
+    addConfigurationListener(UsbConfigurationListener &p_listener) {
+        if (m_numListeners >= nMaxListeners) {
+            return false;
+        }
+
+        m_listeners[m_numListeners++] = &p_listener;
+        return true;
+    }
+
+    void
+    handleCtrlRequest(const UsbSetupPacket_t &p_setupPacket, UsbControlPipe &p_ctrlPipe) override {
+        DeviceT::handleCtrlRequest(p_setupPacket, p_ctrlPipe);
+
+        /* Standard Request, Host to Device, Recipient Device */
+        if ((static_cast<uint8_t>(p_setupPacket.m_bmRequestType) != 0x00) || (p_setupPacket.m_bRequest != m_requestSetConfiguration)) {
+            return;
+        }
+
+        for (unsigned idx = 0; idx < m_numListeners; idx++) {
+            m_listeners[idx]->setConfiguration(p_setupPacket.m_wValue & 0xFF);
+        }
+    }
+};
+
+} /* namespace usb */
+
+#endif /* _USB_CONFIGURATION_LISTENER_HPP_D05A7C38_ */
@@ -0,0 +1,557 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _USB_DESCRIPTOR_BUILDER_HPP_83E1F0C6_
+#define _USB_DESCRIPTOR_BUILDER_HPP_83E1F0C6_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace usb {
+    namespace descriptor {
+
+/***************************************************************************//**
+ * @brief Compile-time Builder for USB Configuration Descriptors.
+ *
+ * A Configuration is composed of Functions, e.g. a CDC ACM Function (IAD, two
+ * Interfaces, CDC Functional Descriptors and three Endpoints) or a
+ * Vendor-specific Function (one Interface, two Endpoints). The Builder numbers
+ * the Interfaces in the Order in which the Functions are passed. It also
+ * computes all Lengths, incl. \c wTotalLength, and fills in the
+ * Cross-References between Interfaces, e.g. in the CDC Union Descriptor.
+ *
+ * The Result is a \c std::array of Bytes that is computed entirely by the
+ * Compiler. It can be placed in Flash as-is, so it costs no Cycles and no
+ * RAM at Run Time.
+ *
+ * Example:
+ * \code
+ * static constexpr auto descr = ::usb::descriptor::configuration(
+ *     1, iConfiguration, 0xC0, 5,
+ *     ::usb::descriptor::CdcAcmFunction(iInterface, notificationEp, bulkOutEp, bulkInEp)
+ * );
+ * \endcode
+ *
+ * If the Firmware needs the Interface Numbers, the Functions are kept in a
+ * List (see functions()), from which both the Descriptor and the Numbers are
+ * derived (see getInterfaceNumber()).
+ ******************************************************************************/
+
+/***************************************************************************//**
+ * @brief Sequential Writer into a \c std::array, usable in \c constexpr Context.
+ ******************************************************************************/
+template<size_t nLength>
+class Writer {
+    std::array<uint8_t, nLength> &  m_data;
+    size_t                          m_pos;
+
+public:
+    constexpr Writer(std::array<uint8_t, nLength> &p_data) : m_data(p_data), m_pos(0) {
+
+    }
+
+    constexpr void
+    byte(const uint8_t p_byte) {
+        m_data[m_pos++] = p_byte;
+    }
+
+    constexpr void
+    word(const uint16_t p_word) {
+        byte(p_word & 0xFF);
+        byte(p_word >> 8);
+    }
+
+    constexpr size_t
+    position(void) const {
+        return m_pos;
+    }
+};
+
+/***************************************************************************//**
+ * @brief Endpoint Descriptor (see USB 2.0 Spec, Table 9-13).
+ ******************************************************************************/
+typedef struct Endpoint_s {
+    static constexpr size_t m_length = 7;
+
+    typedef enum TransferType_e : uint8_t {
+        e_Control       = 0,
+        e_Isochronous   = 1,
+        e_Bulk          = 2,
+        e_Interrupt     = 3
+    } TransferType_t;
+
+    uint8_t         m_bEndpointAddress;
+    TransferType_t  m_bmAttributes;
+    uint16_t        m_wMaxPacketSize;
+    uint8_t         m_bInterval;
+
+    constexpr unsigned
+    getNumber(void) const {
+        return m_bEndpointAddress & 0x0F;
+    }
+
+    constexpr bool
+    isIn(void) const {
+        return (m_bEndpointAddress & 0x80) != 0;
+    }
+
+    /**
+     * @brief Check the Max. Packet Size and the Interval against the Limits of
+     *   a Full Speed Device (see USB 2.0 Spec, Sections 5.5 - 5.8 and 9.6.6).
+     */
+    constexpr bool
+    isValid(void) const {
+        switch (m_bmAttributes) {
+        case e_Control:
+            return (m_wMaxPacketSize == 8) || (m_wMaxPacketSize == 16) || (m_wMaxPacketSize == 32) || (m_wMaxPacketSize == 64);
+        case e_Bulk:
+            return (m_wMaxPacketSize == 8) || (m_wMaxPacketSize == 16) || (m_wMaxPacketSize == 32) || (m_wMaxPacketSize == 64);
+        case e_Interrupt:
+            return (m_wMaxPacketSize <= 64) && (m_bInterval >= 1);
+        case e_Isochronous:
+            return (m_wMaxPacketSize <= 1023) && (m_bInterval >= 1) && (m_bInterval <= 16);
+        }
+
+        return false;
+    }
+
+    template<typename WriterT>
+    constexpr void
+    render(WriterT &p_writer) const {
+        p_writer.byte(m_length);
+        p_writer.byte(0x05);                /* ENDPOINT */
+        p_writer.byte(m_bEndpointAddress);
+        p_writer.byte(m_bmAttributes);
+        p_writer.word(m_wMaxPacketSize);
+        p_writer.byte(m_bInterval);
+    }
+} Endpoint_t;
+
+constexpr Endpoint_t
+bulkOut(const unsigned p_number, const uint16_t p_maxPacketSize = 64) {
+    return { static_cast<uint8_t>(p_number & 0x0F), Endpoint_t::e_Bulk, p_maxPacketSize, 0 };
+}
+
+constexpr Endpoint_t
+bulkIn(const unsigned p_number, const uint16_t p_maxPacketSize = 64) {
+    return { static_cast<uint8_t>(0x80 | (p_number & 0x0F)), Endpoint_t::e_Bulk, p_maxPacketSize, 0 };
+}
+
+constexpr Endpoint_t
+interruptIn(const unsigned p_number, const uint16_t p_maxPacketSize, const uint8_t p_interval) {
+    return { static_cast<uint8_t>(0x80 | (p_number & 0x0F)), Endpoint_t::e_Interrupt, p_maxPacketSize, p_interval };
+}
+
+/**
+ * @brief Isochronous Endpoint (asynchronous, Data Endpoint).
+ *
+ * At Full Speed, \p p_interval is the Exponent of the Period, i.e. the
+ * Endpoint is serviced every 2^(p_interval - 1) Frames. \p p_maxPacketSize may
+ * be up to 1023 Bytes.
+ */
+constexpr Endpoint_t
+isochronousOut(const unsigned p_number, const uint16_t p_maxPacketSize, const uint8_t p_interval = 1) {
+    return { static_cast<uint8_t>(p_number & 0x0F), Endpoint_t::e_Isochronous, p_maxPacketSize, p_interval };
+}
+
+constexpr Endpoint_t
+isochronousIn(const unsigned p_number, const uint16_t p_maxPacketSize, const uint8_t p_interval = 1) {
+    return { static_cast<uint8_t>(0x80 | (p_number & 0x0F)), Endpoint_t::e_Isochronous, p_maxPacketSize, p_interval };
+}
+
+/***************************************************************************//**
+ * @brief Interface Descriptor (see USB 2.0 Spec, Table 9-12).
+ ******************************************************************************/
+template<typename WriterT>
+constexpr void
+renderInterface(WriterT &p_writer, const uint8_t p_number, const uint8_t p_numEndpoints,
+  const uint8_t p_class, const uint8_t p_subClass, const uint8_t p_protocol, const uint8_t p_iInterface,
+  const uint8_t p_alternateSetting = 0) {
+    p_writer.byte(9);
+    p_writer.byte(0x04);                    /* INTERFACE */
+    p_writer.byte(p_number);
+    p_writer.byte(p_alternateSetting);
+    p_writer.byte(p_numEndpoints);
+    p_writer.byte(p_class);
+    p_writer.byte(p_subClass);
+    p_writer.byte(p_protocol);
+    p_writer.byte(p_iInterface);
+}
+
+/***************************************************************************//**
+ * @brief CDC Abstract Control Model Function, i.e. a Virtual COM Port.
+ *
+ * Consists of an Interface Association Descriptor, the Communication Interface
+ * with its Functional Descriptors and Notification Endpoint, and the Data
+ * Interface with a Bulk OUT / Bulk IN Endpoint Pair.
+ ******************************************************************************/
+class CdcAcmFunction {
+    const uint8_t       m_iFunction;
+    const Endpoint_t    m_notificationEndpoint;
+    const Endpoint_t    m_dataOutEndpoint;
+    const Endpoint_t    m_dataInEndpoint;
+
+public:
+    static constexpr unsigned   m_numInterfaces = 2;
+    static constexpr unsigned   m_numEndpoints  = 3;
+    static constexpr size_t     m_length        = 8         /* IAD */
+                                                + 9         /* Communication Interface */
+                                                + 5 + 5 + 4 + 5 /* Header, Call Mgmt., ACM, Union */
+                                                + Endpoint_t::m_length
+                                                + 9         /* Data Interface */
+                                                + 2 * Endpoint_t::m_length;
+
+    constexpr CdcAcmFunction(const uint8_t p_iFunction, const Endpoint_t &p_notificationEndpoint,
+      const Endpoint_t &p_dataOutEndpoint, const Endpoint_t &p_dataInEndpoint)
+      : m_iFunction(p_iFunction), m_notificationEndpoint(p_notificationEndpoint),
+        m_dataOutEndpoint(p_dataOutEndpoint), m_dataInEndpoint(p_dataInEndpoint) {
+
+    }
+
+    constexpr Endpoint_t
+    getEndpoint(const unsigned p_idx) const {
+        return (p_idx == 0) ? m_notificationEndpoint : ((p_idx == 1) ? m_dataOutEndpoint : m_dataInEndpoint);
+    }
+
+    template<typename WriterT>
+    constexpr void
+    render(WriterT &p_writer, const uint8_t p_firstInterface) const {
+        const uint8_t commInterface = p_firstInterface;
+        const uint8_t dataInterface = p_firstInterface + 1;
+
+        /* Interface Association Descriptor */
+        p_writer.byte(8);
+        p_writer.byte(0x0B);
+        p_writer.byte(commInterface);
+        p_writer.byte(m_numInterfaces);
+        p_writer.byte(0x02);                /* Communication Device Class */
+        p_writer.byte(0x02);                /* Abstract Control Model */
+        p_writer.byte(0x01);                /* AT Commands: V.250 */
+        p_writer.byte(m_iFunction);
+
+        renderInterface(p_writer, commInterface, 1, 0x02, 0x02, 0x01, m_iFunction);
+
+        /* Header Functional Descriptor, CDC 1.10 */
+        p_writer.byte(5);
+        p_writer.byte(0x24);
+        p_writer.byte(0x00);
+        p_writer.word(0x0110);
+
+        /* Call Management Functional Descriptor */
+        p_writer.byte(5);
+        p_writer.byte(0x24);
+        p_writer.byte(0x01);
+        p_writer.byte(0x00);                /* bmCapabilities */
+        p_writer.byte(dataInterface);
+
+        /* Abstract Control Management Functional Descriptor */
+        p_writer.byte(4);
+        p_writer.byte(0x24);
+        p_writer.byte(0x02);
+        p_writer.byte(0x02);                /* bmCapabilities: Line Coding and Serial State */
+
+        /* Union Functional Descriptor */
+        p_writer.byte(5);
+        p_writer.byte(0x24);
+        p_writer.byte(0x06);
+        p_writer.byte(commInterface);
+        p_writer.byte(dataInterface);
+
+        m_notificationEndpoint.render(p_writer);
+
+        renderInterface(p_writer, dataInterface, 2, 0x0A, 0x00, 0x00, m_iFunction);
+        m_dataOutEndpoint.render(p_writer);
+        m_dataInEndpoint.render(p_writer);
+    }
+};
+
+/***************************************************************************//**
+ * @brief Vendor-specific Function with an OUT / IN Endpoint Pair.
+ *
+ * The Interface has a single Alternate Setting, so this is meant for Bulk and
+ * Interrupt Endpoints. Isochronous Endpoints go into VendorIsochronousFunction.
+ ******************************************************************************/
+class VendorFunction {
+    const uint8_t       m_iInterface;
+    const uint8_t       m_subClass;
+    const uint8_t       m_protocol;
+    const Endpoint_t    m_dataOutEndpoint;
+    const Endpoint_t    m_dataInEndpoint;
+
+public:
+    static constexpr unsigned   m_numInterfaces = 1;
+    static constexpr unsigned   m_numEndpoints  = 2;
+    static constexpr size_t     m_length        = 9 + 2 * Endpoint_t::m_length;
+
+    constexpr VendorFunction(const uint8_t p_iInterface, const uint8_t p_subClass, const uint8_t p_protocol,
+      const Endpoint_t &p_dataOutEndpoint, const Endpoint_t &p_dataInEndpoint)
+      : m_iInterface(p_iInterface), m_subClass(p_subClass), m_protocol(p_protocol),
+        m_dataOutEndpoint(p_dataOutEndpoint), m_dataInEndpoint(p_dataInEndpoint) {
+
+    }
+
+    constexpr Endpoint_t
+    getEndpoint(const unsigned p_idx) const {
+        return (p_idx == 0) ? m_dataOutEndpoint : m_dataInEndpoint;
+    }
+
+    template<typename WriterT>
+    constexpr void
+    render(WriterT &p_writer, const uint8_t p_firstInterface) const {
+        renderInterface(p_writer, p_firstInterface, 2, 0xFF, m_subClass, m_protocol, m_iInterface);
+        m_dataOutEndpoint.render(p_writer);
+        m_dataInEndpoint.render(p_writer);
+    }
+};
+
+/***************************************************************************//**
+ * @brief Vendor-specific Function with an Isochronous OUT / IN Endpoint Pair.
+ *
+ * The default Alternate Setting 0 has no Endpoints, so a configured Device does
+ * not take any Isochronous Bandwidth (see USB 2.0 Spec, Section 5.6.3). The
+ * Host selects Alternate Setting 1 via \c SET_INTERFACE to get the Endpoints.
+ ******************************************************************************/
+class VendorIsochronousFunction {
+    const uint8_t       m_iInterface;
+    const uint8_t       m_subClass;
+    const uint8_t       m_protocol;
+    const Endpoint_t    m_dataOutEndpoint;
+    const Endpoint_t    m_dataInEndpoint;
+
+public:
+    static constexpr unsigned   m_numInterfaces = 1;
+    static constexpr unsigned   m_numEndpoints  = 2;
+    static constexpr size_t     m_length        = 9 + 9 + 2 * Endpoint_t::m_length;
+
+    constexpr VendorIsochronousFunction(const uint8_t p_iInterface, const uint8_t p_subClass, const uint8_t p_protocol,
+      const Endpoint_t &p_dataOutEndpoint, const Endpoint_t &p_dataInEndpoint)
+      : m_iInterface(p_iInterface), m_subClass(p_subClass), m_protocol(p_protocol),
+        m_dataOutEndpoint(p_dataOutEndpoint), m_dataInEndpoint(p_dataInEndpoint) {
+
+    }
+
+    constexpr Endpoint_t
+    getEndpoint(const unsigned p_idx) const {
+        return (p_idx == 0) ? m_dataOutEndpoint : m_dataInEndpoint;
+    }
+
+    template<typename WriterT>
+    constexpr void
+    render(WriterT &p_writer, const uint8_t p_firstInterface) const {
+        renderInterface(p_writer, p_firstInterface, 0, 0xFF, m_subClass, m_protocol, m_iInterface, /* p_alternateSetting = */ 0);
+        renderInterface(p_writer, p_firstInterface, 2, 0xFF, m_subClass, m_protocol, m_iInterface, /* p_alternateSetting = */ 1);
+        m_dataOutEndpoint.render(p_writer);
+        m_dataInEndpoint.render(p_writer);
+    }
+};
+
+/***************************************************************************//**
+ * @brief Mass Storage Function: SCSI Transparent Command Set over the
+ *   Bulk-Only Transport, with a Bulk OUT / Bulk IN Endpoint Pair.
+ ******************************************************************************/
+class MassStorageFunction {
+    const uint8_t       m_iInterface;
+    const Endpoint_t    m_dataOutEndpoint;
+    const Endpoint_t    m_dataInEndpoint;
+
+public:
+    static constexpr unsigned   m_numInterfaces = 1;
+    static constexpr unsigned   m_numEndpoints  = 2;
+    static constexpr size_t     m_length        = 9 + 2 * Endpoint_t::m_length;
+
+    constexpr MassStorageFunction(const uint8_t p_iInterface, const Endpoint_t &p_dataOutEndpoint, const Endpoint_t &p_dataInEndpoint)
+      : m_iInterface(p_iInterface), m_dataOutEndpoint(p_dataOutEndpoint), m_dataInEndpoint(p_dataInEndpoint) {
+
+    }
+
+    constexpr Endpoint_t
+    getEndpoint(const unsigned p_idx) const {
+        return (p_idx == 0) ? m_dataOutEndpoint : m_dataInEndpoint;
+    }
+
+    template<typename WriterT>
+    constexpr void
+    render(WriterT &p_writer, const uint8_t p_firstInterface) const {
+        renderInterface(p_writer, p_firstInterface, 2, 0x08, 0x06, 0x50, m_iInterface); /* Mass Storage, SCSI, BOT */
+        m_dataOutEndpoint.render(p_writer);
+        m_dataInEndpoint.render(p_writer);
+    }
+};
+
+/***************************************************************************//**
+ * @brief Device Firmware Upgrade Function in DFU Mode, i.e. without Endpoints
+ *   and with the DFU Functional Descriptor (see USB DFU 1.1, Section 4.2).
+ *
+ * Download, Upload and Manifestation-tolerant; the Host neither needs to
+ * detach the Device nor to reset it afterwards.
+ ******************************************************************************/
+class DfuFunction {
+    const uint8_t       m_iInterface;
+    const uint16_t      m_transferSize;
+
+public:
+    static constexpr unsigned   m_numInterfaces = 1;
+    static constexpr unsigned   m_numEndpoints  = 0;
+    static constexpr size_t     m_length        = 9 + 9;
+
+    constexpr DfuFunction(const uint8_t p_iInterface, const uint16_t p_transferSize)
+      : m_iInterface(p_iInterface), m_transferSize(p_transferSize) {
+
+    }
+
+    constexpr Endpoint_t
+    getEndpoint(const unsigned /* p_idx */) const {
+        return {};
+    }
+
+    template<typename WriterT>
+    constexpr void
+    render(WriterT &p_writer, const uint8_t p_firstInterface) const {
+        renderInterface(p_writer, p_firstInterface, 0, 0xFE, 0x01, 0x02, m_iInterface); /* Application Specific, DFU, DFU Mode */
+
+        /* DFU Functional Descriptor */
+        p_writer.byte(9);
+        p_writer.byte(0x21);
+        p_writer.byte(0x07);                /* bmAttributes: Manifestation Tolerant, Upload, Download */
+        p_writer.word(255);                 /* wDetachTimeOut in ms; no Detach in DFU Mode */
+        p_writer.word(m_transferSize);
+        p_writer.word(0x0110);              /* bcdDFUVersion */
+    }
+};
+
+/***************************************************************************//**
+ * @brief Configuration Descriptor incl. all Functions.
+ ******************************************************************************/
+template<typename... FunctionsT>
+constexpr std::array<uint8_t, 9 + (FunctionsT::m_length + ...)>
+configuration(const uint8_t p_bConfigurationValue, const uint8_t p_iConfiguration,
+  const uint8_t p_bmAttributes, const uint8_t p_bMaxPower, const FunctionsT &... p_functions) {
+    constexpr size_t    totalLength     = 9 + (FunctionsT::m_length + ...);
+    constexpr unsigned  numInterfaces   = (FunctionsT::m_numInterfaces + ...);
+
+    static_assert(totalLength <= 0xFFFF, "Configuration Descriptor too long");
+    static_assert(numInterfaces <= 0xFF, "Too many Interfaces");
+
+    std::array<uint8_t, totalLength> data {};
+    Writer<totalLength> writer(data);
+
+    writer.byte(9);
+    writer.byte(0x02);                      /* CONFIGURATION */
+    writer.word(totalLength);
+    writer.byte(numInterfaces);
+    writer.byte(p_bConfigurationValue);
+    writer.byte(p_iConfiguration);
+    writer.byte(0x80 | p_bmAttributes);     /* USB 2.0 Spec demands Bit 7 to always be set */
+    writer.byte(p_bMaxPower);
+
+    uint8_t firstInterface = 0;
+    ((p_functions.render(writer, firstInterface), firstInterface += FunctionsT::m_numInterfaces), ...);
+
+    return data;
+}
+
+/***************************************************************************//**
+ * @brief List of the Functions of a Configuration, in the Order of their
+ *   Interfaces.
+ *
+ * The List refers to the Function Objects, so these must have static Storage.
+ ******************************************************************************/
+template<typename... FunctionsT>
+constexpr std::tuple<const FunctionsT &...>
+functions(const FunctionsT &... p_functions) {
+    return std::tuple<const FunctionsT &...>(p_functions...);
+}
+
+/***************************************************************************//**
+ * @brief Configuration Descriptor incl. all Functions of a List, see functions().
+ ******************************************************************************/
+template<typename... FunctionsT>
+constexpr auto
+configuration(const uint8_t p_bConfigurationValue, const uint8_t p_iConfiguration,
+  const uint8_t p_bmAttributes, const uint8_t p_bMaxPower, const std::tuple<const FunctionsT &...> &p_functions) {
+    return std::apply([&](const FunctionsT &... p_function) {
+        return configuration(p_bConfigurationValue, p_iConfiguration, p_bmAttributes, p_bMaxPower, p_function...);
+    }, p_functions);
+}
+
+template<typename FunctionT, typename OtherT>
+constexpr bool
+isSameFunction(const FunctionT & /* p_function */, const OtherT & /* p_other */) {
+    return false;
+}
+
+template<typename FunctionT>
+constexpr bool
+isSameFunction(const FunctionT &p_function, const FunctionT &p_other) {
+    return &p_function == &p_other;
+}
+
+/***************************************************************************//**
+ * @brief Number of the first Interface of \p p_function in the Configuration
+ *   built from \p p_functions, see configuration().
+ *
+ * @return \c 0xFF if \p p_function is not Part of the List.
+ ******************************************************************************/
+template<typename FunctionT, typename... FunctionsT>
+constexpr uint8_t
+getInterfaceNumber(const FunctionT &p_function, const std::tuple<const FunctionsT &...> &p_functions) {
+    return std::apply([&](const FunctionsT &... p_other) {
+        uint8_t number = 0xFF;
+        uint8_t firstInterface = 0;
+
+        ((number = isSameFunction(p_function, p_other) ? firstInterface : number, firstInterface += FunctionsT::m_numInterfaces), ...);
+
+        return number;
+    }, p_functions);
+}
+
+/***************************************************************************//**
+ * @brief Check that no Endpoint Address is used twice, that all Endpoints
+ *   exist on a Core with \p nNumEndpoints IN and OUT Endpoints and that their
+ *   Max. Packet Sizes and Intervals are valid, see Endpoint_t::isValid().
+ ******************************************************************************/
+template<unsigned nNumEndpoints, typename... FunctionsT>
+constexpr bool
+hasValidEndpoints(const FunctionsT &... p_functions) {
+    constexpr unsigned numEndpoints = (FunctionsT::m_numEndpoints + ...);
+    Endpoint_t endpoints[numEndpoints] {};
+    unsigned idx = 0;
+
+    ((void) [&] {
+        for (unsigned ep = 0; ep < FunctionsT::m_numEndpoints; ep++) {
+            endpoints[idx++] = p_functions.getEndpoint(ep);
+        }
+    }(), ...);
+
+    for (unsigned i = 0; i < numEndpoints; i++) {
+        if ((endpoints[i].getNumber() == 0) || (endpoints[i].getNumber() >= nNumEndpoints) || !endpoints[i].isValid()) {
+            return false;
+        }
+
+        for (unsigned j = i + 1; j < numEndpoints; j++) {
+            if (endpoints[i].m_bEndpointAddress == endpoints[j].m_bEndpointAddress) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+template<unsigned nNumEndpoints, typename... FunctionsT>
+constexpr bool
+hasValidEndpoints(const std::tuple<const FunctionsT &...> &p_functions) {
+    return std::apply([](const FunctionsT &... p_function) {
+        return hasValidEndpoints<nNumEndpoints>(p_function...);
+    }, p_functions);
+}
+
+    } /* namespace descriptor */
+} /* namespace usb */
+
+#endif /* _USB_DESCRIPTOR_BUILDER_HPP_83E1F0C6_ */
@@ -0,0 +1,453 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _USB_DFU_HPP_C83A1F56_
+#define _USB_DFU_HPP_C83A1F56_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace usb {
+
+/***************************************************************************//**
+ * @brief Class-specific Requests of the Device Firmware Upgrade Class, see
+ *   USB DFU 1.1, Table 3.2.
+ ******************************************************************************/
+typedef enum UsbDfuRequest_e : uint8_t {
+    e_UsbDfuRequest_Detach                  = 0x00,
+    e_UsbDfuRequest_Dnload                  = 0x01,
+    e_UsbDfuRequest_Upload                  = 0x02,
+    e_UsbDfuRequest_GetStatus               = 0x03,
+    e_UsbDfuRequest_ClrStatus               = 0x04,
+    e_UsbDfuRequest_GetState                = 0x05,
+    e_UsbDfuRequest_Abort                   = 0x06
+} UsbDfuRequest_t;
+
+/** @brief DFU States, see USB DFU 1.1, Section 6.1.2. */
+typedef enum UsbDfuState_e : uint8_t {
+    e_UsbDfuState_AppIdle                   = 0,
+    e_UsbDfuState_AppDetach                 = 1,
+    e_UsbDfuState_DfuIdle                   = 2,
+    e_UsbDfuState_DnloadSync                = 3,
+    e_UsbDfuState_DnBusy                    = 4,
+    e_UsbDfuState_DnloadIdle                = 5,
+    e_UsbDfuState_ManifestSync              = 6,
+    e_UsbDfuState_Manifest                  = 7,
+    e_UsbDfuState_ManifestWaitReset         = 8,
+    e_UsbDfuState_UploadIdle                = 9,
+    e_UsbDfuState_Error                     = 10
+} UsbDfuState_t;
+
+/** @brief DFU Status Codes, see USB DFU 1.1, Section 6.1.2. */
+typedef enum UsbDfuStatus_e : uint8_t {
+    e_UsbDfuStatus_Ok                       = 0x00,
+    e_UsbDfuStatus_ErrTarget                = 0x01,
+    e_UsbDfuStatus_ErrFile                  = 0x02,
+    e_UsbDfuStatus_ErrWrite                 = 0x03,
+    e_UsbDfuStatus_ErrErase                 = 0x04,
+    e_UsbDfuStatus_ErrCheckErased           = 0x05,
+    e_UsbDfuStatus_ErrProg                  = 0x06,
+    e_UsbDfuStatus_ErrVerify                = 0x07,
+    e_UsbDfuStatus_ErrAddress               = 0x08,
+    e_UsbDfuStatus_ErrNotDone               = 0x09,
+    e_UsbDfuStatus_ErrFirmware              = 0x0A,
+    e_UsbDfuStatus_ErrVendor                = 0x0B,
+    e_UsbDfuStatus_ErrUsbr                  = 0x0C,
+    e_UsbDfuStatus_ErrPor                   = 0x0D,
+    e_UsbDfuStatus_ErrUnknown               = 0x0E,
+    e_UsbDfuStatus_ErrStalledPkt            = 0x0F
+} UsbDfuStatus_t;
+
+/***************************************************************************//**
+ * @brief Response to \c DFU_GETSTATUS, see USB DFU 1.1, Section 6.1.2.
+ ******************************************************************************/
+typedef struct UsbDfuStatusReport_s {
+    uint8_t     m_bStatus;
+    uint8_t     m_bwPollTimeout[3];     /**< Milliseconds, Little Endian */
+    uint8_t     m_bState;
+    uint8_t     m_iString;
+
+    constexpr uint32_t
+    getPollTimeout(void) const {
+        return m_bwPollTimeout[0] | (m_bwPollTimeout[1] << 8) | (m_bwPollTimeout[2] << 16);
+    }
+} __attribute__((packed)) UsbDfuStatusReport_t;
+
+static_assert(sizeof(UsbDfuStatusReport_t) == 6, "DFU Status must be 6 Bytes");
+
+/***************************************************************************//**
+ * @brief Device Firmware Upgrade into a Download Slot in Flash.
+ *
+ * Implements the DFU-Mode State Machine of USB DFU 1.1 for Download and
+ * Upload. The Image goes to a Slot of whole Flash Sectors that the running
+ * Firmware does not occupy; a Bootloader that installs it from there is not
+ * Part of this Class.
+ *
+ * Flash Work overlaps with USB Reception:
+ * - Each \c DFU_DNLOAD Block is received into one of two Buffers while the
+ *   Block in the other Buffer is being programmed.
+ * - A Sector is erased when the first Block for it arrives. While the Flash
+ *   would otherwise be idle, the Sector after the one currently being
+ *   received is erased ahead of its Data.
+ * - Flash Jobs are driven by the Flash Interrupt via handleFlashIrq(), so no
+ *   Request Handler ever waits for the Flash. Instead, \c DFU_GETSTATUS
+ *   reports \c dfuDNBUSY with a Poll Timeout while both Buffers are taken,
+ *   and \c dfuDNLOAD-IDLE as soon as one is free again.
+ *
+ * A Block is therefore acknowledged before it is programmed. A Programming
+ * Error is reported by a later \c DFU_GETSTATUS (\c dfuERROR with
+ * \c errPROG, \c errVERIFY or \c errERASE), at the latest before
+ * Manifestation completes.
+ *
+ * Only the last Block may be shorter than \p nTransferSz. Once a short Block
+ * has arrived, further Data Blocks are stalled with \c errSTALLEDPKT; only
+ * the final, empty \c DFU_DNLOAD is accepted.
+ *
+ * The Function is Manifestation-tolerant: \c DFU_GETSTATUS after the final,
+ * empty \c DFU_DNLOAD reports \c dfuMANIFEST until all Blocks are in Flash and
+ * then returns to \c dfuIDLE.
+ *
+ * All Methods are called from the Context of the USB Interrupt, except
+ * handleFlashIrq(), which must run at the same Priority.
+ *
+ * @tparam FlashT Flash Engine, e.g. ::stm32::FlashProgrammerViaSTM32F4.
+ * @tparam nTransferSz \c wTransferSize, i.e. max. Bytes per Block.
+ ******************************************************************************/
+template<typename FlashT, size_t nTransferSz = 1024>
+class UsbDfuT {
+    static_assert(((nTransferSz % sizeof(uint32_t)) == 0) && ((FlashT::m_minSectorSz % nTransferSz) == 0),
+      "Transfer Size must consist of Words and divide a Flash Sector, so no Block spans two Sectors");
+
+    /** @brief Poll Timeout while a Sector is erased; the Flash cannot tell how far it has got. */
+    static constexpr uint32_t   m_erasePollInMs = 100;
+
+    enum class Job_e : uint8_t {
+        e_None,
+        e_Erase,
+        e_Program
+    };
+
+    FlashT &                m_flash;
+    const size_t            m_slotOffset;
+    const size_t            m_slotSz;
+
+    UsbDfuState_t           m_state;
+    UsbDfuStatus_t          m_status;
+    UsbDfuStatusReport_t    m_report;
+
+    alignas(4) uint8_t      m_buffer[2][nTransferSz];
+    size_t                  m_length[2];
+    unsigned                m_head;
+    unsigned                m_count;
+
+    Job_e                   m_job;
+    bool                    m_discardJob;
+
+    size_t                  m_rxOffset;         /**< Slot Offset of the next Block from the Host */
+    size_t                  m_programOffset;    /**< Slot Offset of the Block at m_head */
+    size_t                  m_erasedEnd;        /**< Slot is erased up to here */
+    size_t                  m_uploadOffset;
+    bool                    m_shortBlock;       /**< Last Block has arrived; only the empty DFU_DNLOAD may follow */
+
+    void
+    fail(const UsbDfuStatus_t p_status) {
+        m_state     = e_UsbDfuState_Error;
+        m_status    = p_status;
+        m_count     = 0;
+    }
+
+    void
+    enterIdle(void) {
+        m_state         = e_UsbDfuState_DfuIdle;
+        m_status        = e_UsbDfuStatus_Ok;
+        m_count         = 0;
+        /* A Job that is still running belongs to an earlier Download */
+        m_discardJob    = (m_job != Job_e::e_None);
+    }
+
+    void
+    eraseNext(void) {
+        if (m_flash.erase(FlashT::getSector(m_slotOffset + m_erasedEnd))) {
+            m_job = Job_e::e_Erase;
+        } else {
+            fail(e_UsbDfuStatus_ErrErase);
+        }
+    }
+
+    /** @brief Start the next Flash Job unless one is running. */
+    void
+    schedule(void) {
+        const bool isDownloading = (m_state == e_UsbDfuState_DnloadSync) || (m_state == e_UsbDfuState_DnloadIdle)
+          || (m_state == e_UsbDfuState_ManifestSync);
+
+        if ((m_job != Job_e::e_None) || !isDownloading) {
+            return;
+        }
+
+        if (m_count > 0) {
+            if ((m_programOffset + m_length[m_head]) > m_erasedEnd) {
+                eraseNext();
+            } else if (m_flash.program(m_slotOffset + m_programOffset, reinterpret_cast<const uint32_t *>(m_buffer[m_head]), m_length[m_head] / sizeof(uint32_t))) {
+                m_job = Job_e::e_Program;
+            } else {
+                fail(e_UsbDfuStatus_ErrProg);
+            }
+        } else if ((m_state != e_UsbDfuState_ManifestSync) && (m_erasedEnd < m_slotSz)) {
+            /* Erase ahead: The Sector after the one that the next Block goes to */
+            const unsigned  sector      = FlashT::getSector(m_slotOffset + m_rxOffset);
+            const size_t    sectorEnd   = FlashT::getSectorOffset(sector) + FlashT::getSectorSize(sector) - m_slotOffset;
+
+            if (m_erasedEnd <= sectorEnd) {
+                eraseNext();
+            }
+        }
+    }
+
+    uint32_t
+    getBusyTimeInMs(void) const {
+        if (m_job == Job_e::e_Program) {
+            return (m_flash.getRemainingWords() * FlashT::m_programWordTimeInUs + 999) / 1000;
+        }
+        return m_erasePollInMs;
+    }
+
+public:
+    /**
+     * @param p_flash Flash Engine.
+     * @param p_slotOffset Start of the Download Slot, counted from the Start of
+     *   the Flash; must be the Start of a Sector.
+     * @param p_slotSz Size of the Download Slot; must end on a Sector Boundary.
+     */
+    UsbDfuT(FlashT &p_flash, const size_t p_slotOffset, const size_t p_slotSz)
+      : m_flash(p_flash), m_slotOffset(p_slotOffset), m_slotSz(p_slotSz),
+        m_state(e_UsbDfuState_DfuIdle), m_status(e_UsbDfuStatus_Ok), m_report {}, m_buffer {}, m_length {},
+        m_head(0), m_count(0), m_job(Job_e::e_None), m_discardJob(false),
+        m_rxOffset(0), m_programOffset(0), m_erasedEnd(0), m_uploadOffset(0), m_shortBlock(false) {
+
+    }
+
+    static constexpr size_t
+    getTransferSize(void) {
+        return nTransferSz;
+    }
+
+    const UsbDfuState_t &
+    getState(void) const {
+        return m_state;
+    }
+
+    /**
+     * @brief Start of a \c DFU_DNLOAD Request with \p p_length Bytes.
+     *
+     * @return Buffer for the Data Stage, or \c nullptr if the Request must be
+     *   stalled.
+     */
+    uint8_t *
+    beginDownload(const size_t p_length) {
+        if (m_state == e_UsbDfuState_DfuIdle) {
+            enterIdle();
+            m_head          = 0;
+            m_rxOffset      = 0;
+            m_programOffset = 0;
+            m_erasedEnd     = 0;
+            m_shortBlock    = false;
+        } else if ((m_state != e_UsbDfuState_DnloadIdle) || m_shortBlock) {
+            fail(e_UsbDfuStatus_ErrStalledPkt);
+            return nullptr;
+        }
+
+        if ((p_length == 0) || (p_length > nTransferSz)) {
+            fail(e_UsbDfuStatus_ErrStalledPkt);
+            return nullptr;
+        }
+
+        if ((m_rxOffset + p_length) > m_slotSz) {
+            fail(e_UsbDfuStatus_ErrAddress);
+            return nullptr;
+        }
+
+        return m_buffer[(m_head + m_count) % 2];
+    }
+
+    /**
+     * @brief Data Stage of a \c DFU_DNLOAD Request has arrived.
+     *
+     * @return \c false if the Status Stage must be stalled.
+     */
+    bool
+    download(const size_t p_length) {
+        const unsigned idx = (m_head + m_count) % 2;
+
+        if ((p_length == 0) || (p_length > nTransferSz) || (m_count >= 2) || m_shortBlock) {
+            fail(e_UsbDfuStatus_ErrStalledPkt);
+            return false;
+        }
+
+        /* Only the last Block may be short; pad it to full Words */
+        const size_t padded = (p_length + sizeof(uint32_t) - 1) & ~(sizeof(uint32_t) - 1);
+        ::memset(&m_buffer[idx][p_length], 0xFF, padded - p_length);
+
+        m_length[idx]   = padded;
+        m_rxOffset     += padded;
+        m_shortBlock    = (p_length < nTransferSz);
+        m_count++;
+        m_state         = e_UsbDfuState_DnloadSync;
+
+        schedule();
+
+        return true;
+    }
+
+    /**
+     * @brief \c DFU_DNLOAD without Data, i.e. the End of the Image.
+     *
+     * @return \c false if the Request must be stalled.
+     */
+    bool
+    endDownload(void) {
+        if (m_state != e_UsbDfuState_DnloadIdle) {
+            fail(e_UsbDfuStatus_ErrStalledPkt);
+            return false;
+        }
+
+        m_state = e_UsbDfuState_ManifestSync;
+        return true;
+    }
+
+    /**
+     * @brief \c DFU_UPLOAD: Up to \p p_length Bytes of the Slot, in Sequence.
+     *
+     * A Block shorter than \p p_length ends the Upload.
+     *
+     * @return \c false if the Request must be stalled.
+     */
+    bool
+    upload(const size_t p_length, const uint8_t * &p_data, size_t &p_uploadLength) {
+        if (m_state == e_UsbDfuState_DfuIdle) {
+            m_uploadOffset  = 0;
+            m_state         = e_UsbDfuState_UploadIdle;
+        } else if (m_state != e_UsbDfuState_UploadIdle) {
+            fail(e_UsbDfuStatus_ErrStalledPkt);
+            return false;
+        }
+
+        if (p_length > nTransferSz) {
+            fail(e_UsbDfuStatus_ErrStalledPkt);
+            return false;
+        }
+
+        p_uploadLength  = ((m_uploadOffset + p_length) > m_slotSz) ? (m_slotSz - m_uploadOffset) : p_length;
+        p_data          = static_cast<const uint8_t *>(m_flash.map(m_slotOffset + m_uploadOffset));
+        m_uploadOffset += p_uploadLength;
+
+        if (p_uploadLength < p_length) {
+            m_state = e_UsbDfuState_DfuIdle;
+        }
+
+        return true;
+    }
+
+    /** @brief \c DFU_GETSTATUS; may advance the State, see USB DFU 1.1, Figure A.1. */
+    const UsbDfuStatusReport_t &
+    getStatus(void) {
+        UsbDfuState_t   state           = m_state;
+        uint32_t        pollTimeout     = 0;
+
+        if (m_state == e_UsbDfuState_DnloadSync) {
+            if (m_count < 2) {
+                m_state = state = e_UsbDfuState_DnloadIdle;
+            } else {
+                state       = e_UsbDfuState_DnBusy;
+                pollTimeout = getBusyTimeInMs();
+            }
+        } else if (m_state == e_UsbDfuState_ManifestSync) {
+            if ((m_count == 0) && (m_job == Job_e::e_None)) {
+                m_state = state = e_UsbDfuState_DfuIdle;
+            } else {
+                state       = e_UsbDfuState_Manifest;
+                pollTimeout = getBusyTimeInMs();
+            }
+        }
+
+        m_report.m_bStatus          = m_status;
+        m_report.m_bwPollTimeout[0] = (pollTimeout >>  0) & 0xFF;
+        m_report.m_bwPollTimeout[1] = (pollTimeout >>  8) & 0xFF;
+        m_report.m_bwPollTimeout[2] = (pollTimeout >> 16) & 0xFF;
+        m_report.m_bState           = state;
+        m_report.m_iString          = 0;
+
+        return m_report;
+    }
+
+    /** @return \c false if the Request must be stalled. */
+    bool
+    clearStatus(void) {
+        if (m_state != e_UsbDfuState_Error) {
+            fail(e_UsbDfuStatus_ErrStalledPkt);
+            return false;
+        }
+
+        enterIdle();
+        return true;
+    }
+
+    /** @return \c false if the Request must be stalled. */
+    bool
+    abort(void) {
+        switch (m_state) {
+        case e_UsbDfuState_DfuIdle:
+        case e_UsbDfuState_DnloadSync:
+        case e_UsbDfuState_DnloadIdle:
+        case e_UsbDfuState_ManifestSync:
+        case e_UsbDfuState_UploadIdle:
+            enterIdle();
+            return true;
+        default:
+            fail(e_UsbDfuStatus_ErrStalledPkt);
+            return false;
+        }
+    }
+
+    /** @brief Any other Request, e.g. \c DFU_DETACH, which DFU Mode does not support. */
+    void
+    reject(void) {
+        fail(e_UsbDfuStatus_ErrStalledPkt);
+    }
+
+    /** @brief Must be called from the Flash Interrupt. */
+    void
+    handleFlashIrq(void) {
+        if (!m_flash.handleIrq()) {
+            return;
+        }
+
+        const Job_e job = m_job;
+        m_job = Job_e::e_None;
+
+        if (m_discardJob) {
+            m_discardJob = false;
+        } else if (m_state == e_UsbDfuState_Error) {
+            /* Nothing left to do for this Download */
+        } else if (m_flash.getError() != FlashT::Error_e::e_None) {
+            fail((job == Job_e::e_Erase) ? e_UsbDfuStatus_ErrErase
+              : ((m_flash.getError() == FlashT::Error_e::e_Verify) ? e_UsbDfuStatus_ErrVerify : e_UsbDfuStatus_ErrProg));
+        } else if (job == Job_e::e_Erase) {
+            const unsigned sector = FlashT::getSector(m_slotOffset + m_erasedEnd);
+            m_erasedEnd = FlashT::getSectorOffset(sector) + FlashT::getSectorSize(sector) - m_slotOffset;
+        } else {
+            m_programOffset += m_length[m_head];
+            m_head           = (m_head + 1) % 2;
+            m_count--;
+        }
+
+        schedule();
+    }
+};
+
+} /* namespace usb */
+
+#endif /* _USB_DFU_HPP_C83A1F56_ */
@@ -0,0 +1,140 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _USB_DFU_INTERFACE_HPP_71B0E4C9_
+#define _USB_DFU_INTERFACE_HPP_71B0E4C9_
+
+#include <usb/UsbTypes.hpp>
+#include <usb/UsbInterface.hpp>
+#include <usb/UsbControlPipe.hpp>
+#include <usb/UsbDfu.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace usb {
+
+/***************************************************************************//**
+ * @brief Adds a DFU Interface to the Interface of another Function.
+ *
+ * The Configuration has a single ::usb::UsbInterface Object, so the DFU
+ * Interface (see ::usb::descriptor::DfuFunction) cannot have one of its own.
+ * Instead, this Class derives from the Function's Interface Class and takes
+ * the Class Requests addressed to the DFU Interface Number, see
+ * ::usb::UsbDfuT. All other Requests go to \p InterfaceT unchanged, as do the
+ * Constructor Arguments.
+ *
+ * Until setDfu() is called, the Class behaves exactly like \p InterfaceT.
+ *
+ * @tparam InterfaceT Interface of the other Function, e.g. ::usb::UsbVcpInterface.
+ * @tparam DfuT DFU Function, e.g. ::usb::UsbDfuT.
+ ******************************************************************************/
+template<typename InterfaceT, typename DfuT>
+class UsbDfuInterfaceT : public InterfaceT {
+    DfuT *      m_dfu;
+    uint16_t    m_interface;
+
+    bool
+    isDfuRequest(const UsbSetupPacket_t &p_setupPacket) const {
+        /* Class Request, Recipient Interface */
+        return ((static_cast<uint8_t>(p_setupPacket.m_bmRequestType) & 0x7F) == 0x21) && (p_setupPacket.m_wIndex == m_interface);
+    }
+
+public:
+    template<typename... ArgsT>
+    UsbDfuInterfaceT(ArgsT &&... p_args)
+      : InterfaceT(std::forward<ArgsT>(p_args)...), m_dfu(nullptr), m_interface(0xFFFF) {
+
+    }
+
+    void
+    setDfu(DfuT &p_dfu, const uint8_t p_interface) {
+        m_dfu       = &p_dfu;
+        m_interface = p_interface;
+    }
+
+    void
+    handleCtrlRequest(const UsbSetupPacket_t &p_setupPacket, UsbControlPipe &p_ctrlPipe) override {
+        if (!isDfuRequest(p_setupPacket)) {
+            InterfaceT::handleCtrlRequest(p_setupPacket, p_ctrlPipe);
+            return;
+        }
+
+        switch (p_setupPacket.m_bRequest) {
+        case e_UsbDfuRequest_Dnload:
+            if (p_setupPacket.m_wLength == 0) {
+                if (m_dfu->endDownload()) {
+                    p_ctrlPipe.write(nullptr, 0); /* Status Stage */
+                } else {
+                    p_ctrlPipe.stall();
+                }
+            } else if (uint8_t * const buffer = m_dfu->beginDownload(p_setupPacket.m_wLength)) {
+                p_ctrlPipe.expectDataStage(buffer, p_setupPacket.m_wLength);
+            } else {
+                p_ctrlPipe.stall();
+            }
+            break;
+        case e_UsbDfuRequest_Upload: {
+            const uint8_t * data;
+            size_t length;
+
+            if (m_dfu->upload(p_setupPacket.m_wLength, data, length)) {
+                p_ctrlPipe.write(data, length);
+            } else {
+                p_ctrlPipe.stall();
+            }
+        } break;
+        case e_UsbDfuRequest_GetStatus: {
+            const UsbDfuStatusReport_t &report = m_dfu->getStatus();
+
+            p_ctrlPipe.write(reinterpret_cast<const uint8_t *>(&report),
+              (p_setupPacket.m_wLength < sizeof(report)) ? p_setupPacket.m_wLength : sizeof(report));
+        } break;
+        case e_UsbDfuRequest_GetState:
+            p_ctrlPipe.write(reinterpret_cast<const uint8_t *>(&m_dfu->getState()),
+              (p_setupPacket.m_wLength < sizeof(UsbDfuState_t)) ? p_setupPacket.m_wLength : sizeof(UsbDfuState_t));
+            break;
+        case e_UsbDfuRequest_ClrStatus:
+            if (m_dfu->clearStatus()) {
+                p_ctrlPipe.write(nullptr, 0); /* Status Stage */
+            } else {
+                p_ctrlPipe.stall();
+            }
+            break;
+        case e_UsbDfuRequest_Abort:
+            if (m_dfu->abort()) {
+                p_ctrlPipe.write(nullptr, 0); /* Status Stage */
+            } else {
+                p_ctrlPipe.stall();
+            }
+            break;
+        default:
+            /* Incl. DFU_DETACH: The Interface is always in DFU Mode */
+            m_dfu->reject();
+            p_ctrlPipe.stall();
+            break;
+        }
+    }
+
+    void
+    handleCtrlDataStage(const UsbSetupPacket_t &p_setupPacket, const size_t p_length, UsbControlPipe &p_ctrlPipe) override {
+        if (!isDfuRequest(p_setupPacket) || (p_setupPacket.m_bRequest != e_UsbDfuRequest_Dnload)) {
+            InterfaceT::handleCtrlDataStage(p_setupPacket, p_length, p_ctrlPipe);
+            return;
+        }
+
+        if (m_dfu->download(p_length)) {
+            p_ctrlPipe.write(nullptr, 0); /* Status Stage */
+        } else {
+            p_ctrlPipe.stall();
+        }
+    }
+};
+
+} /* namespace usb */
+
+#endif /* _USB_DFU_INTERFACE_HPP_71B0E4C9_ */
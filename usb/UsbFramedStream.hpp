@@ -0,0 +1,192 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _USB_FRAMED_STREAM_HPP_A4F0631D_
+#define _USB_FRAMED_STREAM_HPP_A4F0631D_
+
+#include <usb/UsbBulkOutZeroCopyApplication.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace usb {
+
+typedef enum UsbFrameMagic_e : uint8_t {
+    e_UsbFrameMagic = 0xA5
+} UsbFrameMagic_t;
+
+/***************************************************************************//**
+ * @brief Header of a Frame, see ::usb::UsbFramedStreamT.
+ ******************************************************************************/
+typedef struct UsbFrameHeader_s {
+    uint8_t     m_magic;        /**< Always ::usb::e_UsbFrameMagic. */
+    uint8_t     m_stream;       /**< Stream Number. */
+    uint16_t    m_sequence;     /**< Per Stream, counts up by one per Frame and wraps around. */
+    uint32_t    m_length;       /**< Length of the Payload in Bytes, excl. Padding and CRC. */
+} __attribute__((packed)) UsbFrameHeader_t;
+
+static_assert(sizeof(UsbFrameHeader_t) == 8, "Frame Header must be two Words");
+
+/***************************************************************************//**
+ * @brief Counters of a single Stream, see ::usb::UsbFramedStreamT.
+ ******************************************************************************/
+typedef struct UsbFrameStreamStatistics_s {
+    uint32_t    m_numFrames;        /**< Frames with a matching CRC. */
+    uint32_t    m_numCrcErrors;     /**< Frames with a CRC Mismatch or cut short by the Host. */
+    uint32_t    m_numDropped;       /**< Frames missing from the Sequence. */
+    uint32_t    m_numOutOfOrder;    /**< Frames whose Sequence Number was not ahead of the last one. */
+} UsbFrameStreamStatistics_t;
+
+/***************************************************************************//**
+ * @brief Checks the Frames of the Framed Stream Protocol as they pass from a
+ *   Bulk OUT Endpoint to the Application.
+ *
+ * A Frame consists of a ::usb::UsbFrameHeader_t, the Payload, zero Padding up
+ * to the next Word Boundary and a CRC-32 (Little-Endian). The CRC covers the
+ * Header, the Payload and the Padding; it is computed over 32-Bit
+ * Little-Endian Words, MSB first, as ::stm32::CrcViaSTM32F4 does. Every Frame
+ * starts with a new Packet. A Frame that ends on a Packet Boundary need not be
+ * followed by a Zero-Length Packet, but a short Packet always ends the Frame.
+ *
+ * The Checksum is not computed here: The OUT Endpoint feeds each Word into
+ * \p CrcT as it leaves the RX FIFO, see
+ * ::stm32::usb::BulkOutEndpointZeroCopyViaSTM32F4. As the CRC trails the
+ * checksummed Words, the Accumulator reads zero at the End of an intact Frame,
+ * so it is read once per Frame and then reset for the next one.
+ *
+ * Per Stream, the Frames, CRC Errors, Frames missing from the Sequence and
+ * Frames out of Order are counted. Packets that should start a Frame but do not
+ * carry a valid Header are counted separately. The first Frame of each Stream
+ * sets its Sequence.
+ *
+ * All Packets are passed on to the Application unchanged, so e.g.
+ * ::usb::UsbBulkOutLoopbackRingApplicationT returns the Frames to the Host as
+ * they were sent. Buffers are lent by the Application as well.
+ *
+ * All Callbacks run in the Context of the USB Interrupt.
+ *
+ * @tparam CrcT Checksum Unit fed by the OUT Endpoint, e.g.
+ *   ::stm32::CrcViaSTM32F4 or ::stm32::SoftwareCrc.
+ * @tparam nNumStreams Number of Streams.
+ * @tparam nPacketSz Max. Packet Size of the OUT Endpoint.
+ * @tparam nMaxPayloadSz Max. Payload Length accepted in a Header.
+ ******************************************************************************/
+template<typename CrcT, size_t nNumStreams = 4, size_t nPacketSz = 64, size_t nMaxPayloadSz = 16 * 1024>
+class UsbFramedStreamT : public UsbBulkOutZeroCopyApplication {
+    static_assert((nNumStreams > 0) && (nNumStreams <= 256), "Stream Number is a single Byte");
+    static_assert(nPacketSz >= sizeof(UsbFrameHeader_t), "Frame Header must fit into the first Packet");
+
+public:
+    typedef struct Statistics_s {
+        uint32_t                    m_numBadHeaders;
+        UsbFrameStreamStatistics_t  m_streams[nNumStreams];
+    } Statistics_t;
+
+private:
+    UsbBulkOutZeroCopyApplication & m_application;
+
+    Statistics_t                    m_statistics;
+    uint16_t                        m_nextSequence[nNumStreams];
+    bool                            m_synced[nNumStreams];
+
+    /** @brief Bytes left of the current Frame; zero if the next Packet starts a Frame. */
+    size_t                          m_remaining;
+    unsigned                        m_stream;
+    uint16_t                        m_sequence;
+
+    bool
+    startFrame(const void * const p_data, const size_t p_length) {
+        UsbFrameHeader_t header;
+
+        if (p_length < sizeof(header)) {
+            return false;
+        }
+
+        ::memcpy(&header, p_data, sizeof(header));
+        if ((header.m_magic != e_UsbFrameMagic) || (header.m_stream >= nNumStreams) || (header.m_length > nMaxPayloadSz)) {
+            return false;
+        }
+
+        m_stream    = header.m_stream;
+        m_sequence  = header.m_sequence;
+        m_remaining = sizeof(header) + ((header.m_length + sizeof(uint32_t) - 1) & ~(sizeof(uint32_t) - 1)) + sizeof(uint32_t);
+
+        return true;
+    }
+
+    void
+    endFrame(const bool p_valid) {
+        UsbFrameStreamStatistics_t &stream = m_statistics.m_streams[m_stream];
+
+        if (!p_valid) {
+            stream.m_numCrcErrors++;
+        } else {
+            const uint16_t gap = m_sequence - m_nextSequence[m_stream];
+
+            stream.m_numFrames++;
+
+            if (!m_synced[m_stream] || (gap < 0x8000)) {
+                stream.m_numDropped         += m_synced[m_stream] ? gap : 0;
+                m_nextSequence[m_stream]    = m_sequence + 1;
+                m_synced[m_stream]          = true;
+            } else {
+                stream.m_numOutOfOrder++;
+            }
+        }
+
+        m_remaining = 0;
+        CrcT::reset();
+    }
+
+public:
+    UsbFramedStreamT(UsbBulkOutZeroCopyApplication &p_application)
+      : m_application(p_application), m_statistics {}, m_nextSequence {}, m_synced {}, m_remaining(0), m_stream(0), m_sequence(0) {
+
+    }
+
+    void *
+    lendOutBuffer(void) override {
+        return m_application.lendOutBuffer();
+    }
+
+    void
+    packetReceived(const void * const p_data, const size_t p_length) override {
+        if ((m_remaining == 0) && (p_length > 0) && !startFrame(p_data, p_length)) {
+            m_statistics.m_numBadHeaders++;
+            CrcT::reset();
+        } else if (m_remaining > 0) {
+            if (p_length > m_remaining) {
+                /* The Rest of the Packet went into the Checksum as well */
+                endFrame(false);
+            } else {
+                m_remaining -= p_length;
+
+                if (m_remaining == 0) {
+                    endFrame(CrcT::read() == 0);
+                } else if (p_length < nPacketSz) {
+                    endFrame(false);
+                }
+            }
+        }
+
+        m_application.packetReceived(p_data, p_length);
+    }
+
+    const Statistics_t &
+    getStatistics(void) const {
+        return m_statistics;
+    }
+
+    void
+    resetStatistics(void) {
+        ::memset(&m_statistics, 0, sizeof(m_statistics));
+    }
+};
+
+} /* namespace usb */
+
+#endif /* _USB_FRAMED_STREAM_HPP_A4F0631D_ */
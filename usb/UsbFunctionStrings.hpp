@@ -0,0 +1,90 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _USB_FUNCTION_STRINGS_HPP_4E9A1D37_
+#define _USB_FUNCTION_STRINGS_HPP_4E9A1D37_
+
+#include <usb/UsbTypes.hpp>
+#include <usb/UsbDevice.hpp>
+#include <usb/UsbControlPipe.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace usb {
+
+/***************************************************************************//**
+ * @brief String Descriptors of the Functions of a Composite Device.
+ *
+ * The Strings get the Indices from \c m_firstIndex on, i.e. those after the
+ * Table of ::usb::UsbStringDescriptors_t.
+ ******************************************************************************/
+typedef struct UsbFunctionStrings_s {
+    uint8_t                     m_firstIndex;
+    uint8_t                     m_numStrings;
+    const uint8_t * const *     m_strings;
+} UsbFunctionStrings_t;
+
+/***************************************************************************//**
+ * @brief Adds the String Descriptors of the Functions to ::usb::UsbDevice.
+ *
+ * ::usb::UsbStringDescriptors_t has a single Interface String, so the
+ * Functions of a Composite Device cannot have Strings of their own there.
+ * Instead, this Class derives from ::usb::UsbDevice and answers
+ * \c GET_DESCRIPTOR(STRING) for the Indices in ::usb::UsbFunctionStrings_t.
+ * All other Requests go to ::usb::UsbDevice unchanged, as do the Constructor
+ * Arguments.
+ *
+ * Until setFunctionStrings() is called, the Class behaves exactly like
+ * ::usb::UsbDevice.
+ ******************************************************************************/
+class UsbFunctionStringsDevice : public UsbDevice {
+    static constexpr uint8_t    m_requestGetDescriptor  = 0x06;
+    static constexpr uint8_t    m_descriptorTypeString  = 0x03;
+
+    const UsbFunctionStrings_t *    m_functionStrings = nullptr;
+
+    const uint8_t *
+    getFunctionString(const UsbSetupPacket_t &p_setupPacket) const {
+        /* Standard Request, Device to Host, Recipient Device */
+        if ((m_functionStrings == nullptr) || (static_cast<uint8_t>(p_setupPacket.m_bmRequestType) != 0x80)
+          || (p_setupPacket.m_bRequest != m_requestGetDescriptor) || ((p_setupPacket.m_wValue >> 8) != m_descriptorTypeString)) {
+            return nullptr;
+        }
+
+        const unsigned index = p_setupPacket.m_wValue & 0xFF;
+        if ((index < m_functionStrings->m_firstIndex) || (index >= (m_functionStrings->m_firstIndex + m_functionStrings->m_numStrings))) {
+            return nullptr;
+        }
+
+        return m_functionStrings->m_strings[index - m_functionStrings->m_firstIndex];
+    }
+
+public:
+    using UsbDevice::UsbDevice;
+
+    void
+    setFunctionStrings(const UsbFunctionStrings_t &p_functionStrings) {
+        m_functionStrings = &p_functionStrings;
+    }
+
+    void
+    handleCtrlRequest(const UsbSetupPacket_t &p_setupPacket, UsbControlPipe &p_ctrlPipe) override {
+        const uint8_t * const string = getFunctionString(p_setupPacket);
+
+        if (string == nullptr) {
+            UsbDevice::handleCtrlRequest(p_setupPacket, p_ctrlPipe);
+            return;
+        }
+
+        /* bLength is the first Byte of every Descriptor */
+        p_ctrlPipe.write(string, (p_setupPacket.m_wLength < string[0]) ? p_setupPacket.m_wLength : string[0]);
+    }
+};
+
+} /* namespace usb */
+
+#endif /* _USB_FUNCTION_STRINGS_HPP_4E9A1D37_ */
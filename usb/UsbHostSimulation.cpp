@@ -0,0 +1,480 @@
+/*-
+ * $Copyright$
+-*/
+#if defined(HOSTBUILD)
+
+#include <usb/UsbHostSimulation.hpp>
+
+#include <cstdio>
+#include <cstring>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace usb {
+
+namespace {
+
+enum StandardRequest_e : uint8_t {
+    e_SetAddress        = 0x05,
+    e_GetDescriptor     = 0x06,
+    e_SetConfiguration  = 0x09
+};
+
+enum DescriptorType_e : uint8_t {
+    e_Device            = 0x01,
+    e_Configuration     = 0x02,
+    e_String            = 0x03
+};
+
+} /* namespace */
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+UsbHostSimulation::UsbHostSimulation(stm32::usb::OtgFsRegisterModel &p_model)
+  : m_model(p_model), m_txBuffer {}, m_rxBuffer {} {
+
+}
+
+/*******************************************************************************
+ * Control Transfers
+ ******************************************************************************/
+bool
+UsbHostSimulation::controlRead(const uint8_t (&p_setupPacket)[8], void * const p_buffer, const size_t p_length, size_t &p_received) {
+    p_received = 0;
+
+    if (m_model.setup(0, p_setupPacket) != Handshake_t::e_Ack) {
+        return false;
+    }
+
+    /* Data Stage */
+    for (unsigned retries = 0; retries < m_maxRetries; ) {
+        uint8_t packet[m_maxPacketSz];
+        size_t length;
+
+        const Handshake_t handshake = m_model.in(0, packet, sizeof(packet), length);
+        if (handshake == Handshake_t::e_Stall) {
+            return false;
+        } else if (handshake == Handshake_t::e_Nak) {
+            retries++;
+            continue;
+        }
+
+        const size_t copy = ((p_received + length) > p_length) ? (p_length - p_received) : length;
+        ::memcpy(static_cast<uint8_t *>(p_buffer) + p_received, packet, copy);
+        p_received += copy;
+
+        if ((length < m_maxPacketSz) || (p_received >= p_length)) {
+            break;
+        }
+    }
+
+    /* Status Stage */
+    for (unsigned retries = 0; retries < m_maxRetries; retries++) {
+        const Handshake_t handshake = m_model.out(0, nullptr, 0);
+
+        if (handshake == Handshake_t::e_Ack) {
+            return true;
+        } else if (handshake == Handshake_t::e_Stall) {
+            return false;
+        }
+    }
+
+    return false;
+}
+
+bool
+UsbHostSimulation::controlWrite(const uint8_t (&p_setupPacket)[8], const void * const p_data, const size_t p_length) {
+    if (m_model.setup(0, p_setupPacket) != Handshake_t::e_Ack) {
+        return false;
+    }
+
+    /* Data Stage */
+    for (size_t offs = 0, retries = 0; offs < p_length; ) {
+        const size_t length = ((p_length - offs) > m_maxPacketSz) ? m_maxPacketSz : (p_length - offs);
+
+        const Handshake_t handshake = m_model.out(0, static_cast<const uint8_t *>(p_data) + offs, length);
+        if (handshake == Handshake_t::e_Stall) {
+            return false;
+        } else if (handshake == Handshake_t::e_Nak) {
+            if (++retries >= m_maxRetries) {
+                return false;
+            }
+            continue;
+        }
+
+        offs += length;
+    }
+
+    /* Status Stage: Zero Length IN Packet */
+    for (unsigned retries = 0; retries < m_maxRetries; retries++) {
+        uint8_t packet[m_maxPacketSz];
+        size_t length;
+
+        const Handshake_t handshake = m_model.in(0, packet, sizeof(packet), length);
+        if (handshake == Handshake_t::e_Ack) {
+            return (length == 0);
+        } else if (handshake == Handshake_t::e_Stall) {
+            return false;
+        }
+    }
+
+    return false;
+}
+
+bool
+UsbHostSimulation::getDescriptor(const uint8_t p_type, const uint8_t p_index, void * const p_buffer, const uint16_t p_length, size_t &p_received) {
+    const uint8_t setupPacket[8] = {
+        0x80, e_GetDescriptor, p_index, p_type, 0x00, 0x00,
+        static_cast<uint8_t>(p_length & 0xFF), static_cast<uint8_t>(p_length >> 8)
+    };
+
+    return controlRead(setupPacket, p_buffer, p_length, p_received);
+}
+
+bool
+UsbHostSimulation::controlRead(const uint8_t p_bmRequestType, const uint8_t p_bRequest, const uint16_t p_wValue, const uint16_t p_wIndex,
+  void * const p_buffer, const uint16_t p_length, size_t &p_received) {
+    const uint8_t setupPacket[8] = {
+        p_bmRequestType, p_bRequest,
+        static_cast<uint8_t>(p_wValue & 0xFF), static_cast<uint8_t>(p_wValue >> 8),
+        static_cast<uint8_t>(p_wIndex & 0xFF), static_cast<uint8_t>(p_wIndex >> 8),
+        static_cast<uint8_t>(p_length & 0xFF), static_cast<uint8_t>(p_length >> 8)
+    };
+
+    return controlRead(setupPacket, p_buffer, p_length, p_received);
+}
+
+bool
+UsbHostSimulation::controlWrite(const uint8_t p_bmRequestType, const uint8_t p_bRequest, const uint16_t p_wValue, const uint16_t p_wIndex,
+  const void * const p_data, const uint16_t p_length) {
+    const uint8_t setupPacket[8] = {
+        p_bmRequestType, p_bRequest,
+        static_cast<uint8_t>(p_wValue & 0xFF), static_cast<uint8_t>(p_wValue >> 8),
+        static_cast<uint8_t>(p_wIndex & 0xFF), static_cast<uint8_t>(p_wIndex >> 8),
+        static_cast<uint8_t>(p_length & 0xFF), static_cast<uint8_t>(p_length >> 8)
+    };
+
+    return controlWrite(setupPacket, p_data, p_length);
+}
+
+/*******************************************************************************
+ * Enumeration
+ ******************************************************************************/
+bool
+UsbHostSimulation::enumerate(const void * const p_deviceDescriptor, const size_t p_length) {
+    size_t received;
+
+    if (!m_model.isConnected()) {
+        ::printf("FAIL: Device has not connected to the Bus\n");
+        return false;
+    }
+
+    m_model.busReset();
+
+    if (!getDescriptor(e_Device, 0, m_rxBuffer, 64, received)
+      || (received != p_length)
+      || ::memcmp(m_rxBuffer, p_deviceDescriptor, p_length)) {
+        ::printf("FAIL: GET_DESCRIPTOR(Device) returned %zu Bytes\n", received);
+        return false;
+    }
+
+    const uint8_t setAddress[8] = { 0x00, e_SetAddress, m_deviceAddress, 0x00, 0x00, 0x00, 0x00, 0x00 };
+    if (!controlWrite(setAddress) || (m_model.getDeviceAddress() != m_deviceAddress)) {
+        ::printf("FAIL: SET_ADDRESS(%u), Device is at %u\n", m_deviceAddress, m_model.getDeviceAddress());
+        return false;
+    }
+
+    if (!getDescriptor(e_Configuration, 0, m_rxBuffer, 9, received) || (received != 9)) {
+        ::printf("FAIL: GET_DESCRIPTOR(Configuration) Header returned %zu Bytes\n", received);
+        return false;
+    }
+
+    const uint16_t totalLength = m_rxBuffer[2] | (m_rxBuffer[3] << 8);
+    if (!getDescriptor(e_Configuration, 0, m_rxBuffer, totalLength, received) || (received != totalLength)) {
+        ::printf("FAIL: GET_DESCRIPTOR(Configuration) returned %zu of %u Bytes\n", received, totalLength);
+        return false;
+    }
+
+    if (!getDescriptor(e_String, 0, m_rxBuffer, 255, received) || (received < 4)) {
+        ::printf("FAIL: GET_DESCRIPTOR(String, Language IDs) returned %zu Bytes\n", received);
+        return false;
+    }
+
+    const uint8_t setConfiguration[8] = { 0x00, e_SetConfiguration, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00 };
+    if (!controlWrite(setConfiguration)) {
+        ::printf("FAIL: SET_CONFIGURATION(1)\n");
+        return false;
+    }
+
+    return true;
+}
+
+/*******************************************************************************
+ * Bulk Traffic
+ ******************************************************************************/
+bool
+UsbHostSimulation::bulkLoopback(const unsigned p_endpoint, const size_t p_transferSz, const unsigned p_iterations) {
+    return bulkLoopback(p_endpoint, p_endpoint, p_transferSz, p_iterations);
+}
+
+bool
+UsbHostSimulation::bulkLoopback(const unsigned p_outEndpoint, const unsigned p_inEndpoint, const size_t p_transferSz, const unsigned p_iterations) {
+    if (p_transferSz > m_maxTransferSz) {
+        return false;
+    }
+
+    for (unsigned iteration = 0; iteration < p_iterations; iteration++) {
+        for (size_t idx = 0; idx < p_transferSz; idx++) {
+            m_txBuffer[idx] = static_cast<uint8_t>(idx + iteration);
+        }
+
+        if (!loopbackTransfer(p_outEndpoint, p_inEndpoint, p_transferSz, iteration)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool
+UsbHostSimulation::bulkLoopback(const unsigned p_outEndpoint, const unsigned p_inEndpoint, const void * const p_data, const size_t p_length) {
+    if (p_length > m_maxTransferSz) {
+        return false;
+    }
+
+    ::memcpy(m_txBuffer, p_data, p_length);
+
+    return loopbackTransfer(p_outEndpoint, p_inEndpoint, p_length, 0);
+}
+
+/* Sends the first p_transferSz Bytes of m_txBuffer and compares what comes back */
+bool
+UsbHostSimulation::loopbackTransfer(const unsigned p_outEndpoint, const unsigned p_inEndpoint, const size_t p_transferSz, const unsigned p_iteration) {
+    size_t sent = 0, received = 0;
+    unsigned retries = 0;
+
+    while ((received < p_transferSz) && (retries < m_maxRetries)) {
+        bool progress = false;
+
+        if (sent < p_transferSz) {
+            const size_t length = ((p_transferSz - sent) < m_maxPacketSz) ? (p_transferSz - sent) : m_maxPacketSz;
+
+            if (m_model.out(p_outEndpoint, &m_txBuffer[sent], length) == Handshake_t::e_Ack) {
+                sent += length;
+                progress = true;
+            }
+        }
+
+        size_t length;
+        if (m_model.in(p_inEndpoint, &m_rxBuffer[received], p_transferSz - received, length) == Handshake_t::e_Ack) {
+            received += length;
+            progress = true;
+        }
+
+        retries = progress ? 0 : (retries + 1);
+    }
+
+    if ((received != p_transferSz) || ::memcmp(m_txBuffer, m_rxBuffer, p_transferSz)) {
+        ::printf("FAIL: Loopback of %zu Bytes (Iteration %u): Sent %zu, received %zu Bytes\n", p_transferSz, p_iteration, sent, received);
+        return false;
+    }
+
+    return true;
+}
+
+bool
+UsbHostSimulation::bulkWrite(const unsigned p_endpoint, const void * const p_data, const size_t p_length) {
+    const uint8_t * const data = static_cast<const uint8_t *>(p_data);
+    size_t sent = 0;
+    unsigned retries = 0;
+
+    while ((sent < p_length) && (retries < m_maxRetries)) {
+        const size_t length = ((p_length - sent) < m_maxPacketSz) ? (p_length - sent) : m_maxPacketSz;
+
+        if (m_model.out(p_endpoint, &data[sent], length) == Handshake_t::e_Ack) {
+            sent += length;
+            retries = 0;
+        } else {
+            retries++;
+        }
+    }
+
+    if (sent != p_length) {
+        ::printf("FAIL: Bulk OUT of %zu Bytes on EP%u: Sent %zu Bytes\n", p_length, p_endpoint, sent);
+        return false;
+    }
+
+    return true;
+}
+
+bool
+UsbHostSimulation::bulkRead(const unsigned p_endpoint, void * const p_buffer, const size_t p_length, size_t &p_received) {
+    uint8_t * const buffer = static_cast<uint8_t *>(p_buffer);
+    unsigned retries = 0;
+
+    p_received = 0;
+    while ((p_received < p_length) && (retries < m_maxRetries)) {
+        size_t length;
+
+        if (m_model.in(p_endpoint, &buffer[p_received], p_length - p_received, length) == Handshake_t::e_Ack) {
+            p_received += length;
+            retries = 0;
+
+            if (length < m_maxPacketSz) {
+                break;
+            }
+        } else {
+            retries++;
+        }
+    }
+
+    if (retries >= m_maxRetries) {
+        ::printf("FAIL: Bulk IN of %zu Bytes on EP%u: Received %zu Bytes\n", p_length, p_endpoint, p_received);
+        return false;
+    }
+
+    return true;
+}
+
+bool
+UsbHostSimulation::bulkOut(const unsigned p_endpoint, const size_t p_transferSz, const unsigned p_iterations) {
+    for (unsigned iteration = 0; iteration < p_iterations; iteration++) {
+        size_t sent = 0;
+        unsigned retries = 0;
+
+        while ((sent < p_transferSz) && (retries < m_maxRetries)) {
+            const size_t length = ((p_transferSz - sent) < m_maxPacketSz) ? (p_transferSz - sent) : m_maxPacketSz;
+
+            if (m_model.out(p_endpoint, m_txBuffer, length) == Handshake_t::e_Ack) {
+                sent += length;
+                retries = 0;
+            } else {
+                retries++;
+            }
+        }
+
+        if (sent != p_transferSz) {
+            ::printf("FAIL: Bulk OUT of %zu Bytes (Iteration %u): Sent %zu Bytes\n", p_transferSz, iteration, sent);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*******************************************************************************
+ * Isochronous Traffic
+ ******************************************************************************/
+bool
+UsbHostSimulation::isoLoopback(const unsigned p_outEndpoint, const unsigned p_inEndpoint, const size_t p_packetSz, const unsigned p_numFrames) {
+    if (p_packetSz > sizeof(m_txBuffer)) {
+        return false;
+    }
+
+    /* Let the Device arm its Isochronous Endpoints for the first Frame */
+    m_model.sof();
+
+    for (unsigned frame = 0; frame <= p_numFrames; frame++) {
+        for (size_t idx = 0; idx < p_packetSz; idx++) {
+            m_txBuffer[idx] = static_cast<uint8_t>(idx + frame);
+        }
+
+        if ((frame < p_numFrames) && (m_model.out(p_outEndpoint, m_txBuffer, p_packetSz) != Handshake_t::e_Ack)) {
+            ::printf("FAIL: Isochronous OUT missed Frame %u\n", frame);
+            return false;
+        }
+
+        size_t length;
+        if (m_model.in(p_inEndpoint, m_rxBuffer, sizeof(m_rxBuffer), length) != Handshake_t::e_Ack) {
+            ::printf("FAIL: Isochronous IN missed Frame %u\n", frame);
+            return false;
+        }
+
+        /* The Packet sent in the previous Frame comes back in this one */
+        if (frame > 0) {
+            bool match = (length == p_packetSz);
+
+            for (size_t idx = 0; match && (idx < p_packetSz); idx++) {
+                match = (m_rxBuffer[idx] == static_cast<uint8_t>(idx + frame - 1));
+            }
+
+            if (!match) {
+                ::printf("FAIL: Isochronous IN in Frame %u returned %zu Bytes, expected the %zu Bytes from Frame %u\n", frame, length, p_packetSz, frame - 1);
+                return false;
+            }
+        }
+
+        if (frame < p_numFrames) {
+            m_model.sof();
+        }
+    }
+
+    return true;
+}
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+bool
+UsbHostSimulation::interruptIn(const unsigned p_endpoint, const unsigned p_numFrames, void * const p_buffer, const size_t p_bufferSz, size_t &p_length) {
+    for (unsigned frame = 0; frame < p_numFrames; frame++) {
+        m_model.sof();
+
+        const Handshake_t handshake = m_model.in(p_endpoint, p_buffer, p_bufferSz, p_length);
+        if (handshake == Handshake_t::e_Ack) {
+            return true;
+        }
+
+        if (handshake == Handshake_t::e_Stall) {
+            ::printf("FAIL: Interrupt IN Endpoint %u stalled\n", p_endpoint);
+            return false;
+        }
+    }
+
+    return false;
+}
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+double
+UsbHostSimulation::getPacketsPerSecond(void) const {
+    const stm32::usb::OtgFsRegisterModel::Statistics_t &stats = m_model.getStatistics();
+    const uint64_t numPackets = stats.m_numOutPackets + stats.m_numInPackets;
+    const double cyclesPerPacket = numPackets ? static_cast<double>(stats.m_irqCycles) / numPackets : 0.0;
+
+    return (cyclesPerPacket > 0) ? m_model.getCyclesPerSecond() / cyclesPerPacket : 0.0;
+}
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+void
+UsbHostSimulation::printStatistics(const char * const p_phase) const {
+    const stm32::usb::OtgFsRegisterModel::Statistics_t &stats = m_model.getStatistics();
+    const uint64_t numPackets = stats.m_numOutPackets + stats.m_numInPackets;
+    const double cyclesPerPacket = numPackets ? static_cast<double>(stats.m_irqCycles) / numPackets : 0.0;
+    const double packetsPerSecond = getPacketsPerSecond();
+    const double accessesPerPacket = numPackets ? static_cast<double>(stats.m_numTraps) / numPackets : 0.0;
+
+    ::printf("%-24s %8llu Packets, %6llu NAKs, %8llu IRQs, %6.1f Register Accesses/Packet, %10.1f Cycles/Packet, %12.0f Packets/s",
+      p_phase,
+      static_cast<unsigned long long>(numPackets),
+      static_cast<unsigned long long>(stats.m_numNaks),
+      static_cast<unsigned long long>(stats.m_numIrqs),
+      accessesPerPacket,
+      cyclesPerPacket,
+      packetsPerSecond);
+
+    if (m_model.hasInstructionCounter() && numPackets) {
+        ::printf(", %8.1f Instructions/Packet", static_cast<double>(stats.m_irqInstructions) / numPackets);
+    }
+
+    ::printf(" (Trap Overhead: %.0f Cycles)\n", m_model.getTrapCycles());
+}
+
+} /* namespace usb */
+
+#endif /* defined(HOSTBUILD) */
@@ -0,0 +1,134 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _USB_HOST_SIMULATION_HPP_0F9B3A75_
+#define _USB_HOST_SIMULATION_HPP_0F9B3A75_
+
+#if defined(HOSTBUILD)
+
+#include <usb/OtgFsRegisterModel.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace usb {
+
+/***************************************************************************//**
+ * @brief Host Side of a simulated USB Bus.
+ *
+ * Drives the Device Stack through ::stm32::usb::OtgFsRegisterModel. It
+ * enumerates the Device like a Host Controller would and then moves Bulk
+ * Traffic. After each Phase it reports the Packets per Second and the CPU
+ * Cycles per Packet spent in the Device Stack.
+ ******************************************************************************/
+class UsbHostSimulation {
+public:
+    typedef stm32::usb::OtgFsRegisterModel::Handshake_t Handshake_t;
+
+    UsbHostSimulation(stm32::usb::OtgFsRegisterModel &p_model);
+
+    /**
+     * @brief Enumerate the Device.
+     *
+     * @param p_deviceDescriptor Expected Device Descriptor.
+     * @param p_length Length of the expected Device Descriptor.
+     */
+    bool    enumerate(const void * const p_deviceDescriptor, const size_t p_length);
+
+    /**
+     * @brief Send a Pattern on Bulk OUT and expect it back on Bulk IN.
+     */
+    bool    bulkLoopback(const unsigned p_endpoint, const size_t p_transferSz, const unsigned p_iterations);
+
+    /**
+     * @brief Like bulkLoopback() above, for a Function whose OUT and IN
+     *   Endpoints have different Numbers.
+     */
+    bool    bulkLoopback(const unsigned p_outEndpoint, const unsigned p_inEndpoint, const size_t p_transferSz, const unsigned p_iterations);
+
+    /**
+     * @brief Send \p p_length Bytes from \p p_data as a single Transfer on Bulk
+     *   OUT and expect them back on Bulk IN.
+     */
+    bool    bulkLoopback(const unsigned p_outEndpoint, const unsigned p_inEndpoint, const void * const p_data, const size_t p_length);
+
+    /**
+     * @brief Send \p p_length Bytes as a single Bulk OUT Transfer, ending with
+     *   a short Packet unless \p p_length is a Multiple of the Packet Size.
+     */
+    bool    bulkWrite(const unsigned p_endpoint, const void * const p_data, const size_t p_length);
+
+    /**
+     * @brief Receive a Bulk IN Transfer of up to \p p_length Bytes; a short
+     *   Packet ends it early.
+     */
+    bool    bulkRead(const unsigned p_endpoint, void * const p_buffer, const size_t p_length, size_t &p_received);
+
+    /**
+     * @brief Send a Pattern on Bulk OUT, ignoring NAKs.
+     */
+    bool    bulkOut(const unsigned p_endpoint, const size_t p_transferSz, const unsigned p_iterations);
+
+    /**
+     * @brief Stream a Pattern on an Isochronous OUT Endpoint at one Packet per
+     *   Frame and expect every Packet back on an Isochronous IN Endpoint one
+     *   Frame later, i.e. no Frame must be missed.
+     */
+    bool    isoLoopback(const unsigned p_outEndpoint, const unsigned p_inEndpoint, const size_t p_packetSz, const unsigned p_numFrames);
+
+    /**
+     * @brief Poll an Interrupt IN Endpoint once per Frame, like a Host
+     *   Controller would for an Endpoint with \c bInterval of one.
+     *
+     * @return \c true if the Device returned a Packet within \p p_numFrames
+     *   Frames; the Packet is copied to \p p_buffer.
+     */
+    bool    interruptIn(const unsigned p_endpoint, const unsigned p_numFrames, void * const p_buffer, const size_t p_bufferSz, size_t &p_length);
+
+    /**
+     * @brief Control Transfer with a Data Stage from the Device, e.g. a Class
+     *   or Vendor Request.
+     */
+    bool    controlRead(const uint8_t p_bmRequestType, const uint8_t p_bRequest, const uint16_t p_wValue, const uint16_t p_wIndex,
+              void * const p_buffer, const uint16_t p_length, size_t &p_received);
+
+    /**
+     * @brief Control Transfer with an optional Data Stage to the Device.
+     */
+    bool    controlWrite(const uint8_t p_bmRequestType, const uint8_t p_bRequest, const uint16_t p_wValue, const uint16_t p_wIndex,
+              const void * const p_data, const uint16_t p_length);
+
+    /**
+     * @brief Packets per Second the IRQ Handler could sustain, derived from
+     *   the Cycles it spent per Packet since the Statistics were last reset.
+     *
+     * @return Zero if no Packet was transferred.
+     */
+    double  getPacketsPerSecond(void) const;
+
+    void    printStatistics(const char * const p_phase) const;
+
+private:
+    static constexpr uint8_t    m_deviceAddress     = 5;
+    static constexpr unsigned   m_maxRetries        = 1000;
+    static constexpr size_t     m_maxPacketSz       = 64;
+    static constexpr size_t     m_maxTransferSz     = 16 * 1024;
+
+    stm32::usb::OtgFsRegisterModel &    m_model;
+    uint8_t                             m_txBuffer[m_maxTransferSz];
+    uint8_t                             m_rxBuffer[m_maxTransferSz];
+
+    bool    loopbackTransfer(const unsigned p_outEndpoint, const unsigned p_inEndpoint, const size_t p_transferSz, const unsigned p_iteration);
+    bool    controlRead(const uint8_t (&p_setupPacket)[8], void * const p_buffer, const size_t p_length, size_t &p_received);
+    bool    controlWrite(const uint8_t (&p_setupPacket)[8], const void * const p_data = nullptr, const size_t p_length = 0);
+    bool    getDescriptor(const uint8_t p_type, const uint8_t p_index, void * const p_buffer, const uint16_t p_length, size_t &p_received);
+};
+
+} /* namespace usb */
+
+#endif /* defined(HOSTBUILD) */
+
+#endif /* _USB_HOST_SIMULATION_HPP_0F9B3A75_ */
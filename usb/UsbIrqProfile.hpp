@@ -0,0 +1,114 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _USB_IRQ_PROFILE_HPP_E6A20D58_
+#define _USB_IRQ_PROFILE_HPP_E6A20D58_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace usb {
+
+/***************************************************************************//**
+ * @brief Fixed-size Table of Interrupt Durations, one Entry per Source.
+ *
+ * Each Entry keeps the Number of Samples, the min. / max. / total Duration in
+ * CPU Cycles and a Histogram with logarithmic Buckets:
+ * - Bucket 0 counts Durations below \f$2^{nFirstBucketLog2}\f$ Cycles.
+ * - Bucket \c n counts Durations in \f$[2^{nFirstBucketLog2+n-1}, 2^{nFirstBucketLog2+n})\f$.
+ * - The last Bucket also counts everything above.
+ *
+ * The Table is a packed Structure with a small Header so that it can be sent
+ * to the Host as-is.
+ *
+ * @tparam nNumSources Number of Interrupt Sources.
+ * @tparam nNumBuckets Number of Histogram Buckets per Source.
+ * @tparam nFirstBucketLog2 Upper Limit of Bucket 0 as a Power of Two.
+ ******************************************************************************/
+template<unsigned nNumSources, unsigned nNumBuckets = 16, unsigned nFirstBucketLog2 = 6>
+class UsbIrqProfileT {
+    static_assert(nNumSources <= 0xFF, "Too many Interrupt Sources");
+    static_assert((nNumBuckets >= 2) && (nNumBuckets <= 0xFF), "Histogram needs 2..255 Buckets");
+    static_assert((nFirstBucketLog2 + nNumBuckets) <= 33, "Histogram exceeds the 32-Bit Cycle Counter");
+
+public:
+    typedef struct Entry_s {
+        uint32_t    m_count;
+        uint32_t    m_minCycles;
+        uint32_t    m_maxCycles;
+        uint64_t    m_totalCycles;
+        uint32_t    m_buckets[nNumBuckets];
+    } __attribute__((packed)) Entry_t;
+
+    typedef struct Table_s {
+        uint8_t     m_numSources;
+        uint8_t     m_numBuckets;
+        uint8_t     m_firstBucketLog2;
+        uint8_t     m_reserved;
+        Entry_t     m_entries[nNumSources];
+    } __attribute__((packed)) Table_t;
+
+private:
+    Table_t m_table;
+
+public:
+    UsbIrqProfileT(void) {
+        reset();
+    }
+
+    void
+    reset(void) {
+        ::memset(&m_table, 0, sizeof(m_table));
+
+        m_table.m_numSources        = nNumSources;
+        m_table.m_numBuckets        = nNumBuckets;
+        m_table.m_firstBucketLog2   = nFirstBucketLog2;
+
+        for (Entry_t &entry : m_table.m_entries) {
+            entry.m_minCycles = UINT32_MAX;
+        }
+    }
+
+    static constexpr unsigned
+    getBucket(const uint32_t p_cycles) {
+        if (p_cycles < (1u << nFirstBucketLog2)) {
+            return 0;
+        }
+
+        const unsigned bucket = (31 - __builtin_clz(p_cycles)) - nFirstBucketLog2 + 1;
+        return (bucket < nNumBuckets) ? bucket : (nNumBuckets - 1);
+    }
+
+    void
+    record(const unsigned p_source, const uint32_t p_cycles) {
+        Entry_t &entry = m_table.m_entries[p_source];
+
+        entry.m_count++;
+        entry.m_totalCycles += p_cycles;
+        if (p_cycles < entry.m_minCycles) {
+            entry.m_minCycles = p_cycles;
+        }
+        if (p_cycles > entry.m_maxCycles) {
+            entry.m_maxCycles = p_cycles;
+        }
+        entry.m_buckets[getBucket(p_cycles)]++;
+    }
+
+    const Table_t &
+    getTable(void) const {
+        return m_table;
+    }
+
+    const Entry_t &
+    getEntry(const unsigned p_source) const {
+        return m_table.m_entries[p_source];
+    }
+};
+
+} /* namespace usb */
+
+#endif /* _USB_IRQ_PROFILE_HPP_E6A20D58_ */
@@ -0,0 +1,57 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _USB_ISO_APPLICATION_HPP_2E6B90D4_
+#define _USB_ISO_APPLICATION_HPP_2E6B90D4_
+
+#include <cstddef>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace usb {
+
+/***************************************************************************//**
+ * @brief Interface for Applications that consume an Isochronous OUT Stream.
+ *
+ * isoFrameReceived() is called once per Frame from the SOF Handler, with the
+ * Packet the Host sent in the previous Frame. The Data stays valid until the
+ * next Call.
+ ******************************************************************************/
+class UsbIsoOutApplication {
+public:
+    virtual void isoFrameReceived(const void * const p_data, const size_t p_length) = 0;
+
+protected:
+    ~UsbIsoOutApplication() = default;
+};
+
+/***************************************************************************//**
+ * @brief Isochronous OUT to Isochronous IN Loopback.
+ *
+ * Each Packet received in Frame \c n is sent back to the Host in Frame
+ * \c n + 1. Meant to check that a Stream runs at a fixed Rate without missing
+ * Frames, e.g. in the Host Build.
+ *
+ * @tparam IsoInEndpointT Isochronous IN Endpoint, e.g.
+ *   ::stm32::usb::IsoInEndpointViaSTM32F4.
+ ******************************************************************************/
+template<typename IsoInEndpointT>
+class UsbIsoLoopbackApplicationT : public UsbIsoOutApplication {
+    IsoInEndpointT &    m_inEndpoint;
+
+public:
+    UsbIsoLoopbackApplicationT(IsoInEndpointT &p_inEndpoint)
+      : m_inEndpoint(p_inEndpoint) {
+
+    }
+
+    void
+    isoFrameReceived(const void * const p_data, const size_t p_length) override {
+        m_inEndpoint.write(p_data, p_length);
+    }
+};
+
+} /* namespace usb */
+
+#endif /* _USB_ISO_APPLICATION_HPP_2E6B90D4_ */
@@ -0,0 +1,230 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _USB_LOOPBACK_RING_APPLICATION_HPP_6D1F4A27_
+#define _USB_LOOPBACK_RING_APPLICATION_HPP_6D1F4A27_
+
+#include <usb/UsbApplication.hpp>
+#include <usb/UsbBulkInApplication.hpp>
+#include <usb/UsbBulkOutZeroCopyApplication.hpp>
+#include <usb/OtgFsFifoPlanner.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace usb {
+
+/***************************************************************************//**
+ * @brief Double-buffered Bulk OUT to Bulk IN Loopback.
+ *
+ * The Buffer is organized as a Ring of Packet-sized Slots which is split into
+ * two Halves. Bulk OUT Packets are appended to one Half while the Bulk IN
+ * Endpoint drains the other one. A Half is handed to the IN Endpoint when it is
+ * full, when a short Packet terminates the OUT Transfer or, so that no Data is
+ * left behind in the Ring, whenever the IN Endpoint is idle.
+ *
+ * If the Data sent back so far ends on a Packet Boundary and nothing else is
+ * waiting to be sent, a Zero-Length Packet terminates the IN Transfer. An OUT
+ * Transfer may therefore come back in several IN Transfers; the Host reads
+ * until it has all of its Data.
+ *
+ * If the Host keeps sending while both Halves are in use, the OUT Endpoint is
+ * NAK'ed until the IN Endpoint has drained its Half. With a zero-copy Endpoint,
+ * no Data is dropped. A copying Endpoint may still deliver a Packet that was
+ * in the RX FIFO when the NAK took effect; if there is no Room for it, it is
+ * dropped and counted, see getDropped().
+ *
+ * The Ring's next free Slot is lent to the OUT Endpoint via lendOutBuffer().
+ * With a zero-copy Endpoint such as
+ * ::stm32::usb::BulkOutEndpointZeroCopyViaSTM32F4, the Packet is written there
+ * straight from the RX FIFO and packetReceived() does not copy it again.
+ *
+ * All Callbacks run in the Context of the USB Interrupt, so no additional
+ * locking is required.
+ *
+ * @tparam InEndpointT Bulk IN Endpoint, e.g. ::usb::UsbBulkInEndpointNotifyT.
+ * @tparam OutFlowControlT NAK Control of the OUT Endpoint, e.g.
+ *   ::stm32::usb::OutEndpointNakViaSTM32F4 or
+ *   ::stm32::usb::BulkOutEndpointZeroCopyViaSTM32F4.
+ * @tparam nBufferSz Total Size of the Ring in Bytes.
+ * @tparam nInFifoSzInWords Size of the IN Endpoint's TX FIFO in 32-Bit Words.
+ * @tparam nPacketSz Max. Packet Size of the Bulk Endpoints.
+ ******************************************************************************/
+template<
+  typename InEndpointT,
+  typename OutFlowControlT,
+  size_t nBufferSz,
+  size_t nInFifoSzInWords,
+  size_t nPacketSz = 64
+>
+class UsbBulkOutLoopbackRingApplicationT : public UsbBulkOutZeroCopyApplication, public UsbBulkInApplication {
+public:
+    /** @brief Max. RAM the Loopback Ring may occupy. */
+    static constexpr size_t m_maxBufferSz       = 32 * 1024;
+    static constexpr size_t m_halfSz            = nBufferSz / 2;
+    static constexpr size_t m_slotsPerHalf      = m_halfSz / nPacketSz;
+
+private:
+    static_assert((nPacketSz > 0) && (nPacketSz <= 64) && ((nPacketSz & (nPacketSz - 1)) == 0),
+      "Full Speed Bulk Endpoints support Max. Packet Sizes of 8, 16, 32 or 64 Bytes");
+    static_assert((nBufferSz % (2 * nPacketSz)) == 0,
+      "Buffer Size must be a multiple of two Packets");
+    static_assert(m_slotsPerHalf >= 2,
+      "Each Half of the Ring must hold at least two Packets");
+    static_assert(nBufferSz <= m_maxBufferSz,
+      "Loopback Ring exceeds the RAM Budget");
+    static_assert((nInFifoSzInWords * sizeof(uint32_t)) >= (2 * nPacketSz),
+      "IN FIFO must hold two Packets so they can be sent back-to-back");
+    static_assert(nInFifoSzInWords <= ::stm32::usb::FifoPlanT<1>::m_maxFifoSzInWords,
+      "IN FIFO exceeds the max. TX FIFO Depth of the OTG Core");
+
+    enum class HalfState_e : uint8_t {
+        e_Free,
+        e_Filling,
+        e_Ready,
+        e_Draining
+    };
+
+    InEndpointT &           m_inEndpoint;
+    const OutFlowControlT & m_outFlowControl;
+
+    alignas(4) uint8_t      m_ring[2][m_halfSz];
+    size_t                  m_length[2];
+    HalfState_e             m_state[2];
+    unsigned                m_fill;
+    bool                    m_outNaked;
+    bool                    m_inZlp;
+    unsigned                m_dropped;
+
+    bool
+    isInIdle(void) const {
+        return !m_inZlp && (m_state[0] != HalfState_e::e_Draining) && (m_state[1] != HalfState_e::e_Draining);
+    }
+
+    void
+    commit(void) {
+        const unsigned other = m_fill ^ 1;
+
+        m_state[m_fill] = HalfState_e::e_Ready;
+
+        if (m_state[other] == HalfState_e::e_Free) {
+            m_fill          = other;
+            m_length[other] = 0;
+            m_state[other]  = HalfState_e::e_Filling;
+        } else {
+            m_outFlowControl.setNak();
+            m_outNaked = true;
+        }
+
+        kick();
+    }
+
+    void
+    kick(void) {
+        if (!isInIdle()) {
+            return;
+        }
+
+        for (unsigned half = 0; half < 2; half++) {
+            if (m_state[half] == HalfState_e::e_Ready) {
+                m_state[half] = HalfState_e::e_Draining;
+                m_inEndpoint.write(m_ring[half], m_length[half]);
+                return;
+            }
+        }
+    }
+
+public:
+    UsbBulkOutLoopbackRingApplicationT(InEndpointT &p_inEndpoint, const OutFlowControlT &p_outFlowControl)
+      : m_inEndpoint(p_inEndpoint), m_outFlowControl(p_outFlowControl),
+        m_length { 0, 0 }, m_state { HalfState_e::e_Filling, HalfState_e::e_Free },
+        m_fill(0), m_outNaked(false), m_inZlp(false), m_dropped(0) {
+        m_inEndpoint.registerApplication(*this);
+    }
+
+    ~UsbBulkOutLoopbackRingApplicationT() {
+        m_inEndpoint.unregisterApplication();
+    }
+
+    void *
+    lendOutBuffer(void) override {
+        if (m_outNaked || (m_state[m_fill] != HalfState_e::e_Filling)) {
+            return nullptr;
+        }
+
+        return &m_ring[m_fill][m_length[m_fill]];
+    }
+
+    void
+    packetReceived(const void * const p_data, const size_t p_length) override {
+        const size_t length = p_length < nPacketSz ? p_length : nPacketSz;
+        uint8_t * const slot = &m_ring[m_fill][m_length[m_fill]];
+
+        /* Packet was on its Way before the NAK took effect (copying Endpoint only) */
+        if ((m_state[m_fill] != HalfState_e::e_Filling) || ((m_length[m_fill] + length) > m_halfSz)) {
+            m_dropped++;
+            return;
+        }
+
+        /* Already in Place if the Endpoint wrote to the lent Slot */
+        if (p_data != slot) {
+            ::memcpy(slot, p_data, length);
+        }
+        m_length[m_fill] += length;
+
+        if ((length < nPacketSz) || ((m_length[m_fill] + nPacketSz) > m_halfSz) || isInIdle()) {
+            if (m_length[m_fill] > 0) {
+                commit();
+            }
+        }
+    }
+
+    /** @brief Number of OUT Packets that arrived while the Ring was full. */
+    unsigned
+    getDropped(void) const {
+        return m_dropped;
+    }
+
+    void
+    inTransferComplete(void) override {
+        bool packetBoundary = false;
+
+        m_inZlp = false;
+
+        for (unsigned half = 0; half < 2; half++) {
+            if (m_state[half] == HalfState_e::e_Draining) {
+                packetBoundary = ((m_length[half] % nPacketSz) == 0);
+                m_state[half] = HalfState_e::e_Free;
+
+                if (m_outNaked) {
+                    m_fill          = half;
+                    m_length[half]  = 0;
+                    m_state[half]   = HalfState_e::e_Filling;
+                    m_outNaked      = false;
+
+                    m_outFlowControl.clearNak();
+                }
+            }
+        }
+
+        kick();
+
+        /* Send what has arrived meanwhile, or end the Transfer on a Packet Boundary */
+        if (isInIdle()) {
+            if ((m_state[m_fill] == HalfState_e::e_Filling) && (m_length[m_fill] > 0)) {
+                commit();
+            } else if (packetBoundary) {
+                m_inZlp = true;
+                m_inEndpoint.write(m_ring[m_fill], 0);
+            }
+        }
+    }
+};
+
+} /* namespace usb */
+
+#endif /* _USB_LOOPBACK_RING_APPLICATION_HPP_6D1F4A27_ */
@@ -0,0 +1,522 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _USB_MASS_STORAGE_HPP_B1E79C34_
+#define _USB_MASS_STORAGE_HPP_B1E79C34_
+
+#include <usb/UsbApplication.hpp>
+#include <usb/UsbBulkInApplication.hpp>
+#include <usb/UsbBulkOutZeroCopyApplication.hpp>
+#include <usb/UsbBlockDevice.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace usb {
+
+typedef enum UsbMscSignature_e : uint32_t {
+    e_UsbMscSignature_Cbw   = 0x43425355,   /**< "USBC" */
+    e_UsbMscSignature_Csw   = 0x53425355    /**< "USBS" */
+} UsbMscSignature_t;
+
+typedef enum UsbMscStatus_e : uint8_t {
+    e_UsbMscStatus_Passed       = 0x00,
+    e_UsbMscStatus_Failed       = 0x01,
+    e_UsbMscStatus_PhaseError   = 0x02
+} UsbMscStatus_t;
+
+/***************************************************************************//**
+ * @brief Command Block Wrapper of the Bulk-Only Transport, see USB MSC BOT
+ *   1.0, Section 5.1.
+ ******************************************************************************/
+typedef struct UsbMscCbw_s {
+    uint32_t    m_dCBWSignature;
+    uint32_t    m_dCBWTag;
+    uint32_t    m_dCBWDataTransferLength;
+    uint8_t     m_bmCBWFlags;           /**< Bit 7: Data-In */
+    uint8_t     m_bCBWLUN;
+    uint8_t     m_bCBWCBLength;
+    uint8_t     m_CBWCB[16];
+} __attribute__((packed)) UsbMscCbw_t;
+
+static_assert(sizeof(UsbMscCbw_t) == 31, "Command Block Wrapper must be 31 Bytes");
+
+/***************************************************************************//**
+ * @brief Command Status Wrapper of the Bulk-Only Transport, see USB MSC BOT
+ *   1.0, Section 5.2.
+ ******************************************************************************/
+typedef struct UsbMscCsw_s {
+    uint32_t    m_dCSWSignature;
+    uint32_t    m_dCSWTag;
+    uint32_t    m_dCSWDataResidue;
+    uint8_t     m_bCSWStatus;
+} __attribute__((packed)) UsbMscCsw_t;
+
+static_assert(sizeof(UsbMscCsw_t) == 13, "Command Status Wrapper must be 13 Bytes");
+
+typedef enum UsbScsiOpcode_e : uint8_t {
+    e_UsbScsiOpcode_TestUnitReady           = 0x00,
+    e_UsbScsiOpcode_RequestSense            = 0x03,
+    e_UsbScsiOpcode_Inquiry                 = 0x12,
+    e_UsbScsiOpcode_ModeSense6              = 0x1A,
+    e_UsbScsiOpcode_PreventAllowRemoval     = 0x1E,
+    e_UsbScsiOpcode_ReadCapacity10          = 0x25,
+    e_UsbScsiOpcode_Read10                  = 0x28,
+    e_UsbScsiOpcode_Write10                 = 0x2A
+} UsbScsiOpcode_t;
+
+typedef enum UsbScsiSenseKey_e : uint8_t {
+    e_UsbScsiSenseKey_NoSense               = 0x00,
+    e_UsbScsiSenseKey_MediumError           = 0x03,
+    e_UsbScsiSenseKey_IllegalRequest        = 0x05,
+    e_UsbScsiSenseKey_DataProtect           = 0x07
+} UsbScsiSenseKey_t;
+
+/** @brief Additional Sense Codes, see SPC-3, Table 27. */
+typedef enum UsbScsiAsc_e : uint8_t {
+    e_UsbScsiAsc_None                       = 0x00,
+    e_UsbScsiAsc_WriteError                 = 0x0C,
+    e_UsbScsiAsc_UnrecoveredReadError       = 0x11,
+    e_UsbScsiAsc_InvalidOpcode              = 0x20,
+    e_UsbScsiAsc_LbaOutOfRange              = 0x21,
+    e_UsbScsiAsc_InvalidFieldInCdb          = 0x24,
+    e_UsbScsiAsc_WriteProtected             = 0x27
+} UsbScsiAsc_t;
+
+/***************************************************************************//**
+ * @brief Mass Storage Function (Bulk-Only Transport, SCSI Transparent Command
+ *   Set) on a ::usb::UsbBlockDevice.
+ *
+ * Supports a single LUN with INQUIRY, TEST UNIT READY, REQUEST SENSE,
+ * READ CAPACITY(10), READ(10) and WRITE(10), plus MODE SENSE(6) and PREVENT
+ * ALLOW MEDIUM REMOVAL, which Hosts issue before they mount a Disk. Other
+ * Commands fail with ILLEGAL REQUEST.
+ *
+ * READ(10) Data is handed to the IN Endpoint one Chunk at a Time, straight from
+ * the Medium if it is memory-mapped, see ::usb::UsbBlockDevice::map(). Otherwise
+ * the next Chunk is read into the second of two Buffers while the first one is
+ * sent. Within a Chunk, the IN Endpoint loads the next Packet into the TX FIFO
+ * while the Host takes the current one, so the TX FIFO must hold two Packets.
+ *
+ * WRITE(10) Data goes to the Medium Packet by Packet as it arrives. If the
+ * Medium lends its Memory (see ::usb::UsbBlockDevice::lend()) and the OUT
+ * Endpoint is a zero-copy one such as
+ * ::stm32::usb::BulkOutEndpointZeroCopyViaSTM32F4, the Packets are stored
+ * there straight from the RX FIFO.
+ *
+ * Mismatches between the Host's and the Device's Expectation (see BOT 1.0,
+ * Section 6.7) are resolved without stalling the Bulk Endpoints: Data the
+ * Device does not have is padded with Zeros, Data it does not expect is
+ * discarded, and the CSW reports the Residue and, where the Specification
+ * demands it, a Phase Error.
+ *
+ * An invalid CBW, e.g. a short one or one with a wrong Signature, halts both
+ * Bulk Endpoints until the Host performs a Reset Recovery (BOT 1.0, Sections
+ * 5.3.4 and 6.6.1): reset() is called for \c BULK_ONLY_MASS_STORAGE_RESET, and
+ * the Halts are lifted by the Host's \c CLEAR_FEATURE(ENDPOINT_HALT), which
+ * ::usb::UsbDevice answers. Like the Data Toggles, the Halts survive reset().
+ * An OUT Packet that arrives before reset() renews the Halt of the OUT
+ * Endpoint.
+ *
+ * The Host may send the next CBW before the IN Endpoint has reported the
+ * previous CSW as sent. The CBW is then held and the OUT Endpoint NAK'ed until
+ * the CSW is complete.
+ *
+ * All Callbacks run in the Context of the USB Interrupt.
+ *
+ * @tparam InEndpointT Bulk IN Endpoint with \c setStall(), e.g.
+ *   ::stm32::usb::BulkInEndpointFifoViaSTM32F4.
+ * @tparam OutFlowControlT NAK and Stall Control of the OUT Endpoint, e.g.
+ *   ::stm32::usb::BulkOutEndpointZeroCopyViaSTM32F4.
+ * @tparam nInFifoSzInWords Size of the IN Endpoint's TX FIFO in 32-Bit Words.
+ * @tparam nPacketSz Max. Packet Size of the Bulk Endpoints.
+ * @tparam nChunkSz Bytes per IN Transfer during READ(10); must divide a Block.
+ ******************************************************************************/
+template<
+  typename InEndpointT,
+  typename OutFlowControlT,
+  size_t nInFifoSzInWords,
+  size_t nPacketSz = 64,
+  size_t nChunkSz = UsbBlockDevice::m_blockSz
+>
+class UsbMassStorageT : public UsbBulkOutZeroCopyApplication, public UsbBulkInApplication {
+    static_assert((nPacketSz > 0) && (nPacketSz <= 64) && ((nPacketSz & (nPacketSz - 1)) == 0),
+      "Full Speed Bulk Endpoints support Max. Packet Sizes of 8, 16, 32 or 64 Bytes");
+    static_assert(nPacketSz >= sizeof(UsbMscCbw_t), "CBW must fit into a single Packet");
+    static_assert(((UsbBlockDevice::m_blockSz % nChunkSz) == 0) && ((nChunkSz % nPacketSz) == 0),
+      "Chunk must divide a Block and consist of full Packets");
+    static_assert((nInFifoSzInWords * sizeof(uint32_t)) >= (2 * nPacketSz),
+      "IN FIFO must hold two Packets so the next one can be staged while the current one is sent");
+
+    enum class State_e : uint8_t {
+        e_Command,
+        e_DataIn,
+        e_DataOut,
+        e_Status,
+        e_Halted        /**< Invalid CBW; waiting for the Reset Recovery */
+    };
+
+    static constexpr uint8_t    m_inquiryData[36] = {
+        0x00,                                       /* Direct Access Block Device */
+        0x80,                                       /* Removable */
+        0x04,                                       /* SPC-2 */
+        0x02,                                       /* Response Data Format */
+        36 - 5,                                     /* Additional Length */
+        0x00, 0x00, 0x00,
+        'P', 'h', 'i', 'S', 'c', 'h', ' ', ' ',     /* Vendor */
+        'S', 'T', 'M', '3', '2', 'F', '4', ' ',     /* Product */
+        'L', 'o', 'g', ' ', 'D', 'i', 's', 'k',
+        '1', '.', '0', ' '                          /* Revision */
+    };
+
+    InEndpointT &               m_inEndpoint;
+    const OutFlowControlT &     m_outFlowControl;
+    UsbBlockDevice &            m_disk;
+
+    State_e                     m_state;
+    bool                        m_cbwPending;
+    size_t                      m_cbwLength;
+
+    UsbMscCbw_t                 m_cbw;
+    UsbMscCsw_t                 m_csw;
+    UsbScsiSenseKey_t           m_senseKey;
+    UsbScsiAsc_t                m_asc;
+
+    /** @brief Data Stage: Bytes the Host expects, Bytes backed by Data and Bytes moved so far. */
+    uint32_t                    m_length;
+    uint32_t                    m_valid;
+    uint32_t                    m_offset;
+    /** @brief Data Stage is backed by the Medium from Block m_lba on, else by m_response. */
+    bool                        m_useDisk;
+    uint32_t                    m_lba;
+
+    alignas(4) uint8_t          m_packet[nPacketSz];
+    alignas(4) uint8_t          m_response[sizeof(m_inquiryData)];
+    alignas(4) uint8_t          m_chunk[2][nChunkSz];
+    unsigned                    m_fill;
+    /** @brief Chunk prepared for the IN Endpoint, \c nullptr if none. */
+    const uint8_t *             m_next;
+    size_t                      m_nextLength;
+
+    void
+    setSense(const UsbScsiSenseKey_t p_senseKey, const UsbScsiAsc_t p_asc) {
+        m_senseKey  = p_senseKey;
+        m_asc       = p_asc;
+    }
+
+    void
+    fail(const UsbScsiSenseKey_t p_senseKey, const UsbScsiAsc_t p_asc) {
+        setSense(p_senseKey, p_asc);
+        m_csw.m_bCSWStatus = e_UsbMscStatus_Failed;
+    }
+
+    static uint32_t
+    getBigEndian32(const uint8_t * const p_data) {
+        return (p_data[0] << 24) | (p_data[1] << 16) | (p_data[2] << 8) | p_data[3];
+    }
+
+    static void
+    setBigEndian32(uint8_t * const p_data, const uint32_t p_value) {
+        p_data[0] = (p_value >> 24) & 0xFF;
+        p_data[1] = (p_value >> 16) & 0xFF;
+        p_data[2] = (p_value >>  8) & 0xFF;
+        p_data[3] = (p_value >>  0) & 0xFF;
+    }
+
+    /**
+     * @brief Execute the SCSI Command of m_cbw.
+     *
+     * @return Bytes of Data the Device intends to transfer; \p p_isIn tells the
+     *   Direction.
+     */
+    uint32_t
+    execute(bool &p_isIn) {
+        const uint8_t * const cdb = m_cbw.m_CBWCB;
+
+        p_isIn      = true;
+        m_useDisk   = false;
+
+        switch (cdb[0]) {
+        case e_UsbScsiOpcode_TestUnitReady:
+        case e_UsbScsiOpcode_PreventAllowRemoval:
+            return 0;
+        case e_UsbScsiOpcode_RequestSense:
+            ::memset(m_response, 0, 18);
+            m_response[0]   = 0x70;                 /* Current Error, Fixed Format */
+            m_response[2]   = m_senseKey;
+            m_response[7]   = 18 - 8;               /* Additional Sense Length */
+            m_response[12]  = m_asc;
+            setSense(e_UsbScsiSenseKey_NoSense, e_UsbScsiAsc_None);
+            return (cdb[4] < 18) ? cdb[4] : 18;
+        case e_UsbScsiOpcode_Inquiry:
+            if (cdb[1] & 0x01) {
+                /* No Vital Product Data Pages */
+                fail(e_UsbScsiSenseKey_IllegalRequest, e_UsbScsiAsc_InvalidFieldInCdb);
+                return 0;
+            }
+            ::memcpy(m_response, m_inquiryData, sizeof(m_inquiryData));
+            return (cdb[4] < sizeof(m_inquiryData)) ? cdb[4] : sizeof(m_inquiryData);
+        case e_UsbScsiOpcode_ModeSense6:
+            m_response[0] = 3;                      /* Mode Data Length */
+            m_response[1] = 0;                      /* Medium Type */
+            m_response[2] = m_disk.isWriteProtected() ? 0x80 : 0x00;
+            m_response[3] = 0;                      /* No Block Descriptors */
+            return (cdb[4] < 4) ? cdb[4] : 4;
+        case e_UsbScsiOpcode_ReadCapacity10:
+            setBigEndian32(&m_response[0], m_disk.getNumBlocks() - 1);
+            setBigEndian32(&m_response[4], UsbBlockDevice::m_blockSz);
+            return 8;
+        case e_UsbScsiOpcode_Read10:
+        case e_UsbScsiOpcode_Write10: {
+            const uint32_t lba          = getBigEndian32(&cdb[2]);
+            const uint32_t numBlocks    = (cdb[7] << 8) | cdb[8];
+
+            p_isIn = (cdb[0] == e_UsbScsiOpcode_Read10);
+
+            if ((lba > m_disk.getNumBlocks()) || (numBlocks > (m_disk.getNumBlocks() - lba))) {
+                fail(e_UsbScsiSenseKey_IllegalRequest, e_UsbScsiAsc_LbaOutOfRange);
+                return 0;
+            }
+            if (!p_isIn && m_disk.isWriteProtected()) {
+                fail(e_UsbScsiSenseKey_DataProtect, e_UsbScsiAsc_WriteProtected);
+                return 0;
+            }
+
+            m_useDisk   = true;
+            m_lba       = lba;
+            return numBlocks * UsbBlockDevice::m_blockSz;
+        }
+        default:
+            fail(e_UsbScsiSenseKey_IllegalRequest, e_UsbScsiAsc_InvalidOpcode);
+            return 0;
+        }
+    }
+
+    /** @brief Halt both Bulk Endpoints until the Reset Recovery, see BOT 1.0, Section 6.6.1. */
+    void
+    halt(void) {
+        m_state = State_e::e_Halted;
+        m_inEndpoint.setStall();
+        m_outFlowControl.setStall();
+    }
+
+    void
+    handleCbw(const size_t p_length) {
+        if (p_length != sizeof(m_cbw)) {
+            halt();
+            return;
+        }
+
+        ::memcpy(&m_cbw, m_packet, sizeof(m_cbw));
+        if ((m_cbw.m_dCBWSignature != e_UsbMscSignature_Cbw) || (m_cbw.m_bCBWLUN != 0)) {
+            halt();
+            return;
+        }
+
+        m_csw.m_dCSWSignature   = e_UsbMscSignature_Csw;
+        m_csw.m_dCSWTag         = m_cbw.m_dCBWTag;
+        m_csw.m_bCSWStatus      = e_UsbMscStatus_Passed;
+
+        bool            isIn;
+        const uint32_t  intended    = execute(isIn);
+        const bool      hostIsIn    = (m_cbw.m_bmCBWFlags & 0x80) != 0;
+
+        m_length    = m_cbw.m_dCBWDataTransferLength;
+        m_offset    = 0;
+        m_valid     = (intended < m_length) ? intended : m_length;
+
+        /* Cases 2, 3, 7, 8, 10 and 13 of BOT 1.0, Section 6.7 */
+        if ((intended > m_length) || ((intended > 0) && (isIn != hostIsIn))) {
+            m_csw.m_bCSWStatus = e_UsbMscStatus_PhaseError;
+        }
+        if ((intended > 0) && (isIn != hostIsIn)) {
+            m_valid = 0;
+        }
+        m_csw.m_dCSWDataResidue = m_length - m_valid;
+
+        if (m_length == 0) {
+            sendStatus();
+        } else if (hostIsIn) {
+            m_state = State_e::e_DataIn;
+            m_fill  = 0;
+            stage();
+            send();
+            stage();
+        } else {
+            m_state = State_e::e_DataOut;
+        }
+    }
+
+    /** @brief Prepare the next Chunk of the Data-In Stage, unless one is prepared already. */
+    void
+    stage(void) {
+        const uint32_t staged = m_offset + ((m_next != nullptr) ? m_nextLength : 0);
+
+        if ((m_next != nullptr) || (staged >= m_length)) {
+            return;
+        }
+
+        const size_t length = ((m_length - staged) < nChunkSz) ? (m_length - staged) : nChunkSz;
+        const uint32_t block = m_lba + (staged / UsbBlockDevice::m_blockSz);
+        const size_t offset  = staged % UsbBlockDevice::m_blockSz;
+
+        m_nextLength = length;
+
+        if (m_useDisk && ((staged + length) <= m_valid) && (m_disk.map(block) != nullptr)) {
+            m_next = static_cast<const uint8_t *>(m_disk.map(block)) + offset;
+            return;
+        }
+
+        uint8_t * const chunk   = m_chunk[m_fill];
+        const size_t    valid   = (staged >= m_valid) ? 0 : (((m_valid - staged) < length) ? (m_valid - staged) : length);
+
+        if (valid > 0) {
+            if (!m_useDisk) {
+                ::memcpy(chunk, &m_response[staged], valid);
+            } else if (!m_disk.read(block, offset, chunk, valid)) {
+                fail(e_UsbScsiSenseKey_MediumError, e_UsbScsiAsc_UnrecoveredReadError);
+            }
+        }
+        ::memset(&chunk[valid], 0, length - valid);
+
+        m_next = chunk;
+        m_fill ^= 1;
+    }
+
+    void
+    send(void) {
+        const uint8_t * const data = m_next;
+
+        m_next = nullptr;
+        m_inEndpoint.write(data, m_nextLength);
+        m_offset += m_nextLength;
+    }
+
+    void
+    sendStatus(void) {
+        m_state = State_e::e_Status;
+        m_inEndpoint.write(reinterpret_cast<const uint8_t *>(&m_csw), sizeof(m_csw));
+    }
+
+public:
+    UsbMassStorageT(InEndpointT &p_inEndpoint, const OutFlowControlT &p_outFlowControl, UsbBlockDevice &p_disk)
+      : m_inEndpoint(p_inEndpoint), m_outFlowControl(p_outFlowControl), m_disk(p_disk),
+        m_state(State_e::e_Command), m_cbwPending(false), m_cbwLength(0), m_cbw {}, m_csw {},
+        m_senseKey(e_UsbScsiSenseKey_NoSense), m_asc(e_UsbScsiAsc_None),
+        m_length(0), m_valid(0), m_offset(0), m_useDisk(false), m_lba(0),
+        m_fill(0), m_next(nullptr), m_nextLength(0) {
+        m_inEndpoint.registerApplication(*this);
+    }
+
+    ~UsbMassStorageT() {
+        m_inEndpoint.unregisterApplication();
+    }
+
+    /** @brief Bulk-Only Mass Storage Reset: Wait for the next CBW. Endpoint Halts are kept. */
+    void
+    reset(void) {
+        m_state     = State_e::e_Command;
+        m_next      = nullptr;
+        if (m_cbwPending) {
+            m_cbwPending = false;
+            m_outFlowControl.clearNak();
+        }
+    }
+
+    void *
+    lendOutBuffer(void) override {
+        if (m_cbwPending) {
+            return nullptr;
+        }
+
+        if ((m_state == State_e::e_DataOut) && m_useDisk && (m_offset < m_valid) && ((m_valid - m_offset) >= nPacketSz)) {
+            void * const data = m_disk.lend(m_lba + (m_offset / UsbBlockDevice::m_blockSz), m_offset % UsbBlockDevice::m_blockSz, nPacketSz);
+            if (data != nullptr) {
+                return data;
+            }
+        }
+
+        return m_packet;
+    }
+
+    void
+    packetReceived(const void * const p_data, const size_t p_length) override {
+        switch (m_state) {
+        case State_e::e_Command:
+        case State_e::e_Status:
+            if (p_data != m_packet) {
+                ::memcpy(m_packet, p_data, (p_length < nPacketSz) ? p_length : nPacketSz);
+            }
+
+            if (m_state == State_e::e_Command) {
+                handleCbw(p_length);
+            } else {
+                /* CBW overtook the Completion of the last CSW */
+                m_cbwPending    = true;
+                m_cbwLength     = p_length;
+                m_outFlowControl.setNak();
+            }
+            break;
+        case State_e::e_DataOut: {
+            const size_t length = ((m_length - m_offset) < p_length) ? (m_length - m_offset) : p_length;
+
+            if (m_offset < m_valid) {
+                const size_t valid = ((m_valid - m_offset) < length) ? (m_valid - m_offset) : length;
+
+                if (!m_disk.write(m_lba + (m_offset / UsbBlockDevice::m_blockSz), m_offset % UsbBlockDevice::m_blockSz, p_data, valid)) {
+                    fail(e_UsbScsiSenseKey_MediumError, e_UsbScsiAsc_WriteError);
+                }
+            }
+            m_offset += length;
+
+            if ((m_offset >= m_length) || (p_length < nPacketSz)) {
+                /* A short Packet ends the Transfer early; the Residue counts what the Host held back */
+                const uint32_t processed = (m_offset < m_valid) ? m_offset : m_valid;
+
+                m_csw.m_dCSWDataResidue = m_length - processed;
+                sendStatus();
+            }
+            break;
+        }
+        case State_e::e_DataIn:
+            /* Host must not send during the Data-In Stage */
+            break;
+        case State_e::e_Halted:
+            /* Host has cleared the Halt before the Reset Recovery */
+            m_outFlowControl.setStall();
+            break;
+        }
+    }
+
+    void
+    inTransferComplete(void) override {
+        switch (m_state) {
+        case State_e::e_DataIn:
+            if (m_next != nullptr) {
+                send();
+                stage();
+            } else if (m_offset >= m_length) {
+                sendStatus();
+            }
+            break;
+        case State_e::e_Status:
+            m_state = State_e::e_Command;
+            if (m_cbwPending) {
+                m_cbwPending = false;
+                handleCbw(m_cbwLength);
+                m_outFlowControl.clearNak();
+            }
+            break;
+        default:
+            break;
+        }
+    }
+};
+
+} /* namespace usb */
+
+#endif /* _USB_MASS_STORAGE_HPP_B1E79C34_ */
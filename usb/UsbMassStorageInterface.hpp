@@ -0,0 +1,70 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _USB_MASS_STORAGE_INTERFACE_HPP_0A6F3D82_
+#define _USB_MASS_STORAGE_INTERFACE_HPP_0A6F3D82_
+
+#include <usb/UsbTypes.hpp>
+#include <usb/UsbInterface.hpp>
+#include <usb/UsbControlPipe.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace usb {
+
+/***************************************************************************//**
+ * @brief Class-specific Requests of the Bulk-Only Transport, see USB MSC BOT
+ *   1.0, Section 3.
+ ******************************************************************************/
+typedef enum UsbMscRequest_e : uint8_t {
+    e_UsbMscRequest_GetMaxLun               = 0xFE,
+    e_UsbMscRequest_BulkOnlyReset           = 0xFF
+} UsbMscRequest_t;
+
+/***************************************************************************//**
+ * @brief Interface of a Mass Storage Function, see ::usb::UsbMassStorageT.
+ *
+ * Extends ::usb::UsbVendorInterface by the two Class Requests of the Bulk-Only
+ * Transport:
+ * - \c GET_MAX_LUN (Device-to-Host) returns zero, i.e. a single LUN.
+ * - \c BULK_ONLY_MASS_STORAGE_RESET (Host-to-Device, no Data Stage) makes the
+ *   Function wait for the next CBW.
+ *
+ * @tparam MassStorageT Mass Storage Function, e.g. ::usb::UsbMassStorageT.
+ ******************************************************************************/
+template<typename MassStorageT>
+class UsbMassStorageInterfaceT : public UsbVendorInterface {
+    MassStorageT &  m_massStorage;
+    const uint8_t   m_maxLun;
+
+public:
+    template<typename UsbBulkOutEndpointT, typename UsbBulkInEndpointT>
+    UsbMassStorageInterfaceT(MassStorageT &p_massStorage, UsbBulkOutEndpointT &p_outEndpoint, UsbBulkInEndpointT &p_inEndpoint)
+      : UsbVendorInterface(p_outEndpoint, p_inEndpoint), m_massStorage(p_massStorage), m_maxLun(0) {
+
+    }
+
+    void
+    handleCtrlRequest(const UsbSetupPacket_t &p_setupPacket, UsbControlPipe &p_ctrlPipe) override {
+        switch (p_setupPacket.m_bRequest) {
+        case e_UsbMscRequest_GetMaxLun:
+            p_ctrlPipe.write(&m_maxLun, (p_setupPacket.m_wLength < sizeof(m_maxLun)) ? p_setupPacket.m_wLength : sizeof(m_maxLun));
+            break;
+        case e_UsbMscRequest_BulkOnlyReset:
+            m_massStorage.reset();
+            p_ctrlPipe.write(nullptr, 0); /* Status Stage */
+            break;
+        default:
+            UsbVendorInterface::handleCtrlRequest(p_setupPacket, p_ctrlPipe);
+            break;
+        }
+    }
+};
+
+} /* namespace usb */
+
+#endif /* _USB_MASS_STORAGE_INTERFACE_HPP_0A6F3D82_ */
@@ -0,0 +1,71 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _USB_REMOTE_WAKEUP_HPP_3F81C6A9_
+#define _USB_REMOTE_WAKEUP_HPP_3F81C6A9_
+
+#include <usb/UsbTypes.hpp>
+#include <usb/UsbControlPipe.hpp>
+
+#include <cstdint>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace usb {
+
+/***************************************************************************//**
+ * @brief Passes the Host's \c SET_FEATURE / \c CLEAR_FEATURE
+ *   (\c DEVICE_REMOTE_WAKEUP) on to the Remote Wakeup Driver.
+ *
+ * ::usb::UsbDevice answers both Requests itself, so the Driver would not know
+ * whether the Host has enabled Remote Wakeup. Like
+ * ::usb::UsbConfigurationListenerDeviceT, this derives from \p DeviceT and
+ * takes the same Constructor Arguments. All Requests go to \p DeviceT
+ * unchanged; afterwards, the Feature Selector is passed on via
+ * \c setRemoteWakeupEnabled().
+ *
+ * The Driver must disable Remote Wakeup on a Bus Reset itself (USB 2.0 Spec,
+ * Section 9.1.1.5), as no Request marks it.
+ *
+ * @tparam DeviceT Device Class, e.g. ::usb::UsbFunctionStringsDevice.
+ * @tparam RemoteWakeupT Driver with \c setRemoteWakeupEnabled(bool), e.g.
+ *   ::stm32::usb::UsbSuspendViaSTM32F4.
+ ******************************************************************************/
+template<typename DeviceT, typename RemoteWakeupT>
+class UsbRemoteWakeupDeviceT : public DeviceT {
+    static constexpr uint8_t    m_requestClearFeature               = 0x01;
+    static constexpr uint8_t    m_requestSetFeature                 = 0x03;
+    static constexpr uint16_t   m_featureSelectorRemoteWakeup       = 0x01;
+
+    RemoteWakeupT *     m_remoteWakeup = nullptr;
+
+public:
+    using DeviceT::DeviceT;
+
+    void
+    setRemoteWakeup(RemoteWakeupT &p_remoteWakeup) {
+        m_remoteWakeup = &p_remoteWakeup;
+    }
+
+    void
+    handleCtrlRequest(const UsbSetupPacket_t &p_setupPacket, UsbControlPipe &p_ctrlPipe) override {
+        DeviceT::handleCtrlRequest(p_setupPacket, p_ctrlPipe);
+
+        /* Standard Request, Host to Device, Recipient Device */
+        if ((m_remoteWakeup == nullptr) || (static_cast<uint8_t>(p_setupPacket.m_bmRequestType) != 0x00)
+          || (p_setupPacket.m_wValue != m_featureSelectorRemoteWakeup)) {
+            return;
+        }
+
+        if (p_setupPacket.m_bRequest == m_requestSetFeature) {
+            m_remoteWakeup->setRemoteWakeupEnabled(true);
+        } else if (p_setupPacket.m_bRequest == m_requestClearFeature) {
+            m_remoteWakeup->setRemoteWakeupEnabled(false);
+        }
+    }
+};
+
+} /* namespace usb */
+
+#endif /* _USB_REMOTE_WAKEUP_HPP_3F81C6A9_ */
@@ -0,0 +1,225 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _USB_SUSPEND_VIA_STM32F4_HPP_E15B7D04_
+#define _USB_SUSPEND_VIA_STM32F4_HPP_E15B7D04_
+
+#include <stm32f4xx.h>
+
+#include <cstdint>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace stm32 {
+    namespace usb {
+
+/***************************************************************************//**
+ * @brief USB Suspend / Resume Handling of the STM32F4 OTG Core.
+ *
+ * When the Host stops sending SOFs for 3 ms, the Core reports \c USBSUSP.
+ * handleIrq() then stops the PHY Clock and gates HCLK to the Core via
+ * \c PCGCCTL. The Application may now put the CPU into a low-power Mode, see
+ * ::stm32::LowPower. Any Bus Activity raises the OTG Wakeup EXTI Line (18 for
+ * OTG_FS, 20 for OTG_HS). handleWakeupIrq() ungates the Clocks, so the Core
+ * can report the Resume via \c WKUPINT. A Bus Reset during Suspend ends the
+ * Suspend as well.
+ *
+ * Remote Wakeup is signalled via startRemoteWakeup() and must be ended via
+ * stopRemoteWakeup() after 1 to 15 ms (USB 2.0 Spec, 7.1.7.7). It is only
+ * signalled if the Host has enabled it. The Standard \c SET_FEATURE Request is
+ * answered by ::usb::UsbDevice, so the Host's Choice must be passed on via
+ * setRemoteWakeupEnabled(), see ::usb::UsbRemoteWakeupDeviceT. A Bus Reset
+ * disables Remote Wakeup again. The
+ * Configuration Descriptor must advertise Remote Wakeup in \c bmAttributes.
+ *
+ * handleIrq() must be called from the OTG Interrupt Handler before the Core's
+ * own \c handleIrq(). It consumes \c USBSUSP and \c WKUPINT.
+ *
+ * The Base Address of the OTG Register Block is a Constructor Parameter so that
+ * the Class can be pointed at a Register Model in the Host Build.
+ ******************************************************************************/
+class UsbSuspendViaSTM32F4 {
+public:
+    static constexpr unsigned   m_extiLineOtgFs = 18;
+    static constexpr unsigned   m_extiLineOtgHs = 20;
+
+private:
+    const uintptr_t             m_otgBase;
+    const uint32_t              m_extiLine;
+    volatile bool               m_suspended;
+    volatile bool               m_remoteWakeupEnabled;
+    volatile bool               m_remoteWakeupRequested;
+
+    USB_OTG_GlobalTypeDef *
+    global(void) const {
+        return reinterpret_cast<USB_OTG_GlobalTypeDef *>(m_otgBase);
+    }
+
+    USB_OTG_DeviceTypeDef *
+    device(void) const {
+        return reinterpret_cast<USB_OTG_DeviceTypeDef *>(m_otgBase + USB_OTG_DEVICE_BASE);
+    }
+
+    volatile uint32_t *
+    pcgcctl(void) const {
+        return reinterpret_cast<volatile uint32_t *>(m_otgBase + USB_OTG_PCGCCTL_BASE);
+    }
+
+    void
+    gateClocks(void) const {
+        *pcgcctl() |= USB_OTG_PCGCCTL_STOPCLK | USB_OTG_PCGCCTL_GATECLK;
+    }
+
+    void
+    ungateClocks(void) const {
+        *pcgcctl() &= ~(USB_OTG_PCGCCTL_STOPCLK | USB_OTG_PCGCCTL_GATECLK);
+    }
+
+public:
+    /**
+     * @param p_otgBase Base Address of the OTG Register Block.
+     * @param p_extiLine Wakeup EXTI Line of the Core, \c m_extiLineOtgFs or \c m_extiLineOtgHs.
+     */
+    constexpr UsbSuspendViaSTM32F4(const uintptr_t p_otgBase = USB_OTG_FS_PERIPH_BASE, const unsigned p_extiLine = m_extiLineOtgFs)
+      : m_otgBase(p_otgBase), m_extiLine(1u << p_extiLine), m_suspended(false),
+        m_remoteWakeupEnabled(false), m_remoteWakeupRequested(false) {
+
+    }
+
+    /** @brief Unmask the Suspend / Resume Interrupts and the Wakeup EXTI Line. Must be called after the Core has been started. */
+    void
+    enable(void) const {
+        EXTI->PR    = m_extiLine;
+        EXTI->RTSR  |= m_extiLine;
+        EXTI->IMR   |= m_extiLine;
+
+        global()->GINTMSK |= USB_OTG_GINTMSK_USBSUSPM | USB_OTG_GINTMSK_WUIM;
+    }
+
+    void
+    disable(void) const {
+        global()->GINTMSK &= ~(USB_OTG_GINTMSK_USBSUSPM | USB_OTG_GINTMSK_WUIM);
+
+        EXTI->IMR   &= ~m_extiLine;
+        EXTI->RTSR  &= ~m_extiLine;
+    }
+
+    bool
+    isSuspended(void) const {
+        return m_suspended;
+    }
+
+    void
+    setRemoteWakeupEnabled(const bool p_enabled) {
+        m_remoteWakeupEnabled = p_enabled;
+    }
+
+    bool
+    isRemoteWakeupEnabled(void) const {
+        return m_remoteWakeupEnabled;
+    }
+
+    /**
+     * @brief Ask for Remote Wakeup, e.g. because Data for the Host has arrived.
+     *
+     * May be called from any Interrupt. The Request is dropped when the Host
+     * resumes the Bus by itself.
+     *
+     * @return \c false if the Bus is not suspended or the Host has not enabled
+     *   Remote Wakeup.
+     */
+    bool
+    requestRemoteWakeup(void) {
+        if (!m_suspended || !m_remoteWakeupEnabled) {
+            return false;
+        }
+
+        m_remoteWakeupRequested = true;
+        return true;
+    }
+
+    bool
+    isRemoteWakeupRequested(void) const {
+        return m_remoteWakeupRequested;
+    }
+
+    /**
+     * @brief Start driving Resume Signalling onto the Bus.
+     *
+     * @return \c false if the Bus is not suspended or the Host has not enabled
+     *   Remote Wakeup.
+     */
+    bool
+    startRemoteWakeup(void) {
+        m_remoteWakeupRequested = false;
+
+        if (!m_suspended || !m_remoteWakeupEnabled) {
+            return false;
+        }
+
+        ungateClocks();
+        device()->DCTL |= USB_OTG_DCTL_RWUSIG;
+
+        return true;
+    }
+
+    /** @brief End Resume Signalling. The Host then resumes the Bus. */
+    void
+    stopRemoteWakeup(void) {
+        device()->DCTL &= ~USB_OTG_DCTL_RWUSIG;
+        m_suspended = false;
+    }
+
+    /**
+     * @brief Handle the Suspend / Resume Events of the Core.
+     *
+     * @return \c true if an Event was handled.
+     */
+    bool
+    handleIrq(void) {
+        const uint32_t gintsts = global()->GINTSTS & global()->GINTMSK;
+        bool handled = false;
+
+        if (gintsts & USB_OTG_GINTSTS_WKUINT) {
+            global()->GINTSTS = USB_OTG_GINTSTS_WKUINT;
+            ungateClocks();
+            m_suspended             = false;
+            m_remoteWakeupRequested = false;
+            handled = true;
+        }
+
+        /* Left for the Core, but ends the Suspend and disables Remote Wakeup (USB 2.0 Spec, 9.1.1.5) */
+        if (gintsts & USB_OTG_GINTSTS_USBRST) {
+            ungateClocks();
+            m_suspended             = false;
+            m_remoteWakeupEnabled   = false;
+            m_remoteWakeupRequested = false;
+        }
+
+        if (gintsts & USB_OTG_GINTSTS_USBSUSP) {
+            global()->GINTSTS = USB_OTG_GINTSTS_USBSUSP;
+
+            if (device()->DSTS & USB_OTG_DSTS_SUSPSTS) {
+                m_suspended = true;
+                gateClocks();
+            }
+            handled = true;
+        }
+
+        return handled;
+    }
+
+    /** @brief Handle the OTG Wakeup EXTI Interrupt. */
+    void
+    handleWakeupIrq(void) const {
+        EXTI->PR = m_extiLine;
+
+        ungateClocks();
+    }
+};
+
+    } /* namespace usb */
+} /* namespace stm32 */
+
+#endif /* _USB_SUSPEND_VIA_STM32F4_HPP_E15B7D04_ */
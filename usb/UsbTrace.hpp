@@ -0,0 +1,185 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _USB_TRACE_HPP_6D1F83A7_
+#define _USB_TRACE_HPP_6D1F83A7_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace usb {
+
+/***************************************************************************//**
+ * @brief Binary Trace Event, see ::usb::UsbTraceT.
+ *
+ * The Event only refers to its Format String by Address. The Host looks the
+ * String up in the ELF File, see \c USB_TRACE() and \c usbtrace-decode.py.
+ ******************************************************************************/
+typedef struct UsbTraceEvent_s {
+    uint32_t    m_format;       /**< Address of the Format String (lower 32 Bits in the Host Build). */
+    uint32_t    m_timestamp;    /**< Cycle Counter Reading. */
+    uint32_t    m_arg[2];       /**< Arguments referenced by the Format String. */
+} __attribute__((packed)) UsbTraceEvent_t;
+
+static_assert(sizeof(UsbTraceEvent_t) == 16, "Trace Event must be 16 Bytes");
+
+/***************************************************************************//**
+ * @brief Lock-free Ring of binary Trace Events.
+ *
+ * record() only stores the Address of the Format String, a Cycle Counter
+ * Timestamp and up to two Arguments, i.e. it takes a few dozen Cycles and may
+ * be called from any Interrupt or Task. Formatting is left to the Host.
+ *
+ * Producers reserve a Slot by advancing the Write Index via Compare-and-Swap
+ * and publish it by storing its Sequence Number once the Event is complete.
+ * The single Consumer, e.g. read() or drain(), stops at the first Slot that has
+ * been reserved but not yet published. If the Ring is full, new Events are
+ * dropped and counted, so the Events that are kept are always contiguous.
+ *
+ * Timestamps are taken before the Slot is reserved, so Events recorded by
+ * nested Interrupts may appear slightly out of Order.
+ *
+ * @tparam CycleCounterT Cycle Counter, e.g. ::stm32::DwtCycleCounter or
+ *   ::stm32::MockCycleCounter.
+ * @tparam nNumEvents Size of the Ring in Events, must be a Power of Two.
+ ******************************************************************************/
+template<typename CycleCounterT, size_t nNumEvents>
+class UsbTraceT {
+    static_assert((nNumEvents > 0) && ((nNumEvents & (nNumEvents - 1)) == 0), "Ring Size must be a Power of Two");
+
+    typedef struct Slot_s {
+        std::atomic<uint32_t>   m_sequence;     /**< Write Index + 1 once the Event is published. */
+        UsbTraceEvent_t         m_event;
+    } Slot_t;
+
+    /** @brief Events handed to the Sink per Call by drain(). */
+    static constexpr size_t     m_drainBatchSz = 8;
+
+    Slot_t                      m_slots[nNumEvents];
+    std::atomic<uint32_t>       m_writeIdx;
+    std::atomic<uint32_t>       m_readIdx;
+    std::atomic<uint32_t>       m_dropped;
+
+public:
+    UsbTraceT(void) : m_slots {}, m_writeIdx(0), m_readIdx(0), m_dropped(0) {
+
+    }
+
+    void
+    record(const char * const p_format, const uint32_t p_arg0 = 0, const uint32_t p_arg1 = 0) {
+        const uint32_t timestamp = CycleCounterT::read();
+        uint32_t writeIdx = m_writeIdx.load(std::memory_order_relaxed);
+
+        do {
+            if ((writeIdx - m_readIdx.load(std::memory_order_acquire)) >= nNumEvents) {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        } while (!m_writeIdx.compare_exchange_weak(writeIdx, writeIdx + 1, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+        Slot_t &slot = m_slots[writeIdx % nNumEvents];
+
+        slot.m_event.m_format       = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(p_format));
+        slot.m_event.m_timestamp    = timestamp;
+        slot.m_event.m_arg[0]       = p_arg0;
+        slot.m_event.m_arg[1]       = p_arg1;
+
+        slot.m_sequence.store(writeIdx + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Consumer Side. Only a single Context may call peek(), consume(),
+     *   read() or drain().
+     *
+     * Copies the oldest published Events without removing them from the Ring.
+     *
+     * @return Number of Events copied to \p p_events.
+     */
+    size_t
+    peek(UsbTraceEvent_t * const p_events, const size_t p_maxEvents) const {
+        uint32_t readIdx = m_readIdx.load(std::memory_order_relaxed);
+        size_t numEvents = 0;
+
+        while (numEvents < p_maxEvents) {
+            const Slot_t &slot = m_slots[readIdx % nNumEvents];
+
+            if (slot.m_sequence.load(std::memory_order_acquire) != (readIdx + 1)) {
+                break;
+            }
+
+            p_events[numEvents++] = slot.m_event;
+            readIdx++;
+        }
+
+        return numEvents;
+    }
+
+    /** @brief Remove \p p_numEvents Events, at most as many as the last peek() returned. */
+    void
+    consume(const size_t p_numEvents) {
+        m_readIdx.fetch_add(p_numEvents, std::memory_order_release);
+    }
+
+    /** @return Number of Events copied to \p p_events and removed from the Ring. */
+    size_t
+    read(UsbTraceEvent_t * const p_events, const size_t p_maxEvents) {
+        const size_t numEvents = peek(p_events, p_maxEvents);
+
+        consume(numEvents);
+        return numEvents;
+    }
+
+    /**
+     * @brief Hand all published Events to \p p_sink.
+     *
+     * @tparam SinkT Provides \c write(const UsbTraceEvent_t *, size_t).
+     *
+     * @return Number of Events handed to the Sink.
+     */
+    template<typename SinkT>
+    size_t
+    drain(SinkT &p_sink) {
+        UsbTraceEvent_t events[m_drainBatchSz];
+        size_t total = 0;
+
+        for (size_t numEvents = read(events, m_drainBatchSz); numEvents > 0; numEvents = read(events, m_drainBatchSz)) {
+            p_sink.write(events, numEvents);
+            total += numEvents;
+        }
+
+        return total;
+    }
+
+    /** @brief Events dropped because the Ring was full. */
+    uint32_t
+    getDropped(void) const {
+        return m_dropped.load(std::memory_order_relaxed);
+    }
+};
+
+} /* namespace usb */
+
+/***************************************************************************//**
+ * @brief Record a Trace Event: \c USB_TRACE(trace, "Format", [arg0, [arg1]]).
+ *
+ * Each Format String is a static Object named \c usbTraceFormat, so the Symbol
+ * Table of the ELF File lists all Trace Formats. \c usbtrace-decode.py builds
+ * its Format Table from it. Unless \c USB_TRACING is defined, the Macro
+ * expands to nothing.
+ ******************************************************************************/
+#if defined(USB_TRACING)
+#define USB_TRACE(p_trace, ...)     USB_TRACE_RECORD(p_trace, __VA_ARGS__, 0, 0, 0)
+#define USB_TRACE_RECORD(p_trace, p_format, p_arg0, p_arg1, ...)                                        \
+    do {                                                                                                \
+        static const char usbTraceFormat[] __attribute__((used)) = p_format;                            \
+        (p_trace).record(usbTraceFormat, (p_arg0), (p_arg1));                                           \
+    } while (0)
+#else
+#define USB_TRACE(p_trace, ...)     do { } while (0)
+#endif /* defined(USB_TRACING) */
+
+#endif /* _USB_TRACE_HPP_6D1F83A7_ */
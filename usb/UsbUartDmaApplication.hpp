@@ -0,0 +1,119 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _USB_UART_DMA_APPLICATION_HPP_A3F6102E_
+#define _USB_UART_DMA_APPLICATION_HPP_A3F6102E_
+
+#include <usb/UsbApplication.hpp>
+
+#include <cstddef>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace usb {
+
+/***************************************************************************//**
+ * @brief Bulk OUT Application that sends received Data to a UART via DMA.
+ *
+ * Unlike ::usb::UsbUartApplicationT, the CPU does not copy the Packet to the
+ * UART Byte by Byte. Each Packet is handed to a multi-buffered DMA Stream (see
+ * ::stm32::Uart::UartTxDmaT).
+ *
+ * The OUT Endpoint is NAK'ed while only one DMA Buffer is left. That Buffer
+ * takes the Packet that may already be in the RX FIFO when the NAK takes
+ * effect. The Endpoint is re-armed as soon as the DMA Stream releases a
+ * Buffer. The DMA Stream therefore needs at least three Buffers so that one
+ * Packet can be received while another one is sent.
+ *
+ * pause() NAKs the OUT Endpoint until resume() so that the UART can be drained,
+ * e.g. to change the Baud Rate without garbling Data that is still being sent.
+ *
+ * The DMA Interrupt must run at the same Priority as the USB Interrupt.
+ *
+ * @tparam TxDmaT UART Transmit Path with three or more Buffers, e.g.
+ *   ::stm32::Uart::UartTxDmaT.
+ * @tparam OutFlowControlT NAK Control of the OUT Endpoint, e.g.
+ *   ::stm32::usb::OutEndpointNakViaSTM32F4.
+ ******************************************************************************/
+template<typename TxDmaT, typename OutFlowControlT>
+class UsbUartDmaApplicationT : public UsbBulkOutApplication {
+    TxDmaT &                m_txDma;
+    const OutFlowControlT & m_outFlowControl;
+    bool                    m_outNaked;
+    bool                    m_paused;
+    unsigned                m_dropped;
+
+public:
+    UsbUartDmaApplicationT(TxDmaT &p_txDma, const OutFlowControlT &p_outFlowControl)
+      : m_txDma(p_txDma), m_outFlowControl(p_outFlowControl), m_outNaked(false), m_paused(false), m_dropped(0) {
+
+    }
+
+    void
+    start(void) {
+        m_txDma.start();
+    }
+
+    void
+    packetReceived(const void * const p_data, const size_t p_length) override {
+        if (!m_txDma.submit(p_data, p_length)) {
+            /* Can only happen if the Host ignored the NAK, e.g. after a Bus Reset */
+            m_dropped++;
+        }
+
+        /* Room for one more Packet that may already be in the RX FIFO */
+        if (m_txDma.getNumFree() < 2) {
+            m_outFlowControl.setNak();
+            m_outNaked = true;
+        }
+    }
+
+    void
+    handleDmaIrq(void) {
+        if (m_txDma.handleDmaIrq() && m_outNaked && !m_paused && (m_txDma.getNumFree() >= 2)) {
+            m_outNaked = false;
+            m_outFlowControl.clearNak();
+        }
+    }
+
+    /**
+     * @brief Stop taking Data from the Host until resume().
+     *
+     * Raises the UART Interrupt once everything received so far has been sent,
+     * see isDrained().
+     */
+    void
+    pause(void) {
+        m_paused = true;
+        m_outFlowControl.setNak();
+        m_outNaked = true;
+
+        m_txDma.setDrainIrq(true);
+    }
+
+    bool
+    isDrained(void) const {
+        return m_txDma.isDrained();
+    }
+
+    void
+    resume(void) {
+        m_txDma.setDrainIrq(false);
+
+        m_paused = false;
+        if (m_txDma.getNumFree() >= 2) {
+            m_outNaked = false;
+            m_outFlowControl.clearNak();
+        }
+    }
+
+    unsigned
+    getDropped(void) const {
+        return m_dropped;
+    }
+};
+
+} /* namespace usb */
+
+#endif /* _USB_UART_DMA_APPLICATION_HPP_A3F6102E_ */
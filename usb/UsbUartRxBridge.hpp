@@ -0,0 +1,126 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _USB_UART_RX_BRIDGE_HPP_4E8B2D70_
+#define _USB_UART_RX_BRIDGE_HPP_4E8B2D70_
+
+#include <usb/UsbBulkInApplication.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace usb {
+
+/***************************************************************************//**
+ * @brief Forwards Data received on a UART to a Bulk IN Endpoint.
+ *
+ * Data is taken straight out of the UART's circular DMA Buffer (see
+ * ::stm32::Uart::UartRxDmaT) and handed to the Bulk IN Endpoint without copying.
+ *
+ * While data is streaming in, only full Packets are sent. This happens when
+ * the DMA Stream reaches the half or the end of its Buffer. When the UART Line
+ * goes idle, everything that has arrived so far is flushed. This includes a
+ * trailing short Packet. If the flushed Data ends on a Packet Boundary, a
+ * Zero-Length Packet follows so the Host's Read completes.
+ *
+ * Only one Transfer is in flight at a time. Data that arrives in the meantime
+ * is sent when the IN Endpoint reports completion. If the Host does not read
+ * for so long that the DMA Buffer overruns, the Receive Path drops the unsent
+ * Data and the Bridge continues with the Data received after the Overrun.
+ *
+ * The UART, DMA and USB Interrupts must run at the same Priority. Otherwise
+ * the Callbacks may preempt each other.
+ *
+ * @tparam InEndpointT Bulk IN Endpoint, e.g. ::usb::UsbBulkInEndpointNotifyT.
+ * @tparam RxDmaT UART Receive Path, e.g. ::stm32::Uart::UartRxDmaT.
+ * @tparam nPacketSz Max. Packet Size of the Bulk IN Endpoint.
+ ******************************************************************************/
+template<typename InEndpointT, typename RxDmaT, size_t nPacketSz = 64>
+class UsbUartRxBridgeT : public UsbBulkInApplication {
+    InEndpointT &   m_inEndpoint;
+    RxDmaT &        m_rxDma;
+
+    size_t          m_inFlight;
+    bool            m_idle;
+    bool            m_needZlp;
+    bool            m_inZlp;
+
+    void
+    flush(void) {
+        if ((m_inFlight != 0) || m_inZlp) {
+            return;
+        }
+
+        const uint8_t * data;
+        size_t length = m_rxDma.peek(&data);
+
+        if (!m_idle) {
+            length -= (length % nPacketSz);
+        }
+
+        if (length == 0) {
+            if (m_idle && m_needZlp) {
+                m_needZlp   = false;
+                m_inZlp     = true;
+                m_inEndpoint.write(data, 0);
+                return;
+            }
+
+            m_idle = false;
+            return;
+        }
+
+        m_inFlight  = length;
+        m_needZlp   = ((length % nPacketSz) == 0);
+        m_inEndpoint.write(data, length);
+    }
+
+public:
+    UsbUartRxBridgeT(InEndpointT &p_inEndpoint, RxDmaT &p_rxDma)
+      : m_inEndpoint(p_inEndpoint), m_rxDma(p_rxDma), m_inFlight(0), m_idle(false), m_needZlp(false), m_inZlp(false) {
+        m_inEndpoint.registerApplication(*this);
+    }
+
+    ~UsbUartRxBridgeT() {
+        m_inEndpoint.unregisterApplication();
+    }
+
+    void
+    start(void) {
+        m_rxDma.start();
+    }
+
+    void
+    handleUartIrq(void) {
+        if (m_rxDma.handleUartIrq()) {
+            m_idle = true;
+            flush();
+        }
+    }
+
+    void
+    handleDmaIrq(void) {
+        if (m_rxDma.handleDmaIrq()) {
+            flush();
+        }
+    }
+
+    void
+    inTransferComplete(void) override {
+        if (m_inZlp) {
+            m_inZlp = false;
+        } else {
+            m_rxDma.consume(m_inFlight);
+            m_inFlight = 0;
+        }
+
+        flush();
+    }
+};
+
+} /* namespace usb */
+
+#endif /* _USB_UART_RX_BRIDGE_HPP_4E8B2D70_ */
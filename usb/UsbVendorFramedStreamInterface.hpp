@@ -0,0 +1,81 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _USB_VENDOR_FRAMED_STREAM_INTERFACE_HPP_7D3B15E9_
+#define _USB_VENDOR_FRAMED_STREAM_INTERFACE_HPP_7D3B15E9_
+
+#include <usb/UsbTypes.hpp>
+#include <usb/UsbInterface.hpp>
+#include <usb/UsbControlPipe.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace usb {
+
+/***************************************************************************//**
+ * @brief Vendor-specific Requests of the Framed Stream Interface.
+ *
+ * Numbered after ::usb::UsbVendorTraceRequest_e, so all Sets can share an
+ * Interface.
+ ******************************************************************************/
+typedef enum UsbVendorFrameRequest_e : uint8_t {
+    e_UsbVendorFrameRequest_GetStatistics   = 0x54,
+    e_UsbVendorFrameRequest_ResetStatistics = 0x55
+} UsbVendorFrameRequest_t;
+
+/***************************************************************************//**
+ * @brief Vendor Interface that reports the Counters of the Framed Stream.
+ *
+ * Extends \p InterfaceT by two Vendor Requests:
+ * - \c GET_FRAME_STATISTICS (Device-to-Host) returns the Counters, see
+ *   ::usb::UsbFramedStreamT::Statistics_t.
+ * - \c RESET_FRAME_STATISTICS (Host-to-Device, no Data Stage) clears them.
+ *
+ * The Counters are copied before they are sent, so the Data Stage is
+ * consistent even though the USB Interrupt keeps updating them.
+ *
+ * @tparam FramedStreamT Framed Stream, e.g. ::usb::UsbFramedStreamT.
+ * @tparam InterfaceT Interface that takes all other Requests and the
+ *   Constructor Arguments after \p p_stream, e.g. ::usb::UsbVendorInterface or
+ *   another Set of Vendor Requests.
+ ******************************************************************************/
+template<typename FramedStreamT, typename InterfaceT = UsbVendorInterface>
+class UsbVendorFramedStreamInterfaceT : public InterfaceT {
+    FramedStreamT &                         m_stream;
+    typename FramedStreamT::Statistics_t    m_snapshot;
+
+public:
+    template<typename... ArgsT>
+    UsbVendorFramedStreamInterfaceT(FramedStreamT &p_stream, ArgsT &&... p_args)
+      : InterfaceT(std::forward<ArgsT>(p_args)...), m_stream(p_stream), m_snapshot {} {
+
+    }
+
+    void
+    handleCtrlRequest(const UsbSetupPacket_t &p_setupPacket, UsbControlPipe &p_ctrlPipe) override {
+        switch (p_setupPacket.m_bRequest) {
+        case e_UsbVendorFrameRequest_GetStatistics:
+            ::memcpy(&m_snapshot, &m_stream.getStatistics(), sizeof(m_snapshot));
+            p_ctrlPipe.write(reinterpret_cast<const uint8_t *>(&m_snapshot),
+              (p_setupPacket.m_wLength < sizeof(m_snapshot)) ? p_setupPacket.m_wLength : sizeof(m_snapshot));
+            break;
+        case e_UsbVendorFrameRequest_ResetStatistics:
+            m_stream.resetStatistics();
+            p_ctrlPipe.write(nullptr, 0); /* Status Stage */
+            break;
+        default:
+            InterfaceT::handleCtrlRequest(p_setupPacket, p_ctrlPipe);
+            break;
+        }
+    }
+};
+
+} /* namespace usb */
+
+#endif /* _USB_VENDOR_FRAMED_STREAM_INTERFACE_HPP_7D3B15E9_ */
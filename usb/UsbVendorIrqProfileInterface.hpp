@@ -0,0 +1,79 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _USB_VENDOR_IRQ_PROFILE_INTERFACE_HPP_58C0E4B2_
+#define _USB_VENDOR_IRQ_PROFILE_INTERFACE_HPP_58C0E4B2_
+
+#include <usb/UsbTypes.hpp>
+#include <usb/UsbInterface.hpp>
+#include <usb/UsbControlPipe.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace usb {
+
+/***************************************************************************//**
+ * @brief Vendor-specific Requests of the IRQ Profile Interface.
+ ******************************************************************************/
+typedef enum UsbVendorRequest_e : uint8_t {
+    e_UsbVendorRequest_GetIrqProfile        = 0x50,
+    e_UsbVendorRequest_ResetIrqProfile      = 0x51
+} UsbVendorRequest_t;
+
+/***************************************************************************//**
+ * @brief Vendor Interface that reports the USB Interrupt Profile to the Host.
+ *
+ * Extends \p InterfaceT by two Vendor Requests:
+ * - \c GET_IRQ_PROFILE (Device-to-Host) returns the Profile Table, see
+ *   ::usb::UsbIrqProfileT::Table_t.
+ * - \c RESET_IRQ_PROFILE (Host-to-Device, no Data Stage) clears it.
+ *
+ * The Table is copied before it is sent, so the Data Stage is consistent even
+ * though the Profile keeps being updated by the USB Interrupt.
+ *
+ * @tparam ProfileT Interrupt Profile, e.g.
+ *   ::stm32::usb::IrqProfilerViaSTM32F4::Profile_t.
+ * @tparam InterfaceT Interface that takes all other Requests and the
+ *   Constructor Arguments after \p p_profile, e.g. ::usb::UsbVendorInterface or
+ *   another Set of Vendor Requests.
+ ******************************************************************************/
+template<typename ProfileT, typename InterfaceT = UsbVendorInterface>
+class UsbVendorIrqProfileInterfaceT : public InterfaceT {
+    ProfileT &                      m_profile;
+    typename ProfileT::Table_t      m_snapshot;
+
+public:
+    template<typename... ArgsT>
+    UsbVendorIrqProfileInterfaceT(ProfileT &p_profile, ArgsT &&... p_args)
+      : InterfaceT(std::forward<ArgsT>(p_args)...), m_profile(p_profile), m_snapshot {} {
+
+    }
+
+    void
+    handleCtrlRequest(const UsbSetupPacket_t &p_setupPacket, UsbControlPipe &p_ctrlPipe) override {
+        switch (p_setupPacket.m_bRequest) {
+        case e_UsbVendorRequest_GetIrqProfile:
+            ::memcpy(&m_snapshot, &m_profile.getTable(), sizeof(m_snapshot));
+            p_ctrlPipe.write(reinterpret_cast<const uint8_t *>(&m_snapshot),
+              (p_setupPacket.m_wLength < sizeof(m_snapshot)) ? p_setupPacket.m_wLength : sizeof(m_snapshot));
+            break;
+        case e_UsbVendorRequest_ResetIrqProfile:
+            m_profile.reset();
+            p_ctrlPipe.write(nullptr, 0); /* Status Stage */
+            break;
+        default:
+            InterfaceT::handleCtrlRequest(p_setupPacket, p_ctrlPipe);
+            break;
+        }
+    }
+};
+
+} /* namespace usb */
+
+#endif /* _USB_VENDOR_IRQ_PROFILE_INTERFACE_HPP_58C0E4B2_ */
@@ -0,0 +1,76 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _USB_VENDOR_TASK_STATS_INTERFACE_HPP_4C8D21A7_
+#define _USB_VENDOR_TASK_STATS_INTERFACE_HPP_4C8D21A7_
+
+#include <usb/UsbTypes.hpp>
+#include <usb/UsbInterface.hpp>
+#include <usb/UsbControlPipe.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace usb {
+
+/***************************************************************************//**
+ * @brief Vendor-specific Requests of the Task Statistics Interface.
+ *
+ * Numbered after ::usb::UsbVendorFrameRequest_e, so all Sets can share
+ * an Interface.
+ ******************************************************************************/
+typedef enum UsbVendorTaskStatsRequest_e : uint8_t {
+    e_UsbVendorTaskStatsRequest_GetTaskStats    = 0x56
+} UsbVendorTaskStatsRequest_t;
+
+/***************************************************************************//**
+ * @brief Vendor Interface that reports the Stack Usage and Run Time of all
+ *   FreeRTOS Tasks to the Host.
+ *
+ * Extends \p InterfaceT by the Vendor Request \c GET_TASK_STATS
+ * (Device-to-Host). It returns the last Snapshot of the Task Statistics, see
+ * ::rtos::TaskStatsT::Table_t.
+ *
+ * The Table is copied before it is sent, so the Data Stage is consistent even
+ * though the next Snapshot may be taken meanwhile.
+ *
+ * @tparam TaskStatsT Task Statistics, e.g. ::rtos::TaskStatsT.
+ * @tparam InterfaceT Interface that takes all other Requests and the
+ *   Constructor Arguments after \p p_taskStats, e.g. ::usb::UsbVendorInterface or
+ *   another Set of Vendor Requests.
+ ******************************************************************************/
+template<typename TaskStatsT, typename InterfaceT = UsbVendorInterface>
+class UsbVendorTaskStatsInterfaceT : public InterfaceT {
+    TaskStatsT &                        m_taskStats;
+    typename TaskStatsT::Table_t        m_snapshot;
+
+public:
+    template<typename... ArgsT>
+    UsbVendorTaskStatsInterfaceT(TaskStatsT &p_taskStats, ArgsT &&... p_args)
+      : InterfaceT(std::forward<ArgsT>(p_args)...), m_taskStats(p_taskStats), m_snapshot {} {
+
+    }
+
+    void
+    handleCtrlRequest(const UsbSetupPacket_t &p_setupPacket, UsbControlPipe &p_ctrlPipe) override {
+        switch (p_setupPacket.m_bRequest) {
+        case e_UsbVendorTaskStatsRequest_GetTaskStats:
+            ::memcpy(&m_snapshot, &m_taskStats.getTable(), sizeof(m_snapshot));
+            p_ctrlPipe.write(reinterpret_cast<const uint8_t *>(&m_snapshot),
+              (p_setupPacket.m_wLength < sizeof(m_snapshot)) ? p_setupPacket.m_wLength : sizeof(m_snapshot));
+            break;
+        default:
+            InterfaceT::handleCtrlRequest(p_setupPacket, p_ctrlPipe);
+            break;
+        }
+    }
+};
+
+} /* namespace usb */
+
+#endif /* _USB_VENDOR_TASK_STATS_INTERFACE_HPP_4C8D21A7_ */
@@ -0,0 +1,91 @@
+/*-
+ * $Copyright$
+-*/
+#ifndef _USB_VENDOR_TRACE_INTERFACE_HPP_2F94B6C1_
+#define _USB_VENDOR_TRACE_INTERFACE_HPP_2F94B6C1_
+
+#include <usb/UsbTypes.hpp>
+#include <usb/UsbInterface.hpp>
+#include <usb/UsbControlPipe.hpp>
+#include <usb/UsbTrace.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+/*******************************************************************************
+ *
+ ******************************************************************************/
+namespace usb {
+
+/***************************************************************************//**
+ * @brief Vendor-specific Requests of the Trace Interface.
+ *
+ * Numbered after ::usb::UsbVendorRequest_e, so both Sets can share an Interface.
+ ******************************************************************************/
+typedef enum UsbVendorTraceRequest_e : uint8_t {
+    e_UsbVendorTraceRequest_GetTrace        = 0x52,
+    e_UsbVendorTraceRequest_GetTraceDropped = 0x53
+} UsbVendorTraceRequest_t;
+
+/***************************************************************************//**
+ * @brief Vendor Interface that lets the Host drain the Trace Ring.
+ *
+ * Extends \p InterfaceT by two Vendor Requests:
+ * - \c GET_TRACE (Device-to-Host) returns up to \c wLength / 16 Events from
+ *   the Ring as ::usb::UsbTraceEvent_t Records. A short Response means that
+ *   the Ring is empty. \c wValue is the Number of Events the Host has
+ *   received with the previous \c GET_TRACE; only those are removed from the
+ *   Ring. The Control Pipe does not report whether the Status Stage of a
+ *   Response completed, so a Response that got lost is sent again if the Host
+ *   passes zero.
+ * - \c GET_TRACE_DROPPED (Device-to-Host) returns the Number of dropped
+ *   Events as a 32 Bit Little-Endian Value.
+ *
+ * @tparam TraceT Trace Ring, e.g. ::usb::UsbTraceT.
+ * @tparam InterfaceT Interface that takes all other Requests and the
+ *   Constructor Arguments after \p p_trace, e.g. ::usb::UsbVendorInterface or
+ *   another Set of Vendor Requests.
+ * @tparam nMaxEventsPerRequest Max. Number of Events per \c GET_TRACE Request.
+ ******************************************************************************/
+template<typename TraceT, typename InterfaceT = UsbVendorInterface, size_t nMaxEventsPerRequest = 16>
+class UsbVendorTraceInterfaceT : public InterfaceT {
+    TraceT &            m_trace;
+    UsbTraceEvent_t     m_events[nMaxEventsPerRequest];
+    /** @brief Events sent with the last \c GET_TRACE, still in the Ring until the Host acknowledges them. */
+    size_t              m_numSent;
+    uint32_t            m_dropped;
+
+public:
+    template<typename... ArgsT>
+    UsbVendorTraceInterfaceT(TraceT &p_trace, ArgsT &&... p_args)
+      : InterfaceT(std::forward<ArgsT>(p_args)...), m_trace(p_trace), m_events {}, m_numSent(0), m_dropped(0) {
+
+    }
+
+    void
+    handleCtrlRequest(const UsbSetupPacket_t &p_setupPacket, UsbControlPipe &p_ctrlPipe) override {
+        switch (p_setupPacket.m_bRequest) {
+        case e_UsbVendorTraceRequest_GetTrace: {
+            const size_t maxEvents = p_setupPacket.m_wLength / sizeof(UsbTraceEvent_t);
+
+            m_trace.consume((p_setupPacket.m_wValue < m_numSent) ? p_setupPacket.m_wValue : m_numSent);
+            m_numSent = m_trace.peek(m_events, (maxEvents < nMaxEventsPerRequest) ? maxEvents : nMaxEventsPerRequest);
+
+            p_ctrlPipe.write(reinterpret_cast<const uint8_t *>(m_events), m_numSent * sizeof(UsbTraceEvent_t));
+        } break;
+        case e_UsbVendorTraceRequest_GetTraceDropped:
+            m_dropped = m_trace.getDropped();
+            p_ctrlPipe.write(reinterpret_cast<const uint8_t *>(&m_dropped),
+              (p_setupPacket.m_wLength < sizeof(m_dropped)) ? p_setupPacket.m_wLength : sizeof(m_dropped));
+            break;
+        default:
+            InterfaceT::handleCtrlRequest(p_setupPacket, p_ctrlPipe);
+            break;
+        }
+    }
+};
+
+} /* namespace usb */
+
+#endif /* _USB_VENDOR_TRACE_INTERFACE_HPP_2F94B6C1_ */
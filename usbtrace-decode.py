@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+#-
+# $Copyright$
+#
+"""Decode USB Trace Events (see usb/UsbTrace.hpp) into readable Text.
+
+The Format Strings are looked up in the Firmware's ELF File: every USB_TRACE()
+Site defines a static Object named usbTraceFormat, whose Address is what the
+Device records as the Event's Format.
+
+Events are read either as Text Lines "T <format> <timestamp> <arg0> <arg1>"
+(Hex, as printed on the Debug UART by the Trace Task) or, with --binary, as raw
+16 Byte Records (as returned by the GET_TRACE Vendor Request).
+
+Usage:
+    usbtrace-decode.py [--binary] [--clock HZ] firmware.elf trace.log
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+SHT_SYMTAB = 2
+
+
+def read_format_table(elf_path):
+    """Map the lower 32 Bits of each usbTraceFormat Address to its String."""
+    with open(elf_path, 'rb') as elf_file:
+        elf = elf_file.read()
+
+    if elf[:4] != b'\x7fELF' or elf[5] != 1:
+        raise ValueError('%s is not a Little-Endian ELF File' % elf_path)
+
+    if elf[4] == 1:
+        shoff, = struct.unpack_from('<I', elf, 0x20)
+        shentsize, shnum = struct.unpack_from('<HH', elf, 0x2E)
+        sh_fmt, sym_fmt = '<IIIIIIIIII', '<IIIBBH'
+    else:
+        shoff, = struct.unpack_from('<Q', elf, 0x28)
+        shentsize, shnum = struct.unpack_from('<HH', elf, 0x3A)
+        sh_fmt, sym_fmt = '<IIQQQQIIQQ', '<IBBHQQ'
+
+    sections = [struct.unpack_from(sh_fmt, elf, shoff + idx * shentsize) for idx in range(shnum)]
+    formats = {}
+
+    for section in sections:
+        if section[1] != SHT_SYMTAB:
+            continue
+
+        strtab = sections[section[6]]
+        for offset in range(section[4], section[4] + section[5], section[9]):
+            if elf[4] == 1:
+                name, value, _size, _info, _other, shndx = struct.unpack_from(sym_fmt, elf, offset)
+            else:
+                name, _info, _other, shndx, value, _size = struct.unpack_from(sym_fmt, elf, offset)
+
+            name_start = strtab[4] + name
+            symbol = elf[name_start:elf.index(b'\0', name_start)]
+            if b'usbTraceFormat' not in symbol or shndx == 0 or shndx >= len(sections):
+                continue
+
+            target = sections[shndx]
+            start = target[4] + value - target[3]
+            formats[value & 0xFFFFFFFF] = elf[start:elf.index(b'\0', start)].decode('ascii', 'replace')
+
+    return formats
+
+
+def read_events(trace_path, binary):
+    """Yield (format, timestamp, arg0, arg1) Tuples."""
+    if binary:
+        with open(trace_path, 'rb') as trace_file:
+            data = trace_file.read()
+        for offset in range(0, len(data) - 15, 16):
+            yield struct.unpack_from('<IIII', data, offset)
+        return
+
+    pattern = re.compile(r'^T ([0-9a-fA-F]{8}) ([0-9a-fA-F]{8}) ([0-9a-fA-F]{8}) ([0-9a-fA-F]{8})\s*$')
+    with open(trace_path, 'r', errors='replace') as trace_file:
+        for line in trace_file:
+            match = pattern.match(line)
+            if match:
+                yield tuple(int(word, 16) for word in match.groups())
+
+
+def render(format_string, arg0, arg1):
+    """Apply a printf() Format String to the two 32 Bit Arguments."""
+    args = iter((arg0, arg1))
+
+    def convert(match):
+        flags, conversion = match.group(1), match.group(3)
+        if conversion == '%':
+            return '%'
+        value = next(args, 0)
+        if conversion in 'di' and value & 0x80000000:
+            value -= 0x100000000
+        return ('%' + flags + ('d' if conversion in 'diu' else conversion)) % value
+
+    return re.sub(r'%([-+ #0-9.]*)(hh|h|ll|l|z|t)?([diuxXoc%])', convert, format_string)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Decode USB Trace Events.')
+    parser.add_argument('--binary', action='store_true', help='Trace File holds raw 16 Byte Records')
+    parser.add_argument('--clock', type=float, default=168e6, help='Cycle Counter Frequency in Hz (default: 168 MHz)')
+    parser.add_argument('elf', help='Firmware ELF File')
+    parser.add_argument('trace', help='Trace File')
+    options = parser.parse_args()
+
+    formats = read_format_table(options.elf)
+    previous = None
+    elapsed = 0
+
+    for format_address, timestamp, arg0, arg1 in read_events(options.trace, options.binary):
+        if previous is None:
+            previous = timestamp
+        delta = (timestamp - previous) & 0xFFFFFFFF     # Cycle Counter wraps around
+        elapsed += delta - 0x100000000 if delta & 0x80000000 else delta
+        previous = timestamp
+
+        if format_address in formats:
+            text = render(formats[format_address], arg0, arg1)
+        else:
+            text = '<unknown Format 0x%08x> 0x%08x 0x%08x' % (format_address, arg0, arg1)
+
+        print('%12.3f us  %s' % (elapsed * 1e6 / options.clock, text))
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())